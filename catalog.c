@@ -0,0 +1,383 @@
+/*****************************************************************
+**
+**	@(#) catalog.c -- member zones of a catalog zone (RFC 9432)
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <unistd.h>
+# include <errno.h>
+# include <stdarg.h>
+# include <sys/types.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+# include "config_zkt.h"
+# include "debug.h"
+# include "misc.h"
+# include "zconf.h"
+# include "dki.h"
+# include "log.h"
+# include "zstore.h"
+#define	extern
+# include "catalog.h"
+#undef	extern
+
+/*****************************************************************
+**	A catalog zone (RFC 9432) lists its member zones as
+**		<unique-id>.zones.<catalog> PTR <member zone>
+**	The catalog file is read sequentially, one owner name at a
+**	time, and every member zone is handed over to the caller, so
+**	the memory needed is that of the set of member names used to
+**	drop duplicates.
+**	The serial and the member zones are kept in a state file next
+**	to the catalog file. As long as the serial of the catalog is
+**	unchanged, the members are taken from there and the rest of
+**	the catalog is not read.
+*****************************************************************/
+# define	CAT_MAXNAME	(4 * ZS_MAXNAME)	/* max length of a name in presentation format */
+
+/* set of member names */
+typedef	struct	{
+	char	**tab;
+	size_t	size;		/* number of slots (power of 2) */
+	size_t	n;
+} nameset_t;
+
+static	char	catalog_estr[255+1];
+
+/*****************************************************************
+**	private (static) function definition
+*****************************************************************/
+
+/*****************************************************************
+**	seterr (ret, fmt, ...)
+**	set the error string and return ret
+*****************************************************************/
+static	int	seterr (int ret, const char *fmt, ...)
+{
+	va_list	ap;
+
+	va_start (ap, fmt);
+	vsnprintf (catalog_estr, sizeof (catalog_estr), fmt, ap);
+	va_end (ap);
+
+	return ret;
+}
+
+/*****************************************************************
+**	nameset_add (s, name)
+**	returns 1 if name is new, 0 if already in the set and -1
+**	if out of memory
+*****************************************************************/
+static	int	nameset_add (nameset_t *s, const char *name)
+{
+	const	uchar	*p;
+	size_t	h;
+	size_t	i;
+
+	if ( 2 * (s->n + 1) > s->size )		/* keep the load factor below 1/2 */
+	{
+		char	**old = s->tab;
+		size_t	oldsize = s->size;
+
+		s->size = oldsize ? 2 * oldsize : 1024;
+		if ( (s->tab = calloc (s->size, sizeof (char *))) == NULL )
+		{
+			s->tab = old;
+			s->size = oldsize;
+			return -1;
+		}
+		s->n = 0;
+		for ( i = 0; i < oldsize; i++ )
+			if ( old[i] )
+			{
+				for ( h = 5381, p = (const uchar *)old[i]; *p; p++ )
+					h = h * 33 + *p;
+				while ( s->tab[h & (s->size - 1)] )
+					h++;
+				s->tab[h & (s->size - 1)] = old[i];
+				s->n++;
+			}
+		free (old);
+	}
+
+	for ( h = 5381, p = (const uchar *)name; *p; p++ )
+		h = h * 33 + *p;
+	for ( ; s->tab[h & (s->size - 1)]; h++ )
+		if ( strcmp (s->tab[h & (s->size - 1)], name) == 0 )
+			return 0;
+
+	if ( (s->tab[h & (s->size - 1)] = strdup (name)) == NULL )
+		return -1;
+	s->n++;
+
+	return 1;
+}
+
+static	void	nameset_free (nameset_t *s)
+{
+	size_t	i;
+
+	for ( i = 0; i < s->size; i++ )
+		if ( s->tab[i] )
+			free (s->tab[i]);
+	free (s->tab);
+	memset (s, 0, sizeof (*s));
+}
+
+/*****************************************************************
+**	readstate (statefile, apex, serial, func, stats)
+**	call func for all members of the state file if the state is
+**	that of the catalog "apex" at "serial"
+**	returns 1 if the state file was used
+*****************************************************************/
+static	int	readstate (const char *statefile, const char *apex, ulong serial, int (*func) (const char *zone), catalog_stats_t *stats)
+{
+	FILE	*fp;
+	char	line[CAT_MAXNAME+1];
+	char	name[CAT_MAXNAME+1];
+	char	*p;
+	ulong	oldserial;
+
+	if ( (fp = fopen (statefile, "r")) == NULL )
+		return 0;
+
+	if ( fgets (line, sizeof (line), fp) == NULL ||
+	     sscanf (line, "serial %lu %1023s", &oldserial, name) != 2 ||
+	     oldserial != serial || strcmp (name, apex) != 0 )
+	{
+		fclose (fp);
+		return 0;
+	}
+
+	dbg_val ("parse_catalog: serial %lu unchanged, members taken from state file\n", serial);
+	stats->cached = 1;
+	while ( fgets (line, sizeof (line), fp) != NULL )
+	{
+		if ( (p = strchr (line, '\n')) != NULL )
+			*p = '\0';
+		if ( *line == '\0' )
+			continue;
+		stats->members++;
+		(*func) (line);
+	}
+	fclose (fp);
+
+	return 1;
+}
+
+/*****************************************************************
+**	ismember (owner, apex)
+**	is the owner name of the form <unique-id>.zones.<apex> ?
+*****************************************************************/
+static	int	ismember (const dname_t *owner, const dname_t *apex)
+{
+	const	uchar	*label;
+
+	if ( owner->labels != apex->labels + 2 || !zs_issubdomain (owner, apex) )
+		return 0;
+	label = dname_wire (owner);
+	label += *label + 1;		/* second label */
+	return *label == 5 && memcmp (label + 1, "zones", 5) == 0;
+}
+
+/*****************************************************************
+**	isversion (owner, apex)
+**	is the owner name version.<apex> ?
+*****************************************************************/
+static	int	isversion (const dname_t *owner, const dname_t *apex)
+{
+	const	uchar	*label;
+
+	if ( owner->labels != apex->labels + 1 || !zs_issubdomain (owner, apex) )
+		return 0;
+	label = dname_wire (owner);
+	return *label == 7 && memcmp (label + 1, "version", 7) == 0;
+}
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	catalog_geterrstr ()
+*****************************************************************/
+const	char	*catalog_geterrstr ()
+{
+	return catalog_estr;
+}
+
+/*****************************************************************
+**	parse_catalog (file, func, stats)
+**	call func for every member zone of the catalog zone "file".
+**	The catalog must be the only zone of the file, starting with
+**	the SOA record, and the names must be absolute or be relative
+**	to an $ORIGIN directive.
+**	returns 1 on success or 0 on error (see catalog_geterrstr())
+*****************************************************************/
+int	parse_catalog (const char *file, int (*func) (const char *zone), catalog_stats_t *stats)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	statefile[MAX_PATHSIZE+1];
+	char	tmpfile[MAX_PATHSIZE+sizeof (".tmp")];
+	char	apexstr[CAT_MAXNAME+1];
+	char	member[CAT_MAXNAME+1];
+	const	char	*fname;
+	zsreader_t	*r;
+	zstore_t	*cat;		/* holds the catalog name */
+	const	dname_t	*apex;
+	nameset_t	members;
+	FILE	*fp;
+	rr_t	*rr;
+	long	n;
+	long	i;
+	long	ptr;
+	int	len;
+	int	len2;
+	int	ret;
+
+	assert (file != NULL && func != NULL && stats != NULL);
+	memset (stats, 0, sizeof (*stats));
+	catalog_estr[0] = '\0';
+
+	fname = splitpath (path, sizeof (path), file);
+	if ( (r = zs_open (".", *path ? path : ".", fname)) == NULL )
+		return seterr (0, "%s", zs_geterrstr ());
+
+	/* the first name has to be the apex of the catalog */
+	if ( (n = zs_readname (r, &rr)) <= 0 )
+	{
+		seterr (0, "%s", n == 0 ? "empty catalog zone file": zs_geterrstr ());
+		zs_close (r);
+		return 0;
+	}
+	for ( i = 0; i < n && rr[i].type != ZS_T_SOA; i++ )
+		;
+	len = len2 = -1;
+	if ( i < n && (len = zs_wirelen (rr[i].rdata, rr[i].rdlen)) > 0 )
+		len2 = zs_wirelen (rr[i].rdata + len, rr[i].rdlen - len);
+	if ( i >= n || rr[i].owner->labels == 0 || len2 < 0 || len + len2 + 4 > rr[i].rdlen )
+	{
+		seterr (0, "\"%s\" doesn't start with the SOA record of the catalog zone (missing $ORIGIN ?)", file);
+		zs_close (r);
+		return 0;
+	}
+	stats->serial = zs_get32 (rr[i].rdata + len + len2);
+	zs_dname2str (rr[i].owner, apexstr, sizeof (apexstr));
+	dbg_val2 ("parse_catalog: catalog zone %s serial %lu\n", apexstr, stats->serial);
+
+	snprintf (statefile, sizeof (statefile), "%s%s", file, CATALOG_STATE_EXT);
+	if ( readstate (statefile, apexstr, stats->serial, func, stats) )
+	{
+		zs_close (r);
+		return 1;
+	}
+
+	if ( (cat = zs_new (apexstr)) == NULL )
+	{
+		zs_close (r);
+		return seterr (0, "out of memory");
+	}
+	apex = cat->origin;
+
+	snprintf (tmpfile, sizeof (tmpfile), "%s.tmp", statefile);
+	if ( (fp = fopen (tmpfile, "w")) == NULL )
+		lg_mesg (LG_WARNING, "catalog \"%s\": can't write state file \"%s\"", apexstr, tmpfile);
+	else
+		fprintf (fp, "serial %lu %s\n", stats->serial, apexstr);
+
+	memset (&members, 0, sizeof (members));
+	ret = 1;
+	while ( (n = zs_readname (r, &rr)) > 0 )
+	{
+		if ( isversion (rr[0].owner, apex) )
+		{
+			for ( i = 0; i < n; i++ )
+				if ( rr[i].type == ZS_T_TXT && (rr[i].rdlen != 2 || rr[i].rdata[1] != CATALOG_VERSION[0]) )
+					lg_mesg (LG_WARNING, "catalog \"%s\": unsupported schema version", apexstr);
+			continue;
+		}
+		if ( !ismember (rr[0].owner, apex) )
+			continue;
+
+		for ( ptr = -1, i = 0; i < n; i++ )
+			if ( rr[i].type == ZS_T_PTR )
+				ptr = ptr < 0 ? i : n;
+		if ( ptr < 0 )
+			continue;
+		if ( ptr >= n )		/* more than one PTR record */
+		{
+			zs_dname2str (rr[0].owner, member, sizeof (member));
+			lg_mesg (LG_WARNING, "catalog \"%s\": member entry \"%s\" has more than one PTR record (ignored)", apexstr, member);
+			stats->ignored++;
+			continue;
+		}
+
+		zs_wire2str (rr[ptr].rdata, member, sizeof (member));
+		switch ( nameset_add (&members, member) )
+		{
+		case 0:
+			lg_mesg (LG_WARNING, "catalog \"%s\": duplicate member zone \"%s\" (ignored)", apexstr, member);
+			stats->ignored++;
+			continue;
+		case -1:
+			ret = seterr (0, "out of memory");
+			break;
+		}
+		if ( ret == 0 )
+			break;
+
+		stats->members++;
+		if ( fp )
+			fprintf (fp, "%s\n", member);
+		(*func) (member);
+	}
+	if ( n < 0 )
+		ret = seterr (0, "%s", zs_geterrstr ());
+
+	if ( fp )
+	{
+		if ( ferror (fp) | (fclose (fp) != 0) || ret == 0 || rename (tmpfile, statefile) != 0 )
+			unlink (tmpfile);
+	}
+
+	nameset_free (&members);
+	zs_free (cat);
+	zs_close (r);
+
+	return ret;
+}
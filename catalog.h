@@ -0,0 +1,52 @@
+/*****************************************************************
+**
+**	@(#) catalog.h -- member zones of a catalog zone (RFC 9432)
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+#ifndef CATALOG_H
+# define CATALOG_H
+
+# define	CATALOG_STATE_EXT	".zkt"	/* <catalogfile>.zkt: serial and members of the last run */
+# define	CATALOG_VERSION		"2"	/* supported schema version (RFC 9432) */
+
+typedef	struct	catalog_stats {
+	ulong	serial;		/* serial of the catalog zone */
+	long	members;	/* number of member zones */
+	long	ignored;	/* number of broken or duplicate member entries */
+	int	cached;		/* members are taken from the state file */
+} catalog_stats_t;
+
+extern	const	char	*catalog_geterrstr (void);
+extern	int	parse_catalog (const char *file, int (*func) (const char *zone), catalog_stats_t *stats);
+#endif
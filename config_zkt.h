@@ -76,6 +76,14 @@
 # define	LOG_WITH_LEVEL		1
 #endif
 
+#ifndef LOG_ASYNC	/* write log messages by a background thread (if available) */
+# define	LOG_ASYNC		1
+#endif
+
+#ifndef LOG_ZONEFILES	/* number of per zone log files kept open */
+# define	LOG_ZONEFILES		16
+#endif
+
 #ifndef ALWAYS_CHECK_KEYSETFILES
 # define	ALWAYS_CHECK_KEYSETFILES	1
 #endif
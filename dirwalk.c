@@ -0,0 +1,421 @@
+/*****************************************************************
+**
+**	@(#) dirwalk.c -- parallel walk through a directory tree
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <unistd.h>
+# include <dirent.h>
+# include <sys/types.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+# include <pthread.h>
+#endif
+# include "config_zkt.h"
+# include "debug.h"
+# include "misc.h"
+# include "dki.h"
+#define	extern
+# include "dirwalk.h"
+#undef	extern
+
+/*****************************************************************
+**	The directory tree is walked by a pool of threads. Each thread
+**	has a deque of directories still to visit. It takes its work
+**	from the end of its own deque (depth first) and, if that is
+**	empty, steals from the front of the deque of another thread,
+**	so a single big sub tree is spread over all threads.
+**	A visit reads the names of the sub directories, queues them,
+**	and calls the scan function on the directory. The result is
+**	kept in a tree of the directories in readdir() order, which is
+**	handed over to the merge function after all threads are done,
+**	so the outcome does not depend on the scheduling of the threads.
+*****************************************************************/
+
+typedef	struct	dwnode {
+	char	*path;
+	void	*data;		/* result of the scan function */
+	struct	dwnode	*child;	/* first sub directory */
+	struct	dwnode	*next;	/* next directory of the parent */
+} dwnode_t;
+
+typedef	struct	{
+	dwnode_t	**v;
+	int	first;		/* steal from here */
+	int	last;		/* push and pop here */
+	int	nalloc;
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	pthread_mutex_t	lock;
+#endif
+} dwdeque_t;
+
+typedef	struct	{
+	dirwalk_scan_t	scan;
+	void	*arg;
+	int	recursive;
+	int	nthreads;
+	long	queued;		/* directories waiting in one of the deques */
+	long	pending;	/* directories queued or under work */
+	dwdeque_t	q[DIRWALK_MAXTHREADS];
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+#endif
+} dwctx_t;
+
+typedef	struct	{
+	dwctx_t	*ctx;
+	int	id;
+} dwworker_t;
+
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+# define	lock(l)		pthread_mutex_lock (l)
+# define	unlock(l)	pthread_mutex_unlock (l)
+#else
+# define	lock(l)
+# define	unlock(l)
+#endif
+
+/*****************************************************************
+**	private (static) function definition
+*****************************************************************/
+
+static	dwnode_t	*newnode (const char *path)
+{
+	dwnode_t	*np;
+
+	if ( (np = calloc (1, sizeof (dwnode_t))) == NULL )
+		return NULL;
+	if ( (np->path = strdup (path)) == NULL )
+	{
+		free (np);
+		return NULL;
+	}
+	return np;
+}
+
+/*****************************************************************
+**	isdir (path, dentp)
+**	use the file type of the directory entry if the file system
+**	provides one, and stat() the file otherwise
+*****************************************************************/
+static	int	isdir (const char *path, const struct dirent *dentp)
+{
+#if defined(DT_DIR) && defined(DT_UNKNOWN) && defined(DT_LNK)
+	if ( dentp->d_type == DT_DIR )
+		return 1;
+	if ( dentp->d_type != DT_UNKNOWN && dentp->d_type != DT_LNK )
+		return 0;
+#endif
+	return is_directory (path);
+}
+
+/*****************************************************************
+**	push (c, id, np)
+**	add the directory np to the end of the deque of thread id
+*****************************************************************/
+static	int	push (dwctx_t *c, int id, dwnode_t *np)
+{
+	dwdeque_t	*q = &c->q[id];
+
+	lock (&q->lock);
+	if ( q->last >= q->nalloc )
+	{
+		if ( q->first > 0 )	/* make room at the front first */
+		{
+			memmove (q->v, q->v + q->first, (q->last - q->first) * sizeof (*q->v));
+			q->last -= q->first;
+			q->first = 0;
+		}
+		if ( q->last >= q->nalloc )
+		{
+			dwnode_t	**v;
+			int	n = q->nalloc ? 2 * q->nalloc: 64;
+
+			if ( (v = realloc (q->v, n * sizeof (*v))) == NULL )
+			{
+				unlock (&q->lock);
+				return 0;
+			}
+			q->v = v;
+			q->nalloc = n;
+		}
+	}
+	q->v[q->last++] = np;
+	unlock (&q->lock);
+
+	lock (&c->lock);
+	c->queued++;
+	c->pending++;
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	pthread_cond_broadcast (&c->cond);
+#endif
+	unlock (&c->lock);
+
+	return 1;
+}
+
+/*****************************************************************
+**	take (c, id)
+**	get the next directory from the end of the own deque,
+**	or steal one from the front of the deque of another thread
+*****************************************************************/
+static	dwnode_t	*take (dwctx_t *c, int id)
+{
+	dwdeque_t	*q;
+	dwnode_t	*np;
+	int	i;
+
+	np = NULL;
+	q = &c->q[id];
+	lock (&q->lock);
+	if ( q->last > q->first )
+		np = q->v[--q->last];
+	unlock (&q->lock);
+
+	for ( i = 1; np == NULL && i < c->nthreads; i++ )
+	{
+		q = &c->q[(id + i) % c->nthreads];
+		lock (&q->lock);
+		if ( q->last > q->first )
+			np = q->v[q->first++];
+		unlock (&q->lock);
+	}
+
+	if ( np )
+	{
+		lock (&c->lock);
+		c->queued--;
+		unlock (&c->lock);
+	}
+	return np;
+}
+
+/*****************************************************************
+**	visit (c, id, np)
+**	queue the sub directories of np and scan the directory
+*****************************************************************/
+static	void	visit (dwctx_t *c, int id, dwnode_t *np)
+{
+	DIR	*dirp;
+	struct  dirent  *dentp;
+	dwnode_t	**tail;
+	dwnode_t	*sub;
+	char	path[MAX_PATHSIZE+1];
+
+	dbg_val ("dirwalk: visit (%s)\n", np->path);
+	if ( c->recursive && (dirp = opendir (np->path)) != NULL )
+	{
+		tail = &np->child;
+		while ( (dentp = readdir (dirp)) != NULL )
+		{
+			if ( is_dotfilename (dentp->d_name) )
+				continue;
+
+			pathname (path, sizeof (path), np->path, dentp->d_name, NULL);
+			if ( !isdir (path, dentp) )
+				continue;
+
+			if ( (sub = newnode (path)) == NULL )
+				continue;
+			*tail = sub;
+			tail = &sub->next;
+		}
+		closedir (dirp);
+
+		/* queue the sub directories before the scan, so that idle threads could start on them */
+		for ( sub = np->child; sub; sub = sub->next )
+			if ( !push (c, id, sub) )
+				visit (c, id, sub);	/* out of memory: walk this sub tree by ourself */
+	}
+
+	np->data = c->scan (np->path, c->arg);
+}
+
+static	void	*worker (void *arg)
+{
+	dwworker_t	*w = (dwworker_t *)arg;
+	dwctx_t	*c = w->ctx;
+	dwnode_t	*np;
+	int	done;
+
+	for ( ;; )
+	{
+		if ( (np = take (c, w->id)) == NULL )
+		{
+			lock (&c->lock);
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+			while ( c->queued == 0 && c->pending > 0 )
+				pthread_cond_wait (&c->cond, &c->lock);
+#endif
+			done = c->pending == 0;
+			unlock (&c->lock);
+			if ( done )
+				break;
+			continue;
+		}
+
+		visit (c, w->id, np);
+
+		lock (&c->lock);
+		if ( --c->pending == 0 )
+		{
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+			pthread_cond_broadcast (&c->cond);
+#endif
+		}
+		unlock (&c->lock);
+	}
+
+	return NULL;
+}
+
+/*****************************************************************
+**	merge (np, merge, arg)
+**	hand over the scan results in pre-order and free the tree
+*****************************************************************/
+static	void	merge (dwnode_t *np, dirwalk_merge_t func, void *arg)
+{
+	dwnode_t	*next;
+
+	while ( np )
+	{
+		func (np->path, np->data, arg);
+		merge (np->child, func, arg);
+
+		next = np->next;
+		free (np->path);
+		free (np);
+		np = next;
+	}
+}
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	dirwalk (root, recursive, threads, scan, merge, arg)
+**	call scan() for the directory root and, if recursive is set,
+**	for all directories below, using the given number of threads
+**	(0 means DIRWALK_THREADS).
+**	Afterwards merge() is called for all directories in pre-order.
+**	returns 0 if root is not a directory, 1 otherwise
+*****************************************************************/
+int	dirwalk (const char *root, int recursive, int threads, dirwalk_scan_t scan, dirwalk_merge_t mergefunc, void *arg)
+{
+	dwctx_t	*c;
+	dwworker_t	w[DIRWALK_MAXTHREADS];
+	dwnode_t	*top;
+	int	i;
+
+	assert (root != NULL);
+	assert (scan != NULL && mergefunc != NULL);
+
+	dbg_val ("dirwalk: (%s)\n", root);
+	if ( !is_directory (root) )
+		return 0;
+	if ( (top = newnode (root)) == NULL )
+		return 0;
+
+	if ( threads <= 0 )
+		threads = DIRWALK_THREADS;
+	if ( threads > DIRWALK_MAXTHREADS )
+		threads = DIRWALK_MAXTHREADS;
+	if ( !recursive )
+		threads = 1;
+#if !(defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD)
+	threads = 1;
+#endif
+
+	if ( (c = calloc (1, sizeof (dwctx_t))) == NULL )
+	{
+		free (top->path);
+		free (top);
+		return 0;
+	}
+	c->scan = scan;
+	c->arg = arg;
+	c->recursive = recursive;
+	c->nthreads = threads;
+	for ( i = 0; i < threads; i++ )
+	{
+		w[i].ctx = c;
+		w[i].id = i;
+	}
+
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	{
+	pthread_t	tid[DIRWALK_MAXTHREADS];
+	int	n;
+
+	pthread_mutex_init (&c->lock, NULL);
+	pthread_cond_init (&c->cond, NULL);
+	for ( i = 0; i < threads; i++ )
+		pthread_mutex_init (&c->q[i].lock, NULL);
+
+	if ( !push (c, 0, top) )
+		visit (c, 0, top);
+	for ( n = 1; n < threads; n++ )
+		if ( pthread_create (&tid[n], NULL, worker, &w[n]) != 0 )
+			break;
+	worker (&w[0]);		/* the calling thread is the first worker */
+	for ( i = 1; i < n; i++ )
+		pthread_join (tid[i], NULL);
+	dbg_val ("dirwalk: %d threads\n", n);
+
+	for ( i = 0; i < threads; i++ )
+		pthread_mutex_destroy (&c->q[i].lock);
+	pthread_cond_destroy (&c->cond);
+	pthread_mutex_destroy (&c->lock);
+	}
+#else
+	if ( !push (c, 0, top) )
+		visit (c, 0, top);
+	worker (&w[0]);
+#endif
+
+	for ( i = 0; i < threads; i++ )
+		free (c->q[i].v);
+	free (c);
+
+	merge (top, mergefunc, arg);
+
+	return 1;
+}
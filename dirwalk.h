@@ -0,0 +1,50 @@
+/*****************************************************************
+**
+**	@(#) dirwalk.h -- parallel walk through a directory tree
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+#ifndef DIRWALK_H
+# define DIRWALK_H
+
+# define	DIRWALK_THREADS		8	/* number of threads used if 0 is given */
+# define	DIRWALK_MAXTHREADS	64
+
+/* called in parallel for each directory; the result is handed over to the merge function */
+typedef	void	*(*dirwalk_scan_t) (const char *dir, void *arg);
+/* called in the calling thread for each directory in pre-order (the directory, then the
+** sub directories in the order of readdir()) after the whole tree is scanned */
+typedef	void	(*dirwalk_merge_t) (const char *dir, void *data, void *arg);
+
+extern	int	dirwalk (const char *root, int recursive, int threads, dirwalk_scan_t scan, dirwalk_merge_t merge, void *arg);
+#endif
@@ -5,6 +5,7 @@
 #	(c) Jul 2008 Holger Zuleger  hznet.de
 #
 #	Feb 2010	action "distkeys" added but currently not used
+#	Oct 2026	optional zone difference (DistributeDelta) as 5th parameter
 #
 #	This shell script will be run by zkt-signer as a distribution
 #	and reload command if:
@@ -35,7 +36,7 @@ dir=/var/named		# zone directory on remote name server
 progname=$0
 usage()
 {
-	echo "usage: $progname distkeys|distribute|reload <zone> <path_to_zonefile> [<viewname>]" 1>&2
+	echo "usage: $progname distkeys|distribute|reload <zone> <path_to_zonefile> [<viewname> [<path_to_delta>]]" 1>&2
 	test $# -gt 0 && echo $* 1>&2
 	exit 1
 }
@@ -49,6 +50,8 @@ zone="$2"
 zonefile="$3"
 view=""
 test $# -gt 3 && view="$4"
+delta=""
+test $# -gt 4 && delta="$5"
 
 case $action in
 distkeys)
@@ -62,6 +65,11 @@ distkeys)
 	fi
 	;;
 distribute)
+	if test -n "$delta"	# IXFR journal or nsupdate batch of the changes
+	then
+		: echo "scp $delta $server:$dir/$view/$zone/"
+		scp $delta $server:$dir/$view/$zone/
+	fi
 	if test -n "$view"
 	then
 		: echo "scp $zonefile $server:$dir/$view/$zone/"
@@ -57,6 +57,10 @@
 # include "domaincmp.h"
 # include "misc.h"
 # include "zconf.h"
+# include "keygen.h"
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+# include <openssl/evp.h>
+#endif
 #define	extern
 # include "dki.h"
 #undef	extern
@@ -64,7 +68,11 @@
 /*****************************************************************
 **	private (static) function declaration and definition
 *****************************************************************/
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD && defined(__GNUC__)
+static	__thread	char	dki_estr[MAX_PATHSIZE+MAX_FNAMESIZE+1];	/* keys are read in parallel by dirwalk() */
+#else
 static	char	dki_estr[MAX_PATHSIZE+MAX_FNAMESIZE+1];
+#endif
 
 static	dki_t	*dki_alloc ()
 {
@@ -235,20 +243,18 @@ void	dki_tfree (dki_t **tree)
 
 # define	KEYGEN_COMPMODE	"-C -q "	/* this is the compability mode needed since BIND 9.7 */
 /*****************************************************************
-**	dki_new ()
-**	create new keyfile
-**	allocate memory for new dki key and init with keyfile
+**	dki_keygencmd ()
+**	create new keyfile by running dnssec-keygen and store the
+**	name of the key file in fname
 *****************************************************************/
-dki_t	*dki_new (const char *dir, const char *name, int ksk, int algo, int bitsize, const char *rfile, int lf_days)
+static	int	dki_keygencmd (const char *dir, const char *name, int ksk, int algo, int bitsize, const char *rfile, char *fname, size_t fsize)
 {
 	char	cmdline[511+1];
-	char	fname[254+1];
 	char	randfile[254+1];
 	FILE	*fp;
 	int	len;
 	char	*flag = "";
 	char    *expflag = "";
-	dki_t	*new;
  
 	if ( ksk )
 		flag = "-f KSK";
@@ -273,10 +279,10 @@ dki_t	*dki_new (const char *dir, const char *name, int ksk, int algo, int bitsiz
 	dbg_msg (cmdline);
 
 	if ( (fp = popen (cmdline, "r")) == NULL )
-		return NULL;
+		return -1;
 
 	fname[0] = '\0';
-	fgets (fname, sizeof fname, fp);
+	fgets (fname, fsize, fp);
 
 	pclose (fp);
 
@@ -284,6 +290,33 @@ dki_t	*dki_new (const char *dir, const char *name, int ksk, int algo, int bitsiz
 	if ( len >= 0 && fname[len] == '\n' )
 		fname[len] = '\0';
 
+	return 0;
+}
+
+/*****************************************************************
+**	dki_new ()
+**	create new keyfile
+**	allocate memory for new dki key and init with keyfile
+**	The key is generated in-process if the algorithm is supported
+**	by keygen(), otherwise dnssec-keygen is used.
+*****************************************************************/
+dki_t	*dki_new (const char *dir, const char *name, int ksk, int algo, int bitsize, const char *rfile, int lf_days)
+{
+	char	fname[254+1];
+	dki_t	*new;
+
+	dki_estr[0] = '\0';
+	if ( keygen_supported (algo, bitsize) )
+	{
+		if ( keygen (dir, name, ksk, algo, bitsize, fname, sizeof (fname)) < 0 )
+		{
+			snprintf (dki_estr, sizeof (dki_estr), "dki_new: %s", keygen_geterrstr ());
+			return NULL;
+		}
+	}
+	else if ( dki_keygencmd (dir, name, ksk, algo, bitsize, rfile, fname, sizeof (fname)) < 0 )
+		return NULL;
+
 	new = dki_read (dir, fname);
 	if ( new )
 		dki_setlifetime (new, lf_days);	/* sets gentime + proposed lifetime */
@@ -402,11 +435,11 @@ dki_t	*dki_read (const char *dirname, const char *filename)
 }
 
 /*****************************************************************
-**	dki_readdir ()
-**	read key files from directory 'dir' and, if recursive is
-**	true, from all directorys below that.
+**	readdir_list ()
+**	prepend the keys found in 'dir' (and below, if recursive is
+**	true) to the list 'listp' without sorting them in
 *****************************************************************/
-int	dki_readdir (const char *dir, dki_t **listp, int recursive)
+static	int	readdir_list (const char *dir, dki_t **listp, int recursive)
 {
 	dki_t	*dkp;
 	DIR	*dirp;
@@ -427,16 +460,35 @@ int	dki_readdir (const char *dir, dki_t **listp, int recursive)
 		if ( is_directory (path) && recursive )
 		{
 			dbg_val ("directory: recursive %s\n", path);
-			dki_readdir (path, listp, recursive);
+			readdir_list (path, listp, recursive);
 		}
 		else if ( is_keyfilename (dentp->d_name) )
 			if ( (dkp = dki_read (dir, dentp->d_name)) )
-				dki_add (listp, dkp);
+			{
+				dkp->next = *listp;
+				*listp = dkp;
+			}
 	}
 	closedir (dirp);
 	return 1;
 }
 
+/*****************************************************************
+**	dki_readdir ()
+**	read key files from directory 'dir' and, if recursive is
+**	true, from all directorys below that.
+**	The keys are collected first and sorted once into the list.
+*****************************************************************/
+int	dki_readdir (const char *dir, dki_t **listp, int recursive)
+{
+	int	ret;
+
+	ret = readdir_list (dir, listp, recursive);
+	dki_sortlist (listp);
+
+	return ret;
+}
+
 /*****************************************************************
 **	dki_setstatus_preservetime ()
 **	set status of key and change extension to
@@ -653,6 +705,8 @@ char	*dki_algo2str (int algo)
 	case DK_ALGO_RSASHA512:		return ("RSASHA512");
 	case DK_ALGO_ECDSAP256SHA256:	return ("ECDSAP256SHA256");
 	case DK_ALGO_ECDSAP384SHA384:	return ("ECDSAP384SHA384");
+	case DK_ALGO_ED25519:		return ("ED25519");
+	case DK_ALGO_ED448:		return ("ED448");
 	}
 	return ("unknown");
 }
@@ -676,6 +730,8 @@ char	*dki_algo2sstr (int algo)
 	case DK_ALGO_RSASHA512:		return ("RSASHA5");
 	case DK_ALGO_ECDSAP256SHA256:	return ("P256");
 	case DK_ALGO_ECDSAP384SHA384:	return ("P384");
+	case DK_ALGO_ED25519:		return ("ED25519");
+	case DK_ALGO_ED448:		return ("ED448");
 	}
 	return ("unknown");
 }
@@ -839,6 +895,180 @@ int	dki_prt_managedkey (const dki_t *dkp, FILE *fp)
 }
 
 
+/*****************************************************************
+**	dki_str2digest ()
+**	convert a list of DS digest types (e.g. "sha256, sha384")
+**	into a bit mask of (1 << DK_DIGEST_xxx)
+**	returns -1 on unknown digest types
+*****************************************************************/
+int	dki_str2digest (const char *str)
+{
+	char	name[15+1];
+	int	mask;
+	int	i;
+
+	mask = 0;
+	while ( str && *str )
+	{
+		while ( isflistdelim (*str) )
+			str++;
+		for ( i = 0; *str && !isflistdelim (*str); str++ )
+			if ( i < sizeof (name) - 1 )
+				name[i++] = *str;
+		name[i] = '\0';
+
+		if ( name[0] == '\0' )
+			continue;
+		if ( strcmp (name, "1") == 0 || strcasecmp (name, "sha1") == 0 )
+			mask |= 1 << DK_DIGEST_SHA1;
+		else if ( strcmp (name, "2") == 0 || strcasecmp (name, "sha256") == 0 )
+			mask |= 1 << DK_DIGEST_SHA256;
+		else if ( strcmp (name, "4") == 0 || strcasecmp (name, "sha384") == 0 )
+			mask |= 1 << DK_DIGEST_SHA384;
+		else
+			return -1;
+	}
+
+	return mask;
+}
+
+/*****************************************************************
+**	dki_digest ()
+**	compute the DS digest (RFC 4034 section 5.1.4) of the key
+**	and store it as hex string in 'hex'
+**	returns the length of the digest in bytes or -1 on error
+*****************************************************************/
+int	dki_digest (const dki_t *dkp, int dtype, char *hex, size_t size)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	unsigned char	wire[MAX_LABELSIZE+1 + 4 + 1024];
+	unsigned char	md[EVP_MAX_MD_SIZE];
+	char	b64[((1024 + 2) / 3) * 4 + 1];
+	const	EVP_MD	*type;
+	const	char	*p;
+	const	char	*q;
+	unsigned int	mdlen;
+	int	len;
+	int	pad;
+	int	i;
+
+	assert (dkp != NULL);
+	assert (hex != NULL);
+
+	switch ( dtype )
+	{
+	case DK_DIGEST_SHA1:	type = EVP_sha1 ();	break;
+	case DK_DIGEST_SHA256:	type = EVP_sha256 ();	break;
+	case DK_DIGEST_SHA384:	type = EVP_sha384 ();	break;
+	default:
+		snprintf (dki_estr, sizeof (dki_estr), "dki_digest: unknown digest type %d", dtype);
+		return -1;
+	}
+
+	/* owner name in canonical wire format */
+	len = 0;
+	p = dkp->name;
+	while ( *p && *p != '.' )
+	{
+		if ( (q = strchr (p, '.')) == NULL )
+			q = p + strlen (p);
+		wire[len++] = q - p;
+		while ( p < q )
+			wire[len++] = tolower (*p++);
+		if ( *p == '.' )
+			p++;
+	}
+	wire[len++] = 0;		/* root label */
+
+	/* DNSKEY rdata */
+	wire[len++] = (dkp->flags >> 8) & 0xFF;
+	wire[len++] = dkp->flags & 0xFF;
+	wire[len++] = DK_PROTO_DNS;
+	wire[len++] = dkp->algo;
+
+	for ( i = 0, p = dkp->pubkey; p && *p && i < sizeof (b64) - 1; p++ )
+		if ( !isspace (*p) )
+			b64[i++] = *p;
+	b64[i] = '\0';
+	if ( i == 0 || i % 4 != 0 || i / 4 * 3 > sizeof (wire) - len )
+	{
+		snprintf (dki_estr, sizeof (dki_estr), "dki_digest: invalid public key of key %u", dkp->tag);
+		return -1;
+	}
+	for ( pad = 0; i > 0 && b64[i-1] == '='; i-- )
+		pad++;
+	if ( (i = EVP_DecodeBlock (wire + len, (unsigned char *)b64, strlen (b64))) < 0 )
+	{
+		snprintf (dki_estr, sizeof (dki_estr), "dki_digest: invalid public key of key %u", dkp->tag);
+		return -1;
+	}
+	len += i - pad;
+
+	if ( EVP_Digest (wire, len, md, &mdlen, type, NULL) != 1 || 2 * mdlen + 1 > size )
+	{
+		snprintf (dki_estr, sizeof (dki_estr), "dki_digest: can't compute digest of key %u", dkp->tag);
+		return -1;
+	}
+
+	for ( i = 0; i < mdlen; i++ )
+		sprintf (hex + 2 * i, "%02X", md[i]);
+
+	return mdlen;
+#else
+	snprintf (dki_estr, sizeof (dki_estr), "dki_digest: compiled without libcrypto");
+	return -1;
+#endif
+}
+
+/*****************************************************************
+**	dki_prt_ds ()
+**	print a DS (or CDS) record of the key for each digest type
+**	in the bit mask 'digests'
+**	returns the number of records printed or -1 on error
+*****************************************************************/
+int	dki_prt_ds (const dki_t *dkp, FILE *fp, int ttl, int digests, const char *rrtype)
+{
+	char	hex[2*64+1];
+	int	dtype;
+	int	cnt;
+
+	if ( dkp == NULL )
+		return 0;
+
+	cnt = 0;
+	for ( dtype = DK_DIGEST_SHA1; dtype <= DK_DIGEST_SHA384; dtype++ )
+	{
+		if ( (digests & (1 << dtype)) == 0 )
+			continue;
+		if ( dki_digest (dkp, dtype, hex, sizeof (hex)) < 0 )
+			return -1;
+
+		fprintf (fp, "%s ", dkp->name);
+		if ( ttl > 0 )
+			fprintf (fp, "%d ", ttl);
+		fprintf (fp, "IN %s %u %d %d %s\n", rrtype ? rrtype: "DS", dkp->tag, dkp->algo, dtype, hex);
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/*****************************************************************
+**	dki_prt_cdnskey ()
+*****************************************************************/
+int	dki_prt_cdnskey (const dki_t *dkp, FILE *fp, int ttl)
+{
+	if ( dkp == NULL )
+		return 0;
+
+	fprintf (fp, "%s ", dkp->name);
+	if ( ttl > 0 )
+		fprintf (fp, "%d ", ttl);
+	fprintf (fp, "IN CDNSKEY %d 3 %d %s\n", dkp->flags, dkp->algo, dkp->pubkey);
+
+	return 1;
+}
+
 /*****************************************************************
 **	dki_cmp () 	return <0 | 0 | >0
 *****************************************************************/
@@ -1172,6 +1402,60 @@ dki_t	*dki_add (dki_t **list, dki_t *new)
 	return *list;
 }
 
+/*****************************************************************
+**	dki_sortlist ()	sort the list in dki_cmp() order
+**	Each key gets a sort key made of the domain name (see
+**	domain_sortkey()), the key type and the creation time, and
+**	the list is radix sorted on that.
+*****************************************************************/
+void	dki_sortlist (dki_t **listp)
+{
+	domsort_t	s;
+	dki_t	*dkp;
+	dki_t	*list;
+	unsigned char	suffix[1+8];
+	unsigned long long	t;
+	size_t	i;
+	int	j;
+
+	assert (listp != NULL);
+	if ( *listp == NULL )
+		return;
+	memset (&s, 0, sizeof (s));
+
+	for ( dkp = *listp; dkp; dkp = dkp->next )
+	{
+		suffix[0] = !dki_isksk (dkp);	/* ksk first, */
+		t = (ulong)dkp->time;		/* then by creation time */
+		for ( j = 8; j > 0; j--, t >>= 8 )
+			suffix[j] = t & 0xFF;
+		if ( domsort_add (&s, dkp->name, 1, suffix, sizeof (suffix), dkp) < 0 )
+			break;
+	}
+
+	if ( dkp == NULL )	/* all keys added ? */
+	{
+		domsort_sort (&s);
+		for ( i = s.n; i > 0; i-- )
+		{
+			dkp = s.v[i-1].data;
+			dkp->next = i < s.n ? s.v[i].data : NULL;
+		}
+		*listp = s.v[0].data;
+	}
+	else			/* out of memory: sort by insertion */
+	{
+		list = *listp;
+		*listp = NULL;
+		while ( (dkp = list) != NULL )
+		{
+			list = dkp->next;
+			dki_add (listp, dkp);
+		}
+	}
+	domsort_free (&s);
+}
+
 /*****************************************************************
 **	dki_search ()	search a key with the given tag, or the first
 **			occurence of a key with the given name
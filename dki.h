@@ -62,6 +62,13 @@
 # define	DK_ALGO_NSEC3RSASHA512	DK_ALGO_RSASHA512	/* same as non nsec algorithm RFCxxx */
 # define	DK_ALGO_ECDSAP256SHA256	13	/* RFC 6605 */
 # define	DK_ALGO_ECDSAP384SHA384	14	/* RFC 6605 */
+# define	DK_ALGO_ED25519		15	/* RFC 8080 */
+# define	DK_ALGO_ED448		16	/* RFC 8080 */
+
+/* DS digest types */
+# define	DK_DIGEST_SHA1		1	/* RFC 4034 */
+# define	DK_DIGEST_SHA256	2	/* RFC 4509 */
+# define	DK_DIGEST_SHA384	4	/* RFC 6605 */
 
 /* protocol types */
 # define	DK_PROTO_DNS	3
@@ -152,6 +159,10 @@ extern	int	dki_prt_dnskey (const dki_t *dkp, FILE *fp);
 extern	int	dki_prt_dnskeyttl (const dki_t *dkp, FILE *fp, int ttl);
 extern	int	dki_prt_dnskey_raw (const dki_t *dkp, FILE *fp);
 extern	int	dki_prt_comment (const dki_t *dkp, FILE *fp);
+extern	int	dki_prt_ds (const dki_t *dkp, FILE *fp, int ttl, int digests, const char *rrtype);
+extern	int	dki_prt_cdnskey (const dki_t *dkp, FILE *fp, int ttl);
+extern	int	dki_digest (const dki_t *dkp, int dtype, char *hex, size_t size);
+extern	int	dki_str2digest (const char *str);
 extern	int	dki_cmp (const dki_t *a, const dki_t *b);
 extern	int	dki_timecmp (const dki_t *a, const dki_t *b);
 extern	int	dki_age (const dki_t *dkp, time_t curr);
@@ -179,6 +190,7 @@ extern	dki_t	*dki_destroy (dki_t *dkp);
 extern	int	dki_setstatus (dki_t *dkp, int status);
 extern	int	dki_setstatus_preservetime (dki_t *dkp, int status);
 extern	dki_t	*dki_add (dki_t **dkp, dki_t *new);
+extern	void	dki_sortlist (dki_t **listp);
 extern	const dki_t	*dki_tsearch (const dki_t *tree, int tag, const char *name);
 extern	const dki_t	*dki_search (const dki_t *list, int tag, const char *name);
 extern	const dki_t	*dki_find (const dki_t *list, int ksk, int status, int first);
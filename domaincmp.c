@@ -37,6 +37,7 @@
 **
 *****************************************************************/
 # include <stdio.h>
+# include <stdlib.h>
 # include <string.h>
 # include <assert.h>
 # include <ctype.h>
@@ -254,6 +255,227 @@ int	isparentdomain (const char *child, const char *parent, int level)
 	return 0;
 }
 
+/*****************************************************************
+**
+**	int	domain_sortkey (name, subdomain_above, key, size)
+**
+**	Convert the domain name into a byte string where a plain
+**	memcmp() gives the same order as domaincmp_dir() does on the
+**	names. The labels are stored from right to left, each one
+**	followed by a '.', and the key ends with a byte greater
+**	(subdomain_above) or less than any label character.
+**	The name is not case folded; domaincmp() is case sensitive
+**	and the names are made lower case by domain_canonicdup().
+**
+**	returns the length of the key or -1 if "size" is too small
+**
+*****************************************************************/
+int	domain_sortkey (const char *name, int subdomain_above, unsigned char *key, size_t size)
+{
+	const	char	*end;
+	const	char	*p;
+	size_t	len;
+	size_t	llen;
+
+	assert (name != NULL && key != NULL);
+
+	if ( *name == '.' )	/* skip a leading dot */
+		name++;
+	end = name + strlen (name);
+	while ( end > name && end[-1] == '.' )	/* and all trailing dots */
+		end--;
+
+	len = 0;
+	while ( end > name )
+	{
+		p = end;
+		goto_labelstart (name, p);
+		llen = end - p;
+		if ( len + llen + 1 >= size )
+			return -1;
+		memcpy (key + len, p, llen);
+		len += llen;
+		key[len++] = '.';
+		end = p;
+		if ( end > name )	/* skip the label separator */
+			end--;
+	}
+	if ( len >= size )
+		return -1;
+	key[len++] = subdomain_above ? 0xFF : 0x00;
+
+	return len;
+}
+
+/*****************************************************************
+**	domsort_add (s, name, subdomain_above, suffix, slen, data)
+**	add "data" with the sort key of "name" to "s". The optional
+**	"suffix" is appended to the key and is used to order entries
+**	with the same domain name.
+**	returns 0 on success and -1 if out of memory or the name
+**	is too long
+*****************************************************************/
+int	domsort_add (domsort_t *s, const char *name, int subdomain_above, const unsigned char *suffix, size_t slen, void *data)
+{
+	int	len;
+
+	assert (s != NULL);
+
+	if ( s->n >= s->nalloc )
+	{
+		size_t	nalloc = s->nalloc ? 2 * s->nalloc : 64;
+		domsortent_t	*v;
+
+		if ( (v = realloc (s->v, nalloc * sizeof (*v))) == NULL )
+			return -1;
+		s->v = v;
+		s->nalloc = nalloc;
+	}
+	if ( s->klen + DOMKEY_MAXSIZE + slen > s->kalloc )
+	{
+		size_t	kalloc = s->kalloc ? 2 * s->kalloc : 64 * 32;
+		unsigned char	*keys;
+
+		while ( s->klen + DOMKEY_MAXSIZE + slen > kalloc )
+			kalloc *= 2;
+		if ( (keys = realloc (s->keys, kalloc)) == NULL )
+			return -1;
+		s->keys = keys;
+		s->kalloc = kalloc;
+	}
+
+	if ( (len = domain_sortkey (name, subdomain_above, s->keys + s->klen, DOMKEY_MAXSIZE)) < 0 )
+		return -1;
+	if ( slen > 0 )
+		memcpy (s->keys + s->klen + len, suffix, slen);
+
+	s->v[s->n].off = s->klen;
+	s->v[s->n].len = len + slen;
+	s->v[s->n].data = data;
+	s->klen += len + slen;
+	s->n++;
+
+	return 0;
+}
+
+/*****************************************************************
+**	keycmp (keys, a, b, depth)
+**	compare the keys of entry a and b starting at byte "depth"
+*****************************************************************/
+static	int	keycmp (const unsigned char *keys, const domsortent_t *a, const domsortent_t *b, size_t depth)
+{
+	size_t	len;
+	int	res;
+
+	len = a->len < b->len ? a->len : b->len;
+	if ( len > depth && (res = memcmp (keys + a->off + depth, keys + b->off + depth, len - depth)) != 0 )
+		return res;
+
+	return (a->len > b->len) - (a->len < b->len);
+}
+
+/*****************************************************************
+**	radixsort (keys, v, tmp, n, depth)
+**	stable MSD radix sort of the n entries of v which are all
+**	equal in the first "depth" bytes of their keys.
+**	Small buckets are finished by insertion sort.
+*****************************************************************/
+# define	RADIX_SMALL	16
+static	void	radixsort (const unsigned char *keys, domsortent_t *v, domsortent_t *tmp, size_t n, size_t depth)
+{
+	size_t	count[256+1];
+	size_t	start;
+	size_t	i;
+	size_t	j;
+	int	b;
+
+	while ( n > RADIX_SMALL )
+	{
+		memset (count, 0, sizeof (count));
+		for ( i = 0; i < n; i++ )	/* bucket 0 is for keys ending at depth */
+			count[v[i].len > depth ? keys[v[i].off + depth] + 1 : 0]++;
+
+		for ( b = 0; b <= 256 && count[b] != n; b++ )
+			;
+		if ( b <= 256 )		/* all keys in one bucket ? */
+		{
+			if ( b == 0 )	/* all keys are equal */
+				return;
+			depth++;
+			continue;
+		}
+
+		for ( start = 0, b = 0; b <= 256; b++ )	/* bucket start offsets */
+		{
+			size_t	c = count[b];
+			count[b] = start;
+			start += c;
+		}
+		for ( i = 0; i < n; i++ )
+			tmp[count[v[i].len > depth ? keys[v[i].off + depth] + 1 : 0]++] = v[i];
+		memcpy (v, tmp, n * sizeof (*v));
+
+		/* count[b] is now the end of bucket b; bucket 0 is already sorted */
+		for ( b = 1; b <= 256; b++ )
+			if ( count[b] - count[b-1] > 1 )
+				radixsort (keys, v + count[b-1], tmp, count[b] - count[b-1], depth + 1);
+		return;
+	}
+
+	for ( i = 1; i < n; i++ )
+	{
+		domsortent_t	e = v[i];
+
+		for ( j = i; j > 0 && keycmp (keys, &v[j-1], &e, depth) > 0; j-- )
+			v[j] = v[j-1];
+		v[j] = e;
+	}
+}
+
+/*****************************************************************
+**	domsort_sort (s)
+**	sort the entries of s by their keys; entries with equal keys
+**	keep the order in which they were added
+*****************************************************************/
+void	domsort_sort (domsort_t *s)
+{
+	domsortent_t	*tmp;
+	size_t	i;
+	size_t	j;
+
+	assert (s != NULL);
+	if ( s->n < 2 )
+		return;
+
+	if ( (tmp = malloc (s->n * sizeof (*tmp))) != NULL )
+	{
+		radixsort (s->keys, s->v, tmp, s->n, 0);
+		free (tmp);
+		return;
+	}
+
+	for ( i = 1; i < s->n; i++ )	/* out of memory: insertion sort in place */
+	{
+		domsortent_t	e = s->v[i];
+
+		for ( j = i; j > 0 && keycmp (s->keys, &s->v[j-1], &e, 0) > 0; j-- )
+			s->v[j] = s->v[j-1];
+		s->v[j] = e;
+	}
+}
+
+/*****************************************************************
+**	domsort_free (s)
+*****************************************************************/
+void	domsort_free (domsort_t *s)
+{
+	assert (s != NULL);
+
+	free (s->v);
+	free (s->keys);
+	memset (s, 0, sizeof (*s));
+}
+
 #ifdef DOMAINCMP_TEST
 static  struct {
          char    *a;
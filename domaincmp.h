@@ -36,8 +36,31 @@
 *****************************************************************/
 #ifndef DOMAINCMP_H
 # define DOMAINCMP_H
+
+/* sort keys and lists of domain names in canonical (domaincmp) order */
+# define	DOMKEY_MAXSIZE	(255+2)	/* max length of a domain name sort key */
+
+typedef	struct	{
+	size_t	off;		/* offset of the sort key in domsort_t.keys */
+	size_t	len;		/* length of the sort key */
+	void	*data;		/* the (list) element belonging to the key */
+} domsortent_t;
+
+typedef	struct	{
+	domsortent_t	*v;		/* array of entries */
+	size_t	n;
+	size_t	nalloc;
+	unsigned char	*keys;		/* all sort keys one after another */
+	size_t	klen;
+	size_t	kalloc;
+} domsort_t;
+
 extern	int	domaincmp (const char *a, const char *b);
 extern	int	domaincmp_dir (const char *a, const char *b, int subdomain_above);
 extern	int	isparentdomain (const char *child, const char *parent, int level);
 extern	int	issubdomain (const char *child, const char *parent);
+extern	int	domain_sortkey (const char *name, int subdomain_above, unsigned char *key, size_t size);
+extern	int	domsort_add (domsort_t *s, const char *name, int subdomain_above, const unsigned char *suffix, size_t slen, void *data);
+extern	void	domsort_sort (domsort_t *s);
+extern	void	domsort_free (domsort_t *s);
 #endif
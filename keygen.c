@@ -0,0 +1,677 @@
+/*****************************************************************
+**
+**	@(#) keygen.c -- in-process generation of DNSSEC keys (libcrypto)
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <unistd.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+# include "config_zkt.h"
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+# include <openssl/evp.h>
+# include <openssl/bn.h>
+# include <openssl/rsa.h>
+# include <openssl/ec.h>
+# include <openssl/core_names.h>
+# include <openssl/param_build.h>
+# include <openssl/err.h>
+#endif
+# include "debug.h"
+# include "misc.h"
+# include "dki.h"
+#define	extern
+# include "keygen.h"
+#undef	extern
+
+/*****************************************************************
+**	The key generator writes the key files in the same format
+**	as "dnssec-keygen -C" (BIND 9.7 compability mode), so the
+**	private key file contains no timing metadata:
+**
+**	K<name>+<alg>+<tag>.key
+**		; This is a key-signing key, keyid <tag>, for <name>
+**		<name> IN DNSKEY 257 3 <alg> <base64 public key>
+**
+**	K<name>+<alg>+<tag>.private (mode 0600)
+**		Private-key-format: v1.2
+**		Algorithm: <alg> (<algorithm name>)
+**		<field>: <base64 value>
+**		...
+**
+**	The key tag is computed as described in RFC 4034 Appendix B.
+**	There is no static state besides the error string, so keys
+**	could be generated by several processes in parallel.
+*****************************************************************/
+# define	KEYGEN_MAXTRY	8	/* max number of key tag collisions */
+# define	KEYGEN_MAXRSA	4096	/* max RSA modulus size in bits */
+# define	KEYGEN_MAXPUB	(3 + KEYGEN_MAXRSA / 8 + 4)	/* exponent + modulus */
+# define	KEYGEN_MAXB64	((KEYGEN_MAXPUB + 2) / 3 * 4 + 1)
+
+/*****************************************************************
+**	private (static) function declaration and definition
+*****************************************************************/
+static	char	keygen_estr[255+1];
+
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+static	const	char	*rsa_fields[][2] = {
+	{ "Modulus",		OSSL_PKEY_PARAM_RSA_N },
+	{ "PublicExponent",	OSSL_PKEY_PARAM_RSA_E },
+	{ "PrivateExponent",	OSSL_PKEY_PARAM_RSA_D },
+	{ "Prime1",		OSSL_PKEY_PARAM_RSA_FACTOR1 },
+	{ "Prime2",		OSSL_PKEY_PARAM_RSA_FACTOR2 },
+	{ "Exponent1",		OSSL_PKEY_PARAM_RSA_EXPONENT1 },
+	{ "Exponent2",		OSSL_PKEY_PARAM_RSA_EXPONENT2 },
+	{ "Coefficient",	OSSL_PKEY_PARAM_RSA_COEFFICIENT1 },
+	{ NULL,			NULL },
+};
+
+/*****************************************************************
+**	is_rsa (algo)
+*****************************************************************/
+static	int	is_rsa (int algo)
+{
+	return algo == DK_ALGO_RSASHA1 || algo == DK_ALGO_NSEC3RSASHA1 ||
+		algo == DK_ALGO_RSASHA256 || algo == DK_ALGO_RSASHA512;
+}
+
+/*****************************************************************
+**	ec_size (algo)
+**	return the size of a coordinate (and of the private key) in
+**	bytes of the ecdsa or eddsa algorithm, 0 for all other
+*****************************************************************/
+static	int	ec_size (int algo)
+{
+	switch ( algo )
+	{
+	case DK_ALGO_ECDSAP256SHA256:	return 32;
+	case DK_ALGO_ECDSAP384SHA384:	return 48;
+	case DK_ALGO_ED25519:		return 32;
+	case DK_ALGO_ED448:		return 57;
+	}
+	return 0;
+}
+
+/*****************************************************************
+**	sslerror (func)
+**	set the error string to the last libcrypto error
+*****************************************************************/
+static	int	sslerror (const char *func)
+{
+	char	buf[127+1];
+
+	ERR_error_string_n (ERR_get_error (), buf, sizeof (buf));
+	snprintf (keygen_estr, sizeof (keygen_estr), "keygen: %s: %s", func, buf);
+	ERR_clear_error ();
+
+	return -1;
+}
+
+/*****************************************************************
+**	genkey (algo, bits)
+**	generate a new key pair of the given algorithm
+*****************************************************************/
+static	EVP_PKEY	*genkey (int algo, int bits)
+{
+	EVP_PKEY_CTX	*ctx;
+	EVP_PKEY	*pkey;
+	int	ok;
+
+	switch ( algo )
+	{
+	case DK_ALGO_ECDSAP256SHA256:
+	case DK_ALGO_ECDSAP384SHA384:
+		ctx = EVP_PKEY_CTX_new_id (EVP_PKEY_EC, NULL);
+		break;
+	case DK_ALGO_ED25519:
+		ctx = EVP_PKEY_CTX_new_id (EVP_PKEY_ED25519, NULL);
+		break;
+	case DK_ALGO_ED448:
+		ctx = EVP_PKEY_CTX_new_id (EVP_PKEY_ED448, NULL);
+		break;
+	default:
+		ctx = EVP_PKEY_CTX_new_id (EVP_PKEY_RSA, NULL);
+	}
+	if ( ctx == NULL )
+	{
+		sslerror ("EVP_PKEY_CTX_new_id");
+		return NULL;
+	}
+
+	ok = EVP_PKEY_keygen_init (ctx) > 0;
+	if ( ok && is_rsa (algo) )
+		ok = EVP_PKEY_CTX_set_rsa_keygen_bits (ctx, bits) > 0;	/* exponent is 65537 */
+	else if ( ok && algo == DK_ALGO_ECDSAP256SHA256 )
+		ok = EVP_PKEY_CTX_set_ec_paramgen_curve_nid (ctx, NID_X9_62_prime256v1) > 0;
+	else if ( ok && algo == DK_ALGO_ECDSAP384SHA384 )
+		ok = EVP_PKEY_CTX_set_ec_paramgen_curve_nid (ctx, NID_secp384r1) > 0;
+
+	pkey = NULL;
+	if ( !ok || EVP_PKEY_keygen (ctx, &pkey) <= 0 )
+	{
+		sslerror ("EVP_PKEY_keygen");
+		pkey = NULL;
+	}
+	EVP_PKEY_CTX_free (ctx);
+
+	return pkey;
+}
+
+/*****************************************************************
+**	getbn (pkey, param, buf, size, pad)
+**	store the big number parameter 'param' of the key in buf
+**	(left padded with zeros up to 'pad' bytes if pad > 0)
+**	returns the number of bytes or -1 on error
+*****************************************************************/
+static	int	getbn (const EVP_PKEY *pkey, const char *param, unsigned char *buf, size_t size, int pad)
+{
+	BIGNUM	*bn;
+	int	len;
+
+	bn = NULL;
+	if ( EVP_PKEY_get_bn_param (pkey, param, &bn) <= 0 )
+		return sslerror (param);
+
+	len = BN_num_bytes (bn);
+	if ( pad > 0 )
+		len = ( len <= pad ) ? BN_bn2binpad (bn, buf, pad) : -1;
+	else if ( len <= size )
+		len = BN_bn2bin (bn, buf);
+	else
+		len = -1;
+	BN_clear_free (bn);
+
+	if ( len < 0 )
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: %s too large", param);
+	return len;
+}
+
+/*****************************************************************
+**	getpubkey (pkey, algo, buf, size)
+**	store the public key in DNSKEY wire format (RFC 3110,
+**	RFC 6605, RFC 8080) in buf
+**	returns the length of the public key or -1 on error
+*****************************************************************/
+static	int	getpubkey (const EVP_PKEY *pkey, int algo, unsigned char *buf, size_t size)
+{
+	unsigned char	e[16];
+	size_t	rawlen;
+	int	elen;
+	int	len;
+	int	n;
+
+	if ( (n = ec_size (algo)) > 0 && (algo == DK_ALGO_ED25519 || algo == DK_ALGO_ED448) )
+	{
+		rawlen = size;
+		if ( EVP_PKEY_get_raw_public_key (pkey, buf, &rawlen) <= 0 )
+			return sslerror ("EVP_PKEY_get_raw_public_key");
+		return rawlen;
+	}
+	if ( n > 0 )		/* ecdsa: x | y */
+	{
+		if ( 2 * n > size ||
+		     getbn (pkey, OSSL_PKEY_PARAM_EC_PUB_X, buf, size, n) < 0 ||
+		     getbn (pkey, OSSL_PKEY_PARAM_EC_PUB_Y, buf + n, size - n, n) < 0 )
+			return -1;
+		return 2 * n;
+	}
+
+	/* rsa: exponent length | exponent | modulus */
+	if ( (elen = getbn (pkey, OSSL_PKEY_PARAM_RSA_E, e, sizeof (e), 0)) < 0 )
+		return -1;
+	len = 0;
+	buf[len++] = elen;
+	memcpy (buf + len, e, elen);
+	len += elen;
+	if ( (n = getbn (pkey, OSSL_PKEY_PARAM_RSA_N, buf + len, size - len, 0)) < 0 )
+		return -1;
+
+	return len + n;
+}
+
+/*****************************************************************
+**	keytag (rdata, len)
+**	compute the key tag of the DNSKEY rdata (RFC 4034 Appendix B)
+*****************************************************************/
+static	uint	keytag (const unsigned char *rdata, size_t len)
+{
+	unsigned long	ac;
+	size_t	i;
+
+	ac = 0L;
+	for ( i = 0; i < len; i++ )
+		ac += (i & 1) ? rdata[i] : rdata[i] << 8;
+	ac += (ac >> 16) & 0xFFFF;
+
+	return ac & 0xFFFF;
+}
+
+/*****************************************************************
+**	b64 (buf, bin, len)
+**	base64 encode 'len' bytes of bin into buf
+*****************************************************************/
+static	char	*b64 (char *buf, const unsigned char *bin, int len)
+{
+	EVP_EncodeBlock ((unsigned char *)buf, bin, len);
+	return buf;
+}
+
+/*****************************************************************
+**	keyexist (dir, fname)
+**	check if there is a key file of any state
+*****************************************************************/
+static	int	keyexist (const char *dir, const char *fname)
+{
+	static	const	char	*ext[] = {
+		DKI_KEY_FILEEXT, DKI_ACT_FILEEXT, DKI_PUB_FILEEXT, DKI_DEP_FILEEXT, NULL
+	};
+	char	path[MAX_PATHSIZE+1];
+	int	i;
+
+	for ( i = 0; ext[i]; i++ )
+		if ( fileexist (pathname (path, sizeof (path), dir, fname, ext[i])) )
+			return 1;
+	return 0;
+}
+
+/*****************************************************************
+**	writeprivate (path, pkey, algo)
+**	write the private key file (the file must not exist)
+**	returns 0 on success, 1 if the file exist, -1 on error
+*****************************************************************/
+static	int	writeprivate (const char *path, const EVP_PKEY *pkey, int algo)
+{
+	unsigned char	bin[KEYGEN_MAXRSA/8+1];
+	char	buf[KEYGEN_MAXB64];
+	FILE	*fp;
+	size_t	rawlen;
+	int	fd;
+	int	len;
+	int	i;
+
+	if ( (fd = open (path, O_WRONLY|O_CREAT|O_EXCL, 0600)) < 0 )
+	{
+		if ( errno == EEXIST )
+			return 1;
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: can't create private key file: %s", strerror (errno));
+		return -1;
+	}
+	if ( (fp = fdopen (fd, "w")) == NULL )
+	{
+		close (fd);
+		unlink (path);
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: %s", strerror (errno));
+		return -1;
+	}
+
+	fprintf (fp, "Private-key-format: v1.2\n");
+	fprintf (fp, "Algorithm: %d (%s)\n", algo, dki_algo2str (algo));
+
+	len = 0;
+	if ( is_rsa (algo) )
+	{
+		for ( i = 0; len >= 0 && rsa_fields[i][0]; i++ )
+			if ( (len = getbn (pkey, rsa_fields[i][1], bin, sizeof (bin), 0)) >= 0 )
+				fprintf (fp, "%s: %s\n", rsa_fields[i][0], b64 (buf, bin, len));
+	}
+	else if ( algo == DK_ALGO_ED25519 || algo == DK_ALGO_ED448 )
+	{
+		rawlen = sizeof (bin);
+		if ( EVP_PKEY_get_raw_private_key (pkey, bin, &rawlen) <= 0 )
+			len = sslerror ("EVP_PKEY_get_raw_private_key");
+		else
+			fprintf (fp, "PrivateKey: %s\n", b64 (buf, bin, rawlen));
+	}
+	else if ( (len = getbn (pkey, OSSL_PKEY_PARAM_PRIV_KEY, bin, sizeof (bin), ec_size (algo))) >= 0 )
+		fprintf (fp, "PrivateKey: %s\n", b64 (buf, bin, len));
+
+	OPENSSL_cleanse (bin, sizeof (bin));
+	OPENSSL_cleanse (buf, sizeof (buf));
+
+	if ( fclose (fp) != 0 && len >= 0 )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: write error: %s", strerror (errno));
+		len = -1;
+	}
+	if ( len < 0 )
+	{
+		unlink (path);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*****************************************************************
+**	writepublic (path, owner, flags, algo, b64pub)
+**	write the public key file
+*****************************************************************/
+static	int	writepublic (const char *path, const char *owner, int flags, int algo, uint tag, const char *b64pub)
+{
+	FILE	*fp;
+
+	if ( (fp = fopen (path, "w")) == NULL )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: can't create public key file: %s", strerror (errno));
+		return -1;
+	}
+
+	fprintf (fp, "; This is a %s key, keyid %u, for %s\n",
+			(flags & DK_FLAG_KSK) ? "key-signing": "zone-signing", tag, owner);
+	fprintf (fp, "%s IN DNSKEY %d %d %d %s\n", owner, flags, DK_PROTO_DNS, algo, b64pub);
+
+	if ( fclose (fp) != 0 )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: write error: %s", strerror (errno));
+		unlink (path);
+		return -1;
+	}
+
+	return 0;
+}
+/*****************************************************************
+**	unb64 (bin, size, str)
+**	decode the base64 string str into bin
+**	returns the number of bytes or -1 on error
+*****************************************************************/
+static	int	unb64 (unsigned char *bin, size_t size, const char *str)
+{
+	int	len;
+	int	pad;
+
+	len = strlen (str);
+	if ( len == 0 || len % 4 != 0 || len / 4 * 3 > size )
+		return -1;
+	for ( pad = 0; pad < 2 && str[len-1-pad] == '='; pad++ )
+		;
+	if ( (len = EVP_DecodeBlock (bin, (const unsigned char *)str, len)) < 0 )
+		return -1;
+
+	return len - pad;
+}
+
+/*****************************************************************
+**	readprivate (path, algo)
+**	read the private key file and return the key
+*****************************************************************/
+static	EVP_PKEY	*readprivate (const char *path, int algo)
+{
+	unsigned char	bin[KEYGEN_MAXRSA/8+1];
+	char	line[KEYGEN_MAXB64+64];
+	char	*val;
+	OSSL_PARAM_BLD	*bld;
+	OSSL_PARAM	*params;
+	EVP_PKEY_CTX	*ctx;
+	EVP_PKEY	*pkey;
+	BIGNUM	*bn[sizeof (rsa_fields) / sizeof (rsa_fields[0])];
+	FILE	*fp;
+	int	len;
+	int	n;
+	int	i;
+
+	if ( (fp = fopen (path, "r")) == NULL )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: can't open private key file: %s", strerror (errno));
+		return NULL;
+	}
+
+	memset (bn, 0, sizeof (bn));
+	pkey = NULL;
+	n = 0;
+	while ( fgets (line, sizeof (line), fp) != NULL )
+	{
+		str_chop (line, '\n');
+		if ( (val = strchr (line, ':')) == NULL )
+			continue;
+		*val++ = '\0';
+		while ( *val == ' ' )
+			val++;
+
+		if ( is_rsa (algo) )
+		{
+			for ( i = 0; rsa_fields[i][0]; i++ )
+				if ( strcmp (line, rsa_fields[i][0]) == 0 && bn[i] == NULL &&
+				     (len = unb64 (bin, sizeof (bin), val)) > 0 &&
+				     (bn[i] = BN_bin2bn (bin, len, NULL)) != NULL )
+					n++;
+		}
+		else if ( strcmp (line, "PrivateKey") == 0 && pkey == NULL &&
+			  (len = unb64 (bin, sizeof (bin), val)) == ec_size (algo) )
+		{
+			if ( algo == DK_ALGO_ED25519 || algo == DK_ALGO_ED448 )
+				pkey = EVP_PKEY_new_raw_private_key (algo == DK_ALGO_ED25519 ?
+						EVP_PKEY_ED25519: EVP_PKEY_ED448, NULL, bin, len);
+			else if ( (bn[0] = BN_bin2bn (bin, len, NULL)) != NULL )
+				n++;
+		}
+	}
+	fclose (fp);
+	OPENSSL_cleanse (bin, sizeof (bin));
+	OPENSSL_cleanse (line, sizeof (line));
+
+	if ( pkey == NULL && n > 0 && (bld = OSSL_PARAM_BLD_new ()) != NULL )
+	{
+		if ( is_rsa (algo) )
+		{
+			for ( i = 0; rsa_fields[i][0]; i++ )
+				if ( bn[i] )
+					OSSL_PARAM_BLD_push_BN (bld, rsa_fields[i][1], bn[i]);
+		}
+		else
+		{
+			OSSL_PARAM_BLD_push_utf8_string (bld, OSSL_PKEY_PARAM_GROUP_NAME,
+				algo == DK_ALGO_ECDSAP256SHA256 ? "prime256v1": "secp384r1", 0);
+			OSSL_PARAM_BLD_push_BN (bld, OSSL_PKEY_PARAM_PRIV_KEY, bn[0]);
+		}
+		params = OSSL_PARAM_BLD_to_param (bld);
+		ctx = EVP_PKEY_CTX_new_from_name (NULL, is_rsa (algo) ? "RSA": "EC", NULL);
+		if ( params == NULL || ctx == NULL || EVP_PKEY_fromdata_init (ctx) <= 0 ||
+		     EVP_PKEY_fromdata (ctx, &pkey, EVP_PKEY_KEYPAIR, params) <= 0 )
+			pkey = NULL;
+		EVP_PKEY_CTX_free (ctx);
+		OSSL_PARAM_free (params);
+		OSSL_PARAM_BLD_free (bld);
+	}
+	for ( i = 0; i < sizeof (bn) / sizeof (bn[0]); i++ )
+		BN_clear_free (bn[i]);
+
+	if ( pkey == NULL )
+	{
+		if ( ERR_peek_error () )
+			sslerror ("readprivate");
+		else
+			snprintf (keygen_estr, sizeof (keygen_estr), "keygen: invalid private key file");
+	}
+
+	return pkey;
+}
+#endif
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	keygen_geterrstr ()
+*****************************************************************/
+const	char	*keygen_geterrstr ()
+{
+	return keygen_estr;
+}
+
+/*****************************************************************
+**	keygen_supported (algo, bits)
+**	returns 1 if a key of the given algorithm and size could be
+**	generated in-process
+*****************************************************************/
+int	keygen_supported (int algo, int bits)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	if ( is_rsa (algo) )
+		return bits >= 512 && bits <= KEYGEN_MAXRSA;
+	return ec_size (algo) > 0;
+#else
+	return 0;
+#endif
+}
+
+/*****************************************************************
+**	keygen (dir, name, ksk, algo, bits, fname, fsize)
+**	generate a new key for domain 'name' in directory 'dir'
+**	and store the file name of the key (without extension)
+**	in fname.
+**	returns 0 on success, -1 on error
+*****************************************************************/
+int	keygen (const char *dir, const char *name, int ksk, int algo, int bits, char *fname, size_t fsize)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	unsigned char	rdata[4+KEYGEN_MAXPUB];
+	char	b64pub[KEYGEN_MAXB64];
+	char	owner[MAX_LABELSIZE+1];
+	char	path[MAX_PATHSIZE+1];
+	EVP_PKEY	*pkey;
+	int	flags;
+	int	len;
+	int	try;
+	int	ret;
+	uint	tag;
+
+	assert (name != NULL && *name);
+	assert (fname != NULL);
+
+	keygen_estr[0] = '\0';
+	if ( !keygen_supported (algo, bits) )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: algorithm %s with %d bits not supported",
+								dki_algo2str (algo), bits);
+		return -1;
+	}
+
+	len = strlen (name);
+	if ( len + 2 > sizeof (owner) )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: domain name too long");
+		return -1;
+	}
+	snprintf (owner, sizeof (owner), "%s%s", name, name[len-1] == '.' ? "": ".");
+
+	flags = DK_FLAG_ZONE;
+	if ( ksk )
+		flags |= DK_FLAG_KSK;
+
+	for ( try = 0; try < KEYGEN_MAXTRY; try++ )
+	{
+		if ( (pkey = genkey (algo, bits)) == NULL )
+			return -1;
+
+		rdata[0] = (flags >> 8) & 0xFF;
+		rdata[1] = flags & 0xFF;
+		rdata[2] = DK_PROTO_DNS;
+		rdata[3] = algo;
+		if ( (len = getpubkey (pkey, algo, rdata + 4, sizeof (rdata) - 4)) < 0 )
+		{
+			EVP_PKEY_free (pkey);
+			return -1;
+		}
+		tag = keytag (rdata, 4 + len);
+
+		snprintf (fname, fsize, "K%s+%03d+%05u", owner, algo, tag);
+		ret = 1;
+		if ( !keyexist (dir, fname) )		/* avoid key tag collisions */
+		{
+			rdata[1] |= DK_FLAG_REVOKE;	/* ... also with the revoked key */
+			snprintf (path, sizeof (path), "K%s+%03d+%05u", owner, algo, keytag (rdata, 4 + len));
+			if ( !ksk || !keyexist (dir, path) )
+				ret = writeprivate (pathname (path, sizeof (path), dir, fname, DKI_ACT_FILEEXT), pkey, algo);
+		}
+		EVP_PKEY_free (pkey);
+
+		if ( ret < 0 )
+			return -1;
+		if ( ret == 0 )
+			break;
+		dbg_val1 ("keygen: key tag %u already in use\n", tag);
+	}
+	if ( try >= KEYGEN_MAXTRY )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: no unused key tag found");
+		return -1;
+	}
+
+	b64 (b64pub, rdata + 4, len);
+	if ( writepublic (pathname (path, sizeof (path), dir, fname, DKI_KEY_FILEEXT), owner, flags, algo, tag, b64pub) < 0 )
+	{
+		unlink (pathname (path, sizeof (path), dir, fname, DKI_ACT_FILEEXT));
+		return -1;
+	}
+
+	return 0;
+#else
+	snprintf (keygen_estr, sizeof (keygen_estr), "keygen: compiled without libcrypto");
+	return -1;
+#endif
+}
+
+/*****************************************************************
+**	keygen_load (dir, fname, algo)
+**	read the private key file 'fname' of algorithm 'algo' in
+**	directory 'dir' (as written by keygen() or dnssec-keygen)
+**	returns the key (to be freed with EVP_PKEY_free()) or NULL
+*****************************************************************/
+struct	evp_pkey_st	*keygen_load (const char *dir, const char *fname, int algo)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	char	path[MAX_PATHSIZE+1];
+
+	keygen_estr[0] = '\0';
+	if ( !is_rsa (algo) && ec_size (algo) == 0 )
+	{
+		snprintf (keygen_estr, sizeof (keygen_estr), "keygen: algorithm %s not supported", dki_algo2str (algo));
+		return NULL;
+	}
+
+	return readprivate (pathname (path, sizeof (path), dir, fname, DKI_ACT_FILEEXT), algo);
+#else
+	snprintf (keygen_estr, sizeof (keygen_estr), "keygen: compiled without libcrypto");
+	return NULL;
+#endif
+}
@@ -0,0 +1,369 @@
+/*****************************************************************
+**
+**	@(#) keypool.c -- pool of pre-generated DNSSEC keys
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <unistd.h>
+# include <errno.h>
+# include <dirent.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+# include "config_zkt.h"
+# include "debug.h"
+# include "misc.h"
+# include "zconf.h"
+# include "dki.h"
+# include "log.h"
+#define	extern
+# include "keypool.h"
+#undef	extern
+
+/*****************************************************************
+**	The key pool is a directory with one spool directory per
+**	key profile (algorithm, key size, ksk or zsk) named like
+**	"008-2048-ksk". Each spool directory contains keys generated
+**	for the owner name KEYPOOL_OWNER.
+**	Keys are generated in the subdirectory KEYPOOL_TMPDIR, and
+**	moved to the spool directory afterwards (".key" file first),
+**	so a ".private" file in the spool directory always denotes a
+**	complete key.
+**	A key is claimed by renaming the ".private" file into the
+**	zone directory, which is an atomic operation, so the pool
+**	could be filled and used by more than one process.
+**	The key pool and the zone directories have to be on the same
+**	file system.
+*****************************************************************/
+# define	KEYPOOL_OWNER	"keypool.zkt."	/* owner name of pre-generated keys */
+# define	KEYPOOL_TMPDIR	".tmp"
+
+/*****************************************************************
+**	private (static) function declaration and definition
+*****************************************************************/
+static	char	keypool_estr[255+1];
+static	int	keypool_claims;		/* number of keys taken out of the pool */
+static	int	keypool_misses;		/* number of keys not found in the pool */
+static	double	keypool_claimtime;	/* sum of claim latency (in ms) */
+
+/*****************************************************************
+**	profiledir ()
+**	build the path of the spool directory of the key profile
+*****************************************************************/
+static	char	*profiledir (char *path, size_t size, const char *pooldir, int ksk, int algo, int bits)
+{
+	char	profile[31+1];
+
+	snprintf (profile, sizeof (profile), "%03d-%d-%s", algo, bits, ksk ? "ksk": "zsk");
+	return pathname (path, size, pooldir, profile, NULL);
+}
+
+/*****************************************************************
+**	makedir ()
+*****************************************************************/
+static	int	makedir (const char *path)
+{
+	if ( mkdir (path, 0700) == 0 || errno == EEXIST )
+		return 0;
+
+	snprintf (keypool_estr, sizeof (keypool_estr),
+			"keypool: can't create directory: %s", strerror (errno));
+	return -1;
+}
+
+/*****************************************************************
+**	is_poolkey ()
+**	check if name is the ".private" file of a pool key
+*****************************************************************/
+static	int	is_poolkey (const char *name)
+{
+	size_t	len;
+
+	if ( strncmp (name, "K" KEYPOOL_OWNER "+", 1 + strlen (KEYPOOL_OWNER) + 1) != 0 )
+		return 0;
+	len = strlen (name);
+	return len > strlen (DKI_ACT_FILEEXT) &&
+		strcmp (name + len - strlen (DKI_ACT_FILEEXT), DKI_ACT_FILEEXT) == 0;
+}
+
+/*****************************************************************
+**	movekey ()
+**	move the key files of key 'fname' from dir 'from' to 'to'
+*****************************************************************/
+static	int	movekey (const char *from, const char *to, const char *fname)
+{
+	char	frompath[MAX_PATHSIZE+1];
+	char	topath[MAX_PATHSIZE+1];
+
+	pathname (frompath, sizeof (frompath), from, fname, DKI_KEY_FILEEXT);
+	pathname (topath, sizeof (topath), to, fname, DKI_KEY_FILEEXT);
+	if ( rename (frompath, topath) < 0 )
+		return -1;
+
+	pathname (frompath, sizeof (frompath), from, fname, DKI_ACT_FILEEXT);
+	pathname (topath, sizeof (topath), to, fname, DKI_ACT_FILEEXT);
+	return rename (frompath, topath);
+}
+
+/*****************************************************************
+**	writekey ()
+**	copy the public key file 'from' to 'to' and replace the
+**	owner name by 'domain'. All comments are removed.
+*****************************************************************/
+static	int	writekey (const char *from, const char *to, const char *domain, int tag, int ksk)
+{
+	FILE	*infp;
+	FILE	*outfp;
+	char	buf[4095+1];
+	const	char	*p;
+
+	if ( (infp = fopen (from, "r")) == NULL )
+		return -1;
+	if ( (outfp = fopen (to, "w")) == NULL )
+	{
+		fclose (infp);
+		return -1;
+	}
+
+	fprintf (outfp, "; This is a %s-signing key, keyid %d, for %s\n", ksk ? "key": "zone", tag, domain);
+	while ( fgets (buf, sizeof (buf), infp) )
+	{
+		if ( buf[0] == ';' || buf[0] == '\n' )
+			continue;
+		for ( p = buf; *p && *p != ' ' && *p != '\t'; p++ )	/* skip owner name */
+			;
+		fprintf (outfp, "%s%s", domain, p);
+	}
+	fclose (infp);
+
+	return fclose (outfp) == 0 ? 0 : -1;
+}
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	keypool_geterrstr ()
+**	return error string 
+*****************************************************************/
+const	char	*keypool_geterrstr ()
+{
+	return keypool_estr;
+}
+
+/*****************************************************************
+**	keypool_depth ()
+**	return the number of keys in the pool for the given profile
+*****************************************************************/
+int	keypool_depth (const char *pooldir, int ksk, int algo, int bits)
+{
+	char	path[MAX_PATHSIZE+1];
+	DIR	*dirp;
+	struct	dirent	*dentp;
+	int	depth;
+
+	assert (pooldir != NULL);
+
+	profiledir (path, sizeof (path), pooldir, ksk, algo, bits);
+	if ( (dirp = opendir (path)) == NULL )
+		return 0;
+
+	depth = 0;
+	while ( (dentp = readdir (dirp)) != NULL )
+		if ( is_poolkey (dentp->d_name) )
+			depth++;
+	closedir (dirp);
+
+	return depth;
+}
+
+/*****************************************************************
+**	keypool_fill ()
+**	generate keys for the given profile until the number of keys
+**	in the pool reaches watermark
+**	return the number of generated keys or -1 on error
+*****************************************************************/
+int	keypool_fill (const char *pooldir, int ksk, int algo, int bits, const char *rfile, int watermark)
+{
+	char	dir[MAX_PATHSIZE+1];
+	char	tmpdir[MAX_PATHSIZE+1];
+	dki_t	*dkp;
+	int	depth;
+	int	cnt;
+
+	assert (pooldir != NULL && *pooldir != '\0');
+
+	profiledir (dir, sizeof (dir), pooldir, ksk, algo, bits);
+	pathname (tmpdir, sizeof (tmpdir), dir, KEYPOOL_TMPDIR, NULL);
+	if ( makedir (pooldir) < 0 || makedir (dir) < 0 || makedir (tmpdir) < 0 )
+		return -1;
+
+	cnt = 0;
+	for ( depth = keypool_depth (pooldir, ksk, algo, bits); depth < watermark; depth++ )
+	{
+		if ( (dkp = dki_new (tmpdir, KEYPOOL_OWNER, ksk, algo, bits, rfile, 0)) == NULL )
+		{
+			snprintf (keypool_estr, sizeof (keypool_estr),
+					"keypool_fill: %s", dki_geterrstr ());
+			return -1;
+		}
+		if ( movekey (tmpdir, dir, dkp->fname) < 0 )
+		{
+			snprintf (keypool_estr, sizeof (keypool_estr),
+					"keypool_fill: can't move key %d into pool: %s", dkp->tag, strerror (errno));
+			dki_free (dkp);
+			return -1;
+		}
+		dki_free (dkp);
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/*****************************************************************
+**	keypool_claim ()
+**	take a key of the given profile out of the pool, move it into
+**	the zone directory 'dir' and change the owner name to 'domain'
+**	return the key or NULL if the pool is empty
+*****************************************************************/
+dki_t	*keypool_claim (const char *pooldir, const char *dir, const char *domain, int ksk, int algo, int bits, int lf_days)
+{
+	char	pdir[MAX_PATHSIZE+1];
+	char	frompath[MAX_PATHSIZE+1];
+	char	topath[MAX_PATHSIZE+1];
+	char	keyname[MAX_FNAMESIZE+1];
+	char	poolname[MAX_FNAMESIZE+1];
+	struct	timeval	start;
+	struct	timeval	end;
+	struct	dirent	*dentp;
+	const	char	*dot;
+	DIR	*dirp;
+	dki_t	*dkp;
+	int	alg;
+	int	tag;
+
+	assert (pooldir != NULL);
+	assert (domain != NULL && *domain != '\0');
+
+	if ( dir == NULL || *dir == '\0' )
+		dir = ".";
+	dot = domain[strlen (domain) - 1] == '.' ? "": ".";
+
+	gettimeofday (&start, NULL);
+	profiledir (pdir, sizeof (pdir), pooldir, ksk, algo, bits);
+	if ( (dirp = opendir (pdir)) == NULL )
+	{
+		keypool_misses++;
+		return NULL;
+	}
+
+	dkp = NULL;
+	while ( dkp == NULL && (dentp = readdir (dirp)) != NULL )
+	{
+		if ( !is_poolkey (dentp->d_name) )
+			continue;
+
+		/* "Kkeypool.zkt.+008+12345.private" */
+		snprintf (poolname, sizeof (poolname), "%.*s", (int)(strlen (dentp->d_name) - strlen (DKI_ACT_FILEEXT)), dentp->d_name);
+		if ( sscanf (poolname + 1 + strlen (KEYPOOL_OWNER), "+%d+%d", &alg, &tag) != 2 )
+			continue;
+		snprintf (keyname, sizeof (keyname), "K%s%s+%03d+%05d", domain, dot, alg, tag);
+
+		pathname (topath, sizeof (topath), dir, keyname, DKI_KEY_FILEEXT);
+		if ( fileexist (topath) )	/* key tag already in use in this zone */
+			continue;
+
+		/* claim the key by moving the private key into the zone directory */
+		pathname (frompath, sizeof (frompath), pdir, poolname, DKI_ACT_FILEEXT);
+		pathname (topath, sizeof (topath), dir, keyname, DKI_ACT_FILEEXT);
+		if ( rename (frompath, topath) < 0 )
+		{
+			if ( errno == ENOENT )		/* already claimed by someone else */
+				continue;
+			lg_mesg (LG_ERROR, "keypool: can't move key %d out of pool: %s", tag, strerror (errno));
+			break;
+		}
+		touch (topath, 0);
+
+		pathname (frompath, sizeof (frompath), pdir, poolname, DKI_KEY_FILEEXT);
+		pathname (topath, sizeof (topath), dir, keyname, DKI_KEY_FILEEXT);
+		if ( writekey (frompath, topath, domain, tag, ksk) < 0 )
+		{
+			lg_mesg (LG_ERROR, "keypool: can't write key file %s", topath);
+			unlink (topath);
+			pathname (topath, sizeof (topath), dir, keyname, DKI_ACT_FILEEXT);
+			unlink (topath);
+			continue;
+		}
+		unlink (frompath);
+
+		if ( (dkp = dki_read (dir, keyname)) != NULL )
+			dki_setlifetime (dkp, lf_days);	/* sets gentime + proposed lifetime */
+	}
+	closedir (dirp);
+
+	if ( dkp == NULL )
+	{
+		keypool_misses++;
+		return NULL;
+	}
+
+	gettimeofday (&end, NULL);
+	keypool_claims++;
+	keypool_claimtime += (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+
+	return dkp;
+}
+
+/*****************************************************************
+**	keypool_report ()
+**	log the number of claimed keys and the average claim latency
+*****************************************************************/
+void	keypool_report ()
+{
+	if ( keypool_claims + keypool_misses == 0 )
+		return;
+
+	lg_mesg (LG_NOTICE, "key pool: %d key%s claimed (avg. %.1f ms), %d generated on demand",
+			keypool_claims, keypool_claims == 1 ? "": "s",
+			keypool_claims ? keypool_claimtime / keypool_claims : 0.0, keypool_misses);
+}
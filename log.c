@@ -50,6 +50,11 @@
 # include <config.h>
 #endif
 # include "config_zkt.h"
+#if LOG_ASYNC && defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD && defined(__ATOMIC_ACQUIRE)
+# define	LG_RING	1
+# include <pthread.h>
+# include <sched.h>
+#endif
 # include "misc.h"
 # include "debug.h"
 #define extern
@@ -60,12 +65,72 @@
 **	module internal vars & declarations
 *****************************************************************/
 static	FILE	*lg_fp;
-static	FILE	*lg_fpsave;
 static	int	lg_minfilelevel;
 static	int	lg_syslogging;
 static	int	lg_minsyslevel;
 static	long	lg_errcnt;
+static	long	lg_dropcnt;
 static	const char	*lg_progname;
+static	time_t	lg_tssec = -1;		/* second of the cached timestamp */
+static	char	lg_tsstr[79+1];		/* timestamp prefix of lg_tssec */
+static	int	lg_json;		/* write the log file in JSON format */
+static	char	lg_zonectx[255+1];	/* zone and view the messages belong to */
+static	char	lg_viewctx[63+1];
+
+# define	MAXFNAME	(1023)
+
+/*
+** Per zone log files (LogDomainDir) are opened on the first message
+** of the zone, and kept open in a small LRU cache of LOG_ZONEFILES
+** entries, so a zone without any message costs no open() and close().
+*/
+typedef	struct {
+	FILE	*fp;
+	unsigned long	used;		/* time of the last use (lg_fdclock) */
+	char	name[MAXFNAME+1];
+} lg_fdcache_t;
+
+static	lg_fdcache_t	lg_fdcache[LOG_ZONEFILES];
+static	unsigned long	lg_fdclock;
+static	int	lg_zonelog;		/* a zone log file is selected by lg_zone_start() */
+static	char	lg_zonefile[MAXFNAME+1];
+static	FILE	*lg_zonefp;		/* lg_zonefile, if already opened */
+static	int	lg_zonefailed;		/* lg_zonefile could not be opened */
+
+# define	LG_MSGSIZE	(1023+1)	/* max length of a message */
+# define	LG_FIELDSIZE	(511+1)		/* max length of the JSON fields of a message */
+# define	LG_LINESIZE	(6 * LG_MSGSIZE + LG_FIELDSIZE + 256)	/* escaped message + fields + prefix */
+
+#if defined(LG_RING) && LG_RING
+/*
+** The messages are passed to a writer thread by a ring buffer of
+** LG_RINGSIZE slots. Producers reserve a slot by advancing lg_head,
+** and mark the slot as ready by setting its sequence number to the
+** reserved position + 1. The slots are drained in order by the one
+** thread holding lg_drainlock, which is normally the writer thread.
+*/
+# define	LG_RINGSIZE	256	/* power of 2 */
+# define	LG_RETRIES	100	/* tries to get a slot before a message is dropped */
+
+typedef	struct {
+	unsigned long	seq;
+	struct	timeval	tv;
+	int	priority;
+	char	msg[LG_MSGSIZE];
+	char	fields[LG_FIELDSIZE];
+} lg_slot_t;
+
+static	lg_slot_t	*lg_ring;
+static	unsigned long	lg_head;		/* next slot to reserve */
+static	unsigned long	lg_tail;		/* next slot to drain */
+static	long	lg_dropreported;
+static	int	lg_async;		/* writer thread is running */
+static	int	lg_stop;
+static	pthread_t	lg_tid;
+static	pthread_mutex_t	lg_drainlock = PTHREAD_MUTEX_INITIALIZER;
+static	pthread_mutex_t	lg_waitlock = PTHREAD_MUTEX_INITIALIZER;
+static	pthread_cond_t	lg_wakeup = PTHREAD_COND_INITIALIZER;
+#endif
 
 typedef	struct {
 	lg_lvl_t	level;
@@ -95,7 +160,6 @@ static	lg_symtbl_t	symtbl[] = {
 	{ LG_NONE,	NULL,		-1 }
 };
 
-# define	MAXFNAME	(1023)
 /*****************************************************************
 **	function definitions (for function declarations see log.h)
 *****************************************************************/
@@ -149,6 +213,417 @@ static	FILE	*lg_fileopen (const char *path, const char *name)
 	return fp;
 }
 
+/*****************************************************************
+**	lg_zonefileptr () -- get the log file of the current zone
+**	out of the cache or open it. Has to be called with the
+**	channels locked (lg_lock() or by the writer thread).
+**	returns the file pointer or the one of the main log file
+**	if the zone log file could not be opened
+*****************************************************************/
+static	FILE	*lg_zonefileptr (void)
+{
+	lg_fdcache_t	*e;
+	lg_fdcache_t	*lru;
+
+	if ( lg_zonefp || lg_zonefailed )
+		return lg_zonefp ? lg_zonefp : lg_fp;
+
+	lru = &lg_fdcache[0];
+	for ( e = lg_fdcache; e < &lg_fdcache[LOG_ZONEFILES]; e++ )
+	{
+		if ( e->fp && strcmp (e->name, lg_zonefile) == 0 )
+		{
+			e->used = ++lg_fdclock;
+			return lg_zonefp = e->fp;
+		}
+		if ( e->used < lru->used )	/* free entries are never used */
+			lru = e;
+	}
+
+	if ( lru->fp )
+		fclose (lru->fp);
+	lru->used = 0;
+	if ( (lru->fp = fopen (lg_zonefile, "a")) == NULL )
+	{
+		lg_zonefailed = 1;
+		return lg_fp;
+	}
+	snprintf (lru->name, sizeof (lru->name), "%s", lg_zonefile);
+	lru->used = ++lg_fdclock;
+
+	return lg_zonefp = lru->fp;
+}
+
+/*****************************************************************
+**	lg_jsonstr (buf, size, str) -- write str as JSON string
+**	(with quotes) to buf
+**	returns the length or -1 if it does not fit into buf
+*****************************************************************/
+static	int	lg_jsonstr (char *buf, size_t size, const char *str)
+{
+	static	const	char	hex[] = "0123456789abcdef";
+	size_t	len;
+	unsigned char	c;
+
+	len = 0;
+	if ( size < 3 )
+		return -1;
+	buf[len++] = '"';
+	for ( ; (c = (unsigned char)*str) != '\0'; str++ )
+	{
+		if ( len + 7 >= size )		/* room for "\u00XX and the closing quote */
+			return -1;
+		if ( c == '"' || c == '\\' )
+		{
+			buf[len++] = '\\';
+			buf[len++] = c;
+		}
+		else if ( c == '\n' )
+		{
+			buf[len++] = '\\';
+			buf[len++] = 'n';
+		}
+		else if ( c == '\t' )
+		{
+			buf[len++] = '\\';
+			buf[len++] = 't';
+		}
+		else if ( c < 0x20 || c == 0x7f )
+		{
+			memcpy (buf + len, "\\u00", 4);
+			len += 4;
+			buf[len++] = hex[c >> 4];
+			buf[len++] = hex[c & 0xf];
+		}
+		else
+			buf[len++] = c;
+	}
+	buf[len++] = '"';
+	buf[len] = '\0';
+
+	return len;
+}
+
+/*****************************************************************
+**	lg_jsonfield (buf, len, size, key, str) -- append the field
+**	"key":str, to buf. If str is NULL, the (already formatted)
+**	value val is used.
+**	returns the new length of buf (the old one if it does not fit)
+*****************************************************************/
+static	size_t	lg_jsonfield (char *buf, size_t len, size_t size, const char *key, const char *str, const char *val)
+{
+	size_t	n;
+	int	l;
+
+	n = len;
+	if ( (l = lg_jsonstr (buf + n, size - n, key)) < 0 || (n += l) + 2 >= size )
+		return len;
+	buf[n++] = ':';
+	if ( str )
+	{
+		if ( (l = lg_jsonstr (buf + n, size - n, str)) < 0 )
+			return len;
+	}
+	else if ( (l = snprintf (buf + n, size - n, "%s", val)) < 0 || (size_t)l >= size - n )
+		return len;
+	if ( (n += l) + 1 >= size )
+		return len;
+	buf[n++] = ',';
+	buf[n] = '\0';
+
+	return n;
+}
+
+/*****************************************************************
+**	lg_haskey (fields, key) -- is key one of the fields ?
+*****************************************************************/
+static	int	lg_haskey (const char *fields, const char *key)
+{
+	const	char	*p;
+	size_t	len;
+
+	if ( fields == NULL )
+		return 0;
+	len = strlen (key);
+	for ( p = fields; (p = strstr (p, key)) != NULL; p++ )
+		if ( (p == fields || p[-1] == ' ') && p[len] == '=' )
+			return 1;
+	return 0;
+}
+
+/*****************************************************************
+**	lg_fields (buf, size, event, fields, ap) -- format the JSON
+**	fields of a message (see lg_event()) as a list of "key":value,
+**	returns the length of the list
+*****************************************************************/
+static	size_t	lg_fields (char *buf, size_t size, const char *event, const char *fields, va_list ap)
+{
+	char	key[31+1];
+	char	val[31+1];
+	const	char	*p;
+	const	char	*str;
+	size_t	len;
+	size_t	n;
+	int	lng;
+
+	len = 0;
+	buf[0] = '\0';
+	if ( event )
+		len = lg_jsonfield (buf, len, size, "event", event, NULL);
+	if ( lg_zonectx[0] && !lg_haskey (fields, "zone") )
+		len = lg_jsonfield (buf, len, size, "zone", lg_zonectx, NULL);
+	if ( lg_viewctx[0] && !lg_haskey (fields, "view") )
+		len = lg_jsonfield (buf, len, size, "view", lg_viewctx, NULL);
+
+	for ( p = fields; p && *p; )
+	{
+		while ( *p == ' ' )
+			p++;
+		for ( n = 0; *p && *p != '=' && *p != ' '; p++ )
+			if ( n < sizeof (key) - 1 )
+				key[n++] = *p;
+		key[n] = '\0';
+		if ( *p++ != '=' || *p++ != '%' )
+			break;			/* malformed field list */
+		if ( (lng = (*p == 'l')) )
+			p++;
+
+		str = NULL;
+		switch ( *p++ )
+		{
+		case 's':
+			if ( (str = va_arg (ap, const char *)) == NULL )
+				str = "";
+			break;
+		case 'd':
+			if ( lng )
+				snprintf (val, sizeof (val), "%ld", va_arg (ap, long));
+			else
+				snprintf (val, sizeof (val), "%d", va_arg (ap, int));
+			break;
+		case 'u':
+			if ( lng )
+				snprintf (val, sizeof (val), "%lu", va_arg (ap, unsigned long));
+			else
+				snprintf (val, sizeof (val), "%u", va_arg (ap, unsigned));
+			break;
+		default:
+			return len;		/* unknown conversion: the arguments are out of sync */
+		}
+		if ( key[0] != '_' )		/* "_" is an argument of the message only */
+			len = lg_jsonfield (buf, len, size, key, str, val);
+	}
+
+	return len;
+}
+
+/*****************************************************************
+**	lg_write (priority, tv, mesg, fields) -- write a formatted
+**	message to syslog and the log file
+*****************************************************************/
+static	void	lg_write (int priority, const struct timeval *tv, const char *mesg, const char *fields)
+{
+	char	line[LG_LINESIZE];
+	struct	tm	t;
+	FILE	*fp;
+	size_t	len;
+	int	l;
+
+	if ( lg_syslogging && priority >= lg_minsyslevel )
+	{
+#if defined (LOG_WITH_LEVEL) && LOG_WITH_LEVEL
+		syslog (lg_lvl2syslog (priority), "%s: %s", lg_lvl2str (priority), mesg);
+#else
+		syslog (lg_lvl2syslog (priority), "%s", mesg);
+#endif
+	}
+
+	if ( priority < lg_minfilelevel )
+		return;
+	fp = lg_zonelog ? lg_zonefileptr () : lg_fp;
+	if ( fp == NULL )
+		return;
+
+	if ( tv->tv_sec != lg_tssec )	/* the date and time is the same for one second */
+	{
+		lg_tssec = tv->tv_sec;
+		localtime_r (&lg_tssec, &t);	/* the main thread may use localtime() */
+		snprintf (lg_tsstr, sizeof (lg_tsstr), "%04d-%02d-%02d %02d:%02d:%02d",
+			t.tm_year+1900, t.tm_mon+1, t.tm_mday,
+			t.tm_hour, t.tm_min, t.tm_sec);
+	}
+
+	len = 0;
+	if ( lg_json )	/* {"time":...,"level":...,"prog":...,<fields>"msg":...} */
+	{
+		len = snprintf (line, sizeof (line), "{\"time\":\"%.10sT%s.%03d\",\"level\":\"%s\",",
+				lg_tsstr, lg_tsstr + 11, (int)(tv->tv_usec / 1000), lg_lvl2str (priority));
+		if ( lg_progname )
+			len = lg_jsonfield (line, len, sizeof (line), "prog", lg_progname, NULL);
+		if ( fields && *fields && len + strlen (fields) < sizeof (line) )
+		{
+			memcpy (line + len, fields, strlen (fields));
+			len += strlen (fields);
+		}
+		memcpy (line + len, "\"msg\":", 6);
+		len += 6;
+		if ( (l = lg_jsonstr (line + len, sizeof (line) - len - 2, mesg)) < 0 )
+			l = lg_jsonstr (line + len, sizeof (line) - len - 2, "");
+		len += l;
+		line[len++] = '}';
+	}
+	else
+	{
+#if defined (LOG_WITH_TIMESTAMP) && LOG_WITH_TIMESTAMP
+		len += snprintf (line + len, sizeof (line) - len, "%s.%03d: ", lg_tsstr, (int)(tv->tv_usec / 1000));
+#endif
+#if defined (LOG_WITH_PROGNAME) && LOG_WITH_PROGNAME
+		if ( lg_progname )
+			len += snprintf (line + len, sizeof (line) - len, "%s: ", lg_progname);
+#endif
+#if defined (LOG_WITH_LEVEL) && LOG_WITH_LEVEL
+		len += snprintf (line + len, sizeof (line) - len, "%s: ", lg_lvl2str(priority));
+#endif
+		len += snprintf (line + len, sizeof (line) - len - 1, "%s", mesg);
+	}
+	line[len++] = '\n';
+	fwrite (line, 1, len, fp);
+}
+
+#if defined(LG_RING) && LG_RING
+/*****************************************************************
+**	lg_drain () -- write all messages of the ring buffer
+**	which are ready. Has to be called with lg_drainlock held.
+*****************************************************************/
+static	void	lg_drain (void)
+{
+	lg_slot_t	*slot;
+	struct	timeval	tv;
+	char	mesg[63+1];
+	long	dropped;
+
+	for ( ; ; )
+	{
+		slot = &lg_ring[lg_tail % LG_RINGSIZE];
+		if ( __atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) != lg_tail + 1 )	/* not yet written */
+			break;
+		lg_write (slot->priority, &slot->tv, slot->msg, slot->fields);
+		__atomic_store_n (&slot->seq, lg_tail + LG_RINGSIZE, __ATOMIC_RELEASE);	/* free for the next round */
+		__atomic_store_n (&lg_tail, lg_tail + 1, __ATOMIC_RELAXED);
+	}
+
+	if ( (dropped = __atomic_load_n (&lg_dropcnt, __ATOMIC_RELAXED)) != lg_dropreported )
+	{
+		snprintf (mesg, sizeof (mesg), "log buffer full: %ld message%s dropped",
+				dropped - lg_dropreported, dropped - lg_dropreported == 1 ? "" : "s");
+		gettimeofday (&tv, NULL);
+		lg_write (LG_WARNING, &tv, mesg, NULL);
+		lg_dropreported = dropped;
+	}
+	if ( lg_fp )
+		fflush (lg_fp);
+	if ( lg_zonefp )
+		fflush (lg_zonefp);
+}
+
+/*****************************************************************
+**	lg_reserve () -- get the next free slot of the ring buffer
+**	returns NULL if the ring buffer is full
+*****************************************************************/
+static	lg_slot_t	*lg_reserve (void)
+{
+	lg_slot_t	*slot;
+	unsigned long	pos;
+	long	diff;
+
+	for ( ; ; )
+	{
+		pos = __atomic_load_n (&lg_head, __ATOMIC_RELAXED);
+		slot = &lg_ring[pos % LG_RINGSIZE];
+		diff = (long)(__atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) - pos);
+		if ( diff == 0 && __atomic_compare_exchange_n (&lg_head, &pos, pos + 1, 0,
+						__ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+			return slot;
+		if ( diff < 0 )		/* slot of the previous round not drained */
+			return NULL;
+		/* otherwise another thread was faster */
+	}
+}
+
+/*****************************************************************
+**	lg_writer () -- the writer thread
+*****************************************************************/
+static	void	*lg_writer (void *arg)
+{
+	struct	timeval	now;
+	struct	timespec	timeout;
+
+	pthread_mutex_lock (&lg_waitlock);
+	while ( !lg_stop )
+	{
+		pthread_mutex_unlock (&lg_waitlock);
+
+		pthread_mutex_lock (&lg_drainlock);
+		lg_drain ();
+		pthread_mutex_unlock (&lg_drainlock);
+
+		gettimeofday (&now, NULL);
+		timeout.tv_sec = now.tv_sec;
+		timeout.tv_nsec = (now.tv_usec + 100000) * 1000L;	/* 100ms */
+		if ( timeout.tv_nsec >= 1000000000L )
+		{
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000L;
+		}
+		pthread_mutex_lock (&lg_waitlock);
+		if ( !lg_stop )
+			pthread_cond_timedwait (&lg_wakeup, &lg_waitlock, &timeout);
+	}
+	pthread_mutex_unlock (&lg_waitlock);
+
+	return NULL;
+}
+
+/* fork() handler: write out all messages, so the child starts with an empty buffer */
+static	void	lg_prefork (void)
+{
+	pthread_mutex_lock (&lg_drainlock);
+	if ( lg_ring )
+		lg_drain ();
+}
+
+static	void	lg_postfork_parent (void)
+{
+	pthread_mutex_unlock (&lg_drainlock);
+}
+
+static	void	lg_postfork_child (void)
+{
+	pthread_mutex_unlock (&lg_drainlock);
+	lg_async = 0;		/* the writer thread is not running in the child */
+}
+#endif
+
+/*****************************************************************
+**	lg_lock () / lg_unlock () -- write out the buffered messages
+**	and keep the writer thread away while the log channels change
+*****************************************************************/
+static	void	lg_lock (void)
+{
+#if defined(LG_RING) && LG_RING
+	pthread_mutex_lock (&lg_drainlock);
+	if ( lg_async )
+		lg_drain ();
+#endif
+}
+
+static	void	lg_unlock (void)
+{
+#if defined(LG_RING) && LG_RING
+	pthread_mutex_unlock (&lg_drainlock);
+#endif
+}
+
 /*****************************************************************
 **	lg_str2lvl (level_name)
 *****************************************************************/
@@ -243,6 +718,72 @@ long	lg_reseterrcnt ()
 	return lg_seterrcnt (0L);
 }
 
+/*****************************************************************
+**	lg_getdropcnt () -- returns the number of messages dropped
+**	because the log buffer was full
+*****************************************************************/
+long	lg_getdropcnt ()
+{
+	return lg_dropcnt;
+}
+
+/*****************************************************************
+**	lg_enabled (level) -- returns 1 if a message of this level
+**	would be written to syslog or the log file, 0 otherwise
+*****************************************************************/
+int	lg_enabled (lg_lvl_t level)
+{
+	return (lg_syslogging && level >= lg_minsyslevel) ||
+		((lg_fp != NULL || lg_zonelog) && level >= lg_minfilelevel);
+}
+
+/*****************************************************************
+**	lg_flush () -- write all buffered log messages
+*****************************************************************/
+void	lg_flush ()
+{
+	lg_lock ();
+	if ( lg_fp )
+		fflush (lg_fp);
+	if ( lg_zonefp )
+		fflush (lg_zonefp);
+	lg_unlock ();
+}
+
+/*****************************************************************
+**	lg_setformat (format) -- set the format of the log file
+**	("text" or "json"); syslog messages are always text
+**	returns 0 on success, -1 if the format is unknown
+*****************************************************************/
+int	lg_setformat (const char *format)
+{
+	int	json;
+
+	if ( format == NULL || *format == '\0' || strcasecmp (format, "text") == 0 )
+		json = 0;
+	else if ( strcasecmp (format, "json") == 0 )
+		json = 1;
+	else
+		return -1;
+
+	lg_lock ();		/* buffered messages are written in the old format */
+	lg_json = json;
+	lg_unlock ();
+
+	return 0;
+}
+
+/*****************************************************************
+**	lg_setzone (zone, view) -- set the zone (and view) which the
+**	following messages belong to (NULL for none). In JSON format,
+**	they are written as fields "zone" and "view".
+*****************************************************************/
+void	lg_setzone (const char *zone, const char *view)
+{
+	snprintf (lg_zonectx, sizeof (lg_zonectx), "%s", zone ? zone : "");
+	snprintf (lg_viewctx, sizeof (lg_viewctx), "%s", view ? view : "");
+}
+
 
 /*****************************************************************
 **	lg_open (prog, facility, syslevel, path, file, filelevel)
@@ -257,6 +798,7 @@ int	lg_open (const char *progname, const char *facility, const char *syslevel, c
 
 	dbg_val6 ("lg_open (%s, %s, %s, %s, %s, %s)\n", progname, facility, syslevel, path, file, filelevel);
 
+	lg_lock ();
 	lg_minsyslevel = lg_str2lvl (syslevel);
 	lg_minfilelevel = lg_str2lvl (filelevel);
 
@@ -270,9 +812,39 @@ int	lg_open (const char *progname, const char *facility, const char *syslevel, c
 	if ( file && * file )
 	{
 		if ( (lg_fp = lg_fileopen (path, file)) == NULL )
+		{
+			lg_unlock ();
 			return -1;
+		}
 		lg_progname = progname;
 	}
+
+#if defined(LG_RING) && LG_RING
+	if ( !lg_async && (lg_syslogging || lg_fp) )
+	{
+		static	int	registered = 0;
+		unsigned long	i;
+
+		if ( lg_ring == NULL && (lg_ring = malloc (LG_RINGSIZE * sizeof (lg_slot_t))) == NULL )
+		{
+			lg_unlock ();
+			return 0;	/* log synchronously */
+		}
+		for ( i = 0; i < LG_RINGSIZE; i++ )
+			lg_ring[i].seq = lg_head + i;
+		lg_tail = lg_head;
+		if ( !registered )
+		{
+			pthread_atfork (lg_prefork, lg_postfork_parent, lg_postfork_child);
+			atexit (lg_flush);
+			registered = 1;
+		}
+		lg_stop = 0;
+		if ( pthread_create (&lg_tid, NULL, lg_writer, NULL) == 0 )
+			lg_async = 1;
+	}
+#endif
+	lg_unlock ();
 	
 	return 0;
 }
@@ -284,8 +856,24 @@ int	lg_open (const char *progname, const char *facility, const char *syslevel, c
 *****************************************************************/
 int	lg_close ()
 {
+	lg_fdcache_t	*e;
 	int	ret = 0;
 
+#if defined(LG_RING) && LG_RING
+	if ( lg_async )		/* stop the writer thread */
+	{
+		pthread_mutex_lock (&lg_waitlock);
+		lg_stop = 1;
+		pthread_cond_signal (&lg_wakeup);
+		pthread_mutex_unlock (&lg_waitlock);
+		pthread_join (lg_tid, NULL);
+	}
+#endif
+	lg_lock ();
+#if defined(LG_RING) && LG_RING
+	lg_async = 0;
+#endif
+
 	if ( lg_syslogging )
 	{
 		closelog ();
@@ -296,49 +884,74 @@ int	lg_close ()
 		ret = fclose (lg_fp);
 		lg_fp = NULL;
 	}
+	for ( e = lg_fdcache; e < &lg_fdcache[LOG_ZONEFILES]; e++ )
+		if ( e->fp )
+		{
+			fclose (e->fp);
+			e->fp = NULL;
+			e->used = 0;
+		}
+	lg_zonelog = 0;
+	lg_zonefp = NULL;
+	lg_unlock ();
 
 	return ret;
 }
 
 /*****************************************************************
-**	lg_zone_start (domain)
-**		-- reopen the log channel
+**	lg_zone_start (dir, domain)
+**		-- write the following messages to the domain log file
+**		in dir. The file is opened with the first message.
 **	return values:
-**		 0 on success
-**		 -1 on file open error
+**		 1 on success
+**		 0 if the file name is too long
 *****************************************************************/
 int	lg_zone_start (const char *dir, const char *domain)
 {
-	char	fname[255+1];
+	char	fname[MAXFNAME+1];
+	int	len;
 
 	dbg_val2 ("lg_zone_start (%s, %s)\n", dir, domain);
 
-	snprintf (fname, sizeof (fname), LOG_DOMAINTMPL, domain);
-	if ( lg_fp )
-		lg_fpsave = lg_fp;
-	lg_fp = lg_fileopen (dir, fname);
+	len = 0;
+	if ( dir && *dir )
+		len = snprintf (fname, sizeof (fname), "%s/", dir);
+	if ( len < sizeof (fname) )
+		len += snprintf (fname+len, sizeof (fname) - len, LOG_DOMAINTMPL, domain);
+	if ( len >= sizeof (fname) )
+		return 0;
 
-	return lg_fp != NULL;
+	lg_lock ();		/* the messages so far belong to the current file */
+	memcpy (lg_zonefile, fname, len + 1);
+	lg_zonefp = NULL;
+	lg_zonefailed = 0;
+	lg_zonelog = 1;
+	lg_unlock ();
+
+	return 1;
 }
 
 /*****************************************************************
-**	lg_zone_end (domain)
-**		-- close the (reopened) log channel
+**	lg_zone_end ()
+**		-- write the following messages to the main log file.
+**		The domain log file is kept open in the cache.
 **	return values:
-**		 0 on success
-**		 -1 on file open error
+**		 1 if a domain log file was selected
+**		 0 otherwise
 *****************************************************************/
 int	lg_zone_end ()
 {
-	if ( lg_fp && lg_fpsave )
-	{
-		lg_close ();
-		lg_fp = lg_fpsave;
-		lg_fpsave = NULL;
-		return 1;
-	}
+	if ( !lg_zonelog )
+		return 0;
 
-	return 0;
+	lg_lock ();
+	if ( lg_zonefp )
+		fflush (lg_zonefp);
+	lg_zonefp = NULL;
+	lg_zonelog = 0;
+	lg_unlock ();
+
+	return 1;
 }
 
 /*****************************************************************
@@ -359,11 +972,100 @@ void	lg_args (lg_lvl_t level, int argc, char * const argv[])
 		len += snprintf (cmdline+len, sizeof (cmdline) - len, " %s", argv[i]);
 
 #if 1
-	lg_mesg (level, "------------------------------------------------------------");
+	if ( !lg_json )		/* a separator line is of no use in JSON */
+		lg_mesg (level, "------------------------------------------------------------");
 #else
 	lg_mesg (level, "");
 #endif
-	lg_mesg (level, "running%s ", cmdline);
+	lg_event (level, "start", "_=%s cmdline=%s", "running%s ", cmdline, cmdline + (len > 0));
+}
+
+/*****************************************************************
+**	lg_vevent (level, event, fields, fmt, ap)
+**	format the message (and its JSON fields) and write it or pass
+**	it to the writer thread
+*****************************************************************/
+static	void	lg_vevent (int priority, const char *event, const char *fields, const char *fmt, va_list ap)
+{
+	va_list aq;
+	struct	timeval	tv;
+	char	mesg[LG_MSGSIZE];
+	char	jfields[LG_FIELDSIZE];
+	char	*mp;
+	char	*fp;
+	size_t	msize;
+	size_t	fsize;
+#if defined(LG_RING) && LG_RING
+	lg_slot_t	*slot;
+	int	i;
+#endif
+
+	assert (fmt != NULL);
+	assert (priority >= LG_DEBUG && priority <= LG_FATAL);
+
+	if ( priority >= LG_ERROR )
+#if defined(LG_RING) && LG_RING
+		__atomic_fetch_add (&lg_errcnt, 1, __ATOMIC_RELAXED);
+#else
+		lg_errcnt++;
+#endif
+
+	dbg_val3 ("syslog = %d prio = %d >= sysmin = %d\n", lg_syslogging, priority, lg_minsyslevel);
+	dbg_val3 ("filelg = %d prio = %d >= filmin = %d\n", lg_fp!=NULL, priority, lg_minfilelevel);
+	if ( !lg_enabled (priority) )	/* nothing to format */
+		return;
+
+	mp = mesg;
+	msize = sizeof (mesg);
+	fp = jfields;
+	fsize = sizeof (jfields);
+#if defined(LG_RING) && LG_RING
+	slot = NULL;
+	if ( lg_async )
+	{
+		/* if the ring is full, help the writer (which may wait for a slot still being written) */
+		for ( i = 0; (slot = lg_reserve ()) == NULL && i < LG_RETRIES; i++ )
+		{
+			pthread_mutex_lock (&lg_drainlock);
+			lg_drain ();
+			pthread_mutex_unlock (&lg_drainlock);
+			sched_yield ();
+		}
+		if ( slot == NULL )
+		{
+			__atomic_fetch_add (&lg_dropcnt, 1, __ATOMIC_RELAXED);
+			return;
+		}
+		mp = slot->msg;
+		msize = sizeof (slot->msg);
+		fp = slot->fields;
+		fsize = sizeof (slot->fields);
+	}
+#endif
+
+	gettimeofday (&tv, NULL);
+	va_copy (aq, ap);
+	vsnprintf (mp, msize, fmt, ap);
+	*fp = '\0';
+	if ( lg_json )
+		lg_fields (fp, fsize, event, fields, aq);
+	va_end (aq);
+
+#if defined(LG_RING) && LG_RING
+	if ( slot )
+	{
+		slot->tv = tv;
+		slot->priority = priority;
+		__atomic_store_n (&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);	/* ready to be written */
+
+		if ( priority >= LG_ERROR ||
+		     __atomic_load_n (&lg_head, __ATOMIC_RELAXED) - __atomic_load_n (&lg_tail, __ATOMIC_RELAXED) >= LG_RINGSIZE / 4 )
+			pthread_cond_signal (&lg_wakeup);
+		return;
+	}
+#endif
+
+	lg_write (priority, &tv, mp, fp);
 }
 
 /*****************************************************************
@@ -379,61 +1081,44 @@ void	lg_args (lg_lvl_t level, int argc, char * const argv[])
 **	To call this function before an elog_open() is called is
 **	useless!
 **
+**	With threads, the message is formatted into the ring buffer
+**	and written by the writer thread (see lg_flush()).
+**
 *****************************************************************/
 void	lg_mesg (int priority, char *fmt, ...)
 {
 	va_list ap;
-	struct	timeval	tv;
-	struct	tm	*t;
-	char	format[256];
-
-	assert (fmt != NULL);
-	assert (priority >= LG_DEBUG && priority <= LG_FATAL);
 
-	format[0] ='\0';
-
-	dbg_val3 ("syslog = %d prio = %d >= sysmin = %d\n", lg_syslogging, priority, lg_minsyslevel);
-	if ( lg_syslogging && priority >= lg_minsyslevel )
-	{
-#if defined (LOG_WITH_LEVEL) && LOG_WITH_LEVEL
-		snprintf (format, sizeof (format), "%s: %s", lg_lvl2str(priority), fmt);
-		fmt = format;
-#endif
-		va_start(ap, fmt);
-		vsyslog (lg_lvl2syslog (priority), fmt, ap);
-		va_end(ap);
-	}
+	va_start(ap, fmt);
+	lg_vevent (priority, NULL, NULL, fmt, ap);
+	va_end(ap);
+}
 
-	dbg_val3 ("filelg = %d prio = %d >= filmin = %d\n", lg_fp!=NULL, priority, lg_minfilelevel);
-	if ( lg_fp && priority >= lg_minfilelevel )
-	{
-#if defined (LOG_WITH_TIMESTAMP) && LOG_WITH_TIMESTAMP
-		gettimeofday (&tv, NULL);
-		t = localtime ((time_t *) &tv.tv_sec);
-		fprintf (lg_fp, "%04d-%02d-%02d ",
-			t->tm_year+1900, t->tm_mon+1, t->tm_mday);
-		fprintf (lg_fp, "%02d:%02d:%02d.%03d: ",
-			t->tm_hour, t->tm_min, t->tm_sec, tv.tv_usec / 1000);
-#endif
-#if defined (LOG_WITH_PROGNAME) && LOG_WITH_PROGNAME
-		if ( lg_progname )
-			fprintf (lg_fp, "%s: ", lg_progname);
-#endif
-#if defined (LOG_WITH_LEVEL) && LOG_WITH_LEVEL
-		if ( fmt != format )	/* level is not in fmt string */
-			fprintf (lg_fp, "%s: ", lg_lvl2str(priority));
-#endif
-		va_start(ap, fmt);
-		vfprintf (lg_fp, fmt, ap);
-		va_end(ap);
-		fprintf (lg_fp, "\n");
-	}
+/*****************************************************************
+**
+**	lg_event (level, event, fields, fmt, ...)
+**
+**	Same as lg_mesg() for an event with typed fields. In JSON
+**	format, the event type and the fields are written as members
+**	of the log record in addition to the message.
+**	"fields" is a list of "key=%conv" separated by spaces, which
+**	describes the arguments in the order they are passed
+**	(conv is one of s, d, u, ld or lu). The format string "fmt" may
+**	use the same or less arguments. The key "_" names an argument
+**	used by the message only.
+**	Example:
+**	lg_event (LG_NOTICE, "reload", "zone=%s", "%s: reload triggered", zone);
+**
+*****************************************************************/
+void	lg_event (int priority, const char *event, const char *fields, char *fmt, ...)
+{
+	va_list ap;
 
-	if ( priority >= LG_ERROR )
-		lg_errcnt++;
+	va_start(ap, fmt);
+	lg_vevent (priority, event, fields, fmt, ap);
+	va_end(ap);
 }
 
-
 #ifdef LOG_TEST
 const char *progname;
 int	main (int argc, char *argv[])
@@ -63,10 +63,16 @@ extern	lg_lvl_t	lg_lvl2syslog (lg_lvl_t level);
 extern	long	lg_geterrcnt (void);
 extern	long	lg_seterrcnt (long value);
 extern	long	lg_reseterrcnt (void);
+extern	long	lg_getdropcnt (void);
+extern	int	lg_enabled (lg_lvl_t level);
+extern	void	lg_flush (void);
 extern	int	lg_open (const char *progname, const char *facility, const char *syslevel, const char *path, const char *file, const char *filelevel);
 extern	int	lg_close (void);
 extern	int	lg_zone_start (const char *dir, const char *domain);
 extern	int	lg_zone_end (void);
 extern	void	lg_args (lg_lvl_t level, int argc, char * const argv[]);
 extern	void	lg_mesg (int level, char *fmt, ...);
+extern	void	lg_event (int level, const char *event, const char *fields, char *fmt, ...);
+extern	int	lg_setformat (const char *format);
+extern	void	lg_setzone (const char *zone, const char *view);
 #endif
@@ -152,6 +152,35 @@ char	*domain_canonicdup (const char *s)
 
 	return new;
 }
+
+/*****************************************************************
+**	domain_hash (name)
+**	returns a hash value (32 bit FNV-1a) of the lower case
+**	domain name without the trailing dot.
+**	The value is stable between program runs, so it could be
+**	used to spread periodic work of zones deterministically.
+*****************************************************************/
+unsigned long	domain_hash (const char *name)
+{
+	unsigned long	hash;
+	size_t	len;
+	size_t	i;
+
+	assert (name != NULL);
+
+	len = strlen (name);
+	if ( len > 1 && name[len-1] == '.' )
+		len--;
+
+	hash = 2166136261UL;
+	for ( i = 0; i < len; i++ )
+	{
+		hash ^= (unsigned char)tolower (name[i]);
+		hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+	}
+
+	return hash;
+}
 #if 0		/* replaced by domain_canonicdup */
 /*****************************************************************
 **	str_tolowerdup (s)
@@ -671,6 +700,54 @@ time_t	file_mtime (const char *fname)
 	return st.st_mtime;
 }
 
+/*****************************************************************
+**	file_stamp (fs, st)
+**	fill in the version stamp of a file out of its stat info.
+**	Any write to the file changes the stamp, even if the size and
+**	the mtime in seconds remain the same (nanosecond mtime and
+**	ctime, inode number for a replaced file).
+*****************************************************************/
+void	file_stamp (filestamp_t *fs, const struct stat *st)
+{
+	fs->mtime = (long)st->st_mtime;
+	fs->ctime = (long)st->st_ctime;
+#if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC) && HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	fs->mtime_ns = (long)st->st_mtim.tv_nsec;
+	fs->ctime_ns = (long)st->st_ctim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC) && HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC
+	fs->mtime_ns = (long)st->st_mtimespec.tv_nsec;
+	fs->ctime_ns = (long)st->st_ctimespec.tv_nsec;
+#else
+	fs->mtime_ns = 0L;
+	fs->ctime_ns = 0L;
+#endif
+	fs->ino = (long)st->st_ino;
+	fs->size = (long)st->st_size;
+}
+
+/*****************************************************************
+**	file_stampcmp (fs1, fs2)
+**	returns 0 if both stamps are equal (the file is unchanged)
+*****************************************************************/
+int	file_stampcmp (const filestamp_t *fs1, const filestamp_t *fs2)
+{
+	return fs1->mtime != fs2->mtime || fs1->mtime_ns != fs2->mtime_ns ||
+		fs1->ctime != fs2->ctime || fs1->ctime_ns != fs2->ctime_ns ||
+		fs1->ino != fs2->ino || fs1->size != fs2->size;
+}
+
+/*****************************************************************
+**	file_stampisold (fs, now)
+**	returns 1 if the file was not changed in the current second.
+**	A file written in the current second may be written again
+**	without a visible change of the stamp (timestamp resolution of
+**	the file system), so it should not be cached.
+*****************************************************************/
+int	file_stampisold (const filestamp_t *fs, time_t now)
+{
+	return fs->mtime < (long)now && fs->ctime < (long)now;
+}
+
 /*****************************************************************
 **	is_exec_ok (prog)
 **	Check if we are running as root or if the file owner of
@@ -717,6 +794,7 @@ void fatal (char *fmt, ...)
 		fprintf (stderr, "%s: ", progname);
         vfprintf (stderr, fmt, ap);
         va_end(ap);
+	lg_flush ();		/* don't loose buffered log messages */
         exit (127);
 }
 
@@ -754,6 +832,13 @@ void	verbmesg (int verblvl, const zconf_t *conf, char *fmt, ...)
 {
 	char	str[511+1];
         va_list ap;
+	int	tostdout;
+	int	tolog;
+
+	tostdout = verblvl <= conf->verbosity;	/* check if we have to print this to stdout */
+	tolog = verblvl <= conf->verboselog && lg_enabled (LG_DEBUG);	/* ... or to syslog and/or file */
+	if ( !tostdout && !tolog )
+		return;
 
 	str[0] = '\0';
 	va_start(ap, fmt);
@@ -761,12 +846,12 @@ void	verbmesg (int verblvl, const zconf_t *conf, char *fmt, ...)
 	va_end(ap);
 
 	//fprintf (stderr, "verbmesg (%d stdout=%d filelog=%d str = :%s:\n", verblvl, conf->verbosity, conf->verboselog, str);
-	if ( verblvl <= conf->verbosity )	/* check if we have to print this to stdout */
-		logmesg (str);
+	if ( tostdout )
+		logmesg ("%s", str);
 
 	str_chop (str, '\n');
-	if ( verblvl <= conf->verboselog )	/* check logging to syslog and/or file */
-		lg_mesg (LG_DEBUG, str);
+	if ( tolog )
+		lg_mesg (LG_DEBUG, "%s", str);
 }
 
 
@@ -799,21 +884,16 @@ time_t	timestr2time (const char *timestr)
 #if defined(HAVE_TIMEGM) && HAVE_TIMEGM
 	sec = timegm (&t);
 #else
-	{
-	char	tzstr[31+1];
-	char	*tz;
-
-	tz = getenv("TZ");
-	snprintf (tzstr, sizeof (tzstr), "TZ=%s", "UTC");
-	putenv (tzstr);
-	tzset();
-	sec = mktime(&t);
-	if (tz)
-		snprintf (tzstr, sizeof (tzstr), "TZ=%s", tz);
-	else
-		snprintf (tzstr, sizeof (tzstr), "TZ=%s", "");
-	putenv (tzstr);
-	tzset();
+	{	/* days since 1970-01-01 of the proleptic gregorian calendar; */
+		/* unlike mktime() with TZ=UTC this is safe to use in threads */
+	long	y = t.tm_year + 1900 - (t.tm_mon < 2);
+	long	era = (y >= 0 ? y : y - 399) / 400;
+	long	yoe = y - era * 400;
+	long	doy = (153 * (t.tm_mon + (t.tm_mon < 2 ? 10 : -2)) + 2) / 5 + t.tm_mday - 1;
+	long	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	long	days = era * 146097 + doe - 719468;
+
+	sec = ((days * 24 + t.tm_hour) * 60 + t.tm_min) * 60 + t.tm_sec;
 	}
 #endif
 	
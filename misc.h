@@ -37,6 +37,7 @@
 #ifndef MISC_H
 # define MISC_H
 # include <sys/types.h>
+# include <sys/stat.h>
 # include <stdarg.h>
 # include <stdio.h>
 # include "zconf.h"
@@ -44,6 +45,16 @@
 # define min(a, b)	((a) < (b) ? (a) : (b))
 # define max(a, b)	((a) > (b) ? (a) : (b))
 
+/* version of a file, see file_stamp() */
+typedef	struct	{
+	long	mtime;
+	long	mtime_ns;
+	long	ctime;
+	long	ctime_ns;
+	long	ino;
+	long	size;
+} filestamp_t;
+
 extern	const	char	*getnameappendix (const char *progname, const char *basename);
 extern	const	char	*getdefconfname (const char *view);
 extern	int	fileexist (const char *name);
@@ -56,6 +67,7 @@ extern	int	copyfile (const char *fromfile, const char *tofile, const char *dnske
 extern	int	copyzonefile (const char *fromfile, const char *tofile, const char *dnskeyfile);
 extern	int	cmpfile (const char *file1, const char *file2);
 extern	char	*str_delspace (char *s);
+extern	unsigned long	domain_hash (const char *name);
 #if 1
 extern	char	*domain_canonicdup (const char *s);
 #else
@@ -70,6 +82,9 @@ extern	time_t	timestr2time (const char *timestr);
 extern	int	is_keyfilename (const char *name);
 extern	int	is_directory (const char *name);
 extern	time_t	file_mtime (const char *fname);
+extern	void	file_stamp (filestamp_t *fs, const struct stat *st);
+extern	int	file_stampcmp (const filestamp_t *fs1, const filestamp_t *fs2);
+extern	int	file_stampisold (const filestamp_t *fs, time_t now);
 extern	int	is_exec_ok (const char *prog);
 extern	char	*age2str (time_t sec);
 extern	time_t	stop_timer (time_t start);
@@ -35,9 +35,16 @@
 **
 *****************************************************************/
 # include <stdio.h>
+# include <stdlib.h>
 # include <string.h>
 # include <ctype.h>
 # include <assert.h>
+# include <errno.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <time.h>
+# include <fcntl.h>
+# include <unistd.h>
 # include "debug.h"
 # include "misc.h"
 # include "log.h"
@@ -86,6 +93,46 @@ static struct KeyWords {
 	{ NULL,		TOK_UNKNOWN },
 };
 
+/* Collision free hash of the keywords above (checked by kwhash_init()) */
+# define	KW_HASHSIZE	15
+# define	KW_MAXLEN	15	/* strlen ("delegation-only") */
+# define	kwhash(s, len)	((3 * (len) + (unsigned char)(s)[0] + (unsigned char)(s)[(len)-1]) % KW_HASHSIZE)
+static	const struct KeyWords	*kwtab[KW_HASHSIZE];
+
+/* the file to parse, read in as a whole */
+typedef	struct	{
+	char	*buf;
+	const	char	*p;
+	const	char	*end;
+} nclex_t;
+
+# define	lex_getc(lp)	((lp)->p < (lp)->end ? (unsigned char)*(lp)->p++ : EOF)
+# define	lex_ungetc(c, lp)	if ( (c) != EOF ) (lp)->p--
+
+/* the statements of a file we are interested in */
+typedef	struct	ncstmt	{
+	int	tok;		/* TOK_DIR, TOK_INCLUDE, TOK_VIEW, TOK_ZONE or 0 (include w/o file) */
+	char	*val;		/* directory, include file, view or zone name */
+	char	*file;		/* zone file (TOK_ZONE only) */
+	struct	ncstmt	*next;
+} ncstmt_t;
+
+/* cached statements of a file, valid as long as the file stamp is unchanged */
+typedef	struct	ncfile	{
+	char	*path;
+	filestamp_t	stamp;
+	int	used;		/* used in this run ? */
+	ncstmt_t	*stmts;
+	struct	ncfile	*next;
+} ncfile_t;
+
+# define	NC_CACHESIZE	1024	/* number of hash buckets */
+static	const	char	*cachefile = NULL;
+static	int	cacheloaded = 0;
+static	int	cachedirty = 0;
+static	ncfile_t	*cache[NC_CACHESIZE];
+static	int	depth = 0;		/* include level of parse_namedconf() */
+
 #ifdef DBG
 static	const char	*tok2str (int  tok)
 {
@@ -99,19 +146,74 @@ static	const char	*tok2str (int  tok)
 }
 #endif
 
-static	int	searchkw (const char *keyword)
+static	void	kwhash_init (void)
 {
 	int	i;
+	int	h;
+
+	for ( i = 0; kw[i].name; i++ )
+	{
+		if ( kw[i].tok == TOK_STRING )	/* not a keyword */
+			continue;
+		h = kwhash (kw[i].name, strlen (kw[i].name));
+		assert (kwtab[h] == NULL);	/* kwhash() is no longer collision free */
+		kwtab[h] = &kw[i];
+	}
+}
+
+static	int	searchkw (const char *keyword, size_t len)
+{
+	const	struct	KeyWords	*k;
 
 	dbg_val ("ncparse: searchkw (%s)\n", keyword);
-	i = 0;
-	while ( kw[i].name && strcmp (kw[i].name, keyword) != 0 )
-		i++;
+	if ( len == 0 || len > KW_MAXLEN )
+		return TOK_UNKNOWN;
+
+	if ( (k = kwtab[kwhash (keyword, len)]) != NULL && strcmp (k->name, keyword) == 0 )
+		return k->tok;
 
-	return kw[i].tok;
+	return TOK_UNKNOWN;
 }
 
-static	int	gettok (FILE *fp, char *val, size_t valsize)
+/*****************************************************************
+**	lex_open (lp, filename, st)
+**	read the whole file into memory
+*****************************************************************/
+static	int	lex_open (nclex_t *lp, const char *filename, struct stat *st)
+{
+	ssize_t	n;
+	size_t	len;
+	int	fd;
+
+	if ( (fd = open (filename, O_RDONLY)) < 0 )
+		return 0;
+	if ( fstat (fd, st) < 0 || (lp->buf = malloc (st->st_size + 1)) == NULL )
+	{
+		close (fd);
+		return 0;
+	}
+
+	len = 0;
+	while ( len < (size_t)st->st_size && (n = read (fd, lp->buf + len, st->st_size - len)) != 0 )
+	{
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			free (lp->buf);
+			close (fd);
+			return 0;
+		}
+		len += n;
+	}
+	close (fd);
+
+	lp->p = lp->buf;
+	lp->end = lp->buf + len;
+	return 1;
+}
+
+static	int	gettok (nclex_t *lp, char *val, size_t valsize)
 {
 	int	lastc;
 	int	c;
@@ -121,12 +223,12 @@ static	int	gettok (FILE *fp, char *val, size_t valsize)
 
 	*val = '\0';
 	do {
-		while ( (c = getc (fp)) != EOF && isspace (c) )
+		while ( (c = lex_getc (lp)) != EOF && isspace (c) )
 			;
 
 		if ( c == '#' )		/* single line comment ? */
 		{
-			while ( (c = getc (fp)) != EOF && c != '\n' )
+			while ( (c = lex_getc (lp)) != EOF && c != '\n' )
 				;
 			continue;
 		}
@@ -139,19 +241,19 @@ static	int	gettok (FILE *fp, char *val, size_t valsize)
 
 		if ( c == '/' )		/* begin of C comment ? */
 		{
-			if ( (c = getc (fp)) == '*' )	/* yes! */
+			if ( (c = lex_getc (lp)) == '*' )	/* yes! */
 			{
 				lastc = EOF;		/* read until end of c comment */
-				while ( (c = getc (fp)) != EOF && !(lastc == '*' && c == '/') )
+				while ( (c = lex_getc (lp)) != EOF && !(lastc == '*' && c == '/') )
 					lastc = c;
 			}	
 			else if ( c == '/' )	/* is it a C single line comment ? */
 			{
-				while ( (c = getc (fp)) != EOF && c != '\n' )
+				while ( (c = lex_getc (lp)) != EOF && c != '\n' )
 					;
 			}
 			else		/* no ! */
-				ungetc (c, fp);
+				lex_ungetc (c, lp);
 			continue;
 		}
 
@@ -159,12 +261,12 @@ static	int	gettok (FILE *fp, char *val, size_t valsize)
 		{
 			p = val;
 			bufend = val + valsize - 1;
-			while ( (c = getc (fp)) != EOF && p < bufend && c != '\"' )
+			while ( (c = lex_getc (lp)) != EOF && p < bufend && c != '\"' )
 				*p++ = c;
 			*p = '\0';
 			/* if string buffer is too small, eat up rest of string */
 			while ( c != EOF && c != '\"' )
-				c = getc (fp);
+				c = lex_getc (lp);
 			
 			return TOK_STRING;
 		}
@@ -173,11 +275,11 @@ static	int	gettok (FILE *fp, char *val, size_t valsize)
 		bufend = buf + sizeof (buf) - 1;
 		do
 			*p++ = tolower (c);
-		while ( (c = getc (fp)) != EOF && p < bufend && (isalpha (c) || c == '-') );
+		while ( (c = lex_getc (lp)) != EOF && p < bufend && (isalpha (c) || c == '-') );
 		*p = '\0';
-		ungetc (c, fp);
+		lex_ungetc (c, lp);
 
-		if ( (c = searchkw (buf)) != TOK_UNKNOWN )
+		if ( (c = searchkw (buf, p - buf)) != TOK_UNKNOWN )
 			return c;
 	}  while ( c != EOF );
 
@@ -185,40 +287,66 @@ static	int	gettok (FILE *fp, char *val, size_t valsize)
 }
 
 /*****************************************************************
-**
-**	parse_namedconf (const char *filename, chroot_dir, dir, dirsize, int (*func) ())
-**
-**	Very dumb named.conf parser.
-**	- In a zone declaration the _first_ keyword MUST be "type"
-**	- For every master zone "func (directory, zone, filename)" will be called
-**
+**	statement list
 *****************************************************************/
-// int	parse_namedconf (const char *filename, const char *chroot_dir, char *dir, size_t dirsize, int (*func) ())
-int	parse_namedconf (const char *filename, const char *chroot_dir, char *dir, size_t dirsize, int (*func) (const char *, const char *, const char *, const char *))
+static	void	stmt_free (ncstmt_t *sp)
 {
-	FILE	*fp;
+	ncstmt_t	*next;
+
+	for ( ; sp; sp = next )
+	{
+		next = sp->next;
+		if ( sp->val )
+			free (sp->val);
+		if ( sp->file )
+			free (sp->file);
+		free (sp);
+	}
+}
+
+static	ncstmt_t	**stmt_add (ncstmt_t **tail, int tok, const char *val, const char *file)
+{
+	ncstmt_t	*sp;
+
+	if ( tail == NULL )	/* out of memory before */
+		return NULL;
+
+	if ( (sp = calloc (1, sizeof (*sp))) == NULL ||
+	     (val && (sp->val = strdup (val)) == NULL) ||
+	     (file && (sp->file = strdup (file)) == NULL) )
+	{
+		stmt_free (sp);
+		return NULL;
+	}
+	sp->tok = tok;
+	*tail = sp;
+
+	return &sp->next;
+}
+
+/*****************************************************************
+**	lex_file (filename, st, listp)
+**	read the directory, include, view and master zone statements
+**	of filename into *listp
+*****************************************************************/
+static	int	lex_file (const char *filename, struct stat *st, ncstmt_t **listp)
+{
+	nclex_t	lex;
+	ncstmt_t	**tail;
 	int	tok;
-	char	path[511+1];
 #if 1	/* this is potentialy too small for key data, but we don't need the keys... */
 	char	strval[255+1];		
 #else
 	char	strval[4095+1];
 #endif
-	char	view[255+1];
 	char	zone[255+1];
-	char	zonefile[255+1];
 
-	dbg_val ("parse_namedconf: parsing file \"%s\" \n", filename);
-
-	assert (filename != NULL);
-	assert (dir != NULL && dirsize != 0);
-	assert (func != NULL);
-
-	view[0] = '\0';
-	if ( (fp = fopen (filename, "r")) == NULL )
+	*listp = NULL;
+	if ( !lex_open (&lex, filename, st) )
 		return 0;
 
-	while ( (tok = gettok (fp, strval, sizeof strval)) != EOF )
+	tail = listp;
+	while ( (tok = gettok (&lex, strval, sizeof strval)) != EOF )
 	{
 		if ( tok > 0 && tok < 256 )
 		{
@@ -227,77 +355,407 @@ int	parse_namedconf (const char *filename, const char *chroot_dir, char *dir, si
 		}
 		else if ( tok == TOK_DIR )
 		{
-			if ( gettok (fp, strval, sizeof (strval)) == TOK_STRING )
-			{
-				dbg_val2 ("parse_namedconf: directory found \"%s\" (dir is %s)\n",
-										 strval, dir);
-				if ( *strval != '/' &&  *dir )
-					snprintf (path, sizeof (path), "%s/%s", dir, strval);
-				else
-					snprintf (path, sizeof (path), "%s", strval);
-
-				/* prepend chroot directory (do it only once) */
-				if ( chroot_dir && *chroot_dir )
-				{
-					snprintf (dir, dirsize, "%s%s%s", chroot_dir, *path == '/' ? "": "/", path);
-					chroot_dir = NULL;
-				}
-				else
-					snprintf (dir, dirsize, "%s", path);
-				dbg_val ("parse_namedconf: new dir \"%s\" \n", dir);
-			}	
+			if ( gettok (&lex, strval, sizeof (strval)) == TOK_STRING )
+				tail = stmt_add (tail, TOK_DIR, strval, NULL);
 		}	
 		else if ( tok == TOK_INCLUDE )
 		{
-			if ( gettok (fp, strval, sizeof (strval)) == TOK_STRING )
-			{
-				if ( *strval != '/' && *dir )
-					snprintf (path, sizeof (path), "%s/%s", dir, strval);
-				else
-					snprintf (path, sizeof (path), "%s", strval);
-				if ( !parse_namedconf (path, chroot_dir, dir, dirsize, func) )
-				{
-					fclose (fp);
-					return 0;
-				}
-			}
+			if ( gettok (&lex, strval, sizeof (strval)) == TOK_STRING )
+				tail = stmt_add (tail, TOK_INCLUDE, strval, NULL);
 			else
-			{
-				error ("parse_namedconf: need a filename after \"include\"!\n");
-				lg_mesg (LG_ERROR, "parse_namedconf: need a filename after \"include\"!");
-			}
+				tail = stmt_add (tail, 0, NULL, NULL);
 		}
 		else if ( tok == TOK_VIEW )
 		{
-			if ( gettok (fp, strval, sizeof (strval)) != TOK_STRING )
+			if ( gettok (&lex, strval, sizeof (strval)) != TOK_STRING )
 				continue;
-			snprintf (view, sizeof view, "%s", strval);	/* store the name of the view */
+			tail = stmt_add (tail, TOK_VIEW, strval, NULL);
 		}
 		else if ( tok == TOK_ZONE )
 		{
-			if ( gettok (fp, strval, sizeof (strval)) != TOK_STRING )
+			if ( gettok (&lex, strval, sizeof (strval)) != TOK_STRING )
 				continue;
 			snprintf (zone, sizeof zone, "%s", strval);	/* store the name of the zone */
 
-			if ( gettok (fp, strval, sizeof (strval)) != TOK_MASTER )
+			if ( gettok (&lex, strval, sizeof (strval)) != TOK_MASTER )
 				continue;
-			if ( gettok (fp, strval, sizeof (strval)) != TOK_FILE )
+			if ( gettok (&lex, strval, sizeof (strval)) != TOK_FILE )
 				continue;
-			if ( gettok (fp, strval, sizeof (strval)) != TOK_STRING )
+			if ( gettok (&lex, strval, sizeof (strval)) != TOK_STRING )
 				continue;
-			snprintf (zonefile, sizeof zonefile, "%s", strval);	/* this is the filename */
-
-			dbg_val4 ("dir %s view %s zone %s file %s\n", dir, view, zone, zonefile);
-			(*func) (dir, view, zone, zonefile);
+			tail = stmt_add (tail, TOK_ZONE, zone, strval);
 		}
 		else 
 			dbg_val3 ("%-10s(%d): %s\n", tok2str(tok), tok, strval);
+
+		if ( tail == NULL )
+			break;
+	}
+	free (lex.buf);
+
+	if ( tail == NULL )	/* out of memory */
+	{
+		stmt_free (*listp);
+		*listp = NULL;
+		return 0;
+	}
+	return 1;
+}
+
+/*****************************************************************
+**	statement cache
+**	The statements of every file parsed are kept in a cache file
+**	with one line per statement:
+**		F <mtime> <mtime_ns> <ctime> <ctime_ns> <inode> <size> <path>
+**						begin of a file
+**		D <dir>				directory
+**		I <file>			include
+**		i				include without file
+**		V <view>			view
+**		Z <zone> <zonefile>		master zone
+**	with the fields delimited by tabs.
+*****************************************************************/
+static	unsigned int	cache_hash (const char *path)
+{
+	unsigned int	h;
+
+	h = 5381;
+	while ( *path )
+		h = h * 33 + (unsigned char)*path++;
+	return h % NC_CACHESIZE;
+}
+
+static	ncfile_t	*cache_search (const char *path)
+{
+	ncfile_t	*fp;
+
+	for ( fp = cache[cache_hash (path)]; fp; fp = fp->next )
+		if ( strcmp (fp->path, path) == 0 )
+			return fp;
+	return NULL;
+}
+
+static	ncfile_t	*cache_add (const char *path, const filestamp_t *stamp, ncstmt_t *stmts)
+{
+	ncfile_t	*fp;
+	unsigned int	h;
+
+	if ( (fp = cache_search (path)) != NULL )	/* replace old entry */
+	{
+		stmt_free (fp->stmts);
+		fp->stamp = *stamp;
+		fp->stmts = stmts;
+		return fp;
+	}
+
+	if ( (fp = calloc (1, sizeof (*fp))) == NULL || (fp->path = strdup (path)) == NULL )
+	{
+		if ( fp )
+			free (fp);
+		return NULL;
+	}
+	fp->stamp = *stamp;
+	fp->stmts = stmts;
+	h = cache_hash (path);
+	fp->next = cache[h];
+	cache[h] = fp;
+
+	return fp;
+}
+
+/* strings with a tab or newline are not cacheable */
+# define	cacheable(s)	((s) == NULL || strpbrk ((s), "\t\n") == NULL)
+
+static	int	cache_isvalid (const ncstmt_t *sp)
+{
+	for ( ; sp; sp = sp->next )
+		if ( !cacheable (sp->val) || !cacheable (sp->file) )
+			return 0;
+	return 1;
+}
+
+static	void	cache_load (void)
+{
+	FILE	*fp;
+	char	line[1023+1];
+	char	*p;
+	char	*tab;
+	ncfile_t	*file;
+	ncstmt_t	**tail;
+	filestamp_t	stamp;
+	int	n;
+
+	cacheloaded = 1;
+	if ( (fp = fopen (cachefile, "r")) == NULL )
+		return;
+
+	file = NULL;
+	tail = NULL;
+	while ( fgets (line, sizeof (line), fp) != NULL )
+	{
+		if ( (p = strchr (line, '\n')) == NULL )	/* line too long */
+			break;
+		*p = '\0';
+
+		if ( line[0] == 'F' )
+		{
+			if ( sscanf (line, "F\t%ld\t%ld\t%ld\t%ld\t%ld\t%ld\t%n",
+					&stamp.mtime, &stamp.mtime_ns, &stamp.ctime, &stamp.ctime_ns,
+					&stamp.ino, &stamp.size, &n) != 6 )
+				break;		/* old or damaged cache file */
+			if ( (file = cache_add (line + n, &stamp, NULL)) == NULL )
+				break;
+			tail = &file->stmts;
+			continue;
+		}
+		if ( file == NULL )
+			break;
+
+		p = line[1] == '\t' ? line + 2 : NULL;
+		switch ( line[0] )
+		{
+		case 'D':	tail = p ? stmt_add (tail, TOK_DIR, p, NULL) : NULL;	break;
+		case 'I':	tail = p ? stmt_add (tail, TOK_INCLUDE, p, NULL) : NULL;	break;
+		case 'i':	tail = stmt_add (tail, 0, NULL, NULL);	break;
+		case 'V':	tail = p ? stmt_add (tail, TOK_VIEW, p, NULL) : NULL;	break;
+		case 'Z':
+			if ( p == NULL || (tab = strchr (p, '\t')) == NULL )
+				tail = NULL;
+			else
+			{
+				*tab++ = '\0';
+				tail = stmt_add (tail, TOK_ZONE, p, tab);
+			}
+			break;
+		default:
+			tail = NULL;
+		}
+		if ( tail == NULL )
+			break;
+	}
+
+	if ( !feof (fp) && file )	/* drop the entry we stopped at */
+	{
+		stmt_free (file->stmts);
+		file->stmts = NULL;
+		file->stamp.size = -1;
 	}
 	fclose (fp);
+	dbg_val ("parse_namedconf: cache file %s loaded\n", cachefile);
+}
+
+static	void	cache_save (void)
+{
+	FILE	*fp;
+	ncfile_t	*file;
+	ncfile_t	**pp;
+	const	ncstmt_t	*sp;
+	char	tmpfile[511+1];
+	int	h;
+	int	ok;
+
+	/* remove the files not used in this run */
+	for ( h = 0; h < NC_CACHESIZE; h++ )
+		for ( pp = &cache[h]; (file = *pp) != NULL; )
+			if ( file->used )
+				pp = &file->next;
+			else
+			{
+				*pp = file->next;
+				stmt_free (file->stmts);
+				free (file->path);
+				free (file);
+				cachedirty = 1;
+			}
+
+	if ( !cachedirty )
+		return;
+
+	snprintf (tmpfile, sizeof (tmpfile), "%s.tmp", cachefile);
+	if ( (fp = fopen (tmpfile, "w")) == NULL )
+	{
+		lg_mesg (LG_ERROR, "parse_namedconf: can't write cache file \"%s\"", tmpfile);
+		return;
+	}
+
+	ok = 1;
+	for ( h = 0; h < NC_CACHESIZE; h++ )
+		for ( file = cache[h]; file; file = file->next )
+		{
+			fprintf (fp, "F\t%ld\t%ld\t%ld\t%ld\t%ld\t%ld\t%s\n",
+				file->stamp.mtime, file->stamp.mtime_ns, file->stamp.ctime, file->stamp.ctime_ns,
+				file->stamp.ino, file->stamp.size, file->path);
+			for ( sp = file->stmts; sp; sp = sp->next )
+				switch ( sp->tok )
+				{
+				case TOK_DIR:	fprintf (fp, "D\t%s\n", sp->val);	break;
+				case TOK_INCLUDE:	fprintf (fp, "I\t%s\n", sp->val);	break;
+				case TOK_VIEW:	fprintf (fp, "V\t%s\n", sp->val);	break;
+				case TOK_ZONE:	fprintf (fp, "Z\t%s\t%s\n", sp->val, sp->file);	break;
+				default:	fprintf (fp, "i\n");	break;
+				}
+		}
+	if ( ferror (fp) )
+		ok = 0;
+	if ( fclose (fp) != 0 )
+		ok = 0;
+
+	if ( ok && rename (tmpfile, cachefile) == 0 )
+		cachedirty = 0;
+	else
+	{
+		lg_mesg (LG_ERROR, "parse_namedconf: can't write cache file \"%s\"", cachefile);
+		unlink (tmpfile);
+	}
+}
+
+/*****************************************************************
+**
+**	parse_namedconf_cache (const char *file)
+**
+**	Keep the statements of the parsed named.conf files in "file".
+**	Files with unchanged modification time (in nanoseconds), change
+**	time, inode and size are not read again on the next run. NULL or "" switches the cache off.
+**
+*****************************************************************/
+void	parse_namedconf_cache (const char *file)
+{
+	if ( file && *file )
+		cachefile = file;
+	else
+		cachefile = NULL;
+}
+
+/*****************************************************************
+**	exec_stmts (stmts, chroot_dir, dir, dirsize, func)
+**	run the statements of a file in the order of appearance
+*****************************************************************/
+static	int	exec_stmts (const ncstmt_t *sp, const char *chroot_dir, char *dir, size_t dirsize, int (*func) (const char *, const char *, const char *, const char *))
+{
+	char	path[511+1];
+	char	view[255+1];
+
+	view[0] = '\0';
+	for ( ; sp; sp = sp->next )
+	{
+		if ( sp->tok == TOK_DIR )
+		{
+			dbg_val2 ("parse_namedconf: directory found \"%s\" (dir is %s)\n",
+									 sp->val, dir);
+			if ( *sp->val != '/' &&  *dir )
+				snprintf (path, sizeof (path), "%s/%s", dir, sp->val);
+			else
+				snprintf (path, sizeof (path), "%s", sp->val);
+
+			/* prepend chroot directory (do it only once) */
+			if ( chroot_dir && *chroot_dir )
+			{
+				snprintf (dir, dirsize, "%s%s%s", chroot_dir, *path == '/' ? "": "/", path);
+				chroot_dir = NULL;
+			}
+			else
+				snprintf (dir, dirsize, "%s", path);
+			dbg_val ("parse_namedconf: new dir \"%s\" \n", dir);
+		}	
+		else if ( sp->tok == TOK_INCLUDE )
+		{
+			if ( *sp->val != '/' && *dir )
+				snprintf (path, sizeof (path), "%s/%s", dir, sp->val);
+			else
+				snprintf (path, sizeof (path), "%s", sp->val);
+			if ( !parse_namedconf (path, chroot_dir, dir, dirsize, func) )
+				return 0;
+		}
+		else if ( sp->tok == TOK_VIEW )
+			snprintf (view, sizeof view, "%s", sp->val);	/* store the name of the view */
+		else if ( sp->tok == TOK_ZONE )
+		{
+			dbg_val4 ("dir %s view %s zone %s file %s\n", dir, view, sp->val, sp->file);
+			(*func) (dir, view, sp->val, sp->file);
+		}
+		else
+		{
+			error ("parse_namedconf: need a filename after \"include\"!\n");
+			lg_mesg (LG_ERROR, "parse_namedconf: need a filename after \"include\"!");
+		}
+	}
 
 	return 1;
 }
 
+/*****************************************************************
+**
+**	parse_namedconf (const char *filename, chroot_dir, dir, dirsize, int (*func) ())
+**
+**	Very dumb named.conf parser.
+**	- In a zone declaration the _first_ keyword MUST be "type"
+**	- For every master zone "func (directory, zone, filename)" will be called
+**	- The file is read in as a whole and lexed into the list of
+**	  statements of interest, which is kept in the cache (if any)
+**
+*****************************************************************/
+// int	parse_namedconf (const char *filename, const char *chroot_dir, char *dir, size_t dirsize, int (*func) ())
+int	parse_namedconf (const char *filename, const char *chroot_dir, char *dir, size_t dirsize, int (*func) (const char *, const char *, const char *, const char *))
+{
+	struct	stat	st;
+	filestamp_t	stamp;
+	ncfile_t	*file;
+	ncstmt_t	*stmts;
+	int	ret;
+
+	dbg_val ("parse_namedconf: parsing file \"%s\" \n", filename);
+
+	assert (filename != NULL);
+	assert (dir != NULL && dirsize != 0);
+	assert (func != NULL);
+
+	if ( kwtab[kwhash ("zone", 4)] == NULL )
+		kwhash_init ();
+	if ( cachefile && !cacheloaded )
+		cache_load ();
+
+	file = NULL;
+	if ( cachefile && stat (filename, &st) == 0 &&
+	     (file = cache_search (filename)) != NULL )
+	{
+		file_stamp (&stamp, &st);
+		if ( file_stampcmp (&file->stamp, &stamp) != 0 )
+			file = NULL;		/* file has changed */
+	}
+
+	if ( file )
+		dbg_val ("parse_namedconf: \"%s\" found in cache\n", filename);
+	else
+	{
+		if ( !lex_file (filename, &st, &stmts) )
+			return 0;
+		file_stamp (&stamp, &st);
+		/* a file changed in this second may change again unnoticed */
+		if ( cachefile && cache_isvalid (stmts) && file_stampisold (&stamp, time (NULL)) &&
+		     (file = cache_add (filename, &stamp, stmts)) != NULL )
+			cachedirty = 1;
+		else	/* not cached: run and free the statements */
+		{
+			depth++;
+			ret = exec_stmts (stmts, chroot_dir, dir, dirsize, func);
+			depth--;
+			stmt_free (stmts);
+			if ( cachefile && depth == 0 )
+				cache_save ();
+			return ret;
+		}
+	}
+
+	file->used = 1;
+	depth++;
+	ret = exec_stmts (file->stmts, chroot_dir, dir, dirsize, func);
+	depth--;
+	if ( cachefile && depth == 0 )
+		cache_save ();
+
+	return ret;
+}
+
 #ifdef TEST_NCPARSE
 int	printzone (const char *dir, const char *view, const char *zone, const char *file)
 {
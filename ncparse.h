@@ -37,5 +37,6 @@
 
 #ifndef NCPARSE_H
 # define NCPARSE_H
+extern	void	parse_namedconf_cache (const char *file);
 extern	int	parse_namedconf (const char *filename, const char *chroot_dir, char *dir, size_t dirsize, int (*func) ());
 #endif
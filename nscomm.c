@@ -81,7 +81,7 @@ int	dyn_update_freeze (const char *domain, const zconf_t *z, int freeze)
 	else
 		snprintf (str, sizeof (str), "\"%s\"", domain);
 
-	lg_mesg (LG_NOTICE, "%s: %s dynamic zone", str, action);
+	lg_event (LG_NOTICE, action, "_=%s _=%s zone=%s", "%s: %s dynamic zone", str, action, domain);
 	verbmesg (1, z, "\t%s dynamic zone %s\n", action, str);
 
 	if ( z->view )
@@ -110,11 +110,15 @@ int	dyn_update_freeze (const char *domain, const zconf_t *z, int freeze)
 **	what is
 **		1 for zone distribution and relaod
 **		2 for key distribution (used by dynamic zoes)
+**	delta is the path of the difference to the last distributed
+**	zone (IXFR journal or UPDATE batch) or NULL; it is passed as
+**	fifth argument (after the possibly empty view name)
 *****************************************************************/
-int	dist_and_reload (const zone_t *zp, int what)
+int	dist_and_reload (const zone_t *zp, int what, const char *delta)
 {
 	char	path[MAX_PATHSIZE+1];
-	char	cmdline[255+MAX_PATHSIZE+1];
+	char	args[2*MAX_PATHSIZE+255+1];
+	char	cmdline[255+sizeof (args)+1];
 	char	zone[254+1];
 	char	str[254+1];
 	char	*view;
@@ -153,10 +157,15 @@ int	dist_and_reload (const zone_t *zp, int what)
 		snprintf (zone, sizeof (zone), "\"%s\"", zp->zone);
 
 
-	pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+	zone_nsfile (zp, path, sizeof (path));	/* the file loaded by the name server */
+	if ( delta )
+		snprintf (args, sizeof (args), "%s %s \"%s\" %s", zp->zone, path, view, delta);
+	else
+		snprintf (args, sizeof (args), "%s %s %s", zp->zone, path, view);
+
 	if ( what == 2 )
 	{
-		lg_mesg (LG_NOTICE, "%s: key distribution triggered", zone);
+		lg_event (LG_NOTICE, "distkeys", "zone=%s", "%s: key distribution triggered", zone);
 		verbmesg (1, zp->conf, "\tDistribute keys for zone %s\n", zone);
 		snprintf (cmdline, sizeof (cmdline), "%s distkeys %s %s %s 2>&1",
 					zp->conf->dist_cmd, zp->zone, path, view);
@@ -177,9 +186,12 @@ int	dist_and_reload (const zone_t *zp, int what)
 		return 0;
 	}
 
-	lg_mesg (LG_NOTICE, "%s: distribution triggered", zone);
+	if ( delta )
+		lg_event (LG_NOTICE, "distribute", "zone=%s delta=%s", "%s: distribution triggered (delta %s)", zone, delta);
+	else
+		lg_event (LG_NOTICE, "distribute", "zone=%s", "%s: distribution triggered", zone);
 	verbmesg (1, zp->conf, "\tDistribute zone %s\n", zone);
-	snprintf (cmdline, sizeof (cmdline), "%s distribute %s %s %s 2>&1", zp->conf->dist_cmd, zp->zone, path, view);
+	snprintf (cmdline, sizeof (cmdline), "%s distribute %s 2>&1", zp->conf->dist_cmd, args);
 
 	*str = '\0';
 	if ( zp->conf->noexec == 0 )
@@ -196,9 +208,9 @@ int	dist_and_reload (const zone_t *zp, int what)
 	}
 
 
-	lg_mesg (LG_NOTICE, "%s: reload triggered", zone);
+	lg_event (LG_NOTICE, "reload", "zone=%s", "%s: reload triggered", zone);
 	verbmesg (1, zp->conf, "\tReload zone %s\n", zone);
-	snprintf (cmdline, sizeof (cmdline), "%s reload %s %s %s 2>&1", zp->conf->dist_cmd, zp->zone, path, view);
+	snprintf (cmdline, sizeof (cmdline), "%s reload %s 2>&1", zp->conf->dist_cmd, args);
 
 	*str = '\0';
 	if ( zp->conf->noexec == 0 )
@@ -233,7 +245,7 @@ int	reload_zone (const char *domain, const zconf_t *z)
 	else
 		snprintf (str, sizeof (str), "\"%s\"", domain);
 
-	lg_mesg (LG_NOTICE, "%s: reload triggered", str);
+	lg_event (LG_NOTICE, "reload", "_=%s zone=%s", "%s: reload triggered", str, domain);
 	verbmesg (1, z, "\tReload zone %s\n", str);
 
 	if ( z->view )
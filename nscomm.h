@@ -39,5 +39,5 @@
 
 extern	int	dyn_update_freeze (const char *domain, const zconf_t *z, int freeze);
 extern	int	reload_zone (const char *domain, const zconf_t *z);
-extern	int	dist_and_reload (const zone_t *zp, int what);
+extern	int	dist_and_reload (const zone_t *zp, int what, const char *delta);
 #endif
@@ -56,6 +56,7 @@
 # include "dki.h"
 # include "zone.h"
 # include "log.h"
+# include "keypool.h"
 #define extern
 # include "rollover.h"
 #undef extern
@@ -66,6 +67,62 @@
 
 static	dki_t	*genkey (int addkey, dki_t **listp, const char *dir, const char *domain, int ksk, const zconf_t *conf, int status);
 
+# define	TRANS_DEFER	01	/* transition could be deferred */
+# define	TRANS_ADVANCE	02	/* transition could be advanced */
+
+/*****************************************************************
+**	transition_now ()
+**	Check if a key state transition, which is due at time 'due',
+**	should be done now.
+**	To sign the zone only once, a non urgent transition is aligned
+**	to the next scheduled re-signing of the zone at 'resigntime':
+**	A transition which is already due will be deferred (TRANS_DEFER),
+**	if the zone will be re-signed not later than max_ttl + proptime
+**	after the due time.
+**	A transition which is not yet due will be advanced (TRANS_ADVANCE),
+**	if the zone will be re-signed now and the due time is not more
+**	than max_ttl + proptime ahead.
+**	A resigntime of 0 turns off the alignment.
+**	Returns 1 if the transition should be done now, otherwise 0.
+*****************************************************************/
+static	int	transition_now (const char *domain, const zconf_t *z, const char *what, int tag,
+					time_t due, time_t currtime, time_t resigntime, int flags)
+{
+	long	margin;
+
+	if ( resigntime <= 0 )
+		return due < currtime;
+
+	margin = z->max_ttl + z->proptime;
+	if ( due < currtime )		/* transition is due */
+	{
+		if ( (flags & TRANS_DEFER) && resigntime > currtime && resigntime <= due + margin )
+		{
+			verbmesg (1, z, "		->%s %d deferred to next re-signing at %s\n",
+							what, tag, time2str (resigntime, 's'));
+			lg_event (LG_INFO, "deferred", "zone=%s transition=%s tag=%d _=%s delay=%ld",
+					"\"%s\": %s %d deferred by %s to next re-signing",
+					domain, what, tag, str_delspace (age2str (resigntime - currtime)),
+					(long)(resigntime - currtime));
+			return 0;
+		}
+		return 1;
+	}
+
+	/* transition is not due yet */
+	if ( (flags & TRANS_ADVANCE) && resigntime <= currtime && due <= currtime + margin )
+	{
+		verbmesg (1, z, "		->%s %d advanced to current re-signing\n", what, tag);
+		lg_event (LG_INFO, "advanced", "zone=%s transition=%s tag=%d _=%s advance=%ld",
+					"\"%s\": %s %d advanced by %s to current re-signing",
+					domain, what, tag, str_delspace (age2str (due - currtime)),
+					(long)(due - currtime));
+		return 1;
+	}
+
+	return 0;
+}
+
 /*	generate the first (or primary) key (algorithm k_algo) */
 static	dki_t	*genfirstkey (dki_t **listp, const char *dir, const char *domain, int ksk, const zconf_t *conf, int status)
 {
@@ -79,12 +136,12 @@ static	dki_t	*genaddkey (dki_t **listp, const char *dir, const char *domain, int
 }
 
 
-/*	generate a DNSKEY key  */
+/*	generate a DNSKEY key (or take it out of the key pool) */
 static	dki_t	*genkey (int addkey, dki_t **listp, const char *dir, const char *domain, int ksk, const zconf_t *conf, int status)
 {
 	dki_t	*dkp;
-	int	confalgo;
 	int	algo;
+	int	lf_days;
 
 #if 0
 	if ( listp == NULL || domain == NULL )
@@ -94,24 +151,19 @@ static	dki_t	*genkey (int addkey, dki_t **listp, const char *dir, const char *do
 	assert ( domain != NULL );
 #endif
 
-	if ( addkey )	/* generating an additional key ? */
-		confalgo = conf->k2_algo;
-	else
-		confalgo = conf->k_algo;
+	algo = key_algo (addkey, conf);
+	lf_days = key_lifetime (domain, ksk, conf) / DAYSEC;
 
-	algo = confalgo;
-	if ( conf->nsec3 != NSEC3_OFF )		/* is nsec3 turned on ? */
-	{
-		if ( confalgo == DK_ALGO_RSASHA1 )
-			algo = DK_ALGO_NSEC3RSASHA1;
-		else if ( confalgo == DK_ALGO_DSA )
-			algo = DK_ALGO_NSEC3DSA;
-	}
+	dkp = NULL;
+	if ( conf->keypooldir && *conf->keypooldir )
+		dkp = keypool_claim (conf->keypooldir, dir, domain, ksk, algo, ksk ? conf->k_bits : conf->z_bits, lf_days);
 
-	if ( ksk )
-		dkp = dki_new (dir, domain, DKI_KSK, algo, conf->k_bits, conf->k_random, conf->k_life / DAYSEC);
+	if ( dkp )
+		verbmesg (2, conf, "\t\tkey %d taken out of key pool\n", dkp->tag);
+	else if ( ksk )
+		dkp = dki_new (dir, domain, DKI_KSK, algo, conf->k_bits, conf->k_random, lf_days);
 	else
-		dkp = dki_new (dir, domain, DKI_ZSK, algo, conf->z_bits, conf->z_random, conf->z_life / DAYSEC);
+		dkp = dki_new (dir, domain, DKI_ZSK, algo, conf->z_bits, conf->z_random, lf_days);
 	dki_add (listp, dkp);
 	dki_setstatus (dkp, status);
 
@@ -129,7 +181,7 @@ static	time_t	get_exptime (dki_t *key, const zconf_t *z)
 		if ( dki_lifetime (key) )
 			exptime = dki_time (key) + dki_lifetime (key);
 		else
-			exptime = dki_time (key) + z->k_life;
+			exptime = dki_time (key) + key_lifetime (key->name, DKI_KSK, z);
 	}
 
 	return exptime;
@@ -312,7 +364,7 @@ static	int	kskrollover (dki_t *ksk, zone_t *zonelist, zone_t *zp)
 	z = zp->conf;
 	/* check ksk lifetime */
 	if ( (lifetime = dki_lifetime (ksk)) == 0 )	/* if lifetime of key is not set.. */
-		lifetime = z->k_life;			/* ..use global configured lifetime */
+		lifetime = key_lifetime (zp->zone, DKI_KSK, z);	/* ..use global configured lifetime */
 
 	currtime = time (NULL);
 	age = dki_age (ksk, currtime);
@@ -334,7 +386,9 @@ static	int	kskrollover (dki_t *ksk, zone_t *zonelist, zone_t *zp)
 				lg_mesg (LG_ERROR, "\"%s\": unable to generate new ksk for double signing rollover", zp->zone);
 				return 0;
 			}
-			lg_mesg (LG_INFO, "\"%s\": kskrollover phase1: New key %d generated", zp->zone, ksk->tag);
+			lg_event (LG_INFO, "kskrollover", "zone=%s tag=%d phase=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": kskrollover phase1: New key %d generated", zp->zone, ksk->tag,
+					1, "KSK", dki_algo2sstr (ksk->algo), "new key generated");
 
 			/* find the oldest active ksk to create the parent file */
 			if ( (ksk = (dki_t *)dki_findalgo (zp->keys, DKI_KSK, zp->conf->k_algo, 'a', 1)) == NULL )
@@ -384,7 +438,9 @@ static	int	kskrollover (dki_t *ksk, zone_t *zonelist, zone_t *zp)
 			ksk = ksk->next;    /* set ksk to new ksk */
 			if ( !create_parent_file (path, currphase+1, z->key_ttl, ksk) )
 				lg_mesg (LG_ERROR, "Couldn't create parentfile %s\n", path);
-			lg_mesg (LG_INFO, "\"%s\": kskrollover phase2: send new key %d to the parent zone", zp->zone, ksk->tag);
+			lg_event (LG_INFO, "kskrollover", "zone=%s tag=%d phase=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": kskrollover phase2: send new key %d to the parent zone", zp->zone, ksk->tag,
+					2, "KSK", dki_algo2sstr (ksk->algo), "send new key to parent");
 #if defined (USE_DS_TRACKING) && USE_DS_TRACKING
 			if ( !is_parentdirsigned (zonelist, zp) )
 				verbmesg (0, z, "\"%s\": kskrollover phase2: send new key %d to the parent zone now\n", zp->zone, ksk->tag);
@@ -404,12 +460,16 @@ static	int	kskrollover (dki_t *ksk, zone_t *zonelist, zone_t *zp)
 			ksk = ksk->next;    /* set ksk to new ksk */
 			if ( !is_parentdirsigned(zonelist, zp) )
 			{
-				lg_mesg (LG_INFO, "\"%s\": kskrollover phase2: new key %d not yet published in parent zone, already submitted?", zp->zone, ksk->tag);
+				lg_event (LG_INFO, "kskrollover", "zone=%s tag=%d phase=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": kskrollover phase2: new key %d not yet published in parent zone, already submitted?", zp->zone, ksk->tag,
+					2, "KSK", dki_algo2sstr (ksk->algo), "not yet published in parent");
 				verbmesg (0, z, "\"%s\": kskrollover phase2: new key %d not yet published in parent zone, already submitted?\n", zp->zone, ksk->tag);
 			}
 			else
 			{
-				lg_mesg (LG_NOTICE, "\"%s\": kskrollover phase2: new key %d not yet published in parent zone, postponing phase3", zp->zone, ksk->tag);
+				lg_event (LG_NOTICE, "kskrollover", "zone=%s tag=%d phase=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": kskrollover phase2: new key %d not yet published in parent zone, postponing phase3", zp->zone, ksk->tag,
+					2, "KSK", dki_algo2sstr (ksk->algo), "phase3 postponed");
 				verbmesg (2, z, "\"%s\": kskrollover phase2: new key %d not yet published in parent zone, postponing phase3\n", zp->zone, ksk->tag);
 			}
 			return 0; 
@@ -431,7 +491,9 @@ static	int	kskrollover (dki_t *ksk, zone_t *zonelist, zone_t *zp)
 			// verbmesg (2, z, "kskrollover: remove parentfile and rename old key to k<zone>+<algo>+<tag>.key\n");
 			verbmesg (2, z, "\t\tkskrollover: remove parentfile and rename old key to k%s+%03d+%05d.key\n",
 									ksk->name, ksk->algo, ksk->tag);
-			lg_mesg (LG_INFO, "\"%s\": kskrollover phase3: Remove old key %d", zp->zone, ksk->tag);
+			lg_event (LG_INFO, "kskrollover", "zone=%s tag=%d phase=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": kskrollover phase3: Remove old key %d", zp->zone, ksk->tag,
+					3, "KSK", dki_algo2sstr (ksk->algo), "old key removed");
 			return 1;
 		}
 		else
@@ -464,7 +526,7 @@ static	int	kskrollover (dki_t *ksk, zone_t *zonelist, zone_t *zp)
 **	is required. The second rightmost bit is set, if it is an
 **	rfc5011 zone.
 *****************************************************************/
-int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zconf_t *z)
+int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zconf_t *z, time_t resigntime)
 {
 	dki_t	*standbykey;
 	dki_t	*activekey;
@@ -497,10 +559,14 @@ int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zco
 							domain, dkp->tag, time2str (exptime, 's'));
 
 		/* revoked key is older than 30 days? */
-		if ( dki_isrevoked (dkp) && currtime > exptime + REMOVE_HOLD_DOWN )
+		if ( dki_isrevoked (dkp) &&
+		     transition_now (domain, z, "removal of revoked KSK", dkp->tag,
+				exptime + REMOVE_HOLD_DOWN, currtime, resigntime, TRANS_DEFER) )
 		{
 			verbmesg (1, z, "\tRemove revoked key %d which is older than 30 days\n", dkp->tag);
-			lg_mesg (LG_NOTICE, "zone \"%s\": removing revoked key %d", domain, dkp->tag);
+			lg_event (LG_NOTICE, "keyremoved", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"zone \"%s\": removing revoked key %d", domain, dkp->tag,
+					"KSK", dki_algo2sstr (dkp->algo), "revoked");
 
 			/* remove key from list and mark file as removed */
 			if ( prev == NULL )		/* at the beginning of the list ? */
@@ -533,7 +599,9 @@ int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zco
 	/* otherwise we run into an (nearly) immediate key rollover!	*/
 	if ( currtime > exptime && currtime > dki_time (standbykey) + min (ADD_HOLD_DOWN, z->key_ttl) )
 	{
-		lg_mesg (LG_NOTICE, "\"%s\": starting rfc5011 rollover", domain);
+		lg_event (LG_NOTICE, "rfc5011rollover", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": starting rfc5011 rollover", domain, activekey->tag,
+					"KSK", dki_algo2sstr (activekey->algo), "lifetime exceeded");
 		verbmesg (1, z, "\tLifetime of Key Signing Key %d exceeded (%s): Starting rfc5011 rollover!\n",
 							activekey->tag, str_delspace (age2str (dki_age (activekey, currtime))));
 		verbmesg (2, z, "\t\t=>Generating new standby key signing key\n");
@@ -544,7 +612,9 @@ int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zco
 			lg_mesg (LG_ERROR, "\%s\": can't generate new standby KSK", domain);
 		}
 		else
-			lg_mesg (LG_NOTICE, "\"%s\": generated new standby KSK %d", domain, dkp->tag);
+			lg_event (LG_NOTICE, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": generated new standby KSK %d", domain, dkp->tag,
+					"KSK", dki_algo2sstr (dkp->algo), "standby");
 
 		/* standby key gets active  */
 		verbmesg (2, z, "\t\t=>Activating old standby key %d \n", standbykey->tag);
@@ -561,6 +631,64 @@ int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zco
 	return ret;
 }
 
+/*****************************************************************
+**	key_algo ()
+**	Return the algorithm of the primary (addkey == 0) or the
+**	additional key of a zone.
+*****************************************************************/
+int	key_algo (int addkey, const zconf_t *conf)
+{
+	int	confalgo;
+
+	assert ( conf != NULL );
+
+	if ( addkey )	/* generating an additional key ? */
+		confalgo = conf->k2_algo;
+	else
+		confalgo = conf->k_algo;
+
+	if ( conf->nsec3 != NSEC3_OFF )		/* is nsec3 turned on ? */
+	{
+		if ( confalgo == DK_ALGO_RSASHA1 )
+			return DK_ALGO_NSEC3RSASHA1;
+		else if ( confalgo == DK_ALGO_DSA )
+			return DK_ALGO_NSEC3DSA;
+	}
+
+	return confalgo;
+}
+
+/*****************************************************************
+**	key_lifetime ()
+**	Return the configured lifetime of a key signing (ksk == 1) or
+**	zone signing key of the zone.
+**	If KeyLifetimeSpread is set, the lifetime is shortened by a
+**	number of days between 0 and KeyLifetimeSpread. The value is
+**	derived from the domain name, so every zone (and key type)
+**	gets its own but stable lifetime. This avoids that zones
+**	created at the same day do all the key rollovers at the same day.
+*****************************************************************/
+time_t	key_lifetime (const char *domain, int ksk, const zconf_t *z)
+{
+	time_t	lifetime;
+	long	spreaddays;
+	unsigned long	hash;
+
+	assert ( domain != NULL );
+	assert ( z != NULL );
+
+	lifetime = ksk ? z->k_life : z->z_life;
+	if ( lifetime <= 0 || z->key_spread <= 0 )
+		return lifetime;
+
+	spreaddays = min (z->key_spread, lifetime / 2) / DAYSEC;
+	hash = domain_hash (domain);
+	if ( ksk )
+		hash >>= 12;	/* use other bits for the ksk */
+
+	return lifetime - (hash % (spreaddays + 1)) * DAYSEC;
+}
+
 /*****************************************************************
 **	kskstatus ()
 **	Check the ksk status of a zone if a ksk lifetime is set.
@@ -595,7 +723,9 @@ int	kskstatus (zone_t *zonelist, zone_t *zp)
 								zp->zone, dki_geterrstr());
 		}
 		else
-			lg_mesg (LG_INFO, "\"%s\": generated new KSK %d", zp->zone, akey->tag);
+			lg_event (LG_INFO, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": generated new KSK %d", zp->zone, akey->tag,
+					"KSK", dki_algo2sstr (akey->algo), "no active key");
 		return akey != NULL;	/* return value of 1 forces a resigning of the zone */
 	}
 	else	/* try to start a full automated ksk rollover */
@@ -617,8 +747,9 @@ int	kskstatus (zone_t *zonelist, zone_t *zp)
 									zp->zone, dki_geterrstr());
 			}
 			else
-				lg_mesg (LG_INFO, "\"%s\": generated new KSK %d for additional algorithm",
-										zp->zone, akey->tag);
+				lg_event (LG_INFO, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": generated new KSK %d for additional algorithm", zp->zone, akey->tag,
+					"KSK", dki_algo2sstr (akey->algo), "additional algorithm");
 			return 1;	/* return value of 1 forces a resigning of the zone */
 		}
 	}
@@ -626,13 +757,28 @@ int	kskstatus (zone_t *zonelist, zone_t *zp)
 	return 0;
 }
 
+/*****************************************************************
+**	prepublish_flags ()
+**	The pre-publishing of a new ZSK could always be advanced, but
+**	could only be deferred if the new key will be still published
+**	long enough before the active key expires.
+*****************************************************************/
+static	int	prepublish_flags (const dki_t *akey, time_t lifetime, const zconf_t *z, time_t resigntime)
+{
+	if ( resigntime + z->key_ttl + z->proptime < dki_time (akey) + lifetime - (OFFSET) )
+		return TRANS_DEFER|TRANS_ADVANCE;
+	return TRANS_ADVANCE;
+}
+
 /*****************************************************************
 **	zskstatus ()
 **	Check the zsk status of a zone.
+**	Non urgent key transitions are aligned to the next re-signing
+**	of the zone at 'resigntime' (see transition_now()).
 **	Returns 1 if a resigning of the zone is necessary, otherwise
 **	the function returns 0.
 *****************************************************************/
-int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t *z)
+int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t *z, time_t resigntime)
 {
 	dki_t	*akey;
 	dki_t	*nextkey;
@@ -660,12 +806,15 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 	while ( dkp )
 		if ( !dki_isksk (dkp) &&
 		     dki_status (dkp) == DKI_DEPRECIATED && 
-		     dki_age (dkp, currtime) > lifetime )
+		     transition_now (domain, z, "removal of depreciated ZSK", dkp->tag,
+				dki_time (dkp) + lifetime, currtime, resigntime, TRANS_DEFER) )
 		{
 			keychange = 1;
 			verbmesg (1, z, "\tLifetime(%d sec) of depreciated key %d exceeded (%d sec)\n",
 					 lifetime, dkp->tag, dki_age (dkp, currtime));
-			lg_mesg (LG_INFO, "\"%s\": old ZSK %d removed", domain, dkp->tag);
+			lg_event (LG_INFO, "keyremoved", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": old ZSK %d removed", domain, dkp->tag,
+					"ZSK", dki_algo2sstr (dkp->algo), "depreciated");
 			dkp = dki_destroy (dkp);	/* delete the keyfiles */
 			dbg_msg("zskstatus: depreciated key removed ");
 			if ( last )
@@ -682,7 +831,7 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 
 	/* check status of active key */
 	dbg_msg("zskstatus check status of active key ");
-	lifetime = z->z_life;			/* global configured lifetime for zsk */
+	lifetime = key_lifetime (domain, DKI_ZSK, z);	/* global configured lifetime for zsk */
 	akey = (dki_t *)dki_findalgo (*listp, DKI_ZSK, z->k_algo, 'a', 1);
 	if ( akey == NULL && lifetime > 0 )	/* no active key found */
 	{
@@ -694,7 +843,9 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 			lg_mesg (LG_ERROR, "\%s\": can't generate new ZSK", domain);
 		}
 		else
-			lg_mesg (LG_INFO, "\"%s\": generated new ZSK %d", domain, akey->tag);
+			lg_event (LG_INFO, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": generated new ZSK %d", domain, akey->tag,
+					"ZSK", dki_algo2sstr (akey->algo), "no active key");
 	}
 	else	/* active key exist */
 	{
@@ -703,7 +854,9 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 
 		/* lifetime of active key is expired and published key exist ? */
 		age = dki_age (akey, currtime);
-		if ( lifetime > 0 && age > lifetime - (OFFSET) )
+		if ( lifetime > 0 &&
+		     transition_now (domain, z, "rollover of active ZSK", akey->tag,
+				dki_time (akey) + lifetime - (OFFSET), currtime, resigntime, TRANS_DEFER|TRANS_ADVANCE) )
 		{
 			verbmesg (1, z, "\tLifetime(%d +/-%d sec) of active key %d exceeded (%d sec)\n",
 					lifetime, (OFFSET) , akey->tag, dki_age (akey, currtime) );
@@ -722,12 +875,15 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 				dki_setstatus (akey, 'd');	/* depreciate the active key */
 				verbmesg (1, z, "\t\t->activate published key %d\n", nextkey->tag);
 				dki_setstatus (nextkey, 'a');	/* activate published key */
-				lg_mesg (LG_NOTICE, "\"%s\": lifetime of zone signing key %d exceeded: ZSK rollover done", domain, akey->tag);
+				lg_event (LG_NOTICE, "zskrollover", "zone=%s tag=%d newtag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": lifetime of zone signing key %d exceeded: ZSK rollover done",
+					domain, akey->tag, nextkey->tag,
+					"ZSK", dki_algo2sstr (akey->algo), "lifetime exceeded");
 				akey = nextkey;
 				nextkey = NULL;
 				lifetime = dki_lifetime (akey);	/* set lifetime to lt of the new active key (F. Behrens) */
 			}
-			else
+			else if ( age > lifetime - (OFFSET) )
 			{
 				verbmesg (1, z, "\t\t->waiting for published key\n");
 				lg_mesg (LG_NOTICE, "\"%s\": lifetime of zone signing key %d exceeded since %s: ZSK rollover deferred: waiting for published key",
@@ -749,7 +905,9 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 			{
 				keychange = 1;
 				verbmesg (1, z, "\t\t->creating new key %d\n", nextkey->tag);
-				lg_mesg (LG_INFO, "\"%s\": new key %d generated for pre-publishing", domain, nextkey->tag);
+				lg_event (LG_INFO, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": new key %d generated for pre-publishing", domain, nextkey->tag,
+					"ZSK", dki_algo2sstr (nextkey->algo), "pre-publishing");
 			}
 			else
 			{
@@ -767,7 +925,9 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 		 * just before the active key will be removed. See above).
 		 */
 		if ( nextkey == NULL && lifetime > 0 && (akey == NULL ||
-		     dki_age (akey, currtime + z->resign) > lifetime - (OFFSET)) )
+		     transition_now (domain, z, "pre-publishing of successor of ZSK", akey->tag,
+				dki_time (akey) + lifetime - (OFFSET) - z->resign, currtime, resigntime,
+				prepublish_flags (akey, lifetime, z, resigntime))) )
 		{
 			verbmesg (1, z, "\tNew ZSK for publishing needed\n");
 			nextkey = genfirstkey (listp, dir, domain, DKI_ZSK, z, DKI_PUB);
@@ -775,7 +935,9 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 			{
 				keychange = 1;
 				verbmesg (1, z, "\t\t->creating new key %d\n", nextkey->tag);
-				lg_mesg (LG_INFO, "\"%s\": new zone signing key %d generated for publishing", domain, nextkey->tag);
+				lg_event (LG_INFO, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": new zone signing key %d generated for publishing", domain, nextkey->tag,
+					"ZSK", dki_algo2sstr (nextkey->algo), "publishing");
 			}
 			else
 			{
@@ -802,8 +964,9 @@ int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t
 									domain, dki_geterrstr());
 			}
 			else
-				lg_mesg (LG_INFO, "\"%s\": generated new ZSK %d for 2nd algorithm",
-										domain, akey->tag);
+				lg_event (LG_INFO, "newkey", "zone=%s tag=%d type=%s algorithm=%s reason=%s",
+					"\"%s\": generated new ZSK %d for 2nd algorithm", domain, akey->tag,
+					"ZSK", dki_algo2sstr (akey->algo), "additional algorithm");
 			return 1;	/* return value of 1 forces a resigning of the zone */
 		}
 	}
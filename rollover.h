@@ -42,7 +42,9 @@
 # define	ADD_HOLD_DOWN		(30 * DAYSEC)
 # define	REMOVE_HOLD_DOWN	(30 * DAYSEC)
 
-extern	int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zconf_t *z);
+extern	int	ksk5011status (dki_t **listp, const char *dir, const char *domain, const zconf_t *z, time_t resigntime);
 extern	int	kskstatus (zone_t *zonelist, zone_t *zp);
-extern	int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t *z);
+extern	int	zskstatus (dki_t **listp, const char *dir, const char *domain, const zconf_t *z, time_t resigntime);
+extern	time_t	key_lifetime (const char *domain, int ksk, const zconf_t *z);
+extern	int	key_algo (int addkey, const zconf_t *conf);
 #endif
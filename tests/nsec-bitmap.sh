@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+#	Sign a zone with an insecure delegation by the built-in signer
+#	and check the NSEC type bitmap of the delegation point.
+#	The NSEC record is signed, so the bitmap has to include
+#	RRSIG (RFC 4035 2.3): "NS RRSIG NSEC"
+#
+#	usage: tests/nsec-bitmap.sh [zkt-signer]
+#
+
+SIGNER=${1:-`pwd`/zkt-signer}
+if test ! -x "$SIGNER"
+then
+	echo "$0: $SIGNER not found (run make first)"
+	exit 1
+fi
+
+DIR=`mktemp -d ${TMPDIR:-/tmp}/zkt-test.XXXXXX` || exit 1
+trap 'rm -rf "$DIR"' 0
+
+mkdir -p "$DIR/zones/example.test"
+cat > "$DIR/dnssec.conf" <<EOF
+ZoneDir: "$DIR/zones"
+KeyAlgo: RSASHA256
+NSEC3: off
+SigBuiltin: yes
+SigVerify: yes
+KeySetDir: "."
+EOF
+cat > "$DIR/zones/example.test/zone.db" <<EOF
+\$TTL 3600
+@		IN SOA	ns hostmaster 1 3600 600 86400 300
+		IN NS	ns
+ns		IN A	192.0.2.1
+insecure	IN NS	ns.insecure
+ns.insecure	IN A	192.0.2.2
+\$INCLUDE dnskey.db
+EOF
+touch "$DIR/zones/example.test/zone.db.signed"
+
+if ! ZKT_CONFFILE="$DIR/dnssec.conf" "$SIGNER" -D "$DIR/zones" >"$DIR/out" 2>&1
+then
+	cat "$DIR/out"
+	echo "FAIL: zkt-signer failed"
+	exit 1
+fi
+
+bitmap=`awk '$1 == "insecure.example.test." && $4 == "NSEC" { $1 = $2 = $3 = $4 = $5 = ""; print }' \
+	"$DIR/zones/example.test/zone.db.signed" | sed 's/^ *//'`
+if test "$bitmap" != "NS RRSIG NSEC"
+then
+	echo "FAIL: NSEC bitmap of insecure delegation is \"$bitmap\" (expected \"NS RRSIG NSEC\")"
+	exit 1
+fi
+echo "PASS: NSEC bitmap of insecure delegation"
+exit 0
@@ -51,6 +51,9 @@
 # include <strings.h>
 # include <assert.h>
 # include <ctype.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <time.h>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -93,29 +96,72 @@ typedef enum {
 	CONF_VERSION,
 } ctype_t;
 
+/* a local config file applied to a parent config, shared by all zones using the same */
+typedef	struct	zcshared {
+	zconf_t	conf;		/* strings not set by the file are those of the parent */
+	const	zconf_t	*parent;
+	char	*text;		/* content of the config file */
+	size_t	off;		/* start of the parameter records (0 if not compiled) */
+	size_t	len;
+	unsigned	hash;
+	int	refcnt;
+	struct	zcshared	*next;	/* next entry with the same content hash */
+	struct	zcshared	*anext;	/* next entry with the same address hash */
+} zcshared_t;
+
+# define	ZCSHARED_BUCKETS	1024
+# define	zcaddrhash(p)	((unsigned)(((unsigned long)(p) >> 4) % ZCSHARED_BUCKETS))
+
+/* header of a compiled config file (see compileconfig()) */
+# define	SNAP_MAGIC	"ZKTC"
+# define	SNAP_VERSION	2
+typedef	struct	{
+	char	magic[4];
+	unsigned	version;
+	unsigned	fingerprint;	/* of the parameter table and the binary layout */
+	unsigned	reserved;
+	filestamp_t	stamp;		/* of the config file */
+} snaphead_t;
+
+/* output buffer of compileconfig() */
+typedef	struct	{
+	char	*buf;
+	size_t	len;
+	size_t	size;
+} snapbuf_t;
+
 /*****************************************************************
 **	private (static) variables
 *****************************************************************/
 static	int	compversion;
+static	int	parseerrors;		/* number of errors found by parseconfigline() */
+static	zcshared_t	*zcbytext[ZCSHARED_BUCKETS];
+static	zcshared_t	*zcbyaddr[ZCSHARED_BUCKETS];
 
 static	zconf_t	def = {
 	ZONEDIR, RECURSIVE, 
 	PRINTTIME, PRINTAGE, LJUST, LSCOLORTERM,
 	SIG_VALIDITY, MAX_TTL, KEY_TTL, PROPTIME, Unixtime,
-	RESIGN_INT,
+	RESIGN_INT, RESIGN_MARGIN, RESIGN_JITTER,
 	KEY_ALGO, ADDITIONAL_KEY_ALGO,
 	KSK_LIFETIME, KSK_BITS, KSK_RANDOM,
 	ZSK_LIFETIME, ZSK_BITS, ZSK_ALWAYS, ZSK_RANDOM,
-	NSEC3_OFF, SALTLEN,
+	KEY_SPREAD, KEYPOOLDIR, KEYPOOLSIZE,
+	NSEC3_OFF, SALTLEN, SALT_LIFETIME,
 	NULL, /* viewname cmdline parameter */
 	0, /* noexec cmdline parameter */
-	LOGFILE, LOGLEVEL, LOGDOMAINDIR, SYSLOGFACILITY, SYSLOGLEVEL, VERBOSELOG, 0,
+	LOGFILE, LOGLEVEL, LOGDOMAINDIR, LOGFORMAT, SYSLOGFACILITY, SYSLOGLEVEL, VERBOSELOG, 0,
 	DNSKEYFILE, ZONEFILE, KEYSETDIR,
 	LOOKASIDEDOMAIN,
 	SIG_RANDOM, SIG_PSEUDO, SIG_GENDS, SIG_DNSKEY_KSK, SIG_PARAM,
+	SIG_BUILTIN, SIG_THREADS, SIG_INCREMENTAL, SIG_VERIFY, SIGNED_FORMAT,
+	DS_DIGEST, CDS_RECORDS,
 	DEPENDFILES,
 	DIST_CMD,	/* defaults to NULL which means to run "rndc reload" */
-	NAMED_CHROOT
+	DIST_DELTA,
+	NAMED_CHROOT,
+	NAMEDCONF_CACHE,
+	CATALOG_TEMPLATE
 };
 
 typedef	struct {
@@ -152,6 +198,8 @@ static	zconf_para_t	confpara[] = {
 	{ "Max_TTL",		first,	100,	CONF_TIMEINT,	&def.max_ttl },
 	{ "MaximumTTL",		101,	last,	CONF_TIMEINT,	&def.max_ttl },
 	{ "Propagation",	first,	last,	CONF_TIMEINT,	&def.proptime },
+	{ "ResignMargin",	116,	last,	CONF_TIMEINT,	&def.resign_margin, "safety margin before earliest RRSIG expiration (0 = SigValidity - ResignInterval)" },
+	{ "ResignJitter",	116,	last,	CONF_TIMEINT,	&def.resign_jitter, "spread re-signing of zones within this time window" },
 	{ "Key_TTL",		90,	100,	CONF_TIMEINT,	&def.key_ttl },
 	{ "DnsKeyTTL",		101,	last,	CONF_TIMEINT,	&def.key_ttl },
 #if defined (DEF_TTL)
@@ -183,8 +231,12 @@ static	zconf_para_t	confpara[] = {
 #endif
 	{ "ZSK_randfile",	first,	100,	CONF_STRING,	&def.z_random },
 	{ "ZSKrandfile",	101,	last,	CONF_STRING,	&def.z_random },
+	{ "KeyLifetimeSpread",	116,	last,	CONF_TIMEINT,	&def.key_spread, "shorten key lifetimes per zone by up to this value" },
+	{ "KeyPoolDir",		116,	last,	CONF_STRING,	&def.keypooldir, "directory of pre-generated keys (empty: no key pool)" },
+	{ "KeyPoolSize",	116,	last,	CONF_INT,	&def.keypoolsize, "number of keys per key profile kept in the key pool" },
 	{ "NSEC3",		100,	last,	CONF_NSEC3,	&def.nsec3 },
 	{ "SaltBits",		98,	last,	CONF_INT,	&def.saltbits, },
+	{ "SaltLifetime",	116,	last,	CONF_TIMEINT,	&def.salt_life, "lifetime of the NSEC3 salt (0 = never change the salt)" },
 
 	{ "",			first,	last,	CONF_COMMENT,	NULL },
 	{ "",			first,	99,	CONF_COMMENT,	"dnssec-signer options"},
@@ -194,6 +246,7 @@ static	zconf_para_t	confpara[] = {
 	{ "LogFile",		96,	last,	CONF_STRING,	&def.logfile },
 	{ "LogLevel",		96,	last,	CONF_LEVEL,	&def.loglevel },
 	{ "LogDomainDir",	96,	last,	CONF_STRING,	&def.logdomaindir },
+	{ "LogFormat",		116,	last,	CONF_STRING,	&def.logformat, "format of the log file (text or json)" },
 	{ "SyslogFacility",	96,	last,	CONF_FACILITY,	&def.syslogfacility },
 	{ "SyslogLevel",	96,	last,	CONF_LEVEL,	&def.sysloglevel },
 	{ "VerboseLog",		96,	last,	CONF_INT,	&def.verboselog },
@@ -213,14 +266,31 @@ static	zconf_para_t	confpara[] = {
 	{ "SigDnsKeyKSK",	101,	last,	CONF_BOOL,	&def.sig_dnskeyksk, "sign dns keyset with ksk only?" },
 	{ "Sig_Parameter",	first,	100,	CONF_STRING,	&def.sig_param },
 	{ "SigParameter",	101,	last,	CONF_STRING,	&def.sig_param, "additional dnssec-signzone parameter (if any)" },
+	{ "SigBuiltin",		116,	last,	CONF_BOOL,	&def.sig_builtin, "sign static zones with the built-in signer instead of dnssec-signzone?" },
+	{ "SigThreads",		116,	last,	CONF_INT,	&def.sig_threads, "number of signing threads of the built-in signer (0 = number of cpus)" },
+	{ "SigIncremental",	116,	last,	CONF_BOOL,	&def.sig_incremental, "reuse valid signatures of unchanged rrsets (built-in signer only)?" },
+	{ "SigVerify",		116,	last,	CONF_BOOL,	&def.sig_verify, "verify the signed zone before reload (static zones only)?" },
+	{ "SignedFormat",	116,	last,	CONF_STRING,	&def.signed_format, "format of the zone file loaded by the name server (text, raw, map; static zones only)" },
+	{ "DSDigest",		116,	last,	CONF_STRING,	&def.ds_digest, "digest types of the dsset- file (sha256, sha384, sha1; empty: none)" },
+	{ "CDS",		116,	last,	CONF_BOOL,	&def.cds, "publish CDS and CDNSKEY records of the active KSK?" },
 	{ "DependFiles",	113,	last,	CONF_STRING,	&def.dependfiles, "list of files included in ZoneFile (except KeyFile)" },
 	{ "Distribute_Cmd",	97,	100,	CONF_STRING,	&def.dist_cmd },
 	{ "DistributeCmd",	101,	last,	CONF_STRING,	&def.dist_cmd },
+	{ "DistributeDelta",	116,	last,	CONF_STRING,	&def.dist_delta, "pass the zone difference to DistributeCmd as IXFR journal or UPDATE batch (ixfr, update; empty: none)" },
 	{ "NamedChrootDir",	99,	last,	CONF_STRING,	&def.chroot_dir },
+	{ "NamedConfCache",	116,	last,	CONF_STRING,	&def.namedconf_cache, "cache file of the zones found in named.conf (option -N; empty: none)" },
+	{ "CatalogTemplate",	116,	last,	CONF_STRING,	&def.catalog_template, "zone file of catalog members relative to ZoneDir (%z: zone name; trailing '/': ZoneFile)" },
 
 	{ NULL,			0,	0,	CONF_END,	NULL},
 };
 
+/* hash table of the parameter names of confpara[] */
+# define	CONFHASH_SIZE	256	/* power of 2; more than twice the number of names */
+static	zconf_para_t	*hashtab[CONFHASH_SIZE];
+static	unsigned	hashseed;
+static	int	hashperfect;		/* no two names share a slot */
+static	int	hashtab_init = 0;
+
 /*****************************************************************
 **	private (static) function deklaration and definition
 *****************************************************************/
@@ -229,22 +299,117 @@ static	const char	*bool2str (int val)
 	return val ? "True" : "False";
 }
 
-static	int set_varptr (char *entry, void *ptr, const void *ptr2)
+/*****************************************************************
+**	confhash (label, seed)
+**	case insensitive hash of a parameter name
+*****************************************************************/
+static	unsigned	confhash (const char *label, unsigned seed)
+{
+	unsigned	h = 2166136261u ^ seed;	/* FNV-1a */
+
+	while ( *label )
+		h = (h ^ (unsigned char)tolower (*label++)) * 16777619u;
+	return h & (CONFHASH_SIZE - 1);
+}
+
+/*****************************************************************
+**	confhash_init ()
+**	look for a seed which maps every parameter name of confpara[]
+**	to a slot of its own, so a lookup needs one string compare.
+**	If there is no such seed, use linear probing.
+*****************************************************************/
+static	void	confhash_init (void)
 {
 	zconf_para_t	*c;
+	unsigned	seed;
+	unsigned	h;
+	int	collision;
 
-	for ( c = confpara; c->label; c++ )
-		if ( strcasecmp (entry, c->label) == 0 )
+	for ( seed = 0; seed < 1000; seed++ )
+	{
+		memset (hashtab, 0, sizeof (hashtab));
+		collision = 0;
+		for ( c = confpara; !collision && c->type != CONF_END; c++ )
 		{
-			c->var = ptr;
-			c->var2 = ptr2;
-			return 1;
+			if ( c->label == NULL || c->label[0] == '\0' )
+				continue;
+			h = confhash (c->label, seed);
+			if ( hashtab[h] == NULL )
+				hashtab[h] = c;
+			else if ( strcasecmp (hashtab[h]->label, c->label) != 0 )
+				collision = 1;
 		}
-	return 0;
+		if ( !collision )
+		{
+			hashseed = seed;
+			hashperfect = 1;
+			return;
+		}
+	}
+
+	memset (hashtab, 0, sizeof (hashtab));
+	hashseed = 0;
+	hashperfect = 0;
+	for ( c = confpara; c->type != CONF_END; c++ )
+	{
+		if ( c->label == NULL || c->label[0] == '\0' )
+			continue;
+		h = confhash (c->label, hashseed);
+		while ( hashtab[h] && strcasecmp (hashtab[h]->label, c->label) != 0 )
+			h = (h + 1) & (CONFHASH_SIZE - 1);
+		if ( hashtab[h] == NULL )	/* the first one of the same name wins */
+			hashtab[h] = c;
+	}
+}
+
+/*****************************************************************
+**	findpara (label)
+**	returns the entry of confpara[] with the (case insensitive)
+**	name label or NULL
+*****************************************************************/
+static	zconf_para_t	*findpara (const char *label)
+{
+	unsigned	h;
+
+	if ( !hashtab_init )
+	{
+		confhash_init ();
+		hashtab_init = 1;
+	}
+
+	h = confhash (label, hashseed);
+	while ( hashtab[h] )
+	{
+		if ( strcasecmp (hashtab[h]->label, label) == 0 )
+			return hashtab[h];
+		if ( hashperfect )
+			break;
+		h = (h + 1) & (CONFHASH_SIZE - 1);
+	}
+	return NULL;
+}
+
+static	int set_varptr (char *entry, void *ptr, const void *ptr2)
+{
+	zconf_para_t	*c;
+
+	if ( (c = findpara (entry)) == NULL )
+		return 0;
+	c->var = ptr;
+	c->var2 = ptr2;
+	return 1;
 }
 
 static	void set_all_varptr (zconf_t *cp, const zconf_t *cp2)
 {
+	static	zconf_t	*last_cp = NULL;
+	static	const	zconf_t	*last_cp2 = NULL;
+
+	if ( cp == last_cp && cp2 == last_cp2 )	/* confpara[] is already pointing there */
+		return;
+	last_cp = cp;
+	last_cp2 = cp2;
+
 	set_varptr ("zonedir", &cp->zonedir, cp2 ? &cp2->zonedir: NULL);
 	set_varptr ("recursive", &cp->recursive, cp2 ? &cp2->recursive: NULL);
 	set_varptr ("printage", &cp->printage, cp2 ? &cp2->printage: NULL);
@@ -259,6 +424,8 @@ static	void set_all_varptr (zconf_t *cp, const zconf_t *cp2)
 	set_varptr ("key_ttl", &cp->key_ttl, cp2 ? &cp2->key_ttl: NULL);
 	set_varptr ("dnskeyttl", &cp->key_ttl, cp2 ? &cp2->key_ttl: NULL);
 	set_varptr ("propagation", &cp->proptime, cp2 ? &cp2->proptime: NULL);
+	set_varptr ("resignmargin", &cp->resign_margin, cp2 ? &cp2->resign_margin: NULL);
+	set_varptr ("resignjitter", &cp->resign_jitter, cp2 ? &cp2->resign_jitter: NULL);
 #if defined (DEF_TTL)
 	set_varptr ("def_ttl", &cp->def_ttl, cp2 ? &cp2->def_ttl: NULLl);
 #endif
@@ -287,14 +454,19 @@ static	void set_all_varptr (zconf_t *cp, const zconf_t *cp2)
 #endif
 	set_varptr ("zsk_randfile", &cp->z_random, cp2 ? &cp2->z_random: NULL);
 	set_varptr ("zskrandfile", &cp->z_random, cp2 ? &cp2->z_random: NULL);
+	set_varptr ("keylifetimespread", &cp->key_spread, cp2 ? &cp2->key_spread: NULL);
+	set_varptr ("keypooldir", &cp->keypooldir, cp2 ? &cp2->keypooldir: NULL);
+	set_varptr ("keypoolsize", &cp->keypoolsize, cp2 ? &cp2->keypoolsize: NULL);
 	set_varptr ("nsec3", &cp->nsec3, cp2 ? &cp2->nsec3: NULL);
 	set_varptr ("saltbits", &cp->saltbits, cp2 ? &cp2->saltbits: NULL);
+	set_varptr ("saltlifetime", &cp->salt_life, cp2 ? &cp2->salt_life: NULL);
 
 	set_varptr ("--view", &cp->view, cp2 ? &cp2->view: NULL);
 	set_varptr ("--noexec", &cp->noexec, cp2 ? &cp2->noexec: NULL);
 	set_varptr ("logfile", &cp->logfile, cp2 ? &cp2->logfile: NULL);
 	set_varptr ("loglevel", &cp->loglevel, cp2 ? &cp2->loglevel: NULL);
 	set_varptr ("logdomaindir", &cp->logdomaindir, cp2 ? &cp2->logdomaindir: NULL);
+	set_varptr ("logformat", &cp->logformat, cp2 ? &cp2->logformat: NULL);
 	set_varptr ("syslogfacility", &cp->syslogfacility, cp2 ? &cp2->syslogfacility: NULL);
 	set_varptr ("sysloglevel", &cp->sysloglevel, cp2 ? &cp2->sysloglevel: NULL);
 	set_varptr ("verboselog", &cp->verboselog, cp2 ? &cp2->verboselog: NULL);
@@ -314,17 +486,29 @@ static	void set_all_varptr (zconf_t *cp, const zconf_t *cp2)
 	set_varptr ("sigdnskeyksk", &cp->sig_dnskeyksk, cp2 ? &cp2->sig_dnskeyksk: NULL);
 	set_varptr ("sig_parameter", &cp->sig_param, cp2 ? &cp2->sig_param: NULL);
 	set_varptr ("sigparameter", &cp->sig_param, cp2 ? &cp2->sig_param: NULL);
+	set_varptr ("sigbuiltin", &cp->sig_builtin, cp2 ? &cp2->sig_builtin: NULL);
+	set_varptr ("sigthreads", &cp->sig_threads, cp2 ? &cp2->sig_threads: NULL);
+	set_varptr ("sigincremental", &cp->sig_incremental, cp2 ? &cp2->sig_incremental: NULL);
+	set_varptr ("sigverify", &cp->sig_verify, cp2 ? &cp2->sig_verify: NULL);
+	set_varptr ("signedformat", &cp->signed_format, cp2 ? &cp2->signed_format: NULL);
+	set_varptr ("dsdigest", &cp->ds_digest, cp2 ? &cp2->ds_digest: NULL);
+	set_varptr ("cds", &cp->cds, cp2 ? &cp2->cds: NULL);
 	set_varptr ("dependfiles", &cp->dependfiles, cp2 ? &cp2->dependfiles: NULL);
 	set_varptr ("distribute_cmd", &cp->dist_cmd, cp2 ? &cp2->dist_cmd: NULL);
 	set_varptr ("distributecmd", &cp->dist_cmd, cp2 ? &cp2->dist_cmd: NULL);
+	set_varptr ("distributedelta", &cp->dist_delta, cp2 ? &cp2->dist_delta: NULL);
 	set_varptr ("namedchrootdir", &cp->chroot_dir, cp2 ? &cp2->chroot_dir: NULL);
+	set_varptr ("namedconfcache", &cp->namedconf_cache, cp2 ? &cp2->namedconf_cache: NULL);
+	set_varptr ("catalogtemplate", &cp->catalog_template, cp2 ? &cp2->catalog_template: NULL);
 }
 
-static	void	parseconfigline (char *buf, unsigned int line, zconf_t *z)
+static	zconf_para_t	*parseconfigline (char *buf, unsigned int line, zconf_t *z)
 {
 	char		*end, *val, *p;
 	char		*tag;
-	unsigned int	found;
+	char		**str;
+	char		quantity;
+	long		lval;
 	zconf_para_t	*c;
 
 	assert (buf[0] != '\0');
@@ -338,7 +522,7 @@ static	void	parseconfigline (char *buf, unsigned int line, zconf_t *z)
 	
 	/* Ignore comments and emtpy lines */
 	if ( *p == '\0' || ISCOMMENT (p) )
-		return;
+		return NULL;
 
 	tag = p;
 	/* Get the end of the first argument */
@@ -376,127 +560,134 @@ static	void	parseconfigline (char *buf, unsigned int line, zconf_t *z)
 	}
 
 	/* Otherwise it is already terminated above */
-	found = 0;
-	c = confpara;
-	while ( !found && c->type != CONF_END )
+	if ( (c = findpara (tag)) == NULL )
 	{
-		if ( strcasecmp (tag, c->label) == 0 )
-		{
-			char	**str;
-			char	quantity;
-			long	lval;
+		parseerrors++;
+		error ("Unknown configuration statement: %s \"%s\"\n", tag, val);
+		return NULL;
+	}
 
-			found = 1;
-			switch ( c->type )
-			{
-			case CONF_VERSION:
-				break;
-			case CONF_LEVEL:
-			case CONF_FACILITY:
-			case CONF_STRING:
-				str = (char **)c->var;
-				*str = strdup (val);
-				str_untaint (*str);	/* remove "bad" characters */
-				break;
-			case CONF_INT:
-				sscanf (val, "%d", (int *)c->var);
-				break;
-			case CONF_TIMEINT:
-				quantity = 'd';
-				if ( *val == 'u' || *val == 'U' )
-					lval = 0L;
-				else
-					sscanf (val, "%ld%c", &lval, &quantity);
-				if  ( quantity == 'm' )
-					lval *= MINSEC;
-				else if  ( quantity == 'h' )
-					lval *= HOURSEC;
-				else if  ( quantity == 'd' )
-					lval *= DAYSEC;
-				else if  ( quantity == 'w' )
-					lval *= WEEKSEC;
-				else if  ( quantity == 'y' )
-					lval *= YEARSEC;
-				(*(long *)c->var) = lval;
-				break;
-			case CONF_ALGO:
-				if ( strcmp (val, "1") == 0 || strcasecmp (val, "rsa") == 0 ||
-								strcasecmp (val, "rsamd5") == 0 )
-					*((int *)c->var) = DK_ALGO_RSA;
-				else if ( strcmp (val, "3") == 0 ||
-					  strcasecmp (val, "dsa") == 0 )
-					*((int *)c->var) = DK_ALGO_DSA;
-				else if ( strcmp (val, "5") == 0 ||
-					  strcasecmp (val, "rsasha1") == 0 )
-					*((int *)c->var) = DK_ALGO_RSASHA1;
-				else if ( strcmp (val, "6") == 0 ||
-					  strcasecmp (val, "nsec3dsa") == 0 ||
-				          strcasecmp (val, "n3dsa") == 0 )
-					*((int *)c->var) = DK_ALGO_NSEC3DSA;
-				else if ( strcmp (val, "7") == 0 ||
-					  strcasecmp (val, "nsec3rsasha1") == 0 ||
-					  strcasecmp (val, "n3rsasha1") == 0 )
-					*((int *)c->var) = DK_ALGO_NSEC3RSASHA1;
-				else if ( strcmp (val, "8") == 0 ||
-					  strcasecmp (val, "rsasha2") == 0 ||
-				          strcasecmp (val, "rsasha256") == 0 ||
-					  strcasecmp (val, "nsec3rsasha2") == 0 ||
-					  strcasecmp (val, "n3rsasha2") == 0 ||
-					  strcasecmp (val, "nsec3rsasha256") == 0 ||
-					  strcasecmp (val, "n3rsasha256") == 0 )
-					*((int *)c->var) = DK_ALGO_RSASHA256;
-				else if ( strcmp (val, "10") == 0 ||
-					  strcasecmp (val, "rsasha5") == 0 ||
-				          strcasecmp (val, "rsasha512") == 0 ||
-					  strcasecmp (val, "nsec3rsasha5") == 0 ||
-					  strcasecmp (val, "n3rsasha5") == 0 ||
-					  strcasecmp (val, "nsec3rsasha512") == 0 ||
-					  strcasecmp (val, "n3rsasha512") == 0 )
-					*((int *)c->var) = DK_ALGO_RSASHA512;
-				else if ( strcmp (val, "13") == 0 ||
-					  strcasecmp (val, "p256") == 0 ||
-					  strcasecmp (val, "ecdsap256sha256") == 0 )
-					*((int *)c->var) = DK_ALGO_ECDSAP256SHA256;
-				else if ( strcmp (val, "14") == 0 ||
-					  strcasecmp (val, "p384") == 0 ||
-					  strcasecmp (val, "ecdsap384sha384") == 0 )
-					*((int *)c->var) = DK_ALGO_ECDSAP384SHA384;
-				else
-					error ("Illegal algorithm \"%s\" "
-						"in line %d.\n" , val, line);
-				break;
-			case CONF_SERIAL:
-				if ( strcasecmp (val, "unixtime") == 0 )
-					*((serial_form_t *)c->var) = Unixtime;
-				else if ( strcasecmp (val, "incremental") == 0 || strcasecmp (val, "inc") == 0 )
-					*((serial_form_t *)c->var) = Incremental;
-				else
-					error ("Illegal serial no format \"%s\" "
-						"in line %d.\n" , val, line);
-				break;
-			case CONF_NSEC3:
-				if ( strcasecmp (val, "off") == 0 )
-					*((nsec3_t *)c->var) = NSEC3_OFF;
-				else if ( strcasecmp (val, "on") == 0 )
-					*((nsec3_t *)c->var) = NSEC3_ON;
-				else if ( strcasecmp (val, "optout") == 0 )
-					*((nsec3_t *)c->var) = NSEC3_OPTOUT;
-				else
-					error ("Illegal NSEC3 format \"%s\" "
-						"in line %d.\n" , val, line);
-				break;
-			case CONF_BOOL:
-				*((int *)c->var) = ISTRUE (val);
-				break;
-			default:
-				fatal ("Illegal configuration type in line %d.\n", line);
-			}
+	switch ( c->type )
+	{
+	case CONF_VERSION:
+		break;
+	case CONF_LEVEL:
+	case CONF_FACILITY:
+	case CONF_STRING:
+		str = (char **)c->var;
+		*str = strdup (val);
+		str_untaint (*str);	/* remove "bad" characters */
+		break;
+	case CONF_INT:
+		sscanf (val, "%d", (int *)c->var);
+		break;
+	case CONF_TIMEINT:
+		quantity = 'd';
+		if ( *val == 'u' || *val == 'U' )
+			lval = 0L;
+		else
+			sscanf (val, "%ld%c", &lval, &quantity);
+		if  ( quantity == 'm' )
+			lval *= MINSEC;
+		else if  ( quantity == 'h' )
+			lval *= HOURSEC;
+		else if  ( quantity == 'd' )
+			lval *= DAYSEC;
+		else if  ( quantity == 'w' )
+			lval *= WEEKSEC;
+		else if  ( quantity == 'y' )
+			lval *= YEARSEC;
+		(*(long *)c->var) = lval;
+		break;
+	case CONF_ALGO:
+		if ( strcmp (val, "1") == 0 || strcasecmp (val, "rsa") == 0 ||
+						strcasecmp (val, "rsamd5") == 0 )
+			*((int *)c->var) = DK_ALGO_RSA;
+		else if ( strcmp (val, "3") == 0 ||
+			  strcasecmp (val, "dsa") == 0 )
+			*((int *)c->var) = DK_ALGO_DSA;
+		else if ( strcmp (val, "5") == 0 ||
+			  strcasecmp (val, "rsasha1") == 0 )
+			*((int *)c->var) = DK_ALGO_RSASHA1;
+		else if ( strcmp (val, "6") == 0 ||
+			  strcasecmp (val, "nsec3dsa") == 0 ||
+		          strcasecmp (val, "n3dsa") == 0 )
+			*((int *)c->var) = DK_ALGO_NSEC3DSA;
+		else if ( strcmp (val, "7") == 0 ||
+			  strcasecmp (val, "nsec3rsasha1") == 0 ||
+			  strcasecmp (val, "n3rsasha1") == 0 )
+			*((int *)c->var) = DK_ALGO_NSEC3RSASHA1;
+		else if ( strcmp (val, "8") == 0 ||
+			  strcasecmp (val, "rsasha2") == 0 ||
+		          strcasecmp (val, "rsasha256") == 0 ||
+			  strcasecmp (val, "nsec3rsasha2") == 0 ||
+			  strcasecmp (val, "n3rsasha2") == 0 ||
+			  strcasecmp (val, "nsec3rsasha256") == 0 ||
+			  strcasecmp (val, "n3rsasha256") == 0 )
+			*((int *)c->var) = DK_ALGO_RSASHA256;
+		else if ( strcmp (val, "10") == 0 ||
+			  strcasecmp (val, "rsasha5") == 0 ||
+		          strcasecmp (val, "rsasha512") == 0 ||
+			  strcasecmp (val, "nsec3rsasha5") == 0 ||
+			  strcasecmp (val, "n3rsasha5") == 0 ||
+			  strcasecmp (val, "nsec3rsasha512") == 0 ||
+			  strcasecmp (val, "n3rsasha512") == 0 )
+			*((int *)c->var) = DK_ALGO_RSASHA512;
+		else if ( strcmp (val, "13") == 0 ||
+			  strcasecmp (val, "p256") == 0 ||
+			  strcasecmp (val, "ecdsap256sha256") == 0 )
+			*((int *)c->var) = DK_ALGO_ECDSAP256SHA256;
+		else if ( strcmp (val, "14") == 0 ||
+			  strcasecmp (val, "p384") == 0 ||
+			  strcasecmp (val, "ecdsap384sha384") == 0 )
+			*((int *)c->var) = DK_ALGO_ECDSAP384SHA384;
+		else if ( strcmp (val, "15") == 0 ||
+			  strcasecmp (val, "ed25519") == 0 )
+			*((int *)c->var) = DK_ALGO_ED25519;
+		else if ( strcmp (val, "16") == 0 ||
+			  strcasecmp (val, "ed448") == 0 )
+			*((int *)c->var) = DK_ALGO_ED448;
+		else
+		{
+			parseerrors++;
+			error ("Illegal algorithm \"%s\" "
+				"in line %d.\n" , val, line);
 		}
-		c++;
+		break;
+	case CONF_SERIAL:
+		if ( strcasecmp (val, "unixtime") == 0 )
+			*((serial_form_t *)c->var) = Unixtime;
+		else if ( strcasecmp (val, "incremental") == 0 || strcasecmp (val, "inc") == 0 )
+			*((serial_form_t *)c->var) = Incremental;
+		else
+		{
+			parseerrors++;
+			error ("Illegal serial no format \"%s\" "
+				"in line %d.\n" , val, line);
+		}
+		break;
+	case CONF_NSEC3:
+		if ( strcasecmp (val, "off") == 0 )
+			*((nsec3_t *)c->var) = NSEC3_OFF;
+		else if ( strcasecmp (val, "on") == 0 )
+			*((nsec3_t *)c->var) = NSEC3_ON;
+		else if ( strcasecmp (val, "optout") == 0 )
+			*((nsec3_t *)c->var) = NSEC3_OPTOUT;
+		else
+		{
+			parseerrors++;
+			error ("Illegal NSEC3 format \"%s\" "
+				"in line %d.\n" , val, line);
+		}
+		break;
+	case CONF_BOOL:
+		*((int *)c->var) = ISTRUE (val);
+		break;
+	default:
+		fatal ("Illegal configuration type in line %d.\n", line);
 	}
-	if ( !found )
-		error ("Unknown configuration statement: %s \"%s\"\n", tag, val);
-	return;
+
+	return c;
 }
 
 static	void	printconfigline (FILE *fp, zconf_para_t *cp)
@@ -606,6 +797,299 @@ static	void	printconfigline (FILE *fp, zconf_para_t *cp)
 	}
 }
 
+/*****************************************************************
+**	readfile (fname, &len)
+**	returns the content of the file fname in a dynamically
+**	allocated and '\0' terminated buffer or NULL if the file
+**	could not be opened
+*****************************************************************/
+static	char	*readfile (const char *fname, size_t *lenp)
+{
+	char	*buf;
+	char	*p;
+	size_t	len;
+	size_t	size;
+	ssize_t	n;
+	int	fd;
+
+	if ( (fd = open (fname, O_RDONLY)) < 0 )
+		return NULL;
+
+	len = 0;
+	size = 4096;
+	if ( (buf = malloc (size)) == NULL )
+		fatal ("readfile: Out of memory\n");
+	while ( (n = read (fd, buf + len, size - len - 1)) > 0 )
+		if ( (len += n) == size - 1 )
+		{
+			if ( (p = realloc (buf, size *= 2)) == NULL )
+				fatal ("readfile: Out of memory\n");
+			buf = p;
+		}
+	close (fd);
+
+	buf[len] = '\0';
+	*lenp = len;
+	return buf;
+}
+
+/*****************************************************************
+**	parseconfigtext (text, len, conf, sb)
+**	parse the config file content "text" line by line into "z"
+**	and append a record of each parameter set to "sb" (if any)
+*****************************************************************/
+static	void	snaprecord (snapbuf_t *sb, const zconf_para_t *c);
+static	void	parseconfigtext (const char *text, size_t len, zconf_t *z, snapbuf_t *sb)
+{
+	char		buf[1023+1];
+	const	char	*p;
+	const	char	*end;
+	size_t		n;
+	unsigned int	line;
+	zconf_para_t	*c;
+
+	set_all_varptr (z, NULL);
+	line = 0;
+	for ( p = text; p < text + len; p = end + 1 )
+	{
+		if ( (end = memchr (p, '\n', text + len - p)) == NULL )
+			end = text + len;
+		n = end - p;
+		if ( n >= sizeof (buf) )	/* as fgets() would do */
+			n = sizeof (buf) - 1;
+		memcpy (buf, p, n);
+		buf[n] = '\0';
+		line++;
+		if ( n > 0 && (c = parseconfigline (buf, line, z)) != NULL && sb )
+			snaprecord (sb, c);
+	}
+}
+
+/*****************************************************************
+**	snapfingerprint ()
+**	hash of the parameter table and the size of the types stored
+**	in a compiled config file. A compiled file with another
+**	fingerprint was made by a different version and is ignored.
+*****************************************************************/
+static	unsigned	snapfingerprint (void)
+{
+	zconf_para_t	*c;
+	const	char	*p;
+	unsigned	h;
+
+	h = 2166136261u;		/* FNV-1a */
+	for ( c = confpara; c->type != CONF_END; c++ )
+	{
+		for ( p = c->label ? c->label : ""; *p; p++ )
+			h = (h ^ (unsigned char)*p) * 16777619u;
+		h = (h ^ (unsigned)c->type) * 16777619u;
+	}
+	h = (h ^ (unsigned)sizeof (int)) * 16777619u;
+	h = (h ^ (unsigned)sizeof (long)) * 16777619u;
+
+	return h;
+}
+
+static	void	snapput (snapbuf_t *sb, const void *data, size_t len)
+{
+	char	*p;
+
+	if ( sb->len + len > sb->size )
+	{
+		sb->size = sb->size ? sb->size * 2 + len : 4096 + len;
+		if ( (p = realloc (sb->buf, sb->size)) == NULL )
+			fatal ("compileconfig: Out of memory\n");
+		sb->buf = p;
+	}
+	memcpy (sb->buf + sb->len, data, len);
+	sb->len += len;
+}
+
+/*****************************************************************
+**	snaprecord (sb, c)
+**	append the current value of parameter c to the compiled config:
+**	the index of c in confpara[] followed by the value (strings
+**	as length and characters without the '\0', length -1 for NULL)
+*****************************************************************/
+static	void	snaprecord (snapbuf_t *sb, const zconf_para_t *c)
+{
+	unsigned short	idx;
+	const	char	*str;
+	int	slen;
+
+	if ( c->type == CONF_VERSION || c->type == CONF_COMMENT )
+		return;
+
+	idx = c - confpara;
+	snapput (sb, &idx, sizeof (idx));
+	switch ( c->type )
+	{
+	case CONF_LEVEL:
+	case CONF_FACILITY:
+	case CONF_STRING:
+		str = *(char **)c->var;
+		slen = str ? (int)strlen (str) : -1;
+		snapput (sb, &slen, sizeof (slen));
+		if ( slen > 0 )
+			snapput (sb, str, slen);
+		break;
+	case CONF_TIMEINT:
+		snapput (sb, c->var, sizeof (long));
+		break;
+	default:	/* CONF_INT, CONF_BOOL, CONF_ALGO, CONF_SERIAL, CONF_NSEC3 */
+		snapput (sb, c->var, sizeof (int));
+		break;
+	}
+}
+
+/*****************************************************************
+**	snapapply (rec, len, z)
+**	set the parameters of the compiled config records "rec" in "z".
+**	If z is NULL, the records are only checked.
+**	Returns 1 if all records are well formed, 0 otherwise.
+*****************************************************************/
+static	int	snapapply (const char *rec, size_t len, zconf_t *z)
+{
+	const	char	*p;
+	const	char	*end;
+	zconf_para_t	*c;
+	unsigned short	idx;
+	unsigned	npara;
+	char	*str;
+	int	slen;
+	size_t	vlen;
+
+	for ( npara = 0; confpara[npara].type != CONF_END; npara++ )
+		;
+	if ( z )
+		set_all_varptr (z, NULL);
+
+	for ( p = rec, end = rec + len; p < end; p += vlen )
+	{
+		if ( (size_t)(end - p) < sizeof (idx) )
+			return 0;
+		memcpy (&idx, p, sizeof (idx));
+		p += sizeof (idx);
+		if ( idx >= npara )
+			return 0;
+		c = &confpara[idx];
+
+		switch ( c->type )
+		{
+		case CONF_LEVEL:
+		case CONF_FACILITY:
+		case CONF_STRING:
+			if ( (size_t)(end - p) < sizeof (slen) )
+				return 0;
+			memcpy (&slen, p, sizeof (slen));
+			p += sizeof (slen);
+			vlen = slen > 0 ? slen : 0;
+			if ( slen < -1 || (size_t)(end - p) < vlen )
+				return 0;
+			if ( z == NULL )
+				break;
+			str = NULL;
+			if ( slen >= 0 )
+			{
+				if ( (str = malloc (vlen + 1)) == NULL )
+					fatal ("loadconfig: Out of memory\n");
+				memcpy (str, p, vlen);
+				str[vlen] = '\0';
+			}
+			*(char **)c->var = str;
+			break;
+		case CONF_TIMEINT:
+			if ( (size_t)(end - p) < (vlen = sizeof (long)) )
+				return 0;
+			if ( z )
+				memcpy (c->var, p, vlen);
+			break;
+		case CONF_INT:
+		case CONF_BOOL:
+		case CONF_ALGO:
+		case CONF_SERIAL:
+		case CONF_NSEC3:
+			if ( (size_t)(end - p) < (vlen = sizeof (int)) )
+				return 0;
+			if ( z )
+				memcpy (c->var, p, vlen);
+			break;
+		default:
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*****************************************************************
+**	readconfig (filename, &len, &off)
+**	returns the content of the compiled config file of filename
+**	if there is one which is up to date, the content of filename
+**	otherwise. "off" is set to the start of the parameter records
+**	of a compiled config and to 0 for a config file.
+*****************************************************************/
+static	char	*readconfig (const char *filename, size_t *lenp, size_t *offp)
+{
+	char	snapfile[MAX_PATHSIZE+1];
+	struct	stat	st;
+	filestamp_t	stamp;
+	snaphead_t	head;
+	char	*buf;
+	size_t	len;
+
+	if ( stat (filename, &st) == 0 &&
+	     snprintf (snapfile, sizeof (snapfile), "%s%s", filename, CONFIG_SNAPSHOT_EXT) < (int)sizeof (snapfile) &&
+	     (buf = readfile (snapfile, &len)) != NULL )
+	{
+		file_stamp (&stamp, &st);
+		if ( len >= sizeof (head) )
+		{
+			memcpy (&head, buf, sizeof (head));
+			if ( memcmp (head.magic, SNAP_MAGIC, sizeof (head.magic)) == 0 &&
+			     head.version == SNAP_VERSION &&
+			     head.fingerprint == snapfingerprint () &&
+			     file_stampcmp (&head.stamp, &stamp) == 0 &&
+			     snapapply (buf + sizeof (head), len - sizeof (head), NULL) )
+			{
+				dbg_val1 ("readconfig (%s): compiled\n", filename);
+				*lenp = len;
+				*offp = sizeof (head);
+				return buf;
+			}
+		}
+		dbg_val1 ("readconfig (%s): compiled config out of date\n", filename);
+		free (buf);
+	}
+
+	if ( (buf = readfile (filename, lenp)) == NULL )
+		fatal ("Could not open config file \"%s\"\n", filename);
+	*offp = 0;
+	return buf;
+}
+
+/*****************************************************************
+**	freestrings (z, ref)
+**	free the strings of config z which differ from those of ref
+*****************************************************************/
+static	void	freestrings (zconf_t *z, const zconf_t *ref)
+{
+	zconf_para_t	*c;
+
+	set_all_varptr (z, ref);
+	for ( c = confpara; c->type != CONF_END; c++ )
+	{
+		if ( c->type != CONF_STRING && c->type != CONF_LEVEL && c->type != CONF_FACILITY )
+			continue;
+		if ( c->var == NULL || c->var2 == NULL )
+			continue;
+		if ( *(char **)c->var != *(char *const *)c->var2 )
+		{
+			free (*(char **)c->var);
+			*(char **)c->var = *(char *const *)c->var2;	/* aliases of the same parameter */
+		}
+	}
+}
+
 /*****************************************************************
 **	public function definition
 *****************************************************************/
@@ -644,13 +1128,15 @@ const char	*timeint2str (unsigned long val)
 **	If "z" is NULL then a new conf struct will be dynamically
 **	allocated.
 **	If no filename is given the conf struct will be initialized
-**	with the builtin default config
+**	with the builtin default config.
+**	An up to date compiled config of the file (see compileconfig())
+**	is used instead of the file itself.
 *****************************************************************/
 zconf_t	*loadconfig (const char *filename, zconf_t *z)
 {
-	FILE		*fp;
-	char		buf[1023+1];
-	unsigned int	line;
+	char	*buf;
+	size_t	len;
+	size_t	off;
 
 	if ( z == NULL )	/* allocate new memory for zconf_t */
 	{
@@ -669,16 +1155,13 @@ zconf_t	*loadconfig (const char *filename, zconf_t *z)
 	}
 
 	dbg_val1 ("loadconfig (%s)\n", filename);
-	set_all_varptr (z, NULL);
-
-	if ( (fp = fopen(filename, "r")) == NULL )
-		fatal ("Could not open config file \"%s\"\n", filename);
-
-	line = 0;
-	while (fgets(buf, sizeof(buf), fp))
-		parseconfigline (buf, ++line, z);
+	buf = readconfig (filename, &len, &off);
+	if ( off )
+		snapapply (buf + off, len - off, z);
+	else
+		parseconfigtext (buf, len, z, NULL);
+	free (buf);
 
-	fclose(fp);
 	return z;
 }
 
@@ -752,6 +1235,186 @@ zconf_t	*freeconfig (zconf_t *conf)
 	return (zconf_t *)NULL;
 }
 
+/*****************************************************************
+**	loadconfig_shared (file, parent)
+**	Same as loadconfig (file, dupconfig (parent)), but configs
+**	with the same file content and the same parent are parsed only
+**	once and shared. Only the strings set by the file are owned
+**	by the new config, all others are those of the parent.
+**	The parent has to be kept until the config is released by
+**	releaseconfig().
+*****************************************************************/
+const	zconf_t	*loadconfig_shared (const char *filename, const zconf_t *parent)
+{
+	zcshared_t	*e;
+	char	*text;
+	const	char	*p;
+	size_t	len;
+	size_t	off;
+	unsigned	hash;
+
+	assert (filename != NULL && *filename != '\0');
+	assert (parent != NULL);
+
+	text = readconfig (filename, &len, &off);
+
+	hash = 2166136261u;		/* FNV-1a of the content and the parent */
+	for ( p = text + off; p < text + len; p++ )
+		hash = (hash ^ (unsigned char)*p) * 16777619u;
+	hash ^= zcaddrhash (parent) ^ (off != 0);
+
+	for ( e = zcbytext[hash % ZCSHARED_BUCKETS]; e; e = e->next )
+		if ( e->hash == hash && e->parent == parent && e->off == off && e->len == len &&
+		     memcmp (e->text + off, text + off, len - off) == 0 )
+		{
+			dbg_val1 ("loadconfig_shared (%s): shared\n", filename);
+			free (text);
+			e->refcnt++;
+			return &e->conf;
+		}
+
+	dbg_val1 ("loadconfig_shared (%s)\n", filename);
+	if ( (e = calloc (1, sizeof (zcshared_t))) == NULL )
+		fatal ("loadconfig_shared: Out of memory\n");
+	memcpy (&e->conf, parent, sizeof (zconf_t));
+	e->parent = parent;
+	e->text = text;
+	e->off = off;
+	e->len = len;
+	e->hash = hash;
+	e->refcnt = 1;
+
+	if ( off )
+		snapapply (text + off, len - off, &e->conf);
+	else
+		parseconfigtext (text, len, &e->conf, NULL);
+
+	e->next = zcbytext[hash % ZCSHARED_BUCKETS];
+	zcbytext[hash % ZCSHARED_BUCKETS] = e;
+	e->anext = zcbyaddr[zcaddrhash (&e->conf)];
+	zcbyaddr[zcaddrhash (&e->conf)] = e;
+
+	return &e->conf;
+}
+
+/*****************************************************************
+**	releaseconfig (config)
+**	drop a reference to a config returned by loadconfig_shared()
+**	and free it with the strings owned by it if it was the last one.
+**	Any other config is left alone.
+*****************************************************************/
+void	releaseconfig (const zconf_t *conf)
+{
+	zcshared_t	**pp;
+	zcshared_t	*e;
+
+	if ( conf == NULL )
+		return;
+
+	for ( pp = &zcbyaddr[zcaddrhash (conf)]; *pp && &(*pp)->conf != conf; pp = &(*pp)->anext )
+		;
+	if ( (e = *pp) == NULL )	/* not a shared config */
+		return;
+	if ( --e->refcnt > 0 )
+		return;
+	*pp = e->anext;
+
+	for ( pp = &zcbytext[e->hash % ZCSHARED_BUCKETS]; *pp != e; pp = &(*pp)->next )
+		;
+	*pp = e->next;
+
+	freestrings (&e->conf, e->parent);
+
+	free (e->text);
+	free (e);
+}
+
+/*****************************************************************
+**	compileconfig (file)
+**	Parses the config file and, if there is no error in it,
+**	stores the parameters set by the file in binary form in
+**	"file" CONFIG_SNAPSHOT_EXT. This compiled config is used by
+**	loadconfig() as long as the file stamp (see file_stamp())
+**	is unchanged. A file modified in the current second is not
+**	compiled, because the next change may keep the same stamp.
+**	Returns 1 on success, 0 otherwise.
+*****************************************************************/
+int	compileconfig (const char *filename)
+{
+	char	snapfile[MAX_PATHSIZE+1];
+	char	tmpfile[MAX_PATHSIZE+4+1];
+	struct	stat	st;
+	snaphead_t	head;
+	snapbuf_t	sb;
+	zconf_t	z;
+	char	*text;
+	size_t	len;
+	ssize_t	n;
+	size_t	off;
+	int	fd;
+
+	assert (filename != NULL && *filename != '\0');
+
+	if ( snprintf (snapfile, sizeof (snapfile), "%s%s", filename, CONFIG_SNAPSHOT_EXT) >= (int)sizeof (snapfile) ||
+	     snprintf (tmpfile, sizeof (tmpfile), "%s.tmp", snapfile) >= (int)sizeof (tmpfile) )
+	{
+		error ("compileconfig: path name \"%s\" too long\n", filename);
+		return 0;
+	}
+	if ( stat (filename, &st) < 0 || (text = readfile (filename, &len)) == NULL )
+	{
+		error ("Could not open config file \"%s\"\n", filename);
+		return 0;
+	}
+
+	memset (&head, 0, sizeof (head));
+	file_stamp (&head.stamp, &st);
+	if ( !file_stampisold (&head.stamp, time (NULL)) )	/* a change in this second may go unnoticed */
+	{
+		error ("%s: modified in the current second, config not compiled (try again)\n", filename);
+		free (text);
+		return 0;
+	}
+	memcpy (head.magic, SNAP_MAGIC, sizeof (head.magic));
+	head.version = SNAP_VERSION;
+	head.fingerprint = snapfingerprint ();
+	memset (&sb, 0, sizeof (sb));
+	snapput (&sb, &head, sizeof (head));
+
+	memcpy (&z, &def, sizeof (zconf_t));
+	parseerrors = 0;
+	parseconfigtext (text, len, &z, &sb);
+	freestrings (&z, &def);
+	free (text);
+
+	if ( parseerrors > 0 )
+	{
+		error ("%s: %d error%s found, config not compiled\n",
+				filename, parseerrors, parseerrors > 1 ? "s" : "");
+		free (sb.buf);
+		return 0;
+	}
+
+	if ( (fd = open (tmpfile, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0 )
+	{
+		error ("compileconfig: could not create \"%s\"\n", tmpfile);
+		free (sb.buf);
+		return 0;
+	}
+	for ( off = 0; off < sb.len; off += n )
+		if ( (n = write (fd, sb.buf + off, sb.len - off)) <= 0 )
+			break;
+	free (sb.buf);
+	if ( close (fd) < 0 || off < sb.len || rename (tmpfile, snapfile) < 0 )
+	{
+		error ("compileconfig: could not write \"%s\"\n", snapfile);
+		unlink (tmpfile);
+		return 0;
+	}
+
+	return 1;
+}
+
 /*****************************************************************
 **	setconfigpar (entry, pval)
 *****************************************************************/
@@ -958,6 +1621,28 @@ int	checkconfig (const zconf_t *z)
 	if ( z->k_algo == DK_ALGO_RSASHA512 && ( z->k_bits < 1024 || z->z_bits < 1024 ) )
 		ret = fprintf (stderr, "Algorithm RSASHA 512 requires a bit size of at least 1024 \n");
 
+	if ( dki_str2digest (z->ds_digest) < 0 )
+		ret = fprintf (stderr, "Unknown DS digest type in \"%s\"\n", z->ds_digest);
+
+	if ( z->signed_format && *z->signed_format && strcasecmp (z->signed_format, "text") != 0 &&
+	     strcasecmp (z->signed_format, "raw") != 0 && strcasecmp (z->signed_format, "map") != 0 )
+		ret = fprintf (stderr, "Unknown SignedFormat \"%s\" (use text, raw or map)\n", z->signed_format);
+
+	if ( z->logformat && *z->logformat && strcasecmp (z->logformat, "text") != 0 &&
+	     strcasecmp (z->logformat, "json") != 0 )
+		ret = fprintf (stderr, "Unknown LogFormat \"%s\" (use text or json)\n", z->logformat);
+
+	if ( z->dist_delta && *z->dist_delta && strcasecmp (z->dist_delta, "ixfr") != 0 &&
+	     strcasecmp (z->dist_delta, "update") != 0 && strcasecmp (z->dist_delta, "none") != 0 )
+		ret = fprintf (stderr, "Unknown DistributeDelta format \"%s\" (use ixfr or update)\n", z->dist_delta);
+
+	if ( z->catalog_template && *z->catalog_template &&
+	     strstr (z->catalog_template, "%z") == NULL && strstr (z->catalog_template, "%Z") == NULL )
+		ret = fprintf (stderr, "CatalogTemplate \"%s\" should contain the zone name (%%z or %%Z)\n", z->catalog_template);
+
+	if ( z->sig_threads < 0 || z->sig_threads > 64 )
+		ret = fprintf (stderr, "SigThreads should be between 0 (number of cpus) and 64\n");
+
 	if ( z->saltbits < 4 )
 		ret = fprintf (stderr, "Saltlength must be at least 4 bits\n");
 	if ( z->saltbits > 128 )
@@ -996,6 +1681,12 @@ int	checkconfig (const zconf_t *z)
 		ret = fprintf (stderr, "signature lifetime (%ld) (%s)\n", z->sigvalidity, timeint2str(z->sigvalidity - max_ttl));
 	}
 
+	if ( z->resign_jitter > 0 && z->resign_jitter > z->resign / 2 )
+	{
+		fprintf (stderr, "Re-signing jitter (%s) should be less ", timeint2str (z->resign_jitter));
+		ret = fprintf (stderr, "than half of the re-signing interval (%s)\n", timeint2str (z->resign));
+	}
+
 	if ( z->z_life > (24 * WEEKSEC) * (z->z_bits / 512.) )
 	{
 		fprintf (stderr, "Lifetime of zone signing key (%s) ", timeint2str (z->z_life));
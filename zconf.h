@@ -60,6 +60,8 @@
 #endif
 
 # define	RESIGN_INT	((SIG_VALID_DAYS - (SIG_VALID_DAYS / 3)) * DAYSEC)
+# define	RESIGN_MARGIN	(0)	/* 0 means SigValidity - ResignInterval */
+# define	RESIGN_JITTER	(0)	/* no jitter */
 # define	KSK_LIFETIME	(2 * YEARSEC)
 #if 1
 # define	ZSK_LIFETIME	((SIG_VALID_DAYS * 3) * DAYSEC)	/* set to three times the sig validity */
@@ -75,9 +77,13 @@
 /* # define	ZSK_ALGO	(DK_ALGO_RSASHA1)	ZSK_ALGO has to be the same as KSK, so this is no longer used (v0.99) */
 # define	ZSK_BITS	(512)
 # define	ZSK_ALWAYS	0
+# define	KEY_SPREAD	(0)	/* no staggering of key lifetimes */
+# define	KEYPOOLDIR	""	/* no pool of pre-generated keys */
+# define	KEYPOOLSIZE	4
 # define	ZSK_RANDOM	"/dev/urandom"
 # define	NSEC3		0		/* by default nsec3 is off */
 # define	SALTLEN		0		/* salt length in bits (resolution is 4 bits)*/
+# define	SALT_LIFETIME	(0)		/* 0 means never change the salt (RFC 9276) */
 
 #if 0
 # define	ZONEDIR		"."
@@ -93,6 +99,7 @@
 # define	LOGFILE		""
 # define	LOGLEVEL	"error"
 # define	LOGDOMAINDIR	""
+# define	LOGFORMAT	"text"	/* format of the log file (text or json) */
 # define	SYSLOGFACILITY	"none"
 # define	SYSLOGLEVEL	"notice"
 # define	VERBOSELOG	0
@@ -104,15 +111,27 @@
 # define	SIG_GENDS	1
 # define	SIG_DNSKEY_KSK	0	/* Sign DNSKEY RR with KSK only */
 # define	SIG_PARAM	""
+# define	SIG_BUILTIN	0	/* use the built-in signer instead of dnssec-signzone ? */
+# define	SIG_THREADS	0	/* number of signing threads (0 = number of cpus) */
+# define	SIG_INCREMENTAL	0	/* reuse valid signatures of the signed zone ? */
+# define	SIG_VERIFY	1	/* verify the signed zone before reload ? */
+# define	SIGNED_FORMAT	"text"	/* format of the zone file loaded by named (text, raw, map) */
+# define	DS_DIGEST	"sha256"	/* digest types of in-process generated DS records */
+# define	CDS_RECORDS	0	/* add CDS and CDNSKEY records to the key file ? */
 # define	DEPENDFILES	""
 # define	DIST_CMD	NULL	/* default is to run "rndc reload" */
+# define	DIST_DELTA	""	/* format of the zone difference passed to DIST_CMD */
 # define	NAMED_CHROOT	NULL	/* default is none */
+# define	NAMEDCONF_CACHE	""	/* no cache of the parsed named.conf files */
+# define	CATALOG_TEMPLATE	"%z/"	/* zone file of a catalog member relative to ZoneDir */
 
 #ifndef CONFIG_PATH
 # define	CONFIG_PATH	"/var/named/"
 #endif
 # define	CONFIG_FILE	CONFIG_PATH "dnssec.conf"
 # define	LOCALCONF_FILE	"dnssec.conf"
+# define	CONFIG_SNAPSHOT_EXT	".zktc"	/* compiled config file (zkt-conf -b) */
+# define	ZONESTATE_FILE	"zkt.state"	/* per zone state (e.g. signature times) */
 
 /* external command execution path (should be set via config.h) */
 #ifndef BIND_UTIL_PATH
@@ -121,6 +140,7 @@
 # define	SIGNCMD		BIND_UTIL_PATH "dnssec-signzone"
 # define	KEYGENCMD	BIND_UTIL_PATH "dnssec-keygen"
 # define	RELOADCMD	BIND_UTIL_PATH "rndc"
+# define	COMPILECMD	BIND_UTIL_PATH "named-compilezone"
 
 /* macros */
 # define	isflistdelim(c)	( (c) == ':' || (c) == ',' || isspace (c) )
@@ -158,6 +178,8 @@ typedef	struct zconf	{
 #endif
 	serial_form_t	serialform;	/* format of serial no */
 	long	resign;		/* resign interval */
+	long	resign_margin;	/* safety margin before the earliest signature expiration */
+	long	resign_jitter;	/* window for spreading the re-signing time of zones */
 
 	int	k_algo;
 	int	k2_algo;
@@ -169,8 +191,12 @@ typedef	struct zconf	{
 	int	z_bits;
 	int	z_always;	/* always pre-publish zsk ? */
 	char	*z_random;
+	long	key_spread;	/* band for staggering key lifetimes per zone */
+	char	*keypooldir;	/* directory of pre-generated keys */
+	int	keypoolsize;	/* number of keys per key profile in the pool */
 	nsec3_t	nsec3;		/* 0 == off; 1 == on; 2 == on with optout */
 	int	saltbits;
+	long	salt_life;	/* lifetime of the NSEC3 salt of static zones */
 
 	char	*view;
 	int	noexec;
@@ -178,6 +204,7 @@ typedef	struct zconf	{
 	char	*logfile;
 	char	*loglevel;
 	char	*logdomaindir;
+	char	*logformat;	/* "text" or "json" */
 	char	*syslogfacility;
 	char	*sysloglevel;
 	int	verboselog;
@@ -191,9 +218,19 @@ typedef	struct zconf	{
 	int	sig_gends;
 	int	sig_dnskeyksk;
 	char	*sig_param;
+	int	sig_builtin;	/* use the built-in signer ? */
+	int	sig_threads;	/* number of threads of the built-in signer */
+	int	sig_incremental;	/* reuse the signatures of unchanged rrsets ? */
+	int	sig_verify;	/* verify the signed zone before reload ? */
+	char	*signed_format;	/* "text", "raw" or "map" */
+	char	*ds_digest;	/* list of DS digest types ("" = no dsset- file) */
+	int	cds;		/* publish CDS/CDNSKEY records ? */
 	char	*dependfiles;
 	char	*dist_cmd;	/* cmd to run instead of "rndc reload" */
+	char	*dist_delta;	/* "ixfr", "update" or "" */
 	char	*chroot_dir;	/* chroot directory of named */
+	char	*namedconf_cache;	/* cache file of the parsed named.conf files */
+	char	*catalog_template;	/* path of the zone file of catalog members */
 } zconf_t;
 
 extern	const char	*timeint2str (unsigned long val);
@@ -201,6 +238,9 @@ extern	zconf_t	*loadconfig (const char *filename, zconf_t *z);
 extern	zconf_t	*loadconfig_fromstr (const char *str, zconf_t *z);
 extern	zconf_t	*dupconfig (const zconf_t *conf);
 extern	zconf_t	*freeconfig (zconf_t *conf);
+extern	const	zconf_t	*loadconfig_shared (const char *filename, const zconf_t *parent);
+extern	void	releaseconfig (const zconf_t *conf);
+extern	int	compileconfig (const char *filename);
 extern	int	setconfigpar (zconf_t *conf, char *entry, const void *pval);
 extern	int	printconfig (const char *fname, const zconf_t *cp);
 extern	int	printconfigdiff (const char *fname, const zconf_t *ref, const zconf_t *z);
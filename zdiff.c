@@ -0,0 +1,529 @@
+/*****************************************************************
+**
+**	@(#) zdiff.c -- difference of two signed zone files
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <unistd.h>
+# include <errno.h>
+# include <stdarg.h>
+# include <sys/types.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+# include "config_zkt.h"
+# include "debug.h"
+# include "misc.h"
+# include "zconf.h"
+# include "dki.h"
+# include "zstore.h"
+#define	extern
+# include "zdiff.h"
+#undef	extern
+
+/*****************************************************************
+**	The difference of the previous and the new signed zone is
+**	computed by a merge of both zone files in canonical order.
+**	The files are read sequentially, one owner name at a time,
+**	so the memory needed does not depend on the size of the zone.
+**	This works for the files written by the built-in signer; if
+**	a file is not in canonical order (e.g. the NSEC3 records of
+**	dnssec-signzone are written after all other names) both files
+**	are read and sorted in memory instead.
+**
+**	The result is written as an IXFR style journal (RFC 1995:
+**	new SOA, old SOA, deleted records, new SOA, added records,
+**	new SOA) or as an nsupdate(1) batch of DNS UPDATE messages
+**	(RFC 2136). Each UPDATE message has the old SOA record as
+**	prerequisite and the SOA record is replaced by the last one,
+**	so a name server which is not at the old serial rejects the
+**	update and the serial only changes if all messages succeeded.
+*****************************************************************/
+# define	ZD_UNSORTED	(-3)	/* file is not in canonical order */
+
+/* one of the two zone files */
+typedef	struct	{
+	zsreader_t	*r;	/* sequential reader ... */
+	zstore_t	*zs;	/* ... or the whole zone in memory */
+	long	next;		/* index of the next name in memory */
+	rr_t	*rr;		/* records of the current name */
+	long	n;
+	uchar	key[ZS_MAXKEY];	/* sort key of the current name */
+	int	keylen;		/* (-1 before the first name) */
+} zdside_t;
+
+typedef	struct	{
+	int	format;
+	const	char	*origin;
+	FILE	*fp;		/* output file */
+	FILE	*add;		/* added records of the IXFR journal */
+	zstore_t	*soa;	/* old (rr[0]) and new (rr[1]) SOA record */
+	long	changes;	/* number of changes of the current UPDATE message */
+	zdiff_stats_t	*stats;
+} zdiff_t;
+
+static	char	zdiff_estr[255+1];
+
+/*****************************************************************
+**	private (static) function definition
+*****************************************************************/
+
+/*****************************************************************
+**	seterr (ret, fmt, ...)
+**	set the error string and return ret
+*****************************************************************/
+static	int	seterr (int ret, const char *fmt, ...)
+{
+	va_list	ap;
+
+	va_start (ap, fmt);
+	vsnprintf (zdiff_estr, sizeof (zdiff_estr), fmt, ap);
+	va_end (ap);
+
+	return ret;
+}
+
+/*****************************************************************
+**	openside (s, origin, dir, file, inmemory)
+*****************************************************************/
+static	int	openside (zdside_t *s, const char *origin, const char *dir, const char *file, int inmemory)
+{
+	int	ret;
+
+	memset (s, 0, sizeof (zdside_t));
+	s->keylen = -1;
+	if ( !inmemory )
+	{
+		if ( (s->r = zs_open (origin, dir, file)) == NULL )
+			return seterr (ZS_ERROR, "%s", zs_geterrstr ());
+		return ZS_OK;
+	}
+
+	if ( (s->zs = zs_new (origin)) == NULL )
+		return seterr (ZS_ERROR, "out of memory");
+	if ( (ret = zs_readfile (s->zs, dir, file)) != ZS_OK )
+		return seterr (ret, "%s", zs_geterrstr ());
+	zs_sort (s->zs);
+
+	return ZS_OK;
+}
+
+/*****************************************************************
+**	closeside (s)
+*****************************************************************/
+static	void	closeside (zdside_t *s)
+{
+	zs_close (s->r);
+	zs_free (s->zs);
+	memset (s, 0, sizeof (zdside_t));
+}
+
+/*****************************************************************
+**	nextname (s)
+**	get the records of the next owner name
+**	returns 1, 0 at the end of the file, ZD_UNSORTED if the names
+**	are not in ascending order or an error code
+*****************************************************************/
+static	int	nextname (zdside_t *s)
+{
+	const	dname_t	*owner;
+	long	i;
+	int	res;
+
+	if ( s->r )
+	{
+		if ( (s->n = zs_readname (s->r, &s->rr)) < 0 )
+			return seterr ((int)s->n, "%s", zs_geterrstr ());
+	}
+	else
+	{
+		s->rr = s->zs->rr + s->next;
+		for ( i = s->next; i < s->zs->nrr && zs_namecmp (s->zs->rr[i].owner, s->rr->owner) == 0; i++ )
+			;
+		s->n = i - s->next;
+		s->next = i;
+	}
+	if ( s->n == 0 )
+		return 0;
+
+	owner = s->rr->owner;
+	if ( s->keylen >= 0 )
+	{
+		res = memcmp (s->key, dname_key (owner), s->keylen < owner->keylen ? s->keylen: owner->keylen);
+		if ( res > 0 || (res == 0 && s->keylen >= owner->keylen) )
+			return ZD_UNSORTED;
+	}
+	memcpy (s->key, dname_key (owner), owner->keylen);
+	s->keylen = owner->keylen;
+
+	return 1;
+}
+
+/*****************************************************************
+**	getsoa (d, s)
+**	save the SOA record of the first name (the zone apex)
+*****************************************************************/
+static	int	getsoa (zdiff_t *d, const zdside_t *s)
+{
+	const	rr_t	*rr;
+	long	i;
+
+	for ( i = 0; i < s->n; i++ )
+	{
+		rr = &s->rr[i];
+		if ( rr->type != ZS_T_SOA )
+			continue;
+		if ( zs_add (d->soa, zs_dname (d->soa, dname_wire (rr->owner)), rr->type, rr->ttl, rr->rdata, rr->rdlen) == NULL )
+			return seterr (ZS_ERROR, "out of memory");
+		return ZS_OK;
+	}
+
+	return s->r ? ZD_UNSORTED: seterr (ZS_ERROR, "no SOA record at the zone apex");
+}
+
+/*****************************************************************
+**	beginupdate (d)
+**	start a new UPDATE message
+*****************************************************************/
+static	void	beginupdate (zdiff_t *d)
+{
+	const	rr_t	*old;
+
+	old = &d->soa->rr[0];
+	fprintf (d->fp, "zone %s\n", d->origin);
+	fprintf (d->fp, "prereq yxrrset %s IN SOA ", d->origin);
+	zs_printrdata (d->fp, old);
+	putc ('\n', d->fp);
+}
+
+/*****************************************************************
+**	change (d, rr, add)
+**	write one deleted or added record
+*****************************************************************/
+static	void	change (zdiff_t *d, const rr_t *rr, int add)
+{
+	if ( rr->type == ZS_T_SOA )	/* the SOA record frames the changes */
+		return;
+
+	if ( add )
+		d->stats->added++;
+	else
+		d->stats->deleted++;
+
+	if ( d->format == ZDIFF_IXFR )
+	{
+		zs_printrr (add ? d->add: d->fp, rr);
+		return;
+	}
+
+	if ( d->changes == 0 )
+		beginupdate (d);
+	fputs (add ? "update add ": "update delete ", d->fp);
+	zs_printrr (d->fp, rr);
+	if ( ++d->changes >= ZDIFF_UPDMAX )
+	{
+		fputs ("send\n", d->fp);
+		d->changes = 0;
+	}
+}
+
+/*****************************************************************
+**	mergename (d, a, b)
+**	compare the records of the same owner name
+*****************************************************************/
+static	void	mergename (zdiff_t *d, const zdside_t *a, const zdside_t *b)
+{
+	long	i;
+	long	j;
+	int	res;
+
+	i = j = 0;
+	while ( i < a->n || j < b->n )
+	{
+		if ( i >= a->n )
+			res = 1;
+		else if ( j >= b->n )
+			res = -1;
+		else
+			res = zs_rrcmp (&a->rr[i], &b->rr[j]);
+
+		if ( res < 0 )
+			change (d, &a->rr[i++], 0);
+		else if ( res > 0 )
+			change (d, &b->rr[j++], 1);
+		else
+		{
+			if ( a->rr[i].ttl != b->rr[j].ttl )
+			{
+				change (d, &a->rr[i], 0);
+				change (d, &b->rr[j], 1);
+			}
+			i++;
+			j++;
+		}
+	}
+}
+
+/*****************************************************************
+**	appendfile (to, from)
+*****************************************************************/
+static	int	appendfile (FILE *to, FILE *from)
+{
+	char	buf[64 * 1024];
+	size_t	n;
+
+	fflush (from);
+	rewind (from);
+	while ( (n = fread (buf, 1, sizeof (buf), from)) > 0 )
+		if ( fwrite (buf, 1, n, to) != n )
+			return -1;
+
+	return ferror (from) ? -1: 0;
+}
+
+/*****************************************************************
+**	rundiff (d, dir, oldfile, newfile, outfile, inmemory)
+*****************************************************************/
+static	int	rundiff (zdiff_t *d, const char *dir, const char *oldfile, const char *newfile,
+							const char *outfile, int inmemory)
+{
+	zdside_t	a;
+	zdside_t	b;
+	zdside_t	none;		/* a name without records */
+	const	rr_t	*oldsoa;
+	const	rr_t	*newsoa;
+	ulong	delta;
+	int	ra;
+	int	rb;
+	int	ret;
+
+	memset (d->stats, 0, sizeof (zdiff_stats_t));
+	d->stats->inmemory = inmemory;
+	d->changes = 0;
+	memset (&a, 0, sizeof (a));
+	memset (&b, 0, sizeof (b));
+	memset (&none, 0, sizeof (none));
+	d->fp = d->add = NULL;
+	if ( (d->soa = zs_new (NULL)) == NULL )
+		return seterr (ZS_ERROR, "out of memory");
+
+	if ( (ret = openside (&a, d->origin, dir, oldfile, inmemory)) != ZS_OK ||
+	     (ret = openside (&b, d->origin, dir, newfile, inmemory)) != ZS_OK )
+		goto end;
+
+	/* the zone apex is the first name in canonical order */
+	if ( (ret = nextname (&a)) < 0 || (ret == 1 && (ret = nextname (&b)) < 0) )
+		goto end;
+	if ( a.n == 0 || b.n == 0 )
+	{
+		ret = seterr (ZS_ERROR, "empty zone file");
+		goto end;
+	}
+	if ( (ret = getsoa (d, &a)) != ZS_OK || (ret = getsoa (d, &b)) != ZS_OK )
+		goto end;
+
+	oldsoa = &d->soa->rr[0];
+	newsoa = &d->soa->rr[1];
+	d->stats->oldserial = zs_get32 (oldsoa->rdata + oldsoa->rdlen - 20);
+	d->stats->newserial = zs_get32 (newsoa->rdata + newsoa->rdlen - 20);
+	delta = (d->stats->newserial - d->stats->oldserial) & 0xFFFFFFFFUL;
+	if ( delta == 0 || delta >= 0x80000000UL )	/* RFC 1982 */
+	{
+		ret = seterr (ZS_UNSUPPORTED, "serial %lu is not greater than %lu", d->stats->newserial, d->stats->oldserial);
+		goto end;
+	}
+
+	if ( (d->fp = fopen (outfile, "w")) == NULL )
+	{
+		ret = seterr (ZS_ERROR, "can't create \"%.128s\": %s", outfile, strerror (errno));
+		goto end;
+	}
+	if ( d->format == ZDIFF_IXFR )
+	{
+		if ( (d->add = tmpfile ()) == NULL )
+		{
+			ret = seterr (ZS_ERROR, "can't create temporary file: %s", strerror (errno));
+			goto end;
+		}
+		fprintf (d->fp, "; IXFR journal of zone %s (serial %lu to %lu)\n", d->origin, d->stats->oldserial, d->stats->newserial);
+		zs_printrr (d->fp, newsoa);
+		zs_printrr (d->fp, oldsoa);
+		zs_printrr (d->add, newsoa);
+	}
+	else
+		fprintf (d->fp, "; DNS UPDATE of zone %s (serial %lu to %lu)\n", d->origin, d->stats->oldserial, d->stats->newserial);
+
+	ra = rb = 1;
+	while ( ra > 0 || rb > 0 )
+	{
+		if ( rb == 0 || (ra > 0 && zs_namecmp (a.rr->owner, b.rr->owner) < 0) )
+		{
+			mergename (d, &a, &none);
+			ra = nextname (&a);
+		}
+		else if ( ra == 0 || zs_namecmp (a.rr->owner, b.rr->owner) > 0 )
+		{
+			mergename (d, &none, &b);
+			rb = nextname (&b);
+		}
+		else
+		{
+			mergename (d, &a, &b);
+			ra = nextname (&a);
+			rb = nextname (&b);
+		}
+		if ( ra < 0 || rb < 0 )
+		{
+			ret = ra < 0 ? ra: rb;
+			goto end;
+		}
+	}
+
+	if ( d->format == ZDIFF_IXFR )
+	{
+		if ( appendfile (d->fp, d->add) < 0 )
+		{
+			ret = seterr (ZS_ERROR, "can't copy the added records: %s", strerror (errno));
+			goto end;
+		}
+		zs_printrr (d->fp, newsoa);
+	}
+	else
+	{
+		if ( d->changes == 0 )
+			beginupdate (d);
+		fputs ("update add ", d->fp);
+		zs_printrr (d->fp, newsoa);
+		fputs ("send\n", d->fp);
+	}
+	ret = ZS_OK;
+
+end:
+	closeside (&a);
+	closeside (&b);
+	if ( d->add )
+		fclose (d->add);
+	if ( d->fp && fclose (d->fp) == EOF && ret == ZS_OK )
+		ret = seterr (ZS_ERROR, "can't write \"%.128s\": %s", outfile, strerror (errno));
+	d->fp = d->add = NULL;
+	zs_free (d->soa);
+	d->soa = NULL;
+
+	return ret;
+}
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	zdiff_geterrstr ()
+*****************************************************************/
+const	char	*zdiff_geterrstr ()
+{
+	return zdiff_estr;
+}
+
+/*****************************************************************
+**	zdiff_str2format (str)
+**	returns the format of the difference ("ixfr" or "update"),
+**	ZDIFF_NONE for an empty string or "none" and -1 otherwise
+*****************************************************************/
+int	zdiff_str2format (const char *str)
+{
+	if ( str == NULL || *str == '\0' || strcasecmp (str, "none") == 0 )
+		return ZDIFF_NONE;
+	if ( strcasecmp (str, "ixfr") == 0 )
+		return ZDIFF_IXFR;
+	if ( strcasecmp (str, "update") == 0 )
+		return ZDIFF_UPDATE;
+	return -1;
+}
+
+/*****************************************************************
+**	zdiff_format2str (format)
+**	returns the name of the format (also used as file extension)
+*****************************************************************/
+const	char	*zdiff_format2str (int format)
+{
+	switch ( format )
+	{
+	case ZDIFF_IXFR:	return "ixfr";
+	case ZDIFF_UPDATE:	return "update";
+	}
+	return "none";
+}
+
+/*****************************************************************
+**	zdiff (origin, dir, oldfile, newfile, format, outfile, stats)
+**	write the difference of the zone files oldfile and newfile
+**	in directory dir to outfile
+**	returns ZS_OK, ZS_ERROR or ZS_UNSUPPORTED if the difference
+**	could not be expressed (e.g. the serial was not increased)
+*****************************************************************/
+int	zdiff (const char *origin, const char *dir, const char *oldfile, const char *newfile,
+					int format, const char *outfile, zdiff_stats_t *stats)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	tmppath[MAX_PATHSIZE+4+1];
+	zdiff_stats_t	st;
+	zdiff_t	d;
+	int	ret;
+
+	assert (origin != NULL);
+	assert (oldfile != NULL && newfile != NULL && outfile != NULL);
+	assert (format == ZDIFF_IXFR || format == ZDIFF_UPDATE);
+
+	zdiff_estr[0] = '\0';
+	memset (&d, 0, sizeof (d));
+	d.format = format;
+	d.origin = origin;
+	d.stats = stats ? stats: &st;
+
+	pathname (path, sizeof (path), dir, outfile, NULL);
+	snprintf (tmppath, sizeof (tmppath), "%s.tmp", path);
+
+	if ( (ret = rundiff (&d, dir, oldfile, newfile, tmppath, 0)) == ZD_UNSORTED )
+		ret = rundiff (&d, dir, oldfile, newfile, tmppath, 1);
+
+	if ( ret == ZS_OK && rename (tmppath, path) < 0 )
+		ret = seterr (ZS_ERROR, "can't rename \"%.128s\": %s", tmppath, strerror (errno));
+	if ( ret != ZS_OK )
+		unlink (tmppath);
+
+	return ret;
+}
@@ -0,0 +1,60 @@
+/*****************************************************************
+**
+**	@(#) zdiff.h -- difference of two signed zone files
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+#ifndef ZDIFF_H
+# define ZDIFF_H
+
+/* formats of the difference */
+# define	ZDIFF_NONE	0
+# define	ZDIFF_IXFR	1	/* IXFR style journal (RFC 1995) */
+# define	ZDIFF_UPDATE	2	/* DNS UPDATE batch for nsupdate (RFC 2136) */
+
+# define	ZDIFF_UPDMAX	1000	/* max number of changes per UPDATE message */
+
+typedef	struct	zdiff_stats {
+	long	deleted;	/* number of deleted records */
+	long	added;		/* number of added records */
+	ulong	oldserial;
+	ulong	newserial;
+	int	inmemory;	/* files not in canonical order (compared in memory) */
+} zdiff_stats_t;
+
+extern	const	char	*zdiff_geterrstr (void);
+extern	int	zdiff_str2format (const char *str);
+extern	const	char	*zdiff_format2str (int format);
+extern	int	zdiff (const char *origin, const char *dir, const char *oldfile, const char *newfile,
+					int format, const char *outfile, zdiff_stats_t *stats);
+#endif
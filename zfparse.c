@@ -36,6 +36,7 @@
 *****************************************************************/
 # include <stdio.h>
 # include <string.h>
+# include <strings.h>
 # include <stdlib.h>
 # include <unistd.h>	/* for link(), unlink() */
 # include <ctype.h>
@@ -274,6 +275,153 @@ int	parsezonefile (const char *path, const char *file, long *pminttl, long *pmax
 	return keydbfilefound;
 }
 
+/*****************************************************************
+**	is_sigtime ()
+**	check if s looks like a RRSIG time value "YYYYMMDDHHmmSS"
+*****************************************************************/
+static	int	is_sigtime (const char *s)
+{
+	int	i;
+
+	for ( i = 0; i < SIGTIME_LEN; i++ )
+		if ( !isdigit (s[i]) )
+			return 0;
+	return s[i] == '\0';
+}
+
+/*****************************************************************
+**	is_number ()
+*****************************************************************/
+static	int	is_number (const char *s)
+{
+	if ( !isdigit (*s) )
+		return 0;
+	while ( isdigit (*s) )
+		s++;
+	return *s == '\0';
+}
+
+/*****************************************************************
+**	parsesigtimes ()
+**	Scan the signed zone file 'file' and store the earliest
+**	signature expiration time and the latest signature inception
+**	time of all RRSIG records in the corresponding parameter.
+**	The file is read as a stream of tokens, and only the rdata of
+**	RRSIG records is decoded. Both time values are compared as
+**	strings, so there is no time conversion per record.
+**	return the number of RRSIG records found
+**	return -1 on error
+*****************************************************************/
+int	parsesigtimes (const char *path, const char *file, time_t *pexpire, time_t *pinception)
+{
+	FILE	*infp;
+	int	c;
+	int	len;
+	int	field;
+	int	nsigs;
+	char	tok[63+1];
+	char	exptime[SIGTIME_LEN+1];
+	char	minexp[SIGTIME_LEN+1];
+	char	maxinc[SIGTIME_LEN+1];
+	char	filepath[MAX_PATHSIZE+1];
+
+	assert (file != NULL);
+	assert (pexpire != NULL);
+	assert (pinception != NULL);
+
+	if ( file[0] == '/' )
+		pathname (filepath, sizeof (filepath), NULL, file, NULL);
+	else
+		pathname (filepath, sizeof (filepath), path, file, NULL);
+
+	dbg_val ("parsesigtimes (\"%s\")\n", filepath);
+
+	if ( (infp = fopen (filepath, "r")) == NULL )
+	{
+		error ("parsesigtimes: couldn't open file \"%s\" for input\n", filepath);
+		return -1;
+	}
+
+	nsigs = 0;
+	field = -1;	/* -1 means outside of RRSIG rdata */
+	len = 0;
+	minexp[0] = maxinc[0] = '\0';
+	do
+	{
+		c = getc (infp);
+		if ( c == ';' )		/* skip comment */
+			while ( (c = getc (infp)) != EOF && c != '\n' )
+				;
+		else if ( c == '\"' )	/* skip quoted string (TXT rdata) */
+		{
+			while ( (c = getc (infp)) != EOF && c != '\"' )
+				if ( c == '\\' )
+					c = getc (infp);
+			field = -1;
+			len = 0;
+			continue;
+		}
+
+		if ( c != EOF && !isspace (c) && c != '(' && c != ')' )
+		{
+			if ( len < (int)sizeof (tok) - 1 )
+				tok[len++] = c;
+			continue;
+		}
+		if ( len == 0 )		/* no token collected */
+			continue;
+		tok[len] = '\0';
+		len = 0;
+
+		/*
+		** RRSIG rdata: type_covered algorithm labels orig_ttl
+		**		expiration inception keytag signer signature
+		** The field check makes sure, that a "RRSIG" in a NSEC
+		** type bitmap is not taken as the start of the rdata.
+		*/
+		if ( field >= 0 )
+		{
+			field++;
+			if ( field >= 2 && field <= 4 && !is_number (tok) )
+				field = -1;
+			else if ( field == 5 )
+			{
+				if ( is_sigtime (tok) )
+					strcpy (exptime, tok);
+				else
+					field = -1;
+			}
+			else if ( field == 6 )
+			{
+				if ( is_sigtime (tok) )
+				{
+					if ( nsigs == 0 || strcmp (exptime, minexp) < 0 )
+						strcpy (minexp, exptime);
+					if ( nsigs == 0 || strcmp (tok, maxinc) > 0 )
+						strcpy (maxinc, tok);
+					nsigs++;
+				}
+				field = -1;
+				continue;
+			}
+		}
+		if ( field < 0 && strcasecmp (tok, "RRSIG") == 0 )
+			field = 0;
+	} while ( c != EOF );
+
+	fclose (infp);
+
+	if ( nsigs > 0 )
+	{
+		*pexpire = timestr2time (minexp);
+		*pinception = timestr2time (maxinc);
+	}
+
+	dbg_val4 ("parsesigtimes (\"%s\") ==> %d (expire %s inception %s)\n",
+			filepath, nsigs, minexp, maxinc);
+	return nsigs;
+}
+
 #if defined (USE_INCLUDE_FILE_TRACKING) && USE_INCLUDE_FILE_TRACKING
 // ugly copy of function above
 time_t	recursive_file_mtime (const char *path, const char *file, const char *keydbfile)
@@ -37,8 +37,12 @@
 
 #ifndef ZFPARSE_H
 # define ZFPARSE_H
+
+# define	SIGTIME_LEN	14	/* length of RRSIG time string "YYYYMMDDHHmmSS" */
+
 extern	int	parsezonefile (const char *path, const char *file, long *pminttl, long *pmaxttl, const char *keydbfile, char *inclfiles, size_t *plen);
 extern	int	addkeydb (const char *file, const char *keydbfile);
+extern	int	parsesigtimes (const char *path, const char *file, time_t *pexpire, time_t *pinception);
 #if defined (USE_INCLUDE_FILE_TRACKING) && USE_INCLUDE_FILE_TRACKING
 extern	time_t  recursive_file_mtime (const char *path, const char *file, const char *keydbfile);
 #endif
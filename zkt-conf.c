@@ -70,8 +70,9 @@ static	const	char	*view = "";
 static	int	writeflag = 0;
 static	int	allflag = 0;
 static	int	testflag = 0;
+static	int	compileflag = 0;
 
-# define	short_options	":aC:c:O:dlstvwV:rh"
+# define	short_options	":abC:c:O:dlstvwV:rh"
 #if defined(HAVE_GETOPT_LONG) && HAVE_GETOPT_LONG
 static struct option long_options[] = {
 	{"compability",		required_argument, NULL, 'C'},
@@ -82,6 +83,7 @@ static struct option long_options[] = {
 	{"sidecfg",		no_argument, NULL, 's'},
 	{"localcfg",		no_argument, NULL, 'l'},
 	{"all-values",		no_argument, NULL, 'a'},
+	{"compile",		no_argument, NULL, 'b'},
 	{"test",		no_argument, NULL, 't'},
 	{"overwrite",		no_argument, NULL, 'w'},
 	{"version",		no_argument, NULL, 'v' },
@@ -210,6 +212,9 @@ int	main (int argc, char *argv[])
 		case 't':		/* test config */
 			testflag = 1;
 			break;
+		case 'b':		/* compile config file */
+			compileflag = 1;
+			break;
 		case 'v':		/* version */
 			fprintf (stderr, "%s version %s compiled for BIND version %d\n",
 							progname, ZKT_VERSION, BIND_VERSION);
@@ -244,7 +249,16 @@ int	main (int argc, char *argv[])
 	c = optind;
 	if ( c >= argc )	/* no arguments given on commandline */
 	{
-		if ( testflag )
+		if ( compileflag )
+		{
+			if ( strcmp (confname, "stdout") == 0 || !fileexist (confname) )
+				usage ("error: no config file to compile");
+			if ( !compileconfig (confname) )
+				return 1;
+			fprintf (stderr, "Config file \"%s\" compiled to \"%s%s\"\n",
+							confname, confname, CONFIG_SNAPSHOT_EXT);
+		}
+		else if ( testflag )
 		{
 			if ( checkconfig (config) )
 				fprintf (stderr, "All config file parameter seems to be ok\n");
@@ -358,6 +372,7 @@ static	void    usage (char *mesg)
         fprintf (stderr, "usage: %s [-V view] [-w|-t]      -d  [-O <optstr>]\n", progname);
         fprintf (stderr, "usage: %s [-V view] [-w|-t]     [-s] [-c config] [-O <optstr>]\n", progname);
         fprintf (stderr, "usage: %s [-V view] [-w|-t] [-a] -l  [-c config] [-O <optstr>]\n", progname);
+        fprintf (stderr, "usage: %s [-V view] -b [-l] [-c config]\n", progname);
         fprintf (stderr, "\n");
         fprintf (stderr, "usage: %s [-c config] [-w] <zonefile>\n", progname);
         fprintf (stderr, "\n");
@@ -373,6 +388,7 @@ static	void    usage (char *mesg)
 	fprintf (stderr, " \t\tread config options from commandline\n");
         fprintf (stderr, " -t%s\ttest the config parameter if they are useful \n", loptstr (", --test", "\t"));
         fprintf (stderr, " -w%s\twrite or rewrite config file \n", loptstr (", --write", "\t"));
+        fprintf (stderr, " -b%s\tcompile the config file to <file>%s\n", loptstr (", --compile", "\t"), CONFIG_SNAPSHOT_EXT);
         fprintf (stderr, " -h%s\tprint this help \n", loptstr (", --help", "\t"));
         exit (1);
 }
@@ -59,6 +59,7 @@
 # include "strlist.h"
 # include "zconf.h"
 # include "dki.h"
+# include "dirwalk.h"
 # include "zkt.h"
 
 extern  int	optopt;
@@ -119,6 +120,8 @@ static struct option long_options[] = {
 #endif
 
 static	int	parsedirectory (const char *dir, dki_t **listp);
+static	void	*scankeydir (const char *dir, void *arg);
+static	void	mergekeydir (const char *dir, void *data, void *arg);
 static	void	parsefile (const char *file, dki_t **listp);
 static	void	createkey (const char *keyname, const dki_t *list, const zconf_t *conf);
 static	void	ksk_roll (const char *keyname, int phase, const dki_t *list, const zconf_t *conf);
@@ -647,45 +650,51 @@ static	int	create_parent_file (const char *fname, int phase, int ttl, const dki_
 	return phase;
 }
 
-static	int	parsedirectory (const char *dir, dki_t **listp)
+typedef	struct	{
+	dki_t	**listp;
+} parsedir_t;
+
+/* called in parallel for each directory */
+static	void	*scankeydir (const char *dir, void *arg)
 {
-	dki_t	*dkp;
-	DIR	*dirp;
-	struct  dirent  *dentp;
-	char	path[MAX_PATHSIZE+1];
+	dki_t	*list;
 
-	if ( dirflag )
-		return 0;
+	list = NULL;
+	dki_readdir (dir, &list, 0);
 
-	dbg_val ("directory: opendir(%s)\n", dir);
-	if ( (dirp = opendir (dir)) == NULL )
-		return 0;
+	return list;
+}
 
-	while ( (dentp = readdir (dirp)) != NULL )
-	{
-		if ( is_dotfilename (dentp->d_name) )
-			continue;
+/* called in the main thread for each directory in the order of the tree */
+static	void	mergekeydir (const char *dir, void *data, void *arg)
+{
+	parsedir_t	*pd = (parsedir_t *)arg;
+	dki_t	*dkp;
+	dki_t	*next;
 
-		dbg_val ("directory: check %s\n", dentp->d_name);
-		pathname (path, sizeof (path), dir, dentp->d_name, NULL);
-		if ( is_directory (path) && recflag )
-		{
-			dbg_val ("directory: recursive %s\n", path);
-			parsedirectory (path, listp);
-		}
-		else if ( is_keyfilename (dentp->d_name) )
-			if ( (dkp = dki_read (dir, dentp->d_name)) )
-			{
-				// fprintf (stderr, "parsedir: tssearch (%d %s)\n", dkp, dkp->name);
+	for ( dkp = (dki_t *)data; dkp; dkp = next )
+	{
+		next = dkp->next;
+		dkp->next = NULL;
 #if defined (USE_TREE) && USE_TREE
-				dki_tadd (listp, dkp, 1);
+		dki_tadd (pd->listp, dkp, 1);
 #else
-				dki_add (listp, dkp);
+		dki_add (pd->listp, dkp);
 #endif
-			}
 	}
-	closedir (dirp);
-	return 1;
+}
+
+static	int	parsedirectory (const char *dir, dki_t **listp)
+{
+	parsedir_t	pd;
+
+	if ( dirflag )
+		return 0;
+
+	dbg_val ("directory: (%s)\n", dir);
+	pd.listp = listp;
+
+	return dirwalk (dir, recflag, 0, scankeydir, mergekeydir, &pd);
 }
 
 static	void	parsefile (const char *file, dki_t **listp)
@@ -59,6 +59,7 @@
 # include "strlist.h"
 # include "zconf.h"
 # include "dki.h"
+# include "dirwalk.h"
 # include "tcap.h"
 # include "zkt.h"
 
@@ -90,15 +91,18 @@ static	const	char	*view = "";
 static	const	char	*term = NULL;
 
 #if defined(COLOR_MODE) && COLOR_MODE
-# define	short_options	":HKTMV:afC::c:O:dhkLl:prstez"
+# define	short_options	":HKTMDV:afC::c:O:dhkLl:prstez"
 #else
-# define	short_options	":HKTMV:af:c:O:dhkLl:prstez"
+# define	short_options	":HKTMDV:af:c:O:dhkLl:prstez"
 #endif
 #if defined(HAVE_GETOPT_LONG) && HAVE_GETOPT_LONG
 static struct option long_options[] = {
 	{"list-dnskeys",	no_argument, NULL, 'K'},
 	{"list-trustedkeys",	no_argument, NULL, 'T'},
 	{"list-managedkeys",	no_argument, NULL, 'M'},
+	{"list-ds",		no_argument, NULL, 'D'},
+	{"list-cds",		no_argument, NULL, 20},
+	{"list-cdnskeys",	no_argument, NULL, 21},
 	{"ksk",			no_argument, NULL, 'k'},
 	{"zsk",			no_argument, NULL, 'z'},
 	{"age",			no_argument, NULL, 'a'},
@@ -126,6 +130,8 @@ static struct option long_options[] = {
 #endif
 
 static	int	parsedirectory (const char *dir, dki_t **listp, int sub_before);
+static	void	*scankeydir (const char *dir, void *arg);
+static	void	mergekeydir (const char *dir, void *data, void *arg);
 static	void	parsefile (const char *file, dki_t **listp, int sub_before);
 static	void    usage (char *mesg, zconf_t *cp);
 
@@ -190,6 +196,13 @@ int	main (int argc, char *argv[])
 			zskflag = pathflag = 0;
 			action = c;
 			break;
+		case 'D':		/* list DS records */
+		case 20:		/* list CDS records */
+		case 21:		/* list CDNSKEY records */
+			subdomain_before_parent = 0;
+			zskflag = pathflag = 0;
+			action = c;
+			break;
 		case 'T':
 			trustedkeyflag = 1;
 			subdomain_before_parent = 0;
@@ -311,6 +324,15 @@ int	main (int argc, char *argv[])
 	case 'M':
 		zkt_list_managedkeys (data);
 		break;
+	case 'D':
+	case 20:
+		if ( (c = dki_str2digest (config->ds_digest)) <= 0 )
+			c = 1 << DK_DIGEST_SHA256;
+		zkt_list_dsrecords (data, c, action == 'D' ? "DS": "CDS");
+		break;
+	case 21:
+		zkt_list_cdnskeys (data);
+		break;
 	default:
 		zkt_list_keys (data);
 	}
@@ -348,6 +370,12 @@ static	void    usage (char *mesg, zconf_t *cp)
         sopt_usage ("\tusage: %s -M [-dhrz] [-c config] [file|dir ...]\n", progname);
         lopt_usage ("\tusage: %s --list-managedkeys [-dhzr] [-c config] [file|dir ...]\n", progname);
         fprintf (stderr, "\n");
+        fprintf (stderr, "List DS records of key signing keys (digest types see DSDigest)\n");
+        sopt_usage ("\tusage: %s -D [-dhr] [-c config] [file|dir ...]\n", progname);
+        lopt_usage ("\tusage: %s --list-ds [-dhr] [-c config] [file|dir ...]\n", progname);
+        lopt_usage ("\tusage: %s --list-cds [-dhr] [-c config] [file|dir ...]\n", progname);
+        lopt_usage ("\tusage: %s --list-cdnskeys [-dhr] [-c config] [file|dir ...]\n", progname);
+        fprintf (stderr, "\n");
 
         fprintf (stderr, "General options \n");
         fprintf (stderr, "\t-c file%s", loptstr (", --config=file\n", ""));
@@ -376,45 +404,53 @@ static	void    usage (char *mesg, zconf_t *cp)
         exit (1);
 }
 
-static	int	parsedirectory (const char *dir, dki_t **listp, int sub_before)
+typedef	struct	{
+	dki_t	**listp;
+	int	sub_before;
+} parsedir_t;
+
+/* called in parallel for each directory */
+static	void	*scankeydir (const char *dir, void *arg)
 {
-	dki_t	*dkp;
-	DIR	*dirp;
-	struct  dirent  *dentp;
-	char	path[MAX_PATHSIZE+1];
+	dki_t	*list;
 
-	if ( dirflag )
-		return 0;
+	list = NULL;
+	dki_readdir (dir, &list, 0);
 
-	dbg_val ("directory: opendir(%s)\n", dir);
-	if ( (dirp = opendir (dir)) == NULL )
-		return 0;
+	return list;
+}
 
-	while ( (dentp = readdir (dirp)) != NULL )
-	{
-		if ( is_dotfilename (dentp->d_name) )
-			continue;
+/* called in the main thread for each directory in the order of the tree */
+static	void	mergekeydir (const char *dir, void *data, void *arg)
+{
+	parsedir_t	*pd = (parsedir_t *)arg;
+	dki_t	*dkp;
+	dki_t	*next;
 
-		dbg_val ("directory: check %s\n", dentp->d_name);
-		pathname (path, sizeof (path), dir, dentp->d_name, NULL);
-		if ( is_directory (path) && recflag )
-		{
-			dbg_val ("directory: recursive %s\n", path);
-			parsedirectory (path, listp, sub_before);
-		}
-		else if ( is_keyfilename (dentp->d_name) )
-			if ( (dkp = dki_read (dir, dentp->d_name)) )
-			{
-				// fprintf (stderr, "parsedir: tssearch (%d %s)\n", dkp, dkp->name);
+	for ( dkp = (dki_t *)data; dkp; dkp = next )
+	{
+		next = dkp->next;
+		dkp->next = NULL;
 #if defined (USE_TREE) && USE_TREE
-				dki_tadd (listp, dkp, sub_before);
+		dki_tadd (pd->listp, dkp, pd->sub_before);
 #else
-				dki_add (listp, dkp);
+		dki_add (pd->listp, dkp);
 #endif
-			}
 	}
-	closedir (dirp);
-	return 1;
+}
+
+static	int	parsedirectory (const char *dir, dki_t **listp, int sub_before)
+{
+	parsedir_t	pd;
+
+	if ( dirflag )
+		return 0;
+
+	dbg_val ("directory: (%s)\n", dir);
+	pd.listp = listp;
+	pd.sub_before = sub_before;
+
+	return dirwalk (dir, recflag, 0, scankeydir, mergekeydir, &pd);
 }
 
 static	void	parsefile (const char *file, dki_t **listp, int sub_before)
@@ -46,6 +46,8 @@
 # include <unistd.h>	
 # include <ctype.h>	
 # include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/wait.h>
 # include <time.h>
 
 #ifdef HAVE_CONFIG_H
@@ -59,6 +61,7 @@
 # include "debug.h"
 # include "misc.h"
 # include "ncparse.h"
+# include "catalog.h"
 # include "dki.h"
 # include "zone.h"
 # include "nscomm.h"
@@ -66,8 +69,13 @@
 # include "rollover.h"
 # include "log.h"
 # include "zfparse.h"
+# include "keypool.h"
+# include "zstore.h"
+# include "zsign.h"
+# include "zdiff.h"
+# include "dirwalk.h"
 
-# define	short_options	"c:L:V:D:N:o:O:dfHhnrv"
+# define	short_options	"c:C:L:V:D:N:o:O:dfHhnPrv"
 #if defined(HAVE_GETOPT_LONG) && HAVE_GETOPT_LONG
 static struct option long_options[] = {
 	{"reload",		no_argument, NULL, 'r'},
@@ -82,8 +90,10 @@ static struct option long_options[] = {
 	{"view",		required_argument, NULL, 'V' },
 	{"directory",		required_argument, NULL, 'D'},
 	{"named-conf",		required_argument, NULL, 'N'},
+	{"catalog",		required_argument, NULL, 'C'},
 	{"origin",		required_argument, NULL, 'o'},
 	{"dynamic",		no_argument, NULL, 'd' },
+	{"plan",		no_argument, NULL, 'P' },
 	{"help",		no_argument, NULL, 'h'},
 	{0, 0, 0, 0}
 };
@@ -93,12 +103,30 @@ static struct option long_options[] = {
 /**	function declaration	**/
 static	void	usage (char *mesg, zconf_t *conf);
 static	int	add2zonelist (const char *dir, const char *view, const char *zone, const char *file);
+static	int	catalog2zonelist (const char *zone);
 static	int	parsedir (const char *dir, zone_t **zp, const zconf_t *conf);
+static	void	*scanzonedir (const char *dir, void *arg);
+static	void	mergezonedir (const char *dir, void *data, void *arg);
 static	int	dosigning (zone_t *zonelist, zone_t *zp);
+static	time_t	get_sigexpire (zone_t *zp);
+static	time_t	get_resigntime (zone_t *zp, time_t zfilesig_time, time_t *psig_expire);
+static	void	plan_rollover (const zone_t *zp, int ksk, time_t currtime, int *cnt, int ndays);
+static	void	print_plan (zone_t *zonelist);
+static	int	keypool_profile (const zconf_t *conf, int i, int *ksk, int *algo, int *bits);
+static	pid_t	keypool_start (const zconf_t *conf);
+static	void	keypool_status (const zconf_t *conf, FILE *fp);
 static	int	check_keydb_timestamp (dki_t *keylist, time_t reftime);
 static	int	new_keysetfiles (const char *dir, time_t zone_signing_time);
-static	int	writekeyfile (const char *fname, const dki_t *list, int key_ttl);
-static	int	sign_zone (const zone_t *zp);
+static	int	writekeyfile (const char *fname, const dki_t *list, const zconf_t *conf);
+static	int	write_dsset (const zone_t *zp);
+static	int	salt_due (const zone_t *zp, time_t currtime);
+static	int	nsec3_salt (zone_t *zp, char *salt, size_t size);
+static	const	char	*signed_newfile (const zone_t *zp, char *file, size_t size);
+static	int	sign_zone (zone_t *zp);
+static	int	verify_zone (zone_t *zp, const char *newfile);
+static	int	dist_zone (const zone_t *zp);
+static	int	compile_zone (const zone_t *zp);
+static	int	nsfile_outdated (const zone_t *zp);
 static	void	register_key (dki_t *listp, const zconf_t *z);
 static	void	copy_keyset (const char *dir, const char *domain, const zconf_t *conf);
 
@@ -112,11 +140,13 @@ static	const	char	*viewname = NULL;
 static	const	char	*logfile = NULL;
 static	const	char	*origin = NULL;
 static	const	char	*namedconf = NULL;
+static	const	char	*catalog = NULL;
 static	const	char	*dirname = NULL;
 static	int	verbose = 0;
 static	int	force = 0;
 static	int	reloadflag = 0;
 static	int	noexec = 0;
+static	int	plan = 0;
 static	int	dynamic_zone = 0;	/* dynamic zone ? */
 static	zone_t	*zonelist = NULL;	/* must be static global because add2zonelist use it */
 static	zconf_t	*config;
@@ -125,6 +155,7 @@ static	zconf_t	*config;
 #define	set_bind96_dynzone(dz)	((dz) = 6)
 #define	bind96_dynzone(dz)	( (dz) >= 6 )
 #define	is_defined(str)		( (str) && *(str) )
+#define	SIGNED_NEW_EXT		".new"	/* signed zone waiting for verification */
 
 int	main (int argc, char *const argv[])
 {
@@ -137,6 +168,8 @@ int	main (int argc, char *const argv[])
 	char	*p;
 	const	char	*defconfname;
 	zone_t	*zp;
+	pid_t	keypool_pid;
+	int	filtered;
 
 	progname = *argv;
 	if ( (p = strrchr (progname, '/')) )
@@ -190,6 +223,9 @@ int	main (int argc, char *const argv[])
 		case 'N':
 			namedconf = optarg;
 			break;
+		case 'C':
+			catalog = optarg;
+			break;
 		case 'D':
 			dirname = optarg;
 			break;
@@ -211,6 +247,9 @@ int	main (int argc, char *const argv[])
 		case 'n':
 			noexec = 1;
 			break;
+		case 'P':
+			plan = 1;
+			break;
 		case 'r':
 			if ( !dynamic_zone )	/* dynamic zones don't need a rndc reload (see "-d" */
 				reloadflag = 1;
@@ -242,6 +281,8 @@ int	main (int argc, char *const argv[])
 
 	if ( lg_open (progname, config->syslogfacility, config->sysloglevel, config->zonedir, logfile, config->loglevel) < -1 )
 		fatal ("Couldn't open logfile %s in dir %s\n", logfile, config->zonedir);
+	if ( lg_setformat (config->logformat) < 0 )
+		lg_mesg (LG_WARNING, "unknown log format \"%s\": using text", config->logformat);
 
 	lg_args (LG_NOTICE, argc, argv);
 
@@ -254,6 +295,11 @@ int	main (int argc, char *const argv[])
 	}
 
 
+	/* fill the key pool in the background */
+	keypool_pid = -1;
+	if ( is_defined (config->keypooldir) && !plan && !noexec )
+		keypool_pid = keypool_start (config);
+
 	if ( origin )		/* option -o ? */
 	{
 		int	ret;
@@ -273,18 +319,45 @@ int	main (int argc, char *const argv[])
 			fatal ("Couldn't read zone \"%s\"\n", origin);
 		}
 	}
+	/* zones given as arguments: skip all others (but their parents) while reading in */
+	filtered = argc - optind > 0;
+	if ( !zone_setfilter (&argv[optind], argc - optind) )
+		fatal ("%s\n", zone_geterrstr ());
 	if ( namedconf )	/* option -N ? */
 	{
 		char	dir[255+1];
+		char	cachefile[MAX_PATHSIZE+1];
 
 		memset (dir, '\0', sizeof (dir));
 		if ( config->zonedir )
 			strncpy (dir, config->zonedir, sizeof(dir));
+		if ( is_defined (config->namedconf_cache) )
+		{
+			if ( *config->namedconf_cache != '/' && is_defined (config->zonedir) )
+				pathname (cachefile, sizeof (cachefile), config->zonedir, config->namedconf_cache, NULL);
+			else
+				snprintf (cachefile, sizeof (cachefile), "%s", config->namedconf_cache);
+			parse_namedconf_cache (cachefile);
+		}
 		if ( !parse_namedconf (namedconf, config->chroot_dir, dir, sizeof (dir), add2zonelist) )
 			fatal ("Can't read file %s as namedconf file\n", namedconf);
-		if ( zonelist == NULL )
+		if ( zonelist == NULL && !filtered )
 			fatal ("No signed zone found in file %s\n", namedconf);
 	}
+	if ( catalog )		/* option -C ? */
+	{
+		catalog_stats_t	cstats;
+
+		if ( !parse_catalog (catalog, catalog2zonelist, &cstats) )
+		{
+			lg_mesg (LG_FATAL, "catalog \"%s\": %s", catalog, catalog_geterrstr ());
+			fatal ("Can't read catalog zone %s: %s\n", catalog, catalog_geterrstr ());
+		}
+		verbmesg (1, config, "Catalog zone %s (serial %lu): %ld member zones%s\n", catalog,
+				cstats.serial, cstats.members, cstats.cached ? " (unchanged)": "");
+		if ( zonelist == NULL && !filtered )
+			fatal ("No signed zone found in catalog zone %s\n", catalog);
+	}
 	if ( dirname )		/* option -D ? */
 	{
 		char	*dir = strdup (dirname);
@@ -297,30 +370,46 @@ int	main (int argc, char *const argv[])
 
 		if ( !parsedir (dir, &zonelist, config) )
 			fatal ("Can't read directory tree %s\n", dir);
-		if ( zonelist == NULL )
+		if ( zonelist == NULL && !filtered )
 			fatal ("No signed zone found in directory tree %s\n", dir);
 		free (dir);
 	}
 
 	/* none of the above: read default directory tree */
-	if ( zonelist == NULL )
+	if ( !origin && !namedconf && !catalog && !dirname )
 		parsedir (config->zonedir, &zonelist, config);
+	zone_sortlist (&zonelist);	/* the zones are read in unsorted */
 
 #if defined(DBG) && DBG
 	for ( zp = zonelist; zp; zp = zp->next )
 		zone_print ("in main: ", zp);
 #endif
-	for ( zp = zonelist; zp; zp = zp->next )
-		if ( in_strarr (zp->zone, &argv[optind], argc - optind) )
-		{
-			dosigning (zonelist, zp);
-			verbmesg (1, zp->conf, "\n");
-		}
+	if ( plan )	/* option -P ? */
+		print_plan (zonelist);
+	else
+		for ( zp = zonelist; zp; zp = zp->next )
+			if ( zone_requested (zp->zone) )
+			{
+				zone_loadkeys (zp);	/* keys are held for one zone at a time */
+				lg_setzone (zp->zone, zp->conf->view);
+				dosigning (zonelist, zp);
+				lg_setzone (NULL, NULL);
+				zone_freekeys (zp);
+				verbmesg (1, zp->conf, "\n");
+			}
 
 	zone_freelist (&zonelist);
 
+	if ( keypool_pid > 0 )		/* wait for the key pool worker */
+		waitpid (keypool_pid, NULL, 0);
+	if ( is_defined (config->keypooldir) && !plan )
+	{
+		keypool_report ();
+		keypool_status (config, NULL);
+	}
+
 	errcnt = lg_geterrcnt ();
-	lg_mesg (LG_NOTICE, "end of run: %d error%s occured", errcnt, errcnt == 1 ? "" : "s");
+	lg_event (LG_NOTICE, "end", "errors=%d", "end of run: %d error%s occured", errcnt, errcnt == 1 ? "" : "s");
 	lg_close ();
 
 	return errcnt < 64 ? errcnt : 64;
@@ -342,12 +431,16 @@ static	void	usage (char *mesg, zconf_t *conf)
 
 	fprintf (stderr, "usage: %s [-L] [-V view] [-c file] [-O optstr] ", progname);
 	fprintf (stderr, "[-D directorytree] ");
-	fprintf (stderr, "[-fhnr] [-v [-v]] [zone ...]\n");
+	fprintf (stderr, "[-fhnPr] [-v [-v]] [zone ...]\n");
 
 	fprintf (stderr, "usage: %s [-L] [-V view] [-c file] [-O optstr] ", progname);
 	fprintf (stderr, "-N named.conf ");
 	fprintf (stderr, "[-fhnr] [-v [-v]] [zone ...]\n");
 
+	fprintf (stderr, "usage: %s [-L] [-V view] [-c file] [-O optstr] ", progname);
+	fprintf (stderr, "-C catalog.db ");
+	fprintf (stderr, "[-fhnr] [-v [-v]] [zone ...]\n");
+
 	fprintf (stderr, "usage: %s [-L] [-V view] [-c file] [-O optstr] ", progname);
 	fprintf (stderr, "-o origin ");
 	fprintf (stderr, "[-fhnr] [-v [-v]] [zonefile.signed]\n");
@@ -364,12 +457,15 @@ static	void	usage (char *mesg, zconf_t *conf)
 	fprintf (stderr, "\t\t parse the given directory tree for a list of secure zones \n");
 	fprintf (stderr, "\t-N file%s", loptstr (", --named-conf=file\n", ""));
 	fprintf (stderr, "\t\t get the list of secure zones out of the named like config file \n");
+	fprintf (stderr, "\t-C file%s", loptstr (", --catalog=file\n", ""));
+	fprintf (stderr, "\t\t get the list of secure zones out of the catalog zone file \n");
 	fprintf (stderr, "\t-o zone%s", loptstr (", --origin=zone", ""));
 	fprintf (stderr, "\tspecify the name of the zone \n");
 	fprintf (stderr, "\t\t The file to sign should be given as an argument (default is \"%s.signed\")\n", conf->zonefile);
 	fprintf (stderr, "\t-h%s\t print this help\n", loptstr (", --help", "\t"));
 	fprintf (stderr, "\t-f%s\t force re-signing\n", loptstr (", --force", "\t"));
 	fprintf (stderr, "\t-n%s\t no execution of external signing command\n", loptstr (", --noexec", "\t"));
+	fprintf (stderr, "\t-P%s\t print the projected re-signing and key rollover load per day (no signing)\n", loptstr (", --plan", "\t"));
 	// fprintf (stderr, "\t-r%s\t reload zone via <rndc reload zone> (or via the external distribution command)\n", loptstr (", --reload", "\t"));
 	fprintf (stderr, "\t-r%s\t reload zone via %s\n", loptstr (", --reload", "\t"), conf->dist_cmd ? conf->dist_cmd: "rndc");
         fprintf (stderr, "\t-v%s\t be verbose (use twice to be very verbose)\n", loptstr (", --verbose", "\t"));
@@ -415,37 +511,80 @@ static	int	add2zonelist (const char *dir, const char *view, const char *zone, co
 	return zone_readdir (dir, zone, file, &zonelist, config, dynamic_zone);
 }
 
-static	int	parsedir (const char *dir, zone_t **zp, const zconf_t *conf)
+/**	fill zonelist with the member zones of a catalog zone	**/
+static	int	catalog2zonelist (const char *zone)
 {
-	DIR	*dirp;
-	struct  dirent  *dentp;
 	char	path[MAX_PATHSIZE+1];
-
-	dbg_val ("parsedir: (%s)\n", dir);
-	if ( !is_directory (dir) )
+	char	*p;
+	const	char	*t;
+	size_t	len;
+
+	/* expand CatalogTemplate to the path of the zone file */
+	p = path;
+	if ( *config->catalog_template != '/' && is_defined (config->zonedir) )
+		p += snprintf (path, sizeof (path), "%s/", config->zonedir);
+	len = strlen (zone);
+	for ( t = config->catalog_template; *t && p < path + sizeof (path) - 1; t++ )
+	{
+		if ( *t != '%' || (t[1] != 'z' && t[1] != 'Z' && t[1] != '%') )
+		{
+			*p++ = *t;
+			continue;
+		}
+		t++;
+		if ( *t == '%' )
+			*p++ = '%';
+		else if ( *t == 'Z' || len <= 1 )	/* zone name with trailing dot */
+			p += snprintf (p, path + sizeof (path) - p, "%s", zone);
+		else
+			p += snprintf (p, path + sizeof (path) - p, "%.*s", (int)(len - 1), zone);
+	}
+	if ( p >= path + sizeof (path) - 1 )
+	{
+		lg_mesg (LG_ERROR, "\"%s\": path of catalog member too long", zone);
 		return 0;
+	}
+	*p = '\0';
+	if ( p > path && p[-1] == '/' )		/* template is a directory ? */
+		snprintf (p, path + sizeof (path) - p, "%s", config->zonefile);
+
+	if ( (p = strrchr (path, '/')) == NULL )
+		return zone_readdir (".", zone, path, &zonelist, config, dynamic_zone);
+	*p++ = '\0';
+	return zone_readdir (*path ? path: "/", zone, p, &zonelist, config, dynamic_zone);
+}
 
-	dbg_line ();
-	zone_readdir (dir, NULL, NULL, zp, conf, dynamic_zone);
+typedef	struct	{
+	zone_t	**zp;
+	const	zconf_t	*conf;
+} parsedir_t;
 
-	dbg_val ("parsedir: opendir(%s)\n", dir);
-	if ( (dirp = opendir (dir)) == NULL )
-		return 0;
+/* called in parallel for each directory of the tree */
+static	void	*scanzonedir (const char *dir, void *arg)
+{
+	parsedir_t	*pd = (parsedir_t *)arg;
 
-	while ( (dentp = readdir (dirp)) != NULL )
-	{
-		if ( is_dotfilename (dentp->d_name) )
-			continue;
+	return zone_scandir (dir, pd->conf, dynamic_zone);
+}
 
-		pathname (path, sizeof (path), dir, dentp->d_name, NULL);
-		if ( !is_directory (path) )
-			continue;
+/* called in the main thread for each directory in the order of the tree */
+static	void	mergezonedir (const char *dir, void *data, void *arg)
+{
+	parsedir_t	*pd = (parsedir_t *)arg;
 
-		dbg_val ("parsedir: recursive %s\n", path);
-		parsedir (path, zp, conf);
-	}
-	closedir (dirp);
-	return 1;
+	dbg_val ("parsedir: add %s\n", dir);
+	zone_readscan (dir, (zonescan_t *)data, pd->zp, pd->conf, dynamic_zone);
+}
+
+static	int	parsedir (const char *dir, zone_t **zp, const zconf_t *conf)
+{
+	parsedir_t	pd;
+
+	dbg_val ("parsedir: (%s)\n", dir);
+	pd.zp = zp;
+	pd.conf = conf;
+
+	return dirwalk (dir, 1, 0, scanzonedir, mergezonedir, &pd);
 }
 
 static	int	dosigning (zone_t *zonelist, zone_t *zp)
@@ -455,10 +594,17 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 	int	newkey;
 	int	newkeysetfile;
 	int	use_unixtime;
+	int	resign_due;
+	int	newsalt;
 	time_t	currtime;
 	time_t	zfile_time;
 	time_t	zfilesig_time;
+	time_t	sig_expire;
+	time_t	resigntime;
+	time_t	nextresign;
 	char	mesg[255+1];
+	char	newfile[MAX_PATHSIZE+1];
+	const	char	*trigger;
 
 	verbmesg (1, zp->conf, "parsing zone \"%s\" in dir \"%s\"\n", zp->zone, zp->dir);
 
@@ -503,9 +649,25 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 			lg_zone_start (zp->conf->logdomaindir, zp->zone);
 	}
 
+	/* re-sign before the earliest signature of the zone expires */
+	resigntime = get_resigntime (zp, zfilesig_time, &sig_expire);
+	if ( sig_expire > 0 )
+		verbmesg (2, zp->conf, "\tEarliest signature expiration at %s", time2str (sig_expire, 's'));
+	verbmesg (2, zp->conf, "\tNext re-signing at %s\n", time2str (resigntime, 's'));
+	resign_due = currtime > resigntime;
+
+	/* static NSEC3 zones get a new salt at the end of the salt lifetime */
+	newsalt = 0;
+	if ( !dynamic_zone && zp->salt && zp->conf->salt_life > 0 &&
+	     (zp->conf->nsec3 != NSEC3_OFF || zp->conf->k_algo == DK_ALGO_NSEC3DSA || zp->conf->k_algo == DK_ALGO_NSEC3RSASHA1) )
+		newsalt = salt_due (zp, currtime);
+
+	/* non urgent key transitions will be aligned to the next re-signing time */
+	nextresign = ( force || resign_due || newsalt || zfile_time > zfilesig_time ) ? currtime : resigntime;
+
 	/* check rfc5011 key signing keys, create new one if necessary */
 	dbg_msg("parsezonedir check rfc 5011 ksk ");
-	newkey = ksk5011status (&zp->keys, zp->dir, zp->zone, zp->conf);
+	newkey = ksk5011status (&zp->keys, zp->dir, zp->zone, zp->conf, nextresign);
 	if ( (newkey & 02) != 02 )	/* not a rfc 5011 zone ? */
 	{
 		verbmesg (2, zp->conf, "\t\t->not a rfc5011 zone, looking for a regular ksk rollover\n");
@@ -518,7 +680,7 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 
 	/* check age of zone keys, probably retire (depreciate) or remove old keys */
 	dbg_msg("parsezonedir check zsk ");
-	newkey += zskstatus (&zp->keys, zp->dir, zp->zone, zp->conf);
+	newkey += zskstatus (&zp->keys, zp->dir, zp->zone, zp->conf, nextresign);
 
 	/* check age of "dnskey.db" file against age of keyfiles */
 	pathname (path, sizeof (path), zp->dir, zp->conf->keyfile, NULL);
@@ -526,6 +688,9 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 	if ( !newkey )
 		newkey = check_keydb_timestamp (zp->keys, file_mtime (path));
 
+	/* refresh the DS set of the zone, independent of the next signing */
+	write_dsset (zp);
+
 	newkeysetfile = 0;
 #if defined(ALWAYS_CHECK_KEYSETFILES) && ALWAYS_CHECK_KEYSETFILES	/* patch from Shane Wegner 15. June 2009 */
 	/* check if there is a new keyset- file */
@@ -571,22 +736,34 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 	**	c) we found a new KSK of a delegated domain, or
 	**	d) the "dnskey.db" file is newer than "zone.db" 
 	**	e) the "zone.db" or any included file is newer than "zone.db.signed" or
-	**	f) "zone.db.signed" is older than the re-sign interval
+	**	f) the earliest signature expires within the re-sign margin
+	**	   (or "zone.db.signed" is older than the re-sign interval) or
+	**	g) the NSEC3 salt is older than the salt lifetime or
+	**	h) the verification of the last signed zone failed
 	**/
 	mesg[0] = '\0';
+	trigger = NULL;		/* short name of the reason for the structured log */
 	if ( force )
-		snprintf (mesg, sizeof(mesg), "Option -f"); 
+		snprintf (mesg, sizeof(mesg), "Option -f"), trigger = "force";
 	else if ( newkey )
-		snprintf (mesg, sizeof(mesg), "Modified zone key set"); 
+		snprintf (mesg, sizeof(mesg), "Modified zone key set"), trigger = "newkey";
 	else if ( newkeysetfile )
-		snprintf (mesg, sizeof(mesg), "Modified KSK in delegated domain"); 
+		snprintf (mesg, sizeof(mesg), "Modified KSK in delegated domain"), trigger = "delegation";
 	else if ( file_mtime (path) > zfilesig_time )
-		snprintf (mesg, sizeof(mesg), "Modified keys");
+		snprintf (mesg, sizeof(mesg), "Modified keys"), trigger = "keys";
 	else if ( zfile_time > zfilesig_time )
-		snprintf (mesg, sizeof(mesg), "Zone file edited");
-	else if ( (currtime - zfilesig_time) > zp->conf->resign - (OFFSET) )
+		snprintf (mesg, sizeof(mesg), "Zone file edited"), trigger = "zonefile";
+	else if ( resign_due && sig_expire > 0 )
+		snprintf (mesg, sizeof(mesg), "signature expiration (%s) within re-signing margin",
+						time2str (sig_expire, 's')), trigger = "expiration";
+	else if ( resign_due )
 		snprintf (mesg, sizeof(mesg), "re-signing interval (%s) reached",
-						str_delspace (age2str (zp->conf->resign)));
+						str_delspace (age2str (zp->conf->resign))), trigger = "interval";
+	else if ( newsalt )
+		snprintf (mesg, sizeof(mesg), "NSEC3 salt lifetime (%s) reached",
+						str_delspace (age2str (zp->conf->salt_life))), trigger = "salt";
+	else if ( zp->verify_failed )
+		snprintf (mesg, sizeof(mesg), "verification of the signed zone failed"), trigger = "verify";
 
 	if ( *mesg )
 		verbmesg (1, zp->conf, "\tRe-signing necessary: %s\n", mesg);
@@ -594,19 +771,30 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 		verbmesg (1, zp->conf, "\tRe-signing not necessary!\n");
 
 	if ( *mesg )
-		lg_mesg (LG_NOTICE, "\"%s\": re-signing triggered: %s", zp->zone,  mesg);
+		lg_event (LG_NOTICE, "resign", "zone=%s reason=%s trigger=%s",
+				"\"%s\": re-signing triggered: %s", zp->zone, mesg, trigger);
 
 	dbg_line ();
 	if ( !(force || newkey || newkeysetfile || zfile_time > zfilesig_time ||	
-	     file_mtime (path) > zfilesig_time ||
-	     (currtime - zfilesig_time) > zp->conf->resign - (OFFSET)) )
+	     file_mtime (path) > zfilesig_time || resign_due || newsalt || zp->verify_failed) )
 	{
 		verbmesg (2, zp->conf, "\tCheck if there is a parent file to copy\n");
 		if ( zp->conf->keysetdir && strcmp (zp->conf->keysetdir, "..") == 0 )
 			copy_keyset (zp->dir, zp->zone, zp->conf);	/* copy the parent- file if it exist */
+		/* SignedFormat may have been changed since the last signing */
+		err = 0;
+		if ( !dynamic_zone && noexec == 0 && !zp->verify_failed && nsfile_outdated (zp) &&
+		     (err = compile_zone (zp)) >= 0 && reloadflag )
+		{
+			/* the name server has to load the new compiled file */
+			if ( zp->conf->dist_cmd )
+				dist_zone (zp);
+			else
+				reload_zone (zp->zone, zp->conf);
+		}
 		if ( is_defined (zp->conf->logdomaindir) )
 			lg_zone_end ();
-		return 0;	/* nothing to do */
+		return err;	/* nothing (else) to do */
 	}
 
 	/* let's start signing the zone */
@@ -615,7 +803,7 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 	/* create new "dnskey.db" file  */
 	pathname (path, sizeof (path), zp->dir, zp->conf->keyfile, NULL);
 	verbmesg (1, zp->conf, "\tWriting key file \"%s\"\n", path);
-	if ( !writekeyfile (path, zp->keys, zp->conf->key_ttl) )
+	if ( !writekeyfile (path, zp->keys, zp->conf) )
 	{
 		error ("Can't create keyfile %s \n", path);
 		lg_mesg (LG_ERROR, "\"%s\": can't create keyfile %s", zp->zone , path);
@@ -683,7 +871,7 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 				copyzonefile (path, zfile, zp->conf->keyfile);
 #if 0
 				if ( zp->conf->dist_cmd )
-					dist_and_reload (zp, 2);	/* ... and send to the name server */
+					dist_and_reload (zp, 2, NULL);	/* ... and send to the name server */
 #endif
 			}
 			else		/* else we can do a simple file copy */
@@ -694,7 +882,7 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 		if ( (err = sign_zone (zp)) < 0 )
 		{
 			error ("\tSigning of zone %s failed (%d)!\n", zp->zone, err);
-			lg_mesg (LG_ERROR, "\"%s\": signing failed!", zp->zone);
+			lg_event (LG_ERROR, "signfailed", "zone=%s error=%d", "\"%s\": signing failed!", zp->zone, err);
 		}
 		timer = stop_timer (timer);
 
@@ -708,7 +896,22 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 		if ( !tstr || *tstr == '\0' )
 			tstr = "0s";
 		verbmesg (1, zp->conf, "\tSigning completed after %s.\n", tstr);
+		lg_event (LG_INFO, "signed", "zone=%s _=%s duration=%ld",
+				"\"%s\": signing completed after %s", zp->zone, tstr, (long)timer);
+		}
+
+		/* check the new signed zone before it replaces the last one */
+		if ( signed_newfile (zp, newfile, sizeof (newfile)) != NULL )
+		{
+			if ( err >= 0 )
+				err = verify_zone (zp, newfile);
+			else	/* remove what the failed signer left behind */
+				unlink (pathname (path, sizeof (path), zp->dir, newfile, NULL));
 		}
+
+		/* convert it into the format loaded by the name server */
+		if ( err >= 0 && !dynamic_zone && noexec == 0 )
+			err = compile_zone (zp);
 	}
 
 	copy_keyset (zp->dir, zp->zone, zp->conf);
@@ -716,7 +919,7 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 	if ( err >= 0 && reloadflag )
 	{
 		if ( zp->conf->dist_cmd )
-			dist_and_reload (zp, 1);
+			dist_zone (zp);
 		else
 			reload_zone (zp->zone, zp->conf);
 
@@ -729,6 +932,317 @@ static	int	dosigning (zone_t *zonelist, zone_t *zp)
 	return err;
 }
 
+/*****************************************************************
+**	get_sigexpire ()
+**	return the earliest RRSIG expiration time of the signed zone
+**	file. The signed file is only scanned if it differs (mtime or
+**	size) from the one recorded in the state file of the zone.
+**	return 0 if no signature time could be found
+*****************************************************************/
+static	time_t	get_sigexpire (zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	time_t	mtime;
+	long	size;
+
+	assert (zp != NULL);
+
+	pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+	mtime = file_mtime (path);
+	size = filesize (path);
+
+	if ( zone_readstate (zp) < 0 )
+		lg_mesg (LG_WARNING, "\"%s\": %s", zp->zone, zone_geterrstr ());
+
+	if ( zp->sig_expire > 0 && zp->sig_mtime == mtime && zp->sig_size == size )
+		return zp->sig_expire;		/* signed file is unchanged since last scan */
+
+	verbmesg (2, zp->conf, "\tScanning signature times of \"%s\"\n", path);
+	zp->sig_expire = zp->sig_inception = 0L;
+	if ( parsesigtimes (zp->dir, zp->sfile, &zp->sig_expire, &zp->sig_inception) <= 0 )
+		return 0L;
+	zp->sig_mtime = mtime;
+	zp->sig_size = size;
+
+	if ( zp->sig_inception > time (NULL) + HOURSEC )
+		lg_mesg (LG_WARNING, "\"%s\": latest signature inception time %s is in the future",
+					zp->zone, time2str (zp->sig_inception, 's'));
+
+	if ( !noexec && zone_writestate (zp) < 0 )
+		lg_mesg (LG_WARNING, "\"%s\": %s", zp->zone, zone_geterrstr ());
+
+	return zp->sig_expire;
+}
+
+/*****************************************************************
+**	resign_lead ()
+**	return the time before the earliest signature expiration
+**	the zone should be re-signed
+*****************************************************************/
+static	long	resign_lead (const zconf_t *conf)
+{
+	long	lead;
+
+	lead = conf->resign_margin;
+	if ( lead <= 0 )
+		lead = conf->sigvalidity - conf->resign;
+
+	return lead + conf->proptime;
+}
+
+/*****************************************************************
+**	resign_offset ()
+**	return the re-signing jitter of the zone: a value between 0
+**	and ResignJitter derived from the zone name, so it's the same
+**	on every run
+*****************************************************************/
+static	long	resign_offset (const zone_t *zp)
+{
+	if ( zp->conf->resign_jitter <= 0 )
+		return 0L;
+
+	return (long)(domain_hash (zp->zone) % (unsigned long)(zp->conf->resign_jitter + 1));
+}
+
+/*****************************************************************
+**	get_resigntime ()
+**	return the time the zone has to be re-signed and store the
+**	earliest signature expiration time in *psig_expire (0 if
+**	there is no RRSIG in the signed zone file)
+*****************************************************************/
+static	time_t	get_resigntime (zone_t *zp, time_t zfilesig_time, time_t *psig_expire)
+{
+	time_t	sig_expire;
+	time_t	resigntime;
+
+	if ( (sig_expire = get_sigexpire (zp)) > 0 )
+		resigntime = sig_expire - resign_lead (zp->conf);
+	else	/* no RRSIG found (or not readable), so use the age of the signed file */
+		resigntime = zfilesig_time + zp->conf->resign - (OFFSET);
+	resigntime -= resign_offset (zp);
+
+	if ( psig_expire )
+		*psig_expire = sig_expire;
+	return resigntime;
+}
+
+/*****************************************************************
+**	plan_rollover ()
+**	count the projected rollovers of the active key (ksk or zsk)
+**	of zone zp in the per day array cnt
+*****************************************************************/
+static	void	plan_rollover (const zone_t *zp, int ksk, time_t currtime, int *cnt, int ndays)
+{
+	const	dki_t	*akey;
+	time_t	lifetime;
+	time_t	t;
+
+	if ( (lifetime = key_lifetime (zp->zone, ksk, zp->conf)) <= 0 )
+		return;
+	if ( (akey = dki_findalgo (zp->keys, ksk, zp->conf->k_algo, 'a', 1)) == NULL )
+		return;
+
+	t = dki_time (akey);
+	if ( dki_lifetime (akey) )
+		t += dki_lifetime (akey);
+	else
+		t += lifetime;
+	if ( t < currtime )	/* overdue ? */
+		t = currtime;
+
+	for ( ; t < currtime + ndays * DAYSEC; t += lifetime )
+		cnt[(t - currtime) / DAYSEC]++;
+}
+
+/*****************************************************************
+**	print_plan ()
+**	print the projected number of zone re-signings and key
+**	rollovers per day for the next signature validity period
+**	(or the zsk lifetime if this is longer)
+*****************************************************************/
+static	void	print_plan (zone_t *zonelist)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	datestr[31+1];
+	zone_t	*zp;
+	time_t	currtime;
+	time_t	endtime;
+	time_t	t;
+	time_t	sig_expire;
+	long	period;
+	long	horizon;
+	int	*resigns;
+	int	*zskrolls;
+	int	*kskrolls;
+	int	ndays;
+	int	day;
+	int	cnt;
+	int	maxcnt;
+	int	total;
+
+	currtime = time (NULL);
+	horizon = DAYSEC;
+	cnt = 0;
+	for ( zp = zonelist; zp; zp = zp->next )
+		if ( zone_requested (zp->zone) )
+		{
+			horizon = max (horizon, zp->conf->sigvalidity);
+			horizon = max (horizon, zp->conf->z_life);
+			cnt++;
+		}
+	ndays = (horizon + DAYSEC - 1) / DAYSEC;
+	endtime = currtime + ndays * DAYSEC;
+
+	resigns = calloc (ndays, sizeof (int));
+	zskrolls = calloc (ndays, sizeof (int));
+	kskrolls = calloc (ndays, sizeof (int));
+	if ( resigns == NULL || zskrolls == NULL || kskrolls == NULL )
+		fatal ("Out of memory\n");
+
+	for ( zp = zonelist; zp; zp = zp->next )
+	{
+		if ( !zone_requested (zp->zone) )
+			continue;
+
+		zone_loadkeys (zp);
+		pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+		t = get_resigntime (zp, file_mtime (path), &sig_expire);
+		if ( t < currtime )	/* overdue ? */
+			t = currtime;
+
+		/* time between two signing runs; dnssec-signzone -j shortens the expiration time */
+		if ( sig_expire > 0 )
+			period = zp->conf->sigvalidity - zp->conf->resign_jitter - resign_lead (zp->conf) - resign_offset (zp);
+		else
+			period = zp->conf->resign - (OFFSET) - resign_offset (zp);
+		if ( period < HOURSEC )
+			period = HOURSEC;
+
+		for ( ; t < endtime; t += period )
+			resigns[(t - currtime) / DAYSEC]++;
+
+		plan_rollover (zp, DKI_ZSK, currtime, zskrolls, ndays);
+		plan_rollover (zp, DKI_KSK, currtime, kskrolls, ndays);
+		zone_freekeys (zp);
+	}
+
+	maxcnt = 1;
+	for ( day = 0; day < ndays; day++ )
+		maxcnt = max (maxcnt, resigns[day]);
+
+	printf ("Projected load of %d zone%s for the next %d days\n", cnt, cnt == 1 ? "": "s", ndays);
+	printf ("%-14s %6s %6s %6s\n", "Date", "Resign", "ZSK", "KSK");
+	total = 0;
+	for ( day = 0; day < ndays; day++ )
+	{
+		t = currtime + day * DAYSEC;
+		strftime (datestr, sizeof (datestr), "%Y-%m-%d %a", localtime (&t));
+		printf ("%-14s %6d %6d %6d  %.*s\n", datestr, resigns[day], zskrolls[day], kskrolls[day],
+				resigns[day] * 50 / maxcnt, "##################################################");
+		total += resigns[day];
+	}
+	printf ("average %.1f re-signings per day (max %d)\n", (double)total / ndays, maxcnt);
+
+	if ( is_defined (config->keypooldir) )
+		keypool_status (config, stdout);
+
+	free (resigns);
+	free (zskrolls);
+	free (kskrolls);
+}
+
+/*****************************************************************
+**	keypool_profile ()
+**	get the i-th key profile (ksk, algorithm and key size)
+**	needed by the config
+**	returns 0 if there is no such profile
+*****************************************************************/
+static	int	keypool_profile (const zconf_t *conf, int i, int *ksk, int *algo, int *bits)
+{
+	int	addkey;
+
+	addkey = i / 2;
+	if ( addkey > 1 || (addkey && (conf->k2_algo == 0 || conf->k2_algo == conf->k_algo)) )
+		return 0;
+
+	*ksk = ( i % 2 == 0 );
+	*algo = key_algo (addkey, conf);
+	*bits = *ksk ? conf->k_bits : conf->z_bits;
+
+	return 1;
+}
+
+/*****************************************************************
+**	keypool_start ()
+**	start a background process to fill the key pool up to
+**	KeyPoolSize keys for all key profiles of the global config
+**	(one process per key profile)
+**	returns the process id of the worker or -1 on error
+*****************************************************************/
+static	pid_t	keypool_start (const zconf_t *conf)
+{
+	pid_t	pid;
+	int	ksk;
+	int	algo;
+	int	bits;
+	int	ret;
+	int	i;
+
+	fflush (NULL);		/* don't duplicate buffered output */
+	if ( (pid = fork ()) != 0 )
+	{
+		if ( pid < 0 )
+			lg_mesg (LG_ERROR, "key pool: can't start worker process: %s", strerror (errno));
+		return pid;
+	}
+
+	/* child process: fill all key profiles in parallel */
+	for ( i = 0; keypool_profile (conf, i, &ksk, &algo, &bits); i++ )
+	{
+		if ( (pid = fork ()) < 0 )
+			lg_mesg (LG_ERROR, "key pool: can't start worker process: %s", strerror (errno));
+		if ( pid != 0 )
+			continue;
+
+		ret = keypool_fill (conf->keypooldir, ksk, algo, bits,
+					ksk ? conf->k_random: conf->z_random, conf->keypoolsize);
+		if ( ret < 0 )
+			lg_mesg (LG_ERROR, "%s", keypool_geterrstr ());
+		else if ( ret > 0 )
+			lg_mesg (LG_INFO, "key pool: %d %s%s (%s, %d bits) generated", ret,
+					ksk ? "KSK": "ZSK", ret == 1 ? "": "s", dki_algo2sstr (algo), bits);
+		lg_close ();
+		exit (0);
+	}
+	while ( wait (NULL) > 0 )
+		;
+	lg_close ();
+	exit (0);
+}
+
+/*****************************************************************
+**	keypool_status ()
+**	print (or log if fp is NULL) the number of keys in the key
+**	pool for all key profiles of the global config
+*****************************************************************/
+static	void	keypool_status (const zconf_t *conf, FILE *fp)
+{
+	int	ksk;
+	int	algo;
+	int	bits;
+	int	i;
+
+	for ( i = 0; keypool_profile (conf, i, &ksk, &algo, &bits); i++ )
+		if ( fp )
+			fprintf (fp, "key pool %s: %d of %d %s (%s, %d bits)\n", conf->keypooldir,
+					keypool_depth (conf->keypooldir, ksk, algo, bits), conf->keypoolsize,
+					ksk ? "KSK": "ZSK", dki_algo2sstr (algo), bits);
+		else
+			lg_mesg (LG_INFO, "key pool: %d of %d %s (%s, %d bits) available",
+					keypool_depth (conf->keypooldir, ksk, algo, bits), conf->keypoolsize,
+					ksk ? "KSK": "ZSK", dki_algo2sstr (algo), bits);
+}
+
 /*****************************************************************
 **	This function is no longer needed, and us doing in fact
 **	nothing.
@@ -774,6 +1288,7 @@ static	void	register_key (dki_t *list, const zconf_t *z)
  *	generation (checked with cmpfile(), see func sign_zone()).
  */
 # define	KEYSET_FILE_PFX	"keyset-"
+# define	DSSET_FILE_PFX	"dsset-"
 static	int	new_keysetfiles (const char *dir, time_t zone_signing_time)
 {
 	DIR	*dirp;
@@ -788,7 +1303,8 @@ static	int	new_keysetfiles (const char *dir, time_t zone_signing_time)
 	dbg_val2 ("new_keysetfile (%s, %s)\n", dir, time2str (zone_signing_time, 's')); 
 	while ( !newkeysetfile && (dentp = readdir (dirp)) != NULL )
 	{
-		if ( strncmp (dentp->d_name, KEYSET_FILE_PFX, strlen (KEYSET_FILE_PFX)) != 0 )
+		if ( strncmp (dentp->d_name, KEYSET_FILE_PFX, strlen (KEYSET_FILE_PFX)) != 0 &&
+		     strncmp (dentp->d_name, DSSET_FILE_PFX, strlen (DSSET_FILE_PFX)) != 0 )
 			continue;
 
 		pathname (path, sizeof (path), dir, dentp->d_name, NULL);
@@ -816,11 +1332,13 @@ static	int	check_keydb_timestamp (dki_t *keylist, time_t reftime)
 	return 0;
 }
 
-static	int	writekeyfile (const char *fname, const dki_t *list, int key_ttl)
+static	int	writekeyfile (const char *fname, const dki_t *list, const zconf_t *conf)
 {
 	FILE	*fp;
 	const	dki_t	*dkp;
 	time_t	curr = time (NULL);
+	int	key_ttl = conf->key_ttl;
+	int	digests;
 	int	ksk;
 
 	if ( (fp = fopen (fname, "w")) == NULL )
@@ -846,18 +1364,473 @@ static	int	writekeyfile (const char *fname, const dki_t *list, int key_ttl)
 		dki_prt_dnskeyttl (dkp, fp, key_ttl);
 		putc ('\n', fp);
 	}
+
+	if ( conf->cds )	/* child DS (RFC 7344) of the active key signing keys */
+	{
+		if ( (digests = dki_str2digest (conf->ds_digest)) <= 0 )
+			digests = 1 << DK_DIGEST_SHA256;
+		fprintf (fp, ";  ***  CDS and CDNSKEY of the active Key Signing Keys  ***\n");
+		for ( dkp = list; dkp; dkp = dkp->next )
+			if ( dki_isksk (dkp) && dki_status (dkp) == DKI_ACT )
+			{
+				if ( dki_prt_ds (dkp, fp, key_ttl, digests, "CDS") < 0 )
+					lg_mesg (LG_ERROR, "\"%s\": %s", dkp->name, dki_geterrstr ());
+				dki_prt_cdnskey (dkp, fp, key_ttl);
+			}
+	}
 	
 	fclose (fp);
 	return 1;
 }
 
-static	int	sign_zone (const zone_t *zp)
+/*****************************************************************
+**	read_dsset ()
+**	read the rdata of all DS records with one of the given digest
+**	types out of a dsset- file (independent of the format used
+**	by dnssec-signzone or write_dsset())
+**	returns the number of records or -1 if the file is not readable
+*****************************************************************/
+# define	MAX_DSSET	(32)
+typedef	char	dsrdata_t[5+1+3+1+3+1+2*64+1];	/* "tag algo type digest" */
+static	int	read_dsset (const char *file, int digests, dsrdata_t set[], int max)
+{
+	FILE	*fp;
+	char	line[1023+1];
+	char	digest[2*64+1];
+	char	*tok;
+	uint	tag;
+	int	algo;
+	int	dtype;
+	int	cnt;
+
+	if ( (fp = fopen (file, "r")) == NULL )
+		return -1;
+
+	cnt = 0;
+	while ( cnt < max && fgets (line, sizeof (line), fp) != NULL )
+	{
+		for ( tok = strtok (line, " \t\n"); tok && strcmp (tok, "DS") != 0; tok = strtok (NULL, " \t\n") )
+			if ( *tok == ';' )
+				tok = NULL;
+		if ( tok == NULL ||
+		     (tok = strtok (NULL, " \t\n")) == NULL || sscanf (tok, "%u", &tag) != 1 ||
+		     (tok = strtok (NULL, " \t\n")) == NULL || sscanf (tok, "%d", &algo) != 1 ||
+		     (tok = strtok (NULL, " \t\n")) == NULL || sscanf (tok, "%d", &dtype) != 1 )
+			continue;
+		if ( dtype < 0 || dtype > 8 || (digests & (1 << dtype)) == 0 )
+			continue;
+
+		digest[0] = '\0';	/* the digest may be split into several words */
+		while ( (tok = strtok (NULL, " \t\n()")) != NULL && *tok != ';' )
+			if ( strlen (digest) + strlen (tok) < sizeof (digest) )
+				strcat (digest, tok);
+
+		snprintf (set[cnt++], sizeof (dsrdata_t), "%u %d %d %s", tag, algo, dtype, digest);
+	}
+	fclose (fp);
+
+	return cnt;
+}
+
+/*****************************************************************
+**	write_dsset ()
+**	write the DS records of the key signing keys of the zone into
+**	the file "dsset-<zone>" without waiting for the next signing
+**	run. The file is only replaced if the DS set has changed, so
+**	the mtime denotes a change of the delegation (see
+**	new_keysetfiles()).
+**	While a KSK rollover is in progress (parent- file exist) the
+**	DS set is left to dnssec-signzone.
+**	returns 1 if the file has been changed
+*****************************************************************/
+static	int	write_dsset (const zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	tmppath[MAX_PATHSIZE+1];
+	char	fname[MAX_FNAMESIZE+1];
+	dsrdata_t	newset[MAX_DSSET];
+	dsrdata_t	oldset[MAX_DSSET];
+	const	dki_t	*dkp;
+	FILE	*fp;
+	int	digests;
+	int	cnt;
+	int	i;
+	int	j;
+
+	if ( noexec || (digests = dki_str2digest (zp->conf->ds_digest)) <= 0 )
+		return 0;
+
+	snprintf (fname, sizeof (fname), "parent-%s", zp->zone);
+	if ( fileexist (pathname (path, sizeof (path), zp->dir, fname, NULL)) )
+		return 0;
+
+	snprintf (fname, sizeof (fname), "." DSSET_FILE_PFX "%s", zp->zone);
+	pathname (tmppath, sizeof (tmppath), zp->dir, fname, NULL);
+	if ( (fp = fopen (tmppath, "w")) == NULL )
+	{
+		lg_mesg (LG_ERROR, "\"%s\": can't create dsset file: %s", zp->zone, strerror (errno));
+		return 0;
+	}
+	cnt = 0;
+	for ( dkp = zp->keys; dkp; dkp = dkp->next )
+		if ( dki_isksk (dkp) && !dki_isrevoked (dkp) &&
+		     (dki_status (dkp) == DKI_ACT || dki_status (dkp) == DKI_PUB) )
+		{
+			if ( dki_prt_ds (dkp, fp, 0, digests, "DS") < 0 )
+			{
+				lg_mesg (LG_ERROR, "\"%s\": %s", zp->zone, dki_geterrstr ());
+				cnt = 0;
+				break;
+			}
+			cnt++;
+		}
+	fclose (fp);
+
+	snprintf (fname, sizeof (fname), DSSET_FILE_PFX "%s", zp->zone);
+	pathname (path, sizeof (path), zp->dir, fname, NULL);
+
+	/* compare the DS rdata only, because dnssec-signzone writes the file too */
+	if ( cnt > 0 && (cnt = read_dsset (tmppath, digests, newset, MAX_DSSET)) == read_dsset (path, digests, oldset, MAX_DSSET) )
+	{
+		for ( i = 0; i < cnt; i++ )
+		{
+			for ( j = 0; j < cnt && strcasecmp (newset[i], oldset[j]) != 0; j++ )
+				;
+			if ( j >= cnt )		/* not found in old DS set */
+				break;
+		}
+		if ( i >= cnt )
+			cnt = 0;		/* DS set is unchanged */
+	}
+	if ( cnt <= 0 )
+	{
+		unlink (tmppath);
+		return 0;
+	}
+	if ( rename (tmppath, path) < 0 )
+	{
+		lg_mesg (LG_ERROR, "\"%s\": can't rename dsset file: %s", zp->zone, strerror (errno));
+		unlink (tmppath);
+		return 0;
+	}
+
+	verbmesg (1, zp->conf, "\tDS set \"%s\" updated\n", path);
+	lg_event (LG_INFO, "dsset", "zone=%s file=%s", "\"%s\": DS set updated", zp->zone, path);
+
+	return 1;
+}
+
+/*****************************************************************
+**	signed_newfile (zp, file, size)
+**	If the signed zone will be verified, the signer writes it to
+**	"<signed zone file>.new", which replaces the signed zone file
+**	only if it is valid (see verify_zone()).
+**	returns the name of the new file (relative to the zone dir)
+**	or NULL if the signed zone file is written directly
+*****************************************************************/
+static	const	char	*signed_newfile (const zone_t *zp, char *file, size_t size)
+{
+	if ( dynamic_zone || !zp->conf->sig_verify || noexec )
+		return NULL;
+	snprintf (file, size, "%s%s", zp->sfile, SIGNED_NEW_EXT);
+	return file;
+}
+
+/*****************************************************************
+**	verify_zone (zp, newfile)
+**	check the new signed zone file before it replaces the signed
+**	zone file loaded by the name server. If the new file is not
+**	valid, it is removed and the last signed zone file is kept.
+**	A failed verification blocks the reload and triggers a
+**	re-signing on the next run.
+**	return 0 if the zone is valid (or couldn't be verified),
+**	otherwise -1
+*****************************************************************/
+static	int	verify_zone (zone_t *zp, const char *newfile)
+{
+	char	newpath[MAX_PATHSIZE+1];
+	char	path[MAX_PATHSIZE+1];
+	zsign_stats_t	stats;
+	time_t	timer;
+	int	ret;
+
+	verbmesg (1, zp->conf, "\tVerifying signed zone \"%s\"\n", newfile);
+	timer = start_timer ();
+	ret = zsign_verify (zp, newfile, time (NULL) + resign_lead (zp->conf), &stats);
+	timer = stop_timer (timer);
+
+	if ( ret == ZS_UNSUPPORTED )
+	{
+		verbmesg (1, zp->conf, "\tVerification skipped: %s\n", zsign_geterrstr ());
+		lg_event (LG_NOTICE, "verifyskipped", "zone=%s reason=%s",
+				"\"%s\": signed zone not verified: %s", zp->zone, zsign_geterrstr ());
+		ret = ZS_OK;
+	}
+	else if ( ret == ZS_OK )
+	{
+		verbmesg (1, zp->conf, "\tVerification of %ld rrsets with %ld signatures ok (%d thread(s), %lds)\n",
+						stats.rrsets, stats.sigs, stats.threads, (long)timer);
+		lg_event (LG_DEBUG, "verified", "zone=%s rrsets=%ld signatures=%ld",
+				"\"%s\": signed zone verified: %ld rrsets, %ld signatures",
+				zp->zone, stats.rrsets, stats.sigs);
+	}
+	else
+	{
+		error ("\tVerification of zone %s failed: %s (last signed zone kept)\n", zp->zone, zsign_geterrstr ());
+		lg_event (LG_ERROR, "verifyfailed", "zone=%s reason=%s",
+				"\"%s\": verification of the signed zone failed: %s (last signed zone kept, zone not reloaded)",
+				zp->zone, zsign_geterrstr ());
+	}
+
+	pathname (newpath, sizeof (newpath), zp->dir, newfile, NULL);
+	pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+	if ( ret != ZS_OK )
+		unlink (newpath);
+	else if ( rename (newpath, path) < 0 )
+	{
+		error ("\tcan't rename %s to %s: %s\n", newpath, path, strerror (errno));
+		lg_mesg (LG_ERROR, "\"%s\": can't rename new signed zone file: %s", zp->zone, strerror (errno));
+		unlink (newpath);
+		return -1;
+	}
+
+	if ( zp->verify_failed != (ret != ZS_OK) )
+	{
+		zp->verify_failed = ret != ZS_OK;
+		if ( zone_writestate (zp) < 0 )
+			lg_mesg (LG_WARNING, "\"%s\": %s", zp->zone, zone_geterrstr ());
+	}
+
+	return ret == ZS_OK ? 0: -1;
+}
+
+/*****************************************************************
+**	dist_zone ()
+**	run the distribution command for the zone. If DistributeDelta
+**	is set, the difference of the signed zone to the last
+**	distributed one (a hard link "<signedfile>.dist") is passed
+**	to the command as IXFR journal or UPDATE batch. Without a
+**	usable previous version only the full zone is distributed.
+*****************************************************************/
+static	int	dist_zone (const zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	base[MAX_PATHSIZE+1];
+	char	bfile[MAX_PATHSIZE+1];
+	char	dfile[MAX_PATHSIZE+1];
+	char	delta[MAX_PATHSIZE+1];
+	const	char	*dp;
+	zdiff_stats_t	stats;
+	struct	stat	sst;
+	struct	stat	bst;
+	int	format;
+	int	ret;
+
+	format = zdiff_str2format (zp->conf->dist_delta);
+	if ( dynamic_zone || noexec || format <= ZDIFF_NONE )
+		return dist_and_reload (zp, 1, NULL);
+
+	pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+	snprintf (bfile, sizeof (bfile), "%s.dist", zp->sfile);
+	pathname (base, sizeof (base), zp->dir, bfile, NULL);
+	snprintf (dfile, sizeof (dfile), "%s.%s", zp->sfile, zdiff_format2str (format));
+	pathname (delta, sizeof (delta), zp->dir, dfile, NULL);
+	unlink (delta);		/* never pass an outdated difference */
+
+	dp = NULL;
+	if ( stat (path, &sst) == 0 && stat (base, &bst) == 0 )
+	{
+		if ( sst.st_dev == bst.st_dev && sst.st_ino == bst.st_ino )
+			verbmesg (2, zp->conf, "	  Signed zone unchanged since the last distribution\n");
+		else if ( (ret = zdiff (zp->zone, zp->dir, bfile, zp->sfile, format, dfile, &stats)) == ZS_OK )
+		{
+			verbmesg (1, zp->conf, "\tZone difference %s: serial %lu to %lu, %ld deleted, %ld added records%s\n",
+					dfile, stats.oldserial, stats.newserial, stats.deleted, stats.added,
+					stats.inmemory ? " (in memory)": "");
+			lg_mesg (LG_DEBUG, "\"%s\": zone difference serial %lu to %lu: %ld deleted, %ld added",
+					zp->zone, stats.oldserial, stats.newserial, stats.deleted, stats.added);
+			dp = delta;
+		}
+		else
+		{
+			verbmesg (1, zp->conf, "\tNo zone difference: %s\n", zdiff_geterrstr ());
+			lg_mesg (ret == ZS_UNSUPPORTED ? LG_NOTICE: LG_WARNING,
+					"\"%s\": no zone difference: %s", zp->zone, zdiff_geterrstr ());
+		}
+	}
+
+	if ( (ret = dist_and_reload (zp, 1, dp)) == 0 )
+	{
+		/* keep the distributed version as base of the next difference */
+		if ( linkfile (path, base) < 0 && copyfile (path, base, NULL) < 0 )
+			lg_mesg (LG_WARNING, "\"%s\": can't keep the distributed zone as \"%s\"", zp->zone, base);
+	}
+
+	return ret;
+}
+
+/*****************************************************************
+**	compile_zone ()
+**	convert the signed zone file into the format (SignedFormat)
+**	loaded by the name server. The text file stays the working
+**	copy of zkt-signer (re-signing time, incremental signing,
+**	verification and zone difference).
+**	return 0 on success (or text format), otherwise -1
+*****************************************************************/
+static	int	compile_zone (const zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	nspath[MAX_PATHSIZE+1];
+	char	tmppath[MAX_PATHSIZE+4+1];
+	char	cmd[255+2*MAX_PATHSIZE+sizeof (tmppath)+1];
+	char	str[254+1];
+	const	char	*fmt;
+	time_t	timer;
+	FILE	*fp;
+	int	exitcode;
+
+	if ( (fmt = zone_nsformat (zp)) == NULL )
+		return 0;
+
+	pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+	zone_nsfile (zp, nspath, sizeof (nspath));
+	snprintf (tmppath, sizeof (tmppath), "%s.tmp", nspath);
+
+	/* the zone is already checked, so skip the integrity and name checks */
+	snprintf (cmd, sizeof (cmd), "%s -q -i none -k ignore -f text -F %s -o %s %s %s 2>&1",
+					COMPILECMD, fmt, tmppath, zp->zone, path);
+	verbmesg (1, zp->conf, "	Compiling signed zone into %s format \"%s\"\n", fmt, nspath);
+	verbmesg (2, zp->conf, "	  Run cmd \"%s\"\n", cmd);
+
+	timer = start_timer ();
+	if ( (fp = popen (cmd, "r")) == NULL )
+		return -1;
+	str[0] = '\0';
+	while ( fgets (str, sizeof (str), fp) != NULL )	/* keep the last line of output */
+		;
+	exitcode = pclose (fp);
+	timer = stop_timer (timer);
+
+	if ( exitcode != 0 || rename (tmppath, nspath) < 0 )
+	{
+		if ( exitcode == 0 )
+			snprintf (str, sizeof (str), "can't rename %.128s: %s", tmppath, strerror (errno));
+		error ("	Compiling of zone %s failed: %s\n", zp->zone, str_chop (str, '\n'));
+		lg_event (LG_ERROR, "compilefailed", "zone=%s format=%s reason=%s",
+				"\"%s\": compiling the signed zone into %s format failed: %s",
+				zp->zone, fmt, str);
+		unlink (tmppath);
+		return -1;
+	}
+	verbmesg (2, zp->conf, "	  Compiled after %lds\n", (long)timer);
+
+	return 0;
+}
+
+/*****************************************************************
+**	nsfile_outdated ()
+**	return 1 if the signed zone has to be compiled into the
+**	SignedFormat (e.g. after the format has been changed)
+*****************************************************************/
+static	int	nsfile_outdated (const zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	nspath[MAX_PATHSIZE+1];
+
+	if ( zone_nsformat (zp) == NULL )
+		return 0;
+
+	pathname (path, sizeof (path), zp->dir, zp->sfile, NULL);
+	zone_nsfile (zp, nspath, sizeof (nspath));
+
+	return !fileexist (nspath) || file_mtime (nspath) < file_mtime (path);
+}
+
+/*****************************************************************
+**	salt_due ()
+**	return 1 if the NSEC3 salt of the static zone has to be
+**	changed, because there is no salt, the salt length has been
+**	changed or the salt is older than SaltLifetime
+*****************************************************************/
+static	int	salt_due (const zone_t *zp, time_t currtime)
+{
+	int	saltlen;
+
+	if ( zp->salt == NULL )
+		return 1;
+
+	saltlen = zp->conf->saltbits / 4;
+	if ( saltlen <= 0 ? strcmp (zp->salt, "-") != 0 : strlen (zp->salt) != saltlen || *zp->salt == '-' )
+		return 1;
+
+	return zp->conf->salt_life > 0 && zp->salt_time + zp->conf->salt_life <= currtime;
+}
+
+/*****************************************************************
+**	nsec3_salt ()
+**	store the NSEC3 salt of the zone in salt.
+**	Static zones keep the salt in the state file, so the NSEC3
+**	chain is only rebuilt if the salt is due (see salt_due()).
+**	Dynamic zones derive the salt from the active ZSK.
+**	return 1 on success, otherwise 0
+*****************************************************************/
+static	int	nsec3_salt (zone_t *zp, char *salt, size_t size)
+{
+	const	dki_t	*kp;
+	time_t	currtime;
+	unsigned int	seed;
+
+	if ( dynamic_zone )
+	{		/* dynamic zones have to reuse the salt on signing */
+		/* use gentime timestamp of ZSK for seeding rand generator */
+		kp = dki_find (zp->keys, DKI_ZSK, DKI_ACTIVE, 1);
+		assert ( kp != NULL );
+		if ( kp->gentime )
+			seed = kp->gentime;
+		else
+			seed = kp->time;
+		return gensalt (salt, size, zp->conf->saltbits, seed);
+	}
+
+	currtime = time (NULL);
+	if ( !salt_due (zp, currtime) && strlen (zp->salt) < size )
+	{
+		strcpy (salt, zp->salt);
+		return 1;
+	}
+
+	seed = 0L;	/* no seed: use mechanism build in gensalt() */
+	if ( !gensalt (salt, size, zp->conf->saltbits, seed) )
+		return 0;
+	if ( noexec )
+		return 1;
+
+	if ( zp->salt )
+		lg_event (LG_NOTICE, "saltchanged", "zone=%s salt=%s", "\"%s\": NSEC3 salt changed", zp->zone, salt);
+	verbmesg (1, zp->conf, "\tNew NSEC3 salt \"%s\"\n", salt);
+	if ( zp->salt )
+		free (zp->salt);
+	zp->salt = strdup (salt);
+	zp->salt_time = currtime;
+	if ( zone_writestate (zp) < 0 )
+		lg_mesg (LG_WARNING, "\"%s\": %s", zp->zone, zone_geterrstr ());
+
+	return 1;
+}
+
+static	int	sign_zone (zone_t *zp)
 {
 	char	cmd[2047+1];
 	char	str[254+1];
 	char	rparam[254+1];
+	char	jparam[31+1];
 	char	nsec3param[637+1];
 	char	keysetdir[254+1];
+	char	salt[510+1];	/* salt has a maximum of 255 bytes == 510 hex nibbles */
+	char	newfile[MAX_PATHSIZE+1];
+	char	fparam[254+1];
+	const	char	*outfile;
+	const	char	*saltp;
 	const	char	*gends;
 	const	char	*dnskeyksk;
 	const	char	*pseudo;
@@ -901,13 +1874,12 @@ static	int	sign_zone (const zone_t *zp)
 		param = conf->sig_param;
 
 	nsec3param[0] = '\0';
+	saltp = NULL;
 	if ( conf->k_algo == DK_ALGO_NSEC3DSA || conf->k_algo == DK_ALGO_NSEC3RSASHA1 ||
 	     conf->nsec3 != NSEC3_OFF )
 	{
-		char	salt[510+1];	/* salt has a maximum of 255 bytes == 510 hex nibbles */
 		const	char	*update;
 		const	char	*optout;
-		unsigned int	seed;
 
 		update = "-u ";		/* trailing blank is necessary */
 		if ( conf->nsec3 == NSEC3_OPTOUT )
@@ -915,23 +1887,50 @@ static	int	sign_zone (const zone_t *zp)
 		else
 			optout = "";
 
-			/* static zones can use always a new salt (full zone signing) */
-		seed = 0L;	/* no seed: use mechanism build in gensalt() */
-		if ( dynamic_zone )
-		{		/* dynamic zones have to reuse the salt on signing */
-			const	dki_t	*kp;
-
-			/* use gentime timestamp of ZSK for seeding rand generator */
-			kp = dki_find (zp->keys, DKI_ZSK, DKI_ACTIVE, 1);
-			assert ( kp != NULL );
-			if ( kp->gentime )
-				seed = kp->gentime;
-			else
-				seed = kp->time;
+		if ( nsec3_salt (zp, salt, sizeof (salt)) )
+		{
+			snprintf (nsec3param, sizeof (nsec3param), "%s%s-3 %s ", update, optout, salt);
+			saltp = salt;
 		}
+	}
 
-		if ( gensalt (salt, sizeof (salt), conf->saltbits, seed) )
-			snprintf (nsec3param, sizeof (nsec3param), "%s%s-3 %s ", update, optout, salt);
+	/* a verified zone is written to a new file first */
+	fparam[0] = '\0';
+	if ( (outfile = signed_newfile (zp, newfile, sizeof (newfile))) != NULL )
+		snprintf (fparam, sizeof (fparam), "-f %.250s ", outfile);
+
+	/* static zones could be signed by the built-in signer */
+	if ( !dynamic_zone && noexec == 0 && zsign_supported (zp) )
+	{
+		zsign_stats_t	stats;
+		time_t	refresh;
+		int	ret;
+
+		/* reused signatures should not trigger the next re-signing too early */
+		refresh = 0L;
+		if ( conf->sig_incremental && !force )
+			refresh = time (NULL) + resign_lead (conf) + resign_offset (zp) + ZSIGN_REFRESH;
+
+		verbmesg (2, conf, "\t  Run built-in signer (%s%s)\n", saltp ? "NSEC3": "NSEC", refresh ? ", incremental": "");
+		if ( (ret = zsign (zp, saltp, refresh, outfile, &stats)) == ZS_OK )
+		{
+			verbmesg (1, conf, "\tBuilt-in signer: %ld rrsets signed by %d key(s) with %ld signatures (%d thread(s))\n",
+						stats.rrsets, stats.keys, stats.sigs, stats.threads);
+			if ( refresh )
+				verbmesg (1, conf, "\tBuilt-in signer: %ld signatures reused\n", stats.reused);
+			verbmesg (2, conf, "\t  %ld records written (%ld NSEC%s)\n", stats.rr, stats.nsec, saltp ? "3": "");
+			lg_mesg (LG_DEBUG, "\"%s\": built-in signer: %ld rrsets, %ld signatures, %ld reused, %d threads",
+						domain, stats.rrsets, stats.sigs, stats.reused, stats.threads);
+			return 0;
+		}
+		if ( ret != ZS_UNSUPPORTED )
+		{
+			lg_mesg (LG_ERROR, "\"%s\": built-in signer: %s", domain, zsign_geterrstr ());
+			verbmesg (1, conf, "\tBuilt-in signer: %s\n", zsign_geterrstr ());
+			return -1;
+		}
+		lg_mesg (LG_NOTICE, "\"%s\": built-in signer: %s (use dnssec-signzone)", domain, zsign_geterrstr ());
+		verbmesg (1, conf, "\tBuilt-in signer: %s (use dnssec-signzone)\n", zsign_geterrstr ());
 	}
 
 	dbg_line();
@@ -939,6 +1938,10 @@ static	int	sign_zone (const zone_t *zp)
 	if ( conf->sig_random && conf->sig_random[0] )
 		snprintf (rparam, sizeof (rparam), "-r %.250s ", conf->sig_random);
 
+	jparam[0] = '\0';
+	if ( conf->resign_jitter > 0 )
+		snprintf (jparam, sizeof (jparam), "-j %ld ", conf->resign_jitter);
+
 	dbg_line();
 	keysetdir[0] = '\0';
 	if ( conf->keysetdir && conf->keysetdir[0] && strcmp (conf->keysetdir, "..") != 0 )
@@ -949,11 +1952,11 @@ static	int	sign_zone (const zone_t *zp)
 
 	dbg_line();
 	if ( dynamic_zone )
-		snprintf (cmd, sizeof (cmd), "cd %s; %s %s %s%s%s%s%s%s-o %s -e +%ld %s -N increment -f %s.dsigned %s K*.private 2>&1",
-			dir, SIGNCMD, param, nsec3param, dnskeyksk, gends, pseudo, rparam, keysetdir, domain, conf->sigvalidity, str, file, file);
+		snprintf (cmd, sizeof (cmd), "cd %s; %s %s %s%s%s%s%s%s%s-o %s -e +%ld %s -N increment -f %s.dsigned %s K*.private 2>&1",
+			dir, SIGNCMD, param, nsec3param, dnskeyksk, gends, pseudo, rparam, jparam, keysetdir, domain, conf->sigvalidity, str, file, file);
 	else
-		snprintf (cmd, sizeof (cmd), "cd %s; %s %s %s%s%s%s%s%s-o %s -e +%ld %s %s K*.private 2>&1",
-			dir, SIGNCMD, param, nsec3param, dnskeyksk, gends, pseudo, rparam, keysetdir, domain, conf->sigvalidity, str, file);
+		snprintf (cmd, sizeof (cmd), "cd %s; %s %s %s%s%s%s%s%s%s%s-o %s -e +%ld %s %s K*.private 2>&1",
+			dir, SIGNCMD, param, nsec3param, dnskeyksk, gends, pseudo, rparam, jparam, keysetdir, fparam, domain, conf->sigvalidity, str, file);
 	verbmesg (2, conf, "\t  Run cmd \"%s\"\n", cmd);
 	*str = '\0';
 	if ( noexec == 0 )
@@ -970,11 +1973,15 @@ static	int	sign_zone (const zone_t *zp)
 
 		exitcode = pclose (fp);
 		verbmesg (2, conf, "\t  Cmd dnssec-signzone returns with exitcode=%d: \"%s\"\n", exitcode, str_chop (str, '\n'));
+		lg_event (LG_DEBUG, "signzone", "zone=%s exitcode=%d", "\"%s\": dnssec-signzone returns with exitcode %d",
+				domain, WIFEXITED (exitcode) ? WEXITSTATUS (exitcode) : -1);
 	}
 
 	dbg_line();
-	len = strlen (str) - 6;
-	if ( len < 0 || strcmp (str+len, "signed") != 0 )
+	if ( outfile == NULL )		/* last line is the name of the output file */
+		outfile = "signed";
+	len = strlen (str) - strlen (outfile);
+	if ( len < 0 || strcmp (str+len, outfile) != 0 )
 		return -1;
 
 	return 0;
@@ -1007,5 +2014,16 @@ static	void	copy_keyset (const char *dir, const char *domain, const zconf_t *con
 					domain, fromfile, ret, strerror(errno));
 			}
 		}
+
+		/* propagate the in-process generated "dsset"-file too */
+		snprintf (fromfile, sizeof (fromfile), "%s/" DSSET_FILE_PFX "%s", dir, domain);
+		snprintf (tofile, sizeof (tofile), "%s/../" DSSET_FILE_PFX "%s", dir, domain);
+		if ( fileexist (fromfile) && cmpfile (fromfile, tofile) != 0 )
+		{
+			verbmesg (2, conf, "\t  copy \"%s\" to parent dir\n", fromfile);
+			if ( (ret = copyfile (fromfile, tofile, NULL)) != 0 )
+				lg_mesg (LG_ERROR, "\"%s\": can't copy \"%s\" to parent dir (%d:%s)",
+					domain, fromfile, ret, strerror(errno));
+		}
 	}
 }
@@ -66,6 +66,9 @@ extern	int	ljustflag;
 
 static	void	printkeyinfo (const dki_t *dkp, const char *oldpath);
 
+static	int	ds_digests;		/* digest types of zkt_list_dsrecords () */
+static	const	char	*ds_rrtype;	/* "DS", "CDS" or NULL for CDNSKEY */
+
 static	void	printkeyinfo (const dki_t *dkp, const char *oldpath)
 {
 	time_t	currtime;
@@ -378,6 +381,75 @@ void	zkt_list_dnskeys (const dki_t *data)
 #endif
 }
 
+/*****************************************************************
+**	prt_delegation ()
+**	print the DS, CDS or CDNSKEY record of a (not revoked) ksk
+*****************************************************************/
+static	void	prt_delegation (const dki_t *dkp)
+{
+	if ( !dki_isksk (dkp) || dki_isrevoked (dkp) )
+		return;
+	if ( labellist && !isinlist (dkp->name, labellist) )
+		return;
+
+	if ( headerflag )
+		dki_prt_comment (dkp, stdout);
+	if ( ds_rrtype == NULL )
+		dki_prt_cdnskey (dkp, stdout, 0);
+	else if ( dki_prt_ds (dkp, stdout, 0, ds_digests, ds_rrtype) < 0 )
+		fprintf (stderr, "%s\n", dki_geterrstr ());
+}
+
+#if defined(USE_TREE) && USE_TREE
+static	void	list_delegation (const dki_t **nodep, const VISIT which, int depth)
+{
+	const	dki_t	*dkp;
+
+	if ( nodep == NULL )
+		return;
+
+	if ( which == INORDER || which == LEAF )
+		for ( dkp = *nodep; dkp; dkp = dkp->next )
+			prt_delegation (dkp);
+}
+#endif
+
+/*****************************************************************
+**	zkt_list_dsrecords ()
+**	print the DS (or CDS if rrtype is "CDS") records of all
+**	key signing keys for all digest types in 'digests'
+*****************************************************************/
+void	zkt_list_dsrecords (const dki_t *data, int digests, const char *rrtype)
+{
+	ds_digests = digests;
+	ds_rrtype = rrtype ? rrtype: "DS";
+#if defined(USE_TREE) && USE_TREE
+	twalk (data, list_delegation);
+#else
+	const	dki_t	*dkp;
+
+	for ( dkp = data; dkp; dkp = dkp->next )
+		prt_delegation (dkp);
+#endif
+}
+
+/*****************************************************************
+**	zkt_list_cdnskeys ()
+**	print the CDNSKEY records of all key signing keys
+*****************************************************************/
+void	zkt_list_cdnskeys (const dki_t *data)
+{
+	ds_rrtype = NULL;
+#if defined(USE_TREE) && USE_TREE
+	twalk (data, list_delegation);
+#else
+	const	dki_t	*dkp;
+
+	for ( dkp = data; dkp; dkp = dkp->next )
+		prt_delegation (dkp);
+#endif
+}
+
 #if defined(USE_TREE) && USE_TREE
 static	void	set_keylifetime (const dki_t **nodep, const VISIT which, int depth)
 {
@@ -42,6 +42,8 @@ extern	void	zkt_list_keys (const dki_t *data);
 extern	void	zkt_list_trustedkeys (const dki_t *data);
 extern	void	zkt_list_managedkeys (const dki_t *data);
 extern	void	zkt_list_dnskeys (const dki_t *data);
+extern	void	zkt_list_dsrecords (const dki_t *data, int digests, const char *rrtype);
+extern	void	zkt_list_cdnskeys (const dki_t *data);
 extern	void	zkt_setkeylifetime (dki_t *data);
 
 #endif
@@ -37,9 +37,12 @@
 # include <stdio.h>
 # include <string.h>
 # include <stdlib.h>
+# include <ctype.h>
 # include <sys/types.h>
 # include <sys/stat.h>
 # include <dirent.h>
+# include <unistd.h>
+# include <time.h>
 # include <assert.h>
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -59,6 +62,77 @@
 *****************************************************************/
 static	char	zone_estr[255+1];
 
+/* set of the zones given on the command line and their parent zones */
+# define	ZF_PARENT	1
+# define	ZF_REQUESTED	2
+typedef	struct	{
+	const	char	*name;
+	int	flag;
+} zfentry_t;
+static	zfentry_t	*zfilter = NULL;	/* NULL: all zones are requested */
+static	unsigned	zfsize = 0;		/* power of 2 */
+
+static	unsigned	zfhash (const char *s)
+{
+	unsigned	h = 2166136261u;	/* FNV-1a */
+
+	while ( *s )
+		h = (h ^ (unsigned char)*s++) * 16777619u;
+	return h;
+}
+
+/*****************************************************************
+**	zfentry (name)
+**	returns the entry of name in the filter set, or the empty
+**	entry where it has to be added
+*****************************************************************/
+static	zfentry_t	*zfentry (const char *name)
+{
+	unsigned	i;
+
+	i = zfhash (name) & (zfsize - 1);
+	while ( zfilter[i].name && strcmp (zfilter[i].name, name) != 0 )
+		i = (i + 1) & (zfsize - 1);
+	return &zfilter[i];
+}
+
+static	void	zfadd (const char *name, int flag)
+{
+	zfentry_t	*e;
+
+	if ( *name == '\0' )
+		return;
+	e = zfentry (name);
+	e->name = name;
+	if ( flag > e->flag )
+		e->flag = flag;
+}
+
+/*****************************************************************
+**	zone_wanted (zone)
+**	check if the zone (given in any case, with or without the
+**	trailing dot) is of interest for the current run
+*****************************************************************/
+static	int	zone_wanted (const char *zone)
+{
+	char	name[MAX_DNAMESIZE+1+1];
+	size_t	len;
+	size_t	i;
+
+	if ( zfilter == NULL )
+		return 1;
+
+	if ( (len = strlen (zone)) >= sizeof (name) - 1 )
+		return 1;
+	for ( i = 0; i < len; i++ )
+		name[i] = tolower ((unsigned char)zone[i]);
+	if ( len == 0 || name[len-1] != '.' )
+		name[len++] = '.';
+	name[len] = '\0';
+
+	return zfentry (name)->flag != 0;
+}
+
 /*****************************************************************
 **	zone_alloc ()
 *****************************************************************/
@@ -104,10 +178,8 @@ void	zone_free (zone_t *zp)
 	if ( zp->dir ) free ((char *)zp->dir);
 	if ( zp->file ) free ((char *)zp->file);
 	if ( zp->sfile ) free ((char *)zp->sfile);
-#if 0
-	/* TODO: actually there are some problems freeing the config :-( */
-	if ( zp->conf ) free ((zconf_t *)zp->conf);
-#endif
+	if ( zp->salt ) free (zp->salt);
+	releaseconfig (zp->conf);	/* does nothing if it is not a local config */
 	if ( zp->keys ) dki_freelist (&zp->keys);
 	free (zp);
 }
@@ -133,9 +205,65 @@ void	zone_freelist (zone_t **listp)
 		*listp = NULL;
 }
 
+/*****************************************************************
+**	zone_setfilter (zones, cnt)
+**	restrict the discovery of zone_readdir() and zone_scandir() to
+**	the zones given (exactly as the canonical name with trailing
+**	dot, like in_strarr() does) and to their parent zones.
+**	cnt == 0 means all zones.
+**	The strings of zones[] have to be kept by the caller.
+*****************************************************************/
+int	zone_setfilter (char *const zones[], int cnt)
+{
+	const	char	*parent;
+	int	i;
+
+	if ( zfilter )
+	{
+		free (zfilter);
+		zfilter = NULL;
+	}
+	if ( zones == NULL || cnt <= 0 )
+		return 1;
+
+	for ( zfsize = 16; zfsize < 4 * (unsigned)cnt; zfsize *= 2 )
+		;
+	if ( (zfilter = calloc (zfsize, sizeof (zfentry_t))) == NULL )
+	{
+		snprintf (zone_estr, sizeof (zone_estr), "zone_setfilter: Out of memory");
+		return 0;
+	}
+
+	for ( i = 0; i < cnt; i++ )
+	{
+		zfadd (zones[i], ZF_REQUESTED);
+		/* the parent zone is looked up by is_parentdirsigned() */
+		if ( (parent = strchr (zones[i], '.')) != NULL )
+			zfadd (parent + 1, ZF_PARENT);
+	}
+
+	return 1;
+}
+
+/*****************************************************************
+**	zone_requested (zone)
+**	returns 1 if the canonical zone name is one of the zones given
+**	to zone_setfilter() (or no filter is set), 0 otherwise
+*****************************************************************/
+int	zone_requested (const char *zone)
+{
+	if ( zfilter == NULL )
+		return 1;
+	if ( zone == NULL || *zone == '\0' )
+		return 0;
+
+	return zfentry (zone)->flag == ZF_REQUESTED;
+}
+
 /*****************************************************************
 **	zone_new ()
-**	allocate memory for new zone structure and initialize it
+**	allocate memory for new zone structure and initialize it;
+**	the keys are read in later by zone_loadkeys()
 *****************************************************************/
 zone_t	*zone_new (zone_t **zp, const char *zone, const char *dir, const char *file, const char *signed_ext, const zconf_t *cp)
 {
@@ -182,11 +310,39 @@ zone_t	*zone_new (zone_t **zp, const char *zone, const char *dir, const char *fi
 		}
 		new->conf = cp;
 		new->keys = NULL;
-		dki_readdir (new->dir, &new->keys, 0);
-		new->next = NULL;
+		new->keysloaded = 0;
+		new->next = *zp;	/* prepend; zone_sortlist() brings the list in order */
+		*zp = new;
 	}
 	
-	return zone_add (zp, new);
+	return new;
+}
+
+/*****************************************************************
+**	zone_loadkeys (zp)
+**	read in the keys of the zone if not already done
+*****************************************************************/
+int	zone_loadkeys (zone_t *zp)
+{
+	assert (zp != NULL);
+
+	if ( zp->keysloaded )
+		return 1;
+	zp->keysloaded = 1;
+	return dki_readdir (zp->dir, &zp->keys, 0);
+}
+
+/*****************************************************************
+**	zone_freekeys (zp)
+**	free the keys of the zone after it is processed
+*****************************************************************/
+void	zone_freekeys (zone_t *zp)
+{
+	assert (zp != NULL);
+
+	if ( zp->keys )
+		dki_freelist (&zp->keys);
+	zp->keysloaded = 0;
 }
 
 /*****************************************************************
@@ -197,7 +353,7 @@ int	zone_readdir (const char *dir, const char *zone, const char *zfile, zone_t *
 	char	*p;
 	char	path[MAX_PATHSIZE+1];
 	char	*signed_ext = ".signed";
-	zconf_t	*localconf = NULL;
+	const	zconf_t	*localconf = NULL;
 
 	assert (dir != NULL && *dir != '\0');
 	assert (conf != NULL);
@@ -211,6 +367,8 @@ int	zone_readdir (const char *dir, const char *zone, const char *zfile, zone_t *
 	}
 	if ( zone == NULL )	/* zone name still null ? */
 		return 0;
+	if ( !zone_wanted (zone) )	/* not given on the command line ? */
+		return 0;
 
 	dbg_val4 ("zone_readdir: (dir: \"%s\", zone: \"%s\", zfile: \"%s\", zp, cp, dyn_zone = %d)\n",
 					dir, zone, zfile ? zfile: "NULL", dyn_zone);
@@ -230,9 +388,9 @@ int	zone_readdir (const char *dir, const char *zone, const char *zfile, zone_t *
 	dbg_val1 ("zone_readdir: check local config file %s\n", path);
 	if ( fileexist (path) )			/* load local config file */
 	{
-		localconf = dupconfig (conf);
-		conf = loadconfig (path, localconf);
-		/* do not free localconf, because a ptr to it will be added to the zone by zone_new() */
+		/* zones with the same local config share it; it is released by zone_free() */
+		localconf = loadconfig_shared (path, conf);
+		conf = localconf;
 	}
 
 	if ( zfile == NULL )
@@ -253,16 +411,72 @@ int	zone_readdir (const char *dir, const char *zone, const char *zfile, zone_t *
 	if ( !fileexist (path) )	/* no .signed file found ? ... */
 	{
 		dbg_val0("no!\n");
+		releaseconfig (localconf);
 		return 0;		/* ... not a secure zone ! */
 	}
 	dbg_val0("yes!\n");
 
 	dbg_val("zone_readdir: add zone (%s)\n", zone);
-	zone_new (listp, zone, dir, zfile, signed_ext, conf);
+	if ( zone_new (listp, zone, dir, zfile, signed_ext, conf) == NULL )
+	{
+		releaseconfig (localconf);
+		return 0;
+	}
 
 	return 1;
 }
 
+/*****************************************************************
+**	zone_scandir (dir, conf, dyn_zone)
+**	the part of zone_readdir (dir, NULL, NULL, ...) which does
+**	not depend on other zones: check if dir may hold a signed zone.
+**	As opposed to zone_readdir() it could be called in parallel
+**	for different directories (it does not load a local config).
+**	returns the result to be handed over to zone_readscan()
+*****************************************************************/
+zonescan_t	*zone_scandir (const char *dir, const zconf_t *conf, int dyn_zone)
+{
+	char	path[MAX_PATHSIZE+1];
+	const	char	*p;
+	zonescan_t	*sp;
+
+	assert (dir != NULL && *dir != '\0');
+	assert (conf != NULL);
+
+	if ( (sp = calloc (1, sizeof (zonescan_t))) == NULL )
+		return NULL;
+	if ( !zone_wanted ((p = strrchr (dir, '/')) ? p + 1: dir) )
+		return sp;	/* nothing to check */
+
+	pathname (path, sizeof (path), dir, LOCALCONF_FILE, NULL);
+	sp->localconf = fileexist (path);
+	pathname (path, sizeof (path), dir, conf->zonefile, dyn_zone ? ".dsigned": ".signed");
+	sp->issigned = fileexist (path);
+
+	return sp;
+}
+
+/*****************************************************************
+**	zone_readscan (dir, sp, listp, conf, dyn_zone)
+**	same as zone_readdir (dir, NULL, NULL, listp, conf, dyn_zone),
+**	but skip the directory if zone_scandir() found nothing of interest;
+**	free the scan result
+*****************************************************************/
+int	zone_readscan (const char *dir, zonescan_t *sp, zone_t **listp, const zconf_t *conf, int dyn_zone)
+{
+	int	ret;
+
+	if ( sp == NULL )	/* out of memory in zone_scandir() ? */
+		return zone_readdir (dir, NULL, NULL, listp, conf, dyn_zone);
+
+	ret = 0;
+	if ( sp->localconf || sp->issigned )	/* a local config may change the zone file name */
+		ret = zone_readdir (dir, NULL, NULL, listp, conf, dyn_zone);
+	free (sp);
+
+	return ret;
+}
+
 
 /*****************************************************************
 **	zone_geterrstr ()
@@ -302,6 +516,51 @@ zone_t	*zone_add (zone_t **list, zone_t *new)
 	return new;
 }
 
+/*****************************************************************
+**	zone_sortlist ()
+**	sort the zone list in domaincmp() order. The names are
+**	converted once into sort keys which are radix sorted, so this
+**	is much faster than building the list with zone_add().
+*****************************************************************/
+void	zone_sortlist (zone_t **listp)
+{
+	domsort_t	s;
+	zone_t	*zp;
+	zone_t	*list;
+	size_t	i;
+
+	assert (listp != NULL);
+	if ( *listp == NULL )
+		return;
+	memset (&s, 0, sizeof (s));
+
+	for ( zp = *listp; zp; zp = zp->next )
+		if ( domsort_add (&s, zp->zone, 1, NULL, 0, zp) < 0 )
+			break;
+
+	if ( zp == NULL )	/* all keys added ? */
+	{
+		domsort_sort (&s);
+		for ( i = s.n; i > 0; i-- )
+		{
+			zp = s.v[i-1].data;
+			zp->next = i < s.n ? s.v[i].data : NULL;
+		}
+		*listp = s.v[0].data;
+	}
+	else			/* out of memory: sort by insertion */
+	{
+		list = *listp;
+		*listp = NULL;
+		while ( (zp = list) != NULL )
+		{
+			list = zp->next;
+			zone_add (listp, zp);
+		}
+	}
+	domsort_free (&s);
+}
+
 /*****************************************************************
 **	zone_search ()
 *****************************************************************/
@@ -316,6 +575,159 @@ const zone_t	*zone_search (const zone_t *list, const char *zone)
 	return list;
 }
 
+/*****************************************************************
+**	zone_nsformat ()
+**	return the format of the signed zone file loaded by the name
+**	server ("raw" or "map") or NULL for the text format. Dynamic
+**	zones (".dsigned") are always kept in text format.
+*****************************************************************/
+const	char	*zone_nsformat (const zone_t *zp)
+{
+	const	char	*fmt;
+	const	char	*ext;
+
+	assert (zp != NULL);
+	fmt = zp->conf->signed_format;
+	if ( fmt == NULL || *fmt == '\0' || strcasecmp (fmt, "text") == 0 )
+		return NULL;
+	if ( (ext = strrchr (zp->sfile, '.')) != NULL && strcmp (ext, ".dsigned") == 0 )
+		return NULL;
+
+	/* checkconfig() accepts any case, but the file extension is lower case */
+	if ( strcasecmp (fmt, "raw") == 0 )
+		return "raw";
+	if ( strcasecmp (fmt, "map") == 0 )
+		return "map";
+	return fmt;
+}
+
+/*****************************************************************
+**	zone_nsfile ()
+**	path of the signed zone file loaded by the name server: the
+**	signed file itself or the file compiled into SignedFormat
+**	("zone.db.signed.raw" or "zone.db.signed.map")
+*****************************************************************/
+char	*zone_nsfile (const zone_t *zp, char *path, size_t size)
+{
+	char	ext[15+1];
+	const	char	*fmt;
+
+	assert (zp != NULL);
+	if ( (fmt = zone_nsformat (zp)) == NULL )
+		return pathname (path, size, zp->dir, zp->sfile, NULL);
+
+	snprintf (ext, sizeof (ext), ".%s", fmt);
+	return pathname (path, size, zp->dir, zp->sfile, ext);
+}
+
+/*****************************************************************
+**	zone_readstate ()
+**	read the state file of the zone (if any) and set the
+**	corresponding values of zp
+**	return 1 if a state file was read, 0 if no state file
+**	exists and -1 on error
+*****************************************************************/
+int	zone_readstate (zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	buf[1023+1];
+	char	name[63+1];
+	char	str[510+1];
+	long	val;
+	FILE	*fp;
+
+	assert (zp != NULL);
+
+	pathname (path, sizeof (path), zp->dir, ZONESTATE_FILE, NULL);
+	if ( !fileexist (path) )
+		return 0;
+
+	if ( (fp = fopen (path, "r")) == NULL )
+	{
+		snprintf (zone_estr, sizeof (zone_estr),
+			"zone_readstate: couldn't open state file %s", ZONESTATE_FILE);
+		return -1;
+	}
+
+	while ( fgets (buf, sizeof (buf), fp) )
+	{
+		if ( buf[0] == ';' || buf[0] == '#' )
+			continue;
+		if ( sscanf (buf, "%63s %510s", name, str) != 2 )
+			continue;
+		val = strtol (str, NULL, 10);
+
+		if ( strcmp (name, "sig_mtime") == 0 )
+			zp->sig_mtime = (time_t)val;
+		else if ( strcmp (name, "sig_size") == 0 )
+			zp->sig_size = val;
+		else if ( strcmp (name, "sig_expire") == 0 )
+			zp->sig_expire = (time_t)val;
+		else if ( strcmp (name, "sig_inception") == 0 )
+			zp->sig_inception = (time_t)val;
+		else if ( strcmp (name, "salt") == 0 )
+		{
+			if ( zp->salt )
+				free (zp->salt);
+			zp->salt = strdup (str);
+		}
+		else if ( strcmp (name, "salt_time") == 0 )
+			zp->salt_time = (time_t)val;
+		else if ( strcmp (name, "verify_failed") == 0 )
+			zp->verify_failed = (int)val;
+	}
+	fclose (fp);
+
+	return 1;
+}
+
+/*****************************************************************
+**	zone_writestate ()
+**	write the state values of zp to the state file of the zone
+**	return 1 on success and -1 on error
+*****************************************************************/
+int	zone_writestate (const zone_t *zp)
+{
+	char	path[MAX_PATHSIZE+1];
+	char	tmppath[MAX_PATHSIZE+1];
+	FILE	*fp;
+
+	assert (zp != NULL);
+
+	pathname (path, sizeof (path), zp->dir, ZONESTATE_FILE, NULL);
+	pathname (tmppath, sizeof (tmppath), zp->dir, ZONESTATE_FILE, ".tmp");
+	if ( (fp = fopen (tmppath, "w")) == NULL )
+	{
+		snprintf (zone_estr, sizeof (zone_estr),
+			"zone_writestate: couldn't create state file %s.tmp", ZONESTATE_FILE);
+		return -1;
+	}
+
+	fprintf (fp, "; ZKT state of zone %s (do not edit)\n", zp->zone);
+	fprintf (fp, "sig_mtime\t%ld\n", (long)zp->sig_mtime);
+	fprintf (fp, "sig_size\t%ld\n", zp->sig_size);
+	fprintf (fp, "sig_expire\t%ld\t; %s\n", (long)zp->sig_expire, time2isostr (zp->sig_expire, 's'));
+	fprintf (fp, "sig_inception\t%ld\t; %s\n", (long)zp->sig_inception, time2isostr (zp->sig_inception, 's'));
+	if ( zp->salt )
+	{
+		fprintf (fp, "salt\t%s\n", zp->salt);
+		fprintf (fp, "salt_time\t%ld\t; %s\n", (long)zp->salt_time, time2isostr (zp->salt_time, 's'));
+	}
+	if ( zp->verify_failed )
+		fprintf (fp, "verify_failed\t%d\n", zp->verify_failed);
+	fclose (fp);
+
+	if ( rename (tmppath, path) < 0 )	/* replace the state file atomically */
+	{
+		snprintf (zone_estr, sizeof (zone_estr),
+			"zone_writestate: couldn't rename state file %s.tmp", ZONESTATE_FILE);
+		unlink (tmppath);
+		return -1;
+	}
+
+	return 1;
+}
+
 /*****************************************************************
 **	zone_print ()
 *****************************************************************/
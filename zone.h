@@ -45,17 +45,42 @@ typedef	struct	Zone {
 	const	char	*sfile;	/* file name of secured zone (zone.db.signed)  */
 	const	zconf_t	*conf;	/* ptr to config */	/* TODO: Should this be only a ptr to a local config ? */
 		dki_t	*keys;	/* ptr to keylist */
+	int	keysloaded;	/* keys are read in by zone_loadkeys() */
+	time_t	sig_mtime;	/* mtime of signed file at the time of the last RRSIG scan */
+	long	sig_size;	/* size of signed file at the time of the last RRSIG scan */
+	time_t	sig_expire;	/* earliest RRSIG expiration time found in signed file */
+	time_t	sig_inception;	/* latest RRSIG inception time found in signed file */
+	char	*salt;		/* current NSEC3 salt of a static zone */
+	time_t	salt_time;	/* time the salt was generated */
+	int	verify_failed;	/* last verification of the signed zone failed */
 	struct	Zone	*next;		/* ptr to next entry in list */
 } zone_t;
 
+/* result of zone_scandir() */
+typedef	struct	zonescan {
+	int	localconf;	/* local config file found */
+	int	issigned;	/* signed zone file found */
+} zonescan_t;
+
 extern	void	zone_free (zone_t *zp);
 extern	void	zone_freelist (zone_t **listp);
+extern	int	zone_setfilter (char *const zones[], int cnt);
+extern	int	zone_requested (const char *zone);
+extern	int	zone_loadkeys (zone_t *zp);
+extern	void	zone_freekeys (zone_t *zp);
 extern	zone_t	*zone_new (zone_t **zp, const char *zone, const char *dir, const char *file, const char *signed_ext, const zconf_t *cp);
 extern	const	char	*zone_geterrstr ();
 extern	zone_t	*zone_add (zone_t **list, zone_t *new);
+extern	void	zone_sortlist (zone_t **listp);
 extern	const zone_t	*zone_search (const zone_t *list, const char *name);
 extern	int	zone_readdir (const char *dir, const char *zone, const char *zfile, zone_t **listp, const zconf_t *conf, int dyn_zone);
+extern	zonescan_t	*zone_scandir (const char *dir, const zconf_t *conf, int dyn_zone);
+extern	int	zone_readscan (const char *dir, zonescan_t *sp, zone_t **listp, const zconf_t *conf, int dyn_zone);
 extern	const	char	*zone_geterrstr (void);
 extern	int	zone_print (const char *mesg, const zone_t *z);
+extern	const	char	*zone_nsformat (const zone_t *zp);
+extern	char	*zone_nsfile (const zone_t *zp, char *path, size_t size);
+extern	int	zone_readstate (zone_t *zp);
+extern	int	zone_writestate (const zone_t *zp);
 
 #endif
@@ -0,0 +1,2415 @@
+/*****************************************************************
+**
+**	@(#) zsign.c -- built-in zone signer
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <unistd.h>
+# include <errno.h>
+# include <ctype.h>
+# include <stdarg.h>
+# include <time.h>
+# include <sys/types.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+# include "config_zkt.h"
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+# include <pthread.h>
+#endif
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+# include <openssl/evp.h>
+# include <openssl/bn.h>
+# include <openssl/ec.h>
+# include <openssl/core_names.h>
+# include <openssl/param_build.h>
+# include <openssl/err.h>
+#endif
+# include "debug.h"
+# include "misc.h"
+# include "log.h"
+# include "zconf.h"
+# include "dki.h"
+# include "zone.h"
+# include "keygen.h"
+# include "zstore.h"
+#define	extern
+# include "zsign.h"
+#undef	extern
+
+/*****************************************************************
+**	The built-in signer is an alternative to dnssec-signzone for
+**	static zones. It reads the zone file into a zone store, adds
+**	the DS records of the child zones (dsset- files), builds the
+**	NSEC or NSEC3 chain and signs all authoritative rrsets with
+**	the active keys of the zone. The signatures are created by a
+**	pool of threads, each with its own libcrypto context and
+**	memory. The rrsets are split into shards, contiguous ranges
+**	of names in canonical order. A thread signs a shard and prints
+**	it into a buffer, and the finished shards are written in order
+**	to a temporary file which is renamed to the signed zone file
+**	(or the given output file) at the end, so the result is the
+**	same as of a single pass. At most ZSIGN_WINDOW shards per
+**	thread are waiting for the output. The unsigned zone (and the
+**	previous signed zone on incremental signing) is still held
+**	completely in memory.
+**	On incremental signing the signatures of unchanged rrsets are
+**	taken from the previous signed zone as long as they are valid
+**	beyond the refresh time.
+**
+**	Zones which could not be handled (unsupported record types,
+**	key algorithms or zone file directives) are rejected with
+**	ZS_UNSUPPORTED, so the caller could use dnssec-signzone.
+*****************************************************************/
+# define	ZSIGN_SHARD	1024	/* number of rrsets signed at once by a thread */
+# define	ZSIGN_WINDOW	4	/* max number of unwritten shards per thread */
+# define	HASHLEN		20	/* length of a SHA-1 NSEC3 hash */
+# define	ZSIGN_MAXERR	10	/* max number of logged verification errors */
+
+static	char	zsign_estr[255+1];
+
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+typedef	struct	{
+	EVP_PKEY	*pkey;
+	const	EVP_MD	*md;	/* NULL for EdDSA */
+	uint	tag;
+	int	algo;
+	int	flags;
+	int	siglen;		/* length of a signature in wire format */
+} zskey_t;
+
+# define	N_AUTH	0	/* authoritative data */
+# define	N_DELEG	1	/* delegation point */
+# define	N_GLUE	2	/* glue or occluded data */
+typedef	struct	{
+	long	first;		/* index of the first record of the name */
+	long	end;
+	int	kind;
+	int	ds;		/* delegation point with DS rrset */
+} node_t;
+
+typedef	struct	{
+	long	first;		/* index of the first record of the rrset */
+	int	count;
+	ulong	keys;		/* bitmask of the signing keys */
+	int	nsig;
+	uchar	*sig;		/* RRSIG rdata, each prefixed by its length */
+	long	rrsig;		/* index of the first RRSIG of the rrset (verification) */
+} job_t;
+
+typedef	struct	{
+	long	job;		/* index of the first job */
+	long	jend;
+	long	first;		/* index of the first record */
+	long	end;
+	char	*buf;		/* signed records of the shard */
+	size_t	len;
+	long	nrr;		/* number of records in buf */
+	int	done;
+} shard_t;
+
+typedef	struct	{
+	zstore_t	*zs;
+	zskey_t	key[ZSIGN_MAXKEYS];
+	int	nkeys;
+	job_t	*job;
+	long	njobs;
+	shard_t	*shard;
+	long	nshards;
+	long	next;		/* next shard to process */
+	long	written;	/* number of shards written to out */
+	long	window;		/* max number of taken but unwritten shards */
+	long	nout;		/* number of records written to out */
+	FILE	*out;
+	ulong	inception;
+	ulong	expiration;
+	long	jitter;
+	int	error;
+	/* verification */
+	const	char	*zone;
+	const	rr_t	*rrsig;	/* RRSIG records of the signed zone */
+	ulong	now;
+	ulong	minexpire;
+	uchar	alg[ZSIGN_MAXKEYS];	/* algorithms which have to sign each rrset */
+	int	nalg;
+	int	haveksk;
+	long	nerr;
+	char	errmsg[255+1];
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	pthread_mutex_t	lock;
+	pthread_cond_t	flushed;	/* signaled if shards are written */
+#endif
+} zsctx_t;
+
+typedef	struct	{
+	zsctx_t	*ctx;
+	zstore_t	*mem;	/* memory of the signatures */
+	EVP_MD_CTX	*mdctx;
+	EVP_MD_CTX	*keyctx[ZSIGN_MAXKEYS];	/* initialized context of each key */
+	uchar	*buf;		/* data to be signed */
+	size_t	size;
+	long	sigs;
+} zsworker_t;
+
+typedef	struct	{
+	uchar	hash[HASHLEN];
+	const	uchar	*wire;
+	long	node;		/* -1 for empty non-terminals */
+} hashed_t;
+
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+# define	ctx_lock(c)	pthread_mutex_lock (&(c)->lock)
+# define	ctx_unlock(c)	pthread_mutex_unlock (&(c)->lock)
+# define	ctx_wait(c)	pthread_cond_wait (&(c)->flushed, &(c)->lock)
+# define	ctx_signal(c)	pthread_cond_broadcast (&(c)->flushed)
+#else
+# define	ctx_lock(c)
+# define	ctx_unlock(c)
+# define	ctx_wait(c)
+# define	ctx_signal(c)
+#endif
+
+/*****************************************************************
+**	private (static) function definition
+*****************************************************************/
+
+/*****************************************************************
+**	sslerror (func)
+**	set the error string to the last libcrypto error
+*****************************************************************/
+static	int	sslerror (const char *func)
+{
+	char	buf[127+1];
+
+	ERR_error_string_n (ERR_get_error (), buf, sizeof (buf));
+	snprintf (zsign_estr, sizeof (zsign_estr), "%s: %s", func, buf);
+	ERR_clear_error ();
+
+	return ZS_ERROR;
+}
+
+/*****************************************************************
+**	keytag (rdata, len)
+**	compute the key tag of the DNSKEY rdata (RFC 4034 Appendix B)
+*****************************************************************/
+static	uint	keytag (const uchar *rdata, size_t len)
+{
+	unsigned long	ac;
+	size_t	i;
+
+	ac = 0L;
+	for ( i = 0; i < len; i++ )
+		ac += (i & 1) ? rdata[i] : rdata[i] << 8;
+	ac += (ac >> 16) & 0xFFFF;
+
+	return ac & 0xFFFF;
+}
+
+/*****************************************************************
+**	setdigest (kp)
+**	set the message digest and signature length of the key
+**	returns 0 or ZS_UNSUPPORTED
+*****************************************************************/
+static	int	setdigest (zskey_t *kp)
+{
+	switch ( kp->algo )
+	{
+	case DK_ALGO_RSASHA1:
+	case DK_ALGO_NSEC3RSASHA1:	kp->md = EVP_sha1 ();	break;
+	case DK_ALGO_RSASHA256:		kp->md = EVP_sha256 ();	break;
+	case DK_ALGO_RSASHA512:		kp->md = EVP_sha512 ();	break;
+	case DK_ALGO_ECDSAP256SHA256:	kp->md = EVP_sha256 ();	kp->siglen = 2 * 32;	return 0;
+	case DK_ALGO_ECDSAP384SHA384:	kp->md = EVP_sha384 ();	kp->siglen = 2 * 48;	return 0;
+	case DK_ALGO_ED25519:		kp->md = NULL;		kp->siglen = 64;	return 0;
+	case DK_ALGO_ED448:		kp->md = NULL;		kp->siglen = 114;	return 0;
+	default:
+		snprintf (zsign_estr, sizeof (zsign_estr), "algorithm %s not supported", dki_algo2str (kp->algo));
+		return ZS_UNSUPPORTED;
+	}
+	kp->siglen = kp->pkey ? EVP_PKEY_get_size (kp->pkey): 0;
+	return 0;
+}
+
+/*****************************************************************
+**	dropsigs (zs)
+**	remove all DNSSEC records created by the signer
+*****************************************************************/
+static	void	dropsigs (zstore_t *zs)
+{
+	long	i;
+	long	n;
+
+	for ( i = n = 0; i < zs->nrr; i++ )
+		switch ( zs->rr[i].type )
+		{
+		case ZS_T_RRSIG:
+		case ZS_T_NSEC:
+		case ZS_T_NSEC3:
+		case ZS_T_NSEC3PARAM:
+			break;
+		default:
+			zs->rr[n++] = zs->rr[i];
+		}
+	zs->nrr = n;
+}
+
+/*****************************************************************
+**	classify (zs, pnodes)
+**	split the (sorted) zone store into names and check if a name
+**	is authoritative, a delegation point or glue/occluded data
+**	returns the number of names or -1 on error
+*****************************************************************/
+static	long	classify (const zstore_t *zs, node_t **pnodes)
+{
+	const	rr_t	*rr;
+	const	dname_t	*owner;
+	const	dname_t	*cut;
+	node_t	*nodes;
+	long	max;
+	long	n;
+	long	i;
+	long	j;
+
+	max = 0;
+	n = 0;
+	nodes = *pnodes;
+	cut = NULL;
+	rr = zs->rr;
+	for ( i = 0; i < zs->nrr; i = j )
+	{
+		owner = rr[i].owner;
+		if ( !zs_issubdomain (owner, zs->origin) )
+		{
+			char	name[1023+1];
+
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of zone data \"%.128s\"",
+								zs_dname2str (owner, name, sizeof (name)));
+			return -1;
+		}
+		if ( n >= max )
+		{
+			max = max ? max * 2: zs->nrr / 2 + 16;
+			if ( (nodes = realloc (nodes, max * sizeof (node_t))) == NULL )
+			{
+				snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+				return -1;
+			}
+			*pnodes = nodes;
+		}
+
+		nodes[n].first = i;
+		nodes[n].kind = N_AUTH;
+		nodes[n].ds = 0;
+		if ( cut && zs_issubdomain (owner, cut) )
+			nodes[n].kind = N_GLUE;
+		else
+			cut = NULL;
+		for ( j = i; j < zs->nrr && rr[j].owner == owner; j++ )
+		{
+			if ( nodes[n].kind == N_GLUE )
+				continue;
+			if ( rr[j].type == ZS_T_NS && owner != zs->origin )
+				nodes[n].kind = N_DELEG;
+			else if ( rr[j].type == ZS_T_DS )
+				nodes[n].ds = 1;
+			else if ( rr[j].type == ZS_T_DNAME )
+				cut = owner;
+		}
+		if ( nodes[n].kind == N_DELEG )
+			cut = owner;
+		nodes[n].end = j;
+		n++;
+	}
+
+	if ( n == 0 || rr[0].owner != zs->origin )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "no SOA record at the zone apex");
+		return -1;
+	}
+	return n;
+}
+
+/*****************************************************************
+**	findrr (zs, np, type)
+**	returns the index of the first record of the type or -1
+*****************************************************************/
+static	long	findrr (const zstore_t *zs, const node_t *np, int type)
+{
+	long	i;
+
+	for ( i = np->first; i < np->end; i++ )
+		if ( zs->rr[i].type == type )
+			return i;
+	return -1;
+}
+
+/*****************************************************************
+**	readdssets (zp, zs, nodes, n)
+**	replace the DS records of the delegations by the content
+**	of the corresponding dsset- file (if any)
+**	returns the number of replaced DS sets
+*****************************************************************/
+static	int	readdssets (const zone_t *zp, zstore_t *zs, const node_t *nodes, long n)
+{
+	char	dsdir[MAX_PATHSIZE+1];
+	char	fname[MAX_FNAMESIZE+1];
+	char	path[MAX_PATHSIZE+1];
+	char	child[1023+1];
+	const	zconf_t	*conf;
+	const	dname_t	*owner;
+	zstore_t	*ds;
+	long	i;
+	long	j;
+	int	cnt;
+
+	conf = zp->conf;
+	if ( conf->keysetdir && *conf->keysetdir && strcmp (conf->keysetdir, "..") != 0 )
+	{
+		if ( *conf->keysetdir == '/' )
+			snprintf (dsdir, sizeof (dsdir), "%s", conf->keysetdir);
+		else
+			pathname (dsdir, sizeof (dsdir), zp->dir, conf->keysetdir, NULL);
+	}
+	else
+		snprintf (dsdir, sizeof (dsdir), "%s", zp->dir);
+
+	cnt = 0;
+	for ( i = 0; i < n; i++ )
+	{
+		if ( nodes[i].kind != N_DELEG )
+			continue;
+		owner = zs->rr[nodes[i].first].owner;
+		zs_dname2str (owner, child, sizeof (child));
+		snprintf (fname, sizeof (fname), "dsset-%.255s", child);
+		if ( !fileexist (pathname (path, sizeof (path), dsdir, fname, NULL)) )
+			continue;
+
+		if ( (ds = zs_new (child)) == NULL )
+			continue;
+		ds->defttl = zs->rr[nodes[i].first].ttl;
+		if ( zs_readfile (ds, dsdir, fname) != ZS_OK )
+		{
+			lg_mesg (LG_WARNING, "\"%s\": %s", zp->zone, zs_geterrstr ());
+			zs_free (ds);
+			continue;
+		}
+
+		for ( j = nodes[i].first; j < nodes[i].end; j++ )	/* remove the old DS set */
+			if ( zs->rr[j].type == ZS_T_DS )
+				zs->rr[j].owner = NULL;
+		for ( j = 0; j < ds->nrr; j++ )
+			if ( ds->rr[j].type == ZS_T_DS && ds->rr[j].owner->len == owner->len &&
+			     memcmp (dname_wire (ds->rr[j].owner), dname_wire (owner), owner->len) == 0 )
+				zs_add (zs, owner, ZS_T_DS, ds->rr[j].ttl, ds->rr[j].rdata, ds->rr[j].rdlen);
+		zs_free (ds);
+		cnt++;
+	}
+
+	if ( cnt > 0 )		/* remove the deleted records */
+	{
+		for ( i = j = 0; i < zs->nrr; i++ )
+			if ( zs->rr[i].owner )
+				zs->rr[j++] = zs->rr[i];
+		zs->nrr = j;
+		zs->sorted = 0;
+	}
+
+	return cnt;
+}
+
+/*****************************************************************
+**	settypes (zs, np, nsec3, type)
+**	store the types of the NSEC/NSEC3 bitmap of the name
+*****************************************************************/
+static	int	settypes (const zstore_t *zs, const node_t *np, int nsec3, ushort *type)
+{
+	long	i;
+	int	n;
+	int	t;
+
+	n = 0;
+	for ( i = np->first; i < np->end && n < 250; i++ )
+	{
+		t = zs->rr[i].type;
+		if ( np->kind == N_DELEG && t != ZS_T_NS && t != ZS_T_DS )
+			continue;
+		if ( n == 0 || type[n-1] != t )
+			type[n++] = t;
+	}
+	/* the NSEC itself is signed, but an opt-out NSEC3 delegation has no RRSIG */
+	if ( !nsec3 || np->kind == N_AUTH || np->ds )
+		type[n++] = ZS_T_RRSIG;
+	if ( nsec3 && np->first == 0 )
+		type[n++] = ZS_T_NSEC3PARAM;
+	if ( !nsec3 )
+		type[n++] = ZS_T_NSEC;
+
+	return n;
+}
+
+/*****************************************************************
+**	mknsec (zs, nodes, n, ttl)
+**	add the NSEC chain to the zone store
+*****************************************************************/
+static	long	mknsec (zstore_t *zs, const node_t *nodes, long n, ulong ttl)
+{
+	uchar	rdata[ZS_MAXNAME + 256 * 34];
+	ushort	type[256];
+	const	dname_t	*next;
+	long	cnt;
+	long	i;
+	long	j;
+	int	len;
+
+	cnt = 0;
+	for ( i = 0; i < n; i = j )
+	{
+		for ( j = i + 1; j < n && nodes[j].kind == N_GLUE; j++ )
+			;
+		next = zs->rr[nodes[j < n ? j: 0].first].owner;
+
+		memcpy (rdata, dname_wire (next), next->len);
+		len = next->len;
+		len += zs_mkbitmap (type, settypes (zs, &nodes[i], 0, type), rdata + len, sizeof (rdata) - len);
+		if ( zs_add (zs, zs->rr[nodes[i].first].owner, ZS_T_NSEC, ttl, rdata, len) == NULL )
+			return -1;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/*****************************************************************
+**	nsec3hash (wire, salt, saltlen, iter, hash)
+**	compute the NSEC3 hash of the name (RFC 5155 5)
+*****************************************************************/
+static	int	nsec3hash (const uchar *wire, const uchar *salt, int saltlen, int iter, uchar *hash)
+{
+	uchar	buf[ZS_MAXNAME + 255];
+	int	len;
+
+	len = zs_wirelen (wire, ZS_MAXNAME);
+	memcpy (buf, wire, len);
+	memcpy (buf + len, salt, saltlen);
+	if ( EVP_Digest (buf, len + saltlen, hash, NULL, EVP_sha1 (), NULL) != 1 )
+		return -1;
+	while ( iter-- > 0 )
+	{
+		memcpy (buf, hash, HASHLEN);
+		memcpy (buf + HASHLEN, salt, saltlen);
+		if ( EVP_Digest (buf, HASHLEN + saltlen, hash, NULL, EVP_sha1 (), NULL) != 1 )
+			return -1;
+	}
+	return 0;
+}
+
+/*****************************************************************
+**	nsec3cmp (a, b)
+**	sort by hash; names in front of empty non-terminals
+*****************************************************************/
+static	int	nsec3cmp (const void *a, const void *b)
+{
+	const	hashed_t	*x = a;
+	const	hashed_t	*y = b;
+	int	res;
+
+	if ( (res = memcmp (x->hash, y->hash, HASHLEN)) != 0 )
+		return res;
+	return (x->node < y->node) - (x->node > y->node);
+}
+
+/*****************************************************************
+**	mknsec3 (zs, nodes, n, ttl, saltstr, iter, optout)
+**	add the NSEC3 chain and the NSEC3PARAM record to the store
+*****************************************************************/
+static	long	mknsec3 (zstore_t *zs, const node_t *nodes, long n, ulong ttl, const char *saltstr, int iter, int optout)
+{
+	static	const	char	b32[] = "0123456789abcdefghijklmnopqrstuv";
+	uchar	rdata[5 + 255 + 1 + HASHLEN + 256 * 34];
+	uchar	salt[255];
+	uchar	wire[ZS_MAXNAME];
+	ushort	type[256];
+	const	dname_t	*owner;
+	const	uchar	*p;
+	hashed_t	*h;
+	long	nh;
+	long	max;
+	long	i;
+	long	j;
+	int	saltlen;
+	int	len;
+	int	k;
+
+	saltlen = 0;
+	if ( saltstr && *saltstr && strcmp (saltstr, "-") != 0 )
+		for ( ; saltstr[0] && saltstr[1] && saltlen < sizeof (salt); saltstr += 2 )
+			sscanf (saltstr, "%2hhx", &salt[saltlen++]);
+
+	/* hash all names and empty non-terminals */
+	max = n + 16;
+	if ( (h = malloc (max * sizeof (hashed_t))) == NULL )
+		return -1;
+	nh = 0;
+	for ( i = 0; i < n; i++ )
+	{
+		if ( nodes[i].kind == N_GLUE || (optout && nodes[i].kind == N_DELEG && !nodes[i].ds) )
+			continue;
+		p = dname_wire (zs->rr[nodes[i].first].owner);
+		for ( j = i; ; j = -1 )
+		{
+			if ( nh >= max )
+			{
+				hashed_t	*tmp;
+
+				max *= 2;
+				if ( (tmp = realloc (h, max * sizeof (hashed_t))) == NULL )
+				{
+					free (h);
+					return -1;
+				}
+				h = tmp;
+			}
+			h[nh].wire = p;
+			h[nh].node = j;
+			if ( nsec3hash (p, salt, saltlen, iter, h[nh].hash) < 0 )
+			{
+				free (h);
+				return sslerror ("nsec3hash");
+			}
+			nh++;
+			if ( zs_wirelen (p, ZS_MAXNAME) <= zs->origin->len )
+				break;
+			p += *p + 1;		/* parent name */
+			if ( zs_wirelen (p, ZS_MAXNAME) <= zs->origin->len )
+				break;
+		}
+	}
+	qsort (h, nh, sizeof (hashed_t), nsec3cmp);
+
+	for ( i = j = 0; i < nh; i++ )		/* remove duplicates */
+	{
+		if ( j > 0 && memcmp (h[j-1].hash, h[i].hash, HASHLEN) == 0 )
+		{
+			len = zs_wirelen (h[i].wire, ZS_MAXNAME);
+			if ( len != zs_wirelen (h[j-1].wire, ZS_MAXNAME) || memcmp (h[i].wire, h[j-1].wire, len) != 0 )
+			{
+				snprintf (zsign_estr, sizeof (zsign_estr), "NSEC3 hash collision");
+				free (h);
+				return -1;
+			}
+			continue;
+		}
+		h[j++] = h[i];
+	}
+	nh = j;
+
+	for ( i = 0; i < nh; i++ )
+	{
+		/* owner name: base32hex of the hash below the zone apex */
+		wire[0] = 32;
+		for ( k = 0; k < 32; k++ )
+		{
+			int	bit = k * 5;
+			int	val = (h[i].hash[bit / 8] << 8 | (bit / 8 + 1 < HASHLEN ? h[i].hash[bit / 8 + 1]: 0));
+
+			wire[1 + k] = b32[(val >> (11 - bit % 8)) & 0x1F];
+		}
+		memcpy (wire + 33, dname_wire (zs->origin), zs->origin->len);
+		if ( (owner = zs_dname (zs, wire)) == NULL )
+		{
+			free (h);
+			return -1;
+		}
+
+		len = 0;
+		rdata[len++] = 1;		/* SHA-1 */
+		rdata[len++] = optout ? 1: 0;
+		zs_put16 (rdata + len, iter);
+		len += 2;
+		rdata[len++] = saltlen;
+		memcpy (rdata + len, salt, saltlen);
+		len += saltlen;
+		rdata[len++] = HASHLEN;
+		memcpy (rdata + len, h[(i + 1) % nh].hash, HASHLEN);
+		len += HASHLEN;
+		if ( h[i].node >= 0 )
+			len += zs_mkbitmap (type, settypes (zs, &nodes[h[i].node], 1, type), rdata + len, sizeof (rdata) - len);
+
+		if ( zs_add (zs, owner, ZS_T_NSEC3, ttl, rdata, len) == NULL )
+		{
+			free (h);
+			return -1;
+		}
+	}
+	free (h);
+
+	len = 0;
+	rdata[len++] = 1;
+	rdata[len++] = 0;
+	zs_put16 (rdata + len, iter);
+	len += 2;
+	rdata[len++] = saltlen;
+	memcpy (rdata + len, salt, saltlen);
+	len += saltlen;
+	if ( zs_add (zs, zs->origin, ZS_T_NSEC3PARAM, 0, rdata, len) == NULL )
+		return -1;
+
+	return nh;
+}
+
+/*****************************************************************
+**	loadkeys (ctx, zp, node)
+**	load the private keys of all active and revoked keys of the
+**	zone which have a DNSKEY record at the zone apex
+*****************************************************************/
+static	int	loadkeys (zsctx_t *c, const zone_t *zp, const node_t *apex)
+{
+	const	dki_t	*dkp;
+	const	rr_t	*rr;
+	zskey_t	*kp;
+	long	i;
+	int	flags;
+	int	ret;
+
+	for ( dkp = zp->keys; dkp; dkp = dkp->next )
+	{
+		if ( dki_status (dkp) != DKI_ACT && dki_status (dkp) != DKI_REV )
+			continue;
+		if ( c->nkeys >= ZSIGN_MAXKEYS )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "too many signing keys");
+			return ZS_UNSUPPORTED;
+		}
+		kp = &c->key[c->nkeys];
+		memset (kp, 0, sizeof (*kp));
+		kp->algo = dkp->algo;
+		if ( (ret = setdigest (kp)) < 0 )
+			return ret;
+
+		/* look for the DNSKEY record (the file name has the tag of the unrevoked key) */
+		for ( i = apex->first; i < apex->end; i++ )
+		{
+			rr = &c->zs->rr[i];
+			if ( rr->type != ZS_T_DNSKEY || rr->rdlen < 4 || rr->rdata[3] != dkp->algo )
+				continue;
+			flags = zs_get16 (rr->rdata);
+			kp->tag = keytag (rr->rdata, rr->rdlen);
+			if ( kp->tag == dkp->tag || ((flags & DK_FLAG_REVOKE) && kp->tag == (dkp->tag + 128) % 65536) )
+			{
+				kp->flags = flags;
+				break;
+			}
+		}
+		if ( i >= apex->end )
+		{
+			lg_mesg (LG_WARNING, "\"%s\": DNSKEY of key %d not found in zone file", zp->zone, dkp->tag);
+			continue;
+		}
+
+		if ( (kp->pkey = keygen_load (dkp->dname, dkp->fname, dkp->algo)) == NULL )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "key %d: %s", dkp->tag, keygen_geterrstr ());
+			return ZS_ERROR;
+		}
+		setdigest (kp);
+		c->nkeys++;
+	}
+
+	if ( c->nkeys == 0 )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "no active signing key found");
+		return ZS_ERROR;
+	}
+	return 0;
+}
+
+/*****************************************************************
+**	keymasks (c, dnskeyksk, dnskey, cds, other)
+**	compute the keys which sign the DNSKEY, the CDS/CDNSKEY and
+**	all other rrsets. Every algorithm signs all rrsets (RFC 6840
+**	5.11); KSKs sign all rrsets if there is no ZSK of the algorithm
+*****************************************************************/
+static	void	keymasks (const zsctx_t *c, int dnskeyksk, ulong *dnskey, ulong *cds, ulong *other)
+{
+	const	zskey_t	*kp;
+	int	zsk[256];
+	int	ksk[256];
+	int	i;
+
+	memset (zsk, 0, sizeof (zsk));
+	memset (ksk, 0, sizeof (ksk));
+	for ( i = 0, kp = c->key; i < c->nkeys; i++, kp++ )
+		if ( !(kp->flags & DK_FLAG_REVOKE) )
+		{
+			if ( kp->flags & DK_FLAG_KSK )
+				ksk[kp->algo] = 1;
+			else
+				zsk[kp->algo] = 1;
+		}
+
+	*dnskey = *cds = *other = 0;
+	for ( i = 0, kp = c->key; i < c->nkeys; i++, kp++ )
+	{
+		if ( kp->flags & DK_FLAG_REVOKE )	/* self signature of revoked key */
+			*dnskey |= 1UL << i;
+		else if ( kp->flags & DK_FLAG_KSK )
+		{
+			*dnskey |= 1UL << i;
+			*cds |= 1UL << i;
+			if ( !zsk[kp->algo] )
+				*other |= 1UL << i;
+		}
+		else
+		{
+			*other |= 1UL << i;
+			*cds |= 1UL << i;
+			if ( !dnskeyksk || !ksk[kp->algo] )
+				*dnskey |= 1UL << i;
+		}
+	}
+}
+
+/*****************************************************************
+**	mkjobs (c, nodes, n, dnskeyksk)
+**	create the list of rrsets to be signed
+*****************************************************************/
+static	long	mkjobs (zsctx_t *c, const node_t *nodes, long n, int dnskeyksk)
+{
+	rr_t	*rr;
+	ulong	dnskey;
+	ulong	cds;
+	ulong	other;
+	ulong	ttl;
+	long	max;
+	long	i;
+	long	j;
+	long	k;
+	long	end;
+
+	keymasks (c, dnskeyksk, &dnskey, &cds, &other);
+	max = 0;
+	rr = c->zs->rr;
+	for ( i = 0; i < n; i++ )
+	{
+		if ( nodes[i].kind == N_GLUE )
+			continue;
+		for ( j = nodes[i].first; j < nodes[i].end; j = end )
+		{
+			ttl = rr[j].ttl;
+			for ( end = j + 1; end < nodes[i].end && rr[end].type == rr[j].type; end++ )
+				if ( rr[end].ttl < ttl )
+					ttl = rr[end].ttl;
+			for ( k = j; k < end; k++ )	/* all records of a rrset have the same ttl */
+				rr[k].ttl = ttl;
+
+			if ( nodes[i].kind == N_DELEG && rr[j].type != ZS_T_DS && rr[j].type != ZS_T_NSEC )
+				continue;
+			if ( c->njobs >= max )
+			{
+				job_t	*tmp;
+
+				max = max ? max * 2: c->zs->nrr / 2 + 16;
+				if ( (tmp = realloc (c->job, max * sizeof (job_t))) == NULL )
+				{
+					snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+					return -1;
+				}
+				c->job = tmp;
+			}
+			c->job[c->njobs].first = j;
+			c->job[c->njobs].count = end - j;
+			c->job[c->njobs].nsig = 0;
+			c->job[c->njobs].sig = NULL;
+			switch ( rr[j].type )
+			{
+			case ZS_T_DNSKEY:	c->job[c->njobs].keys = dnskey;	break;
+			case ZS_T_CDS:
+			case ZS_T_CDNSKEY:	c->job[c->njobs].keys = cds;	break;
+			default:		c->job[c->njobs].keys = other;
+			}
+			c->njobs++;
+		}
+	}
+	return c->njobs;
+}
+
+/*****************************************************************
+**	samerrset (c, jp, prev, k, end)
+**	check if the rrset of the job is the same as the rrset at
+**	index k of the previous signed zone
+*****************************************************************/
+static	int	samerrset (const zsctx_t *c, const job_t *jp, const zstore_t *prev, long k, long end)
+{
+	const	rr_t	*rr;
+	const	rr_t	*prr;
+	int	i;
+
+	rr = &c->zs->rr[jp->first];
+	for ( i = 0; i < jp->count; i++ )
+	{
+		if ( k + i >= end )
+			return 0;
+		prr = &prev->rr[k + i];
+		if ( prr->type != rr[i].type || prr->ttl != rr[i].ttl || prr->rdlen != rr[i].rdlen ||
+		     memcmp (prr->rdata, rr[i].rdata, rr[i].rdlen) != 0 )
+			return 0;
+	}
+	return k + i >= end || prev->rr[k + i].type != rr->type;
+}
+
+/*****************************************************************
+**	reusesigs (c, prev, refresh)
+**	take the signatures of all rrsets which are unchanged since the
+**	previous signing out of the previous signed zone. This is done
+**	only if there is a signature of each signing key of the rrset
+**	which does not expire before the refresh time, otherwise the
+**	rrset will be signed again. Both zone stores are sorted in
+**	canonical order, so they could be merged in one pass.
+**	returns the number of reused signatures or -1 on error
+*****************************************************************/
+static	long	reusesigs (zsctx_t *c, zstore_t *prev, ulong refresh)
+{
+	const	dname_t	*apex;
+	const	dname_t	*owner;
+	const	rr_t	*rr;
+	const	rr_t	*prr;
+	const	rr_t	*sig[ZSIGN_MAXKEYS];
+	job_t	*jp;
+	uchar	*out;
+	ulong	now;
+	ulong	need;
+	long	reused;
+	long	first;
+	long	end;
+	long	k;
+	int	found;
+	int	labels;
+	int	size;
+	int	nsig;
+	int	i;
+
+	apex = c->zs->origin;
+	now = (ulong)time (NULL);
+	reused = 0L;
+	owner = NULL;
+	found = 0;
+	first = end = 0L;
+	for ( jp = c->job; jp < c->job + c->njobs; jp++ )
+	{
+		rr = &c->zs->rr[jp->first];
+		if ( rr->owner != owner )	/* next name: look for it in the previous zone */
+		{
+			owner = rr->owner;
+			for ( first = end; first < prev->nrr && zs_namecmp (prev->rr[first].owner, owner) < 0; first++ )
+				;
+			for ( end = first; end < prev->nrr && prev->rr[end].owner == prev->rr[first].owner; end++ )
+				;
+			found = first < prev->nrr && zs_namecmp (prev->rr[first].owner, owner) == 0;
+			if ( !found )
+				end = first;
+		}
+		if ( !found || jp->keys == 0 )
+			continue;
+
+		for ( k = first; k < end && prev->rr[k].type != rr->type; k++ )
+			;
+		if ( k >= end || !samerrset (c, jp, prev, k, end) )
+			continue;
+
+		/* look for a valid signature of each signing key */
+		labels = owner->labels - zs_iswildcard (owner);
+		need = jp->keys;
+		size = 0;
+		for ( k = first; k < end && need; k++ )
+		{
+			prr = &prev->rr[k];
+			if ( prr->type != ZS_T_RRSIG || prr->rdlen <= 18 + apex->len || prr->ttl != rr->ttl )
+				continue;
+			if ( zs_get16 (prr->rdata) != rr->type || prr->rdata[3] != labels ||
+			     zs_get32 (prr->rdata + 4) != rr->ttl ||
+			     zs_get32 (prr->rdata + 8) < refresh || zs_get32 (prr->rdata + 12) > now ||
+			     memcmp (prr->rdata + 18, dname_wire (apex), apex->len) != 0 )
+				continue;
+			for ( i = 0; i < c->nkeys; i++ )
+				if ( (need & (1UL << i)) && c->key[i].algo == prr->rdata[2] &&
+				     c->key[i].tag == zs_get16 (prr->rdata + 16) )
+				{
+					sig[i] = prr;
+					need &= ~(1UL << i);
+					size += 2 + prr->rdlen;
+					break;
+				}
+		}
+		if ( need )
+			continue;
+
+		if ( (out = zs_alloc (prev, size)) == NULL )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+			return -1;
+		}
+		jp->sig = out;
+		for ( i = nsig = 0; i < c->nkeys; i++ )
+		{
+			if ( !(jp->keys & (1UL << i)) )
+				continue;
+			prr = sig[i];
+			zs_put16 (out, prr->rdlen);
+			memcpy (out + 2, prr->rdata, prr->rdlen);
+			out += 2 + prr->rdlen;
+			nsig++;
+		}
+		jp->nsig = nsig;
+		reused += nsig;
+	}
+
+	return reused;
+}
+
+/*****************************************************************
+**	sign (w, k, data, len, sig)
+**	sign the data with key k and store the signature in DNSSEC
+**	wire format (RFC 3110, RFC 6605, RFC 8080) in sig.
+**	The signing context of a key is initialized once per thread
+**	and copied for each signature, which is much cheaper than
+**	a new initialization.
+**	returns the length of the signature or -1 on error
+*****************************************************************/
+static	int	sign (zsworker_t *w, int k, const uchar *data, size_t len, uchar *sig)
+{
+	const	zskey_t	*kp;
+	uchar	der[256];
+	const	uchar	*p;
+	const	BIGNUM	*r;
+	const	BIGNUM	*s;
+	ECDSA_SIG	*es;
+	size_t	siglen;
+	int	n;
+
+	kp = &w->ctx->key[k];
+	if ( w->keyctx[k] == NULL )
+	{
+		if ( (w->keyctx[k] = EVP_MD_CTX_new ()) == NULL ||
+		     EVP_DigestSignInit (w->keyctx[k], NULL, kp->md, NULL, kp->pkey) <= 0 )
+			return -1;
+	}
+	if ( EVP_MD_CTX_copy_ex (w->mdctx, w->keyctx[k]) <= 0 )
+	{
+		EVP_MD_CTX_reset (w->mdctx);
+		if ( EVP_DigestSignInit (w->mdctx, NULL, kp->md, NULL, kp->pkey) <= 0 )
+			return -1;
+	}
+
+	if ( kp->algo != DK_ALGO_ECDSAP256SHA256 && kp->algo != DK_ALGO_ECDSAP384SHA384 )
+	{
+		siglen = kp->siglen;
+		if ( EVP_DigestSign (w->mdctx, sig, &siglen, data, len) <= 0 || siglen != kp->siglen )
+			return -1;
+		return siglen;
+	}
+
+	/* ecdsa: convert the DER encoded signature into r | s */
+	siglen = sizeof (der);
+	if ( EVP_DigestSign (w->mdctx, der, &siglen, data, len) <= 0 )
+		return -1;
+	p = der;
+	if ( (es = d2i_ECDSA_SIG (NULL, &p, siglen)) == NULL )
+		return -1;
+	ECDSA_SIG_get0 (es, &r, &s);
+	n = kp->siglen / 2;
+	if ( BN_bn2binpad (r, sig, n) != n || BN_bn2binpad (s, sig + n, n) != n )
+		n = -1;
+	ECDSA_SIG_free (es);
+
+	return n < 0 ? -1: kp->siglen;
+}
+
+/*****************************************************************
+**	rrsetdata (w, rr, count, ttl, hdrlen)
+**	put the rrset in canonical wire format behind the RRSIG rdata
+**	header of length hdrlen into the buffer of the worker
+**	returns the length of the data to be signed or -1
+*****************************************************************/
+static	long	rrsetdata (zsworker_t *w, const rr_t *rr, int count, ulong ttl, int hdrlen)
+{
+	uchar	*p;
+	size_t	need;
+	int	i;
+
+	need = hdrlen;
+	for ( i = 0; i < count; i++ )
+		need += rr[i].owner->len + 10 + rr[i].rdlen;
+	if ( need > w->size )
+	{
+		uchar	*tmp;
+
+		if ( (tmp = realloc (w->buf, need + 4096)) == NULL )
+			return -1;
+		w->buf = tmp;
+		w->size = need + 4096;
+	}
+	p = w->buf + hdrlen;
+	for ( i = 0; i < count; i++ )
+	{
+		memcpy (p, dname_wire (rr[i].owner), rr[i].owner->len);
+		p += rr[i].owner->len;
+		zs_put16 (p, rr[i].type);
+		zs_put16 (p + 2, ZS_C_IN);
+		zs_put32 (p + 4, ttl);
+		zs_put16 (p + 8, rr[i].rdlen);
+		memcpy (p + 10, rr[i].rdata, rr[i].rdlen);
+		p += 10 + rr[i].rdlen;
+	}
+
+	return need;
+}
+
+/*****************************************************************
+**	signrrset (w, jp, idx)
+**	create the signatures of the rrset (RFC 4034 3.1.8.1)
+*****************************************************************/
+static	int	signrrset (zsworker_t *w, job_t *jp, long idx)
+{
+	zsctx_t	*c;
+	const	rr_t	*rr;
+	const	dname_t	*apex;
+	uchar	*p;
+	uchar	*out;
+	long	need;
+	ulong	expire;
+	int	hdrlen;
+	int	labels;
+	int	size;
+	int	len;
+	int	i;
+
+	c = w->ctx;
+	rr = &c->zs->rr[jp->first];
+	apex = c->zs->origin;
+
+	expire = c->expiration;
+	if ( c->jitter > 0 )	/* spread the expiration times */
+		expire -= ((ulong)idx * 2654435761UL) % (ulong)c->jitter;
+	labels = rr->owner->labels - zs_iswildcard (rr->owner);
+
+	/* build the rrset part of the data to be signed */
+	hdrlen = 18 + apex->len;
+	if ( (need = rrsetdata (w, rr, jp->count, rr->ttl, hdrlen)) < 0 )
+		return -1;
+
+	size = 0;
+	for ( i = 0; i < c->nkeys; i++ )
+		if ( jp->keys & (1UL << i) )
+			size += 2 + hdrlen + c->key[i].siglen;
+	if ( size == 0 )
+		return 0;
+	if ( (out = zs_alloc (w->mem, size)) == NULL )
+		return -1;
+	jp->sig = out;
+
+	for ( i = 0; i < c->nkeys; i++ )
+	{
+		if ( !(jp->keys & (1UL << i)) )
+			continue;
+
+		/* RRSIG rdata without signature */
+		p = w->buf;
+		zs_put16 (p, rr->type);
+		p[2] = c->key[i].algo;
+		p[3] = labels;
+		zs_put32 (p + 4, rr->ttl);
+		zs_put32 (p + 8, expire);
+		zs_put32 (p + 12, c->inception);
+		zs_put16 (p + 16, c->key[i].tag);
+		memcpy (p + 18, dname_wire (apex), apex->len);
+
+		memcpy (out + 2, w->buf, hdrlen);
+		if ( (len = sign (w, i, w->buf, need, out + 2 + hdrlen)) < 0 )
+			return -1;
+		zs_put16 (out, hdrlen + len);
+		out += 2 + hdrlen + len;
+		jp->nsig++;
+		w->sigs++;
+	}
+
+	return 0;
+}
+
+/*****************************************************************
+**	mkshards (c)
+**	split the job list into shards of about ZSIGN_SHARD rrsets.
+**	A shard covers a contiguous range of the zone in canonical
+**	order and ends at a name boundary, so the apex is always part
+**	of the first shard.
+**	returns the number of shards or -1 on error
+*****************************************************************/
+static	long	mkshards (zsctx_t *c)
+{
+	const	rr_t	*rr;
+	shard_t	*sp;
+	long	j;
+
+	if ( (c->shard = calloc (c->njobs / ZSIGN_SHARD + 1, sizeof (shard_t))) == NULL )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+		return -1;
+	}
+	rr = c->zs->rr;
+	for ( j = 0; j < c->njobs; c->nshards++ )
+	{
+		sp = &c->shard[c->nshards];
+		sp->job = j;
+		sp->first = c->nshards == 0 ? 0: c->job[j].first;
+		for ( j += ZSIGN_SHARD; j < c->njobs && rr[c->job[j].first].owner == rr[c->job[j-1].first].owner; j++ )
+			;
+		if ( j > c->njobs )
+			j = c->njobs;
+		sp->jend = j;
+		sp->end = j < c->njobs ? c->job[j].first: c->zs->nrr;
+	}
+	return c->nshards;
+}
+
+/*****************************************************************
+**	printset (fp, c, i, jp)
+**	print the rrset starting at index i and its signatures
+**	returns the index of the next rrset
+*****************************************************************/
+static	long	printset (FILE *fp, const zsctx_t *c, long i, const job_t *jp)
+{
+	const	rr_t	*rr;
+	rr_t	sig;
+	const	uchar	*p;
+	long	j;
+	int	k;
+
+	rr = c->zs->rr;
+	for ( j = i; j < c->zs->nrr && rr[j].owner == rr[i].owner && rr[j].type == rr[i].type; j++ )
+		zs_printrr (fp, &rr[j]);
+
+	if ( jp )
+	{
+		sig.owner = rr[i].owner;
+		sig.ttl = rr[i].ttl;
+		sig.type = ZS_T_RRSIG;
+		for ( k = 0, p = jp->sig; k < jp->nsig; k++, p += 2 + sig.rdlen )
+		{
+			sig.rdlen = zs_get16 (p);
+			sig.rdata = (uchar *)p + 2;
+			zs_printrr (fp, &sig);
+		}
+	}
+
+	return j;
+}
+
+/*****************************************************************
+**	signshard (w, sp)
+**	sign all rrsets of the shard and print the shard into a
+**	memory buffer. The SOA rrset is printed first.
+**	The signatures are released after printing. The buffer is
+**	kept until all previous shards are written (see worker()).
+**	returns 0, -1 on signing errors or -2 if out of memory
+*****************************************************************/
+static	int	signshard (zsworker_t *w, shard_t *sp)
+{
+	const	zsctx_t	*c;
+	const	rr_t	*rr;
+	const	job_t	*jp;
+	const	job_t	*soa;
+	FILE	*fp;
+	long	i;
+	long	j;
+
+	c = w->ctx;
+	for ( j = sp->job; j < sp->jend; j++ )
+		if ( c->job[j].sig == NULL && signrrset (w, &c->job[j], j) < 0 )
+			return -1;
+
+	if ( (fp = open_memstream (&sp->buf, &sp->len)) == NULL )
+		return -2;
+
+	rr = c->zs->rr;
+	soa = NULL;
+	if ( sp->first == 0 )
+	{
+		for ( jp = &c->job[sp->job]; jp < &c->job[sp->jend] && rr[jp->first].owner == rr[0].owner; jp++ )
+			if ( rr[jp->first].type == ZS_T_SOA )
+				soa = jp;
+		if ( soa )
+		{
+			printset (fp, c, soa->first, soa);
+			sp->nrr += soa->count + soa->nsig;
+		}
+	}
+
+	jp = &c->job[sp->job];
+	for ( i = sp->first; i < sp->end; )
+	{
+		if ( jp < &c->job[sp->jend] && jp->first == i )
+		{
+			if ( jp != soa )
+			{
+				printset (fp, c, i, jp);
+				sp->nrr += jp->count + jp->nsig;
+			}
+			i += jp->count;
+			jp++;
+		}
+		else
+		{
+			j = printset (fp, c, i, NULL);
+			sp->nrr += j - i;
+			i = j;
+		}
+	}
+	if ( fclose (fp) != 0 )
+		return -2;
+
+	/* the signatures are printed, so release them */
+	zs_free (w->mem);
+	if ( (w->mem = zs_new (NULL)) == NULL )
+		return -2;
+
+	return 0;
+}
+
+/*****************************************************************
+**	flushshards (c)
+**	write all consecutive finished shards to the signed zone file
+**	(must be called with the context locked)
+*****************************************************************/
+static	void	flushshards (zsctx_t *c)
+{
+	shard_t	*sp;
+
+	while ( !c->error && c->written < c->nshards && c->shard[c->written].done )
+	{
+		sp = &c->shard[c->written];
+		if ( sp->len > 0 && fwrite (sp->buf, 1, sp->len, c->out) != sp->len )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "write error: %s", strerror (errno));
+			c->error = 1;
+		}
+		c->nout += sp->nrr;
+		free (sp->buf);
+		sp->buf = NULL;
+		c->written++;
+	}
+}
+
+/*****************************************************************
+**	worker (arg)
+**	sign and print shards until all shards are taken
+**	A worker waits for the output if more than c->window shards
+**	are taken but not written, so a slow shard could not pile up
+**	the printed buffers of all the following shards.
+*****************************************************************/
+static	void	*worker (void *arg)
+{
+	zsworker_t	*w;
+	zsctx_t	*c;
+	long	s;
+	int	ret;
+
+	w = (zsworker_t *)arg;
+	c = w->ctx;
+	for (;;)
+	{
+		ctx_lock (c);
+		while ( !c->error && c->next < c->nshards && c->next - c->written >= c->window )
+			ctx_wait (c);
+		s = c->error ? c->nshards: c->next++;
+		ctx_unlock (c);
+		if ( s >= c->nshards )
+			break;
+
+		ret = signshard (w, &c->shard[s]);
+
+		ctx_lock (c);
+		if ( ret < 0 && !c->error )
+		{
+			if ( ret == -1 )
+				sslerror ("signing failed");
+			else
+				snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+			c->error = 1;
+		}
+		c->shard[s].done = 1;
+		flushshards (c);
+		ctx_signal (c);
+		ctx_unlock (c);
+		if ( ret < 0 )
+			break;
+	}
+
+	return NULL;
+}
+
+/*****************************************************************
+**	runworkers (c, w, nthreads, fn)
+**	start the signing (or verifying) threads and wait for them
+**	returns the number of threads used
+*****************************************************************/
+static	int	runworkers (zsctx_t *c, zsworker_t *w, int nthreads, void *(*fn)(void *))
+{
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	pthread_t	tid[ZSIGN_MAXTHREADS];
+	int	n;
+	int	i;
+
+	pthread_mutex_init (&c->lock, NULL);
+	pthread_cond_init (&c->flushed, NULL);
+	for ( n = 1; n < nthreads; n++ )
+		if ( pthread_create (&tid[n], NULL, fn, &w[n]) != 0 )
+			break;
+	fn (&w[0]);		/* the main thread is the first worker */
+	for ( i = 1; i < n; i++ )
+		pthread_join (tid[i], NULL);
+	pthread_cond_destroy (&c->flushed);
+	pthread_mutex_destroy (&c->lock);
+
+	return n;
+#else
+	fn (&w[0]);
+	return 1;
+#endif
+}
+
+/*****************************************************************
+**	openzone (zp, outfile, c, tmppath, size)
+**	create the temporary signed zone file
+*****************************************************************/
+static	int	openzone (const zone_t *zp, const char *outfile, zsctx_t *c, char *tmppath, size_t size)
+{
+	char	path[MAX_PATHSIZE+1];
+
+	pathname (path, sizeof (path), zp->dir, outfile, NULL);
+	snprintf (tmppath, size, "%s.tmp", path);
+	if ( (c->out = fopen (tmppath, "w")) == NULL )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "can't create \"%.128s\": %s", tmppath, strerror (errno));
+		return ZS_ERROR;
+	}
+	setvbuf (c->out, NULL, _IOFBF, 256 * 1024);
+
+	fprintf (c->out, "; File written on %s by the built-in signer\n", time2str (time (NULL), 's'));
+
+	return ZS_OK;
+}
+
+/*****************************************************************
+**	closezone (zp, outfile, c, tmppath, expected)
+**	check if all shards with the expected number of records are
+**	written and rename the temporary file to the output file
+*****************************************************************/
+static	int	closezone (const zone_t *zp, const char *outfile, zsctx_t *c, const char *tmppath, long expected)
+{
+	char	path[MAX_PATHSIZE+1];
+	int	ret;
+
+	ret = ferror (c->out);
+	if ( fclose (c->out) != 0 || ret )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "write error on \"%.128s\": %s", tmppath, strerror (errno));
+		c->error = 1;
+	}
+	c->out = NULL;
+	if ( !c->error && (c->written != c->nshards || c->nout != expected) )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "signed zone incomplete (%ld of %ld records in %ld of %ld shards)",
+					c->nout, expected, c->written, c->nshards);
+		c->error = 1;
+	}
+	if ( c->error )
+	{
+		unlink (tmppath);
+		return ZS_ERROR;
+	}
+
+	pathname (path, sizeof (path), zp->dir, outfile, NULL);
+	if ( rename (tmppath, path) < 0 )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "can't rename \"%.128s\": %s", tmppath, strerror (errno));
+		unlink (tmppath);
+		return ZS_ERROR;
+	}
+
+	return ZS_OK;
+}
+
+/*****************************************************************
+**	verror (c, fmt, ...)
+**	count a verification error of the signed zone and log the
+**	first ZSIGN_MAXERR of them (called with the context locked)
+*****************************************************************/
+static	void	verror (zsctx_t *c, const char *fmt, ...)
+{
+	char	mesg[255+1];
+	va_list	ap;
+
+	va_start (ap, fmt);
+	vsnprintf (mesg, sizeof (mesg), fmt, ap);
+	va_end (ap);
+
+	if ( c->nerr++ == 0 )
+		snprintf (c->errmsg, sizeof (c->errmsg), "%s", mesg);
+	if ( c->nerr <= ZSIGN_MAXERR )
+		lg_mesg (LG_ERROR, "\"%s\": verify: %s", c->zone, mesg);
+}
+
+/*****************************************************************
+**	pkeyfromdata (type, bld)
+**	create a public key out of the parameters in bld
+*****************************************************************/
+static	EVP_PKEY	*pkeyfromdata (const char *type, OSSL_PARAM_BLD *bld)
+{
+	OSSL_PARAM	*params;
+	EVP_PKEY_CTX	*ctx;
+	EVP_PKEY	*pkey;
+
+	pkey = NULL;
+	params = OSSL_PARAM_BLD_to_param (bld);
+	ctx = EVP_PKEY_CTX_new_from_name (NULL, type, NULL);
+	if ( params == NULL || ctx == NULL || EVP_PKEY_fromdata_init (ctx) <= 0 ||
+	     EVP_PKEY_fromdata (ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) <= 0 )
+		pkey = NULL;
+	EVP_PKEY_CTX_free (ctx);
+	OSSL_PARAM_free (params);
+
+	return pkey;
+}
+
+/*****************************************************************
+**	pubkey (rr, kp)
+**	set the public key of the DNSKEY record
+**	(RFC 3110, RFC 6605, RFC 8080)
+**	returns 0, ZS_ERROR or ZS_UNSUPPORTED
+*****************************************************************/
+static	int	pubkey (const rr_t *rr, zskey_t *kp)
+{
+	OSSL_PARAM_BLD	*bld;
+	BIGNUM	*n;
+	BIGNUM	*e;
+	uchar	pub[1 + 2 * 48];
+	const	uchar	*p;
+	int	len;
+	int	elen;
+	int	ret;
+
+	memset (kp, 0, sizeof (*kp));
+	kp->flags = zs_get16 (rr->rdata);
+	kp->algo = rr->rdata[3];
+	kp->tag = keytag (rr->rdata, rr->rdlen);
+	if ( (ret = setdigest (kp)) < 0 )
+		return ret;
+	p = rr->rdata + 4;
+	len = rr->rdlen - 4;
+
+	switch ( kp->algo )
+	{
+	case DK_ALGO_ED25519:
+	case DK_ALGO_ED448:
+		kp->pkey = EVP_PKEY_new_raw_public_key (kp->algo == DK_ALGO_ED25519 ? EVP_PKEY_ED25519: EVP_PKEY_ED448,
+										NULL, p, len);
+		break;
+	case DK_ALGO_ECDSAP256SHA256:
+	case DK_ALGO_ECDSAP384SHA384:
+		if ( len != kp->siglen || (bld = OSSL_PARAM_BLD_new ()) == NULL )
+			break;
+		pub[0] = 0x04;		/* uncompressed point */
+		memcpy (pub + 1, p, len);
+		OSSL_PARAM_BLD_push_utf8_string (bld, OSSL_PKEY_PARAM_GROUP_NAME,
+			kp->algo == DK_ALGO_ECDSAP256SHA256 ? "prime256v1": "secp384r1", 0);
+		OSSL_PARAM_BLD_push_octet_string (bld, OSSL_PKEY_PARAM_PUB_KEY, pub, len + 1);
+		kp->pkey = pkeyfromdata ("EC", bld);
+		OSSL_PARAM_BLD_free (bld);
+		break;
+	default:		/* RSA */
+		if ( len < 3 )
+			break;
+		elen = *p++;
+		len--;
+		if ( elen == 0 )
+		{
+			elen = zs_get16 (p);
+			p += 2;
+			len -= 2;
+		}
+		if ( elen <= 0 || elen >= len || (bld = OSSL_PARAM_BLD_new ()) == NULL )
+			break;
+		e = BN_bin2bn (p, elen, NULL);
+		n = BN_bin2bn (p + elen, len - elen, NULL);
+		if ( e && n )
+		{
+			OSSL_PARAM_BLD_push_BN (bld, OSSL_PKEY_PARAM_RSA_N, n);
+			OSSL_PARAM_BLD_push_BN (bld, OSSL_PKEY_PARAM_RSA_E, e);
+			kp->pkey = pkeyfromdata ("RSA", bld);
+		}
+		BN_free (e);
+		BN_free (n);
+		OSSL_PARAM_BLD_free (bld);
+	}
+
+	if ( kp->pkey == NULL )
+	{
+		sslerror ("pubkey");
+		snprintf (zsign_estr, sizeof (zsign_estr), "invalid DNSKEY of key %d", kp->tag);
+		return ZS_ERROR;
+	}
+	setdigest (kp);
+	return 0;
+}
+
+/*****************************************************************
+**	dnskeys (c, apex)
+**	load the public keys of the DNSKEY rrset and collect the
+**	algorithms which have to sign each rrset
+*****************************************************************/
+static	int	dnskeys (zsctx_t *c, const node_t *apex)
+{
+	const	rr_t	*rr;
+	zskey_t	*kp;
+	long	i;
+	int	ret;
+	int	a;
+
+	for ( i = apex->first; i < apex->end; i++ )
+	{
+		rr = &c->zs->rr[i];
+		if ( rr->type != ZS_T_DNSKEY || rr->rdlen < 4 || !(zs_get16 (rr->rdata) & DK_FLAG_ZONE) )
+			continue;
+		if ( c->nkeys >= ZSIGN_MAXKEYS )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "too many keys");
+			return ZS_UNSUPPORTED;
+		}
+		kp = &c->key[c->nkeys];
+		if ( (ret = pubkey (rr, kp)) < 0 )
+			return ret;
+		c->nkeys++;
+
+		if ( kp->flags & DK_FLAG_REVOKE )
+			continue;
+		if ( kp->flags & DK_FLAG_KSK )
+			c->haveksk = 1;
+		for ( a = 0; a < c->nalg && c->alg[a] != kp->algo; a++ )
+			;
+		if ( a >= c->nalg )
+			c->alg[c->nalg++] = kp->algo;
+	}
+
+	if ( c->nkeys == 0 )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "no DNSKEY at the zone apex");
+		return ZS_ERROR;
+	}
+	return 0;
+}
+
+/*****************************************************************
+**	splitsigs (zs, psig, pnsig, pchain, pnchain)
+**	move the RRSIG records and the NSEC/NSEC3 chain of the
+**	(sorted) store into separate lists
+*****************************************************************/
+static	int	splitsigs (zstore_t *zs, rr_t **psig, long *pnsig, rr_t **pchain, long *pnchain)
+{
+	rr_t	*sig;
+	rr_t	*chain;
+	long	i;
+	long	n;
+
+	sig = malloc ((zs->nrr + 1) * sizeof (rr_t));
+	chain = malloc ((zs->nrr + 1) * sizeof (rr_t));
+	if ( sig == NULL || chain == NULL )
+	{
+		free (sig);
+		free (chain);
+		snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+		return ZS_ERROR;
+	}
+
+	*pnsig = *pnchain = 0;
+	for ( i = n = 0; i < zs->nrr; i++ )
+		switch ( zs->rr[i].type )
+		{
+		case ZS_T_RRSIG:
+			sig[(*pnsig)++] = zs->rr[i];
+			break;
+		case ZS_T_NSEC:
+		case ZS_T_NSEC3:
+		case ZS_T_NSEC3PARAM:
+			chain[(*pnchain)++] = zs->rr[i];
+			break;
+		default:
+			zs->rr[n++] = zs->rr[i];
+		}
+	zs->nrr = n;
+	*psig = sig;
+	*pchain = chain;
+
+	return 0;
+}
+
+/*****************************************************************
+**	rrcmp (a, b)
+**	qsort compare function for records
+*****************************************************************/
+static	int	rrcmp (const void *a, const void *b)
+{
+	return zs_rrcmp ((const rr_t *)a, (const rr_t *)b);
+}
+
+/*****************************************************************
+**	chaincmp (a, b)
+**	compare the rdata of two NSEC or NSEC3 records, ignoring the
+**	case of the NSEC next domain name
+*****************************************************************/
+static	int	chaincmp (const rr_t *a, const rr_t *b)
+{
+	int	i;
+
+	if ( a->rdlen != b->rdlen )
+		return 1;
+	if ( a->type != ZS_T_NSEC )
+		return memcmp (a->rdata, b->rdata, a->rdlen);
+
+	for ( i = 0; i < a->rdlen; i++ )
+		if ( tolower (a->rdata[i]) != tolower (b->rdata[i]) )
+			return 1;
+	return 0;
+}
+
+/*****************************************************************
+**	checkchain (c, nodes, n, chain, nchain)
+**	build the NSEC or NSEC3 chain of the zone data with the
+**	parameters found in the signed zone and compare it with the
+**	chain of the signed zone
+*****************************************************************/
+static	int	checkchain (zsctx_t *c, const node_t *nodes, long n, const rr_t *chain, long nchain)
+{
+	char	name[1023+1];
+	char	salt[510+1];
+	zstore_t	*zs;
+	const	rr_t	*param;
+	const	rr_t	*exp;
+	long	nexp;
+	long	first;
+	long	cnt;
+	long	i;
+	long	j;
+	int	optout;
+	int	res;
+	int	k;
+
+	zs = c->zs;
+	param = NULL;
+	optout = 0;
+	for ( i = 0; i < nchain; i++ )
+		if ( chain[i].type == ZS_T_NSEC3PARAM && chain[i].owner == zs->origin && chain[i].rdlen >= 5 )
+			param = &chain[i];
+		else if ( chain[i].type == ZS_T_NSEC3 && chain[i].rdlen > 1 && (chain[i].rdata[1] & 1) )
+			optout = 1;
+
+	first = zs->nrr;
+	if ( param )
+	{
+		if ( param->rdata[0] != 1 || param->rdlen != 5 + param->rdata[4] )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "unsupported NSEC3PARAM record");
+			return ZS_UNSUPPORTED;
+		}
+		strcpy (salt, "-");
+		for ( k = 0; k < param->rdata[4]; k++ )
+			snprintf (salt + 2 * k, sizeof (salt) - 2 * k, "%02x", param->rdata[5 + k]);
+		cnt = mknsec3 (zs, nodes, n, 0, salt, zs_get16 (param->rdata + 2), optout);
+	}
+	else
+		cnt = mknsec (zs, nodes, n, 0);
+	if ( cnt < 0 )
+	{
+		if ( zsign_estr[0] == '\0' )
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+		return ZS_ERROR;
+	}
+
+	/* compare the expected chain with the chain of the signed zone */
+	exp = &zs->rr[first];
+	nexp = zs->nrr - first;
+	qsort (&zs->rr[first], nexp, sizeof (rr_t), rrcmp);
+	for ( i = j = 0; i < nexp || j < nchain; )
+	{
+		if ( i >= nexp )
+			res = 1;
+		else if ( j >= nchain )
+			res = -1;
+		else if ( (res = zs_namecmp (exp[i].owner, chain[j].owner)) == 0 )
+			res = exp[i].type - chain[j].type;
+
+		if ( res < 0 )
+			verror (c, "%s %s missing", zs_dname2str (exp[i].owner, name, sizeof (name)), zs_type2str (exp[i].type));
+		else if ( res > 0 )
+			verror (c, "%s %s not expected", zs_dname2str (chain[j].owner, name, sizeof (name)), zs_type2str (chain[j].type));
+		else if ( chaincmp (&exp[i], &chain[j]) != 0 )
+			verror (c, "%s %s is wrong", zs_dname2str (exp[i].owner, name, sizeof (name)), zs_type2str (exp[i].type));
+		if ( res <= 0 )
+			i++;
+		if ( res >= 0 )
+			j++;
+	}
+	zs->nrr = first;
+
+	return 0;
+}
+
+/*****************************************************************
+**	mapsigs (c, sig, nsig)
+**	set the range of the covering RRSIG records of each rrset
+*****************************************************************/
+static	void	mapsigs (zsctx_t *c, const rr_t *sig, long nsig)
+{
+	const	rr_t	*rr;
+	job_t	*jp;
+	long	k;
+	int	res;
+
+	k = 0;
+	for ( jp = c->job; jp < c->job + c->njobs; jp++ )
+	{
+		rr = &c->zs->rr[jp->first];
+		for ( ; k < nsig; k++ )
+		{
+			if ( (res = zs_namecmp (sig[k].owner, rr->owner)) == 0 )
+				res = (sig[k].rdlen < 2 ? 0: zs_get16 (sig[k].rdata)) - rr->type;
+			if ( res >= 0 )
+				break;
+		}
+		jp->rrsig = k;
+		jp->nsig = 0;
+		while ( k + jp->nsig < nsig && zs_namecmp (sig[k + jp->nsig].owner, rr->owner) == 0 &&
+			sig[k + jp->nsig].rdlen > 2 && zs_get16 (sig[k + jp->nsig].rdata) == rr->type )
+			jp->nsig++;
+	}
+}
+
+/*****************************************************************
+**	verify (w, k, data, len, sig, siglen)
+**	verify the signature in DNSSEC wire format with key k
+**	returns 1 if the signature is valid, 0 if not, -1 on error
+*****************************************************************/
+static	int	verify (zsworker_t *w, int k, const uchar *data, size_t len, const uchar *sig, int siglen)
+{
+	const	zskey_t	*kp;
+	uchar	der[256];
+	uchar	*p;
+	ECDSA_SIG	*es;
+	BIGNUM	*r;
+	BIGNUM	*s;
+	int	n;
+	int	ret;
+
+	kp = &w->ctx->key[k];
+	if ( w->keyctx[k] == NULL )
+	{
+		if ( (w->keyctx[k] = EVP_MD_CTX_new ()) == NULL ||
+		     EVP_DigestVerifyInit (w->keyctx[k], NULL, kp->md, NULL, kp->pkey) <= 0 )
+			return -1;
+	}
+	if ( EVP_MD_CTX_copy_ex (w->mdctx, w->keyctx[k]) <= 0 )
+	{
+		EVP_MD_CTX_reset (w->mdctx);
+		if ( EVP_DigestVerifyInit (w->mdctx, NULL, kp->md, NULL, kp->pkey) <= 0 )
+			return -1;
+	}
+
+	if ( kp->algo != DK_ALGO_ECDSAP256SHA256 && kp->algo != DK_ALGO_ECDSAP384SHA384 )
+		ret = EVP_DigestVerify (w->mdctx, sig, siglen, data, len);
+	else
+	{
+		/* ecdsa: convert r | s into a DER encoded signature */
+		if ( siglen != kp->siglen )
+			return 0;
+		n = siglen / 2;
+		r = BN_bin2bn (sig, n, NULL);
+		s = BN_bin2bn (sig + n, n, NULL);
+		if ( (es = ECDSA_SIG_new ()) == NULL || r == NULL || s == NULL || ECDSA_SIG_set0 (es, r, s) != 1 )
+		{
+			ECDSA_SIG_free (es);
+			BN_free (r);
+			BN_free (s);
+			return -1;
+		}
+		p = der;
+		n = i2d_ECDSA_SIG (es, &p);
+		ECDSA_SIG_free (es);
+		if ( n <= 0 )
+			return -1;
+		ret = EVP_DigestVerify (w->mdctx, der, n, data, len);
+	}
+	ERR_clear_error ();
+
+	return ret == 1;
+}
+
+/*****************************************************************
+**	vrrset (w, jp)
+**	check the signatures of the rrset: each algorithm of the
+**	DNSKEY rrset has to sign the rrset with a valid signature,
+**	the DNSKEY rrset has to be signed by a KSK and no signature
+**	should expire before minexpire
+**	returns 0 or -1 on error
+*****************************************************************/
+static	int	vrrset (zsworker_t *w, const job_t *jp)
+{
+	char	name[1023+1];
+	zsctx_t	*c;
+	const	rr_t	*rr;
+	const	rr_t	*sig;
+	const	uchar	*sd;
+	ulong	expire;
+	ulong	incept;
+	long	need;
+	int	found[ZSIGN_MAXKEYS];
+	int	kskok;
+	int	hdrlen;
+	int	signer;
+	int	labels;
+	int	ret;
+	int	i;
+	int	k;
+
+	c = w->ctx;
+	rr = &c->zs->rr[jp->first];
+	labels = rr->owner->labels - zs_iswildcard (rr->owner);
+	memset (found, 0, sizeof (found));
+	kskok = rr->type != ZS_T_DNSKEY || !c->haveksk;
+
+	for ( i = 0; i < jp->nsig; i++ )
+	{
+		sig = &c->rrsig[jp->rrsig + i];
+		sd = sig->rdata;
+		if ( sig->rdlen <= 18 || (signer = zs_wirelen (sd + 18, sig->rdlen - 18)) <= 0 )
+			continue;
+		for ( k = 0; k < c->nkeys; k++ )
+			if ( c->key[k].algo == sd[2] && c->key[k].tag == zs_get16 (sd + 16) )
+				break;
+		if ( k >= c->nkeys )		/* signature of an unknown key */
+			continue;
+
+		ret = 0;
+		hdrlen = 18 + signer;
+		if ( sd[3] == labels && signer == c->zs->origin->len )
+		{
+			if ( (need = rrsetdata (w, rr, jp->count, zs_get32 (sd + 4), hdrlen)) < 0 )
+				return -1;
+			memcpy (w->buf, sd, hdrlen);
+			for ( ; k < c->nkeys; k++ )	/* there may be keys with the same tag */
+				if ( c->key[k].algo == sd[2] && c->key[k].tag == zs_get16 (sd + 16) &&
+				     (ret = verify (w, k, w->buf, need, sd + hdrlen, sig->rdlen - hdrlen)) != 0 )
+					break;
+			if ( ret < 0 )
+				return -1;
+			w->sigs++;
+		}
+		expire = zs_get32 (sd + 8);
+		incept = zs_get32 (sd + 12);
+
+		ctx_lock (c);
+		if ( ret <= 0 )
+			verror (c, "%s %s: bad signature of key %d", zs_dname2str (rr->owner, name, sizeof (name)),
+								zs_type2str (rr->type), zs_get16 (sd + 16));
+		else if ( expire < c->minexpire )
+			verror (c, "%s %s: signature of key %d expires at %s", zs_dname2str (rr->owner, name, sizeof (name)),
+								zs_type2str (rr->type), c->key[k].tag, time2str (expire, 's'));
+		else if ( incept > c->now )
+			verror (c, "%s %s: signature of key %d not valid before %s", zs_dname2str (rr->owner, name, sizeof (name)),
+								zs_type2str (rr->type), c->key[k].tag, time2str (incept, 's'));
+		ctx_unlock (c);
+		if ( ret <= 0 )
+			continue;
+
+		found[k] = 1;
+		if ( (c->key[k].flags & DK_FLAG_KSK) && !(c->key[k].flags & DK_FLAG_REVOKE) )
+			kskok = 1;
+	}
+
+	ctx_lock (c);
+	for ( i = 0; i < c->nalg; i++ )
+	{
+		for ( k = 0; k < c->nkeys; k++ )
+			if ( found[k] && c->key[k].algo == c->alg[i] )
+				break;
+		if ( k >= c->nkeys )
+			verror (c, "%s %s: no valid signature of algorithm %s", zs_dname2str (rr->owner, name, sizeof (name)),
+								zs_type2str (rr->type), dki_algo2str (c->alg[i]));
+	}
+	if ( !kskok )
+		verror (c, "%s DNSKEY: not signed by a KSK", zs_dname2str (rr->owner, name, sizeof (name)));
+	ctx_unlock (c);
+
+	return 0;
+}
+
+/*****************************************************************
+**	vworker (arg)
+**	verify rrsets until the job list is empty
+*****************************************************************/
+static	void	*vworker (void *arg)
+{
+	zsworker_t	*w;
+	zsctx_t	*c;
+	long	i;
+	long	end;
+
+	w = (zsworker_t *)arg;
+	c = w->ctx;
+	for (;;)
+	{
+		ctx_lock (c);
+		i = c->error ? c->njobs: c->next;
+		c->next += ZSIGN_SHARD;
+		ctx_unlock (c);
+		if ( i >= c->njobs )
+			break;
+
+		end = i + ZSIGN_SHARD < c->njobs ? i + ZSIGN_SHARD: c->njobs;
+		for ( ; i < end; i++ )
+			if ( vrrset (w, &c->job[i]) < 0 )
+			{
+				ctx_lock (c);
+				if ( !c->error )
+					sslerror ("verification failed");
+				c->error = 1;
+				ctx_unlock (c);
+				return NULL;
+			}
+	}
+
+	return NULL;
+}
+
+/*****************************************************************
+**	setserial (rr)
+**	set the SOA serial to the current time (as with
+**	"dnssec-signzone -N unixtime")
+*****************************************************************/
+static	void	setserial (rr_t *rr)
+{
+	ulong	serial;
+	ulong	now;
+	uchar	*p;
+
+	p = rr->rdata + rr->rdlen - 20;
+	serial = zs_get32 (p);
+	now = (ulong)time (NULL);
+	if ( now > serial )
+		serial = now;
+	else
+		serial = (serial + 1) & 0xFFFFFFFFUL;
+	zs_put32 (p, serial);
+}
+
+/*****************************************************************
+**	numthreads (conf)
+*****************************************************************/
+static	int	numthreads (const zconf_t *conf)
+{
+	long	n;
+
+	n = conf->sig_threads;
+#if defined(HAVE_LIBPTHREAD) && HAVE_LIBPTHREAD
+	if ( n <= 0 )
+		n = sysconf (_SC_NPROCESSORS_ONLN);
+#else
+	n = 1;
+#endif
+	if ( n < 1 )
+		n = 1;
+	if ( n > ZSIGN_MAXTHREADS )
+		n = ZSIGN_MAXTHREADS;
+	return n;
+}
+#endif
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	zsign_geterrstr ()
+*****************************************************************/
+const	char	*zsign_geterrstr ()
+{
+	return zsign_estr;
+}
+
+/*****************************************************************
+**	zsign_supported (zp)
+**	returns 1 if the built-in signer could be used for the zone
+*****************************************************************/
+int	zsign_supported (const zone_t *zp)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	assert (zp != NULL);
+	return zp->conf->sig_builtin;
+#else
+	return 0;
+#endif
+}
+
+/*****************************************************************
+**	zsign (zp, salt, refresh, outfile, stats)
+**	sign the zone file of the zone with the active keys and write
+**	the signed zone file, or outfile (relative to the zone
+**	directory) if not NULL. If salt is not NULL (use "-" for an
+**	empty salt) the zone will be signed with NSEC3.
+**	If refresh is not 0, the signatures of the previous signed
+**	zone file which expire after refresh are reused for unchanged
+**	rrsets (incremental signing).
+**	returns ZS_OK, ZS_ERROR or ZS_UNSUPPORTED (use dnssec-signzone)
+*****************************************************************/
+int	zsign (const zone_t *zp, const char *salt, time_t refresh, const char *outfile, zsign_stats_t *stats)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	char	tmppath[MAX_PATHSIZE+4+1];
+	zsctx_t	c;
+	zstore_t	*prev;
+	zsworker_t	w[ZSIGN_MAXTHREADS];
+	const	zconf_t	*conf;
+	const	rr_t	*soa;
+	node_t	*nodes;
+	ulong	ttl;
+	long	nn;
+	long	cnt;
+	long	i;
+	int	nthreads;
+	int	ret;
+
+	assert (zp != NULL);
+	assert (stats != NULL);
+
+	conf = zp->conf;
+	memset (stats, 0, sizeof (*stats));
+	memset (&c, 0, sizeof (c));
+	memset (w, 0, sizeof (w));
+	zsign_estr[0] = '\0';
+	nodes = NULL;
+	prev = NULL;
+	nthreads = 0;
+
+	ret = ZS_ERROR;
+	if ( (c.zs = zs_new (zp->zone)) == NULL )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "invalid zone name");
+		return ZS_ERROR;
+	}
+	if ( (ret = zs_readfile (c.zs, zp->dir, zp->file)) != ZS_OK )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "%s", zs_geterrstr ());
+		goto out;
+	}
+	ret = ZS_ERROR;
+	dropsigs (c.zs);
+	zs_sort (c.zs);
+	if ( (nn = classify (c.zs, &nodes)) < 0 )
+		goto out;
+	if ( conf->sig_gends && readdssets (zp, c.zs, nodes, nn) > 0 )
+	{
+		zs_sort (c.zs);
+		if ( (nn = classify (c.zs, &nodes)) < 0 )
+			goto out;
+	}
+
+	if ( (i = findrr (c.zs, &nodes[0], ZS_T_SOA)) < 0 || c.zs->rr[i].rdlen < 22 )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "no SOA record at the zone apex");
+		goto out;
+	}
+	soa = &c.zs->rr[i];
+	if ( conf->serialform == Unixtime )
+		setserial (&c.zs->rr[i]);
+	ttl = zs_get32 (soa->rdata + soa->rdlen - 4);	/* NSEC TTL (RFC 9077) */
+	if ( soa->ttl < ttl )
+		ttl = soa->ttl;
+
+	if ( (ret = loadkeys (&c, zp, &nodes[0])) < 0 )
+		goto out;
+	ret = ZS_ERROR;
+
+	if ( refresh > 0 )	/* read the previous signed zone */
+	{
+		if ( (prev = zs_new (zp->zone)) == NULL )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+			goto out;
+		}
+		if ( zs_readfile (prev, zp->dir, zp->sfile) != ZS_OK )
+		{
+			lg_mesg (LG_INFO, "\"%s\": can't reuse signatures: %s", zp->zone, zs_geterrstr ());
+			zs_free (prev);
+			prev = NULL;
+		}
+		else
+			zs_sort (prev);
+	}
+
+	if ( salt )
+		cnt = mknsec3 (c.zs, nodes, nn, ttl, salt, ZSIGN_NSEC3ITER, conf->nsec3 == NSEC3_OPTOUT);
+	else
+		cnt = mknsec (c.zs, nodes, nn, ttl);
+	if ( cnt < 0 )
+	{
+		if ( zsign_estr[0] == '\0' )
+			snprintf (zsign_estr, sizeof (zsign_estr), "can't create the NSEC%s chain", salt ? "3": "");
+		goto out;
+	}
+	stats->nsec = cnt;
+	zs_sort (c.zs);
+	if ( (nn = classify (c.zs, &nodes)) < 0 || mkjobs (&c, nodes, nn, conf->sig_dnskeyksk) < 0 )
+		goto out;
+
+	c.inception = (ulong)time (NULL) - ZSIGN_INCEPTION;
+	c.expiration = (ulong)time (NULL) + conf->sigvalidity;
+	c.jitter = conf->resign_jitter;
+	if ( c.jitter >= conf->sigvalidity )
+		c.jitter = 0;
+
+	cnt = c.njobs;
+	if ( prev )
+	{
+		if ( (stats->reused = reusesigs (&c, prev, (ulong)refresh)) < 0 )
+			goto out;
+		for ( cnt = i = 0; i < c.njobs; i++ )
+			if ( c.job[i].sig == NULL )
+				cnt++;
+	}
+
+	if ( mkshards (&c) < 0 )
+		goto out;
+	nthreads = numthreads (conf);
+	if ( nthreads > cnt / ZSIGN_SHARD + 1 )
+		nthreads = cnt / ZSIGN_SHARD + 1;
+	for ( i = 0; i < nthreads; i++ )
+	{
+		w[i].ctx = &c;
+		if ( (w[i].mem = zs_new (NULL)) == NULL || (w[i].mdctx = EVP_MD_CTX_new ()) == NULL )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+			nthreads = i + 1;
+			goto out;
+		}
+	}
+	if ( outfile == NULL )
+		outfile = zp->sfile;
+	if ( (ret = openzone (zp, outfile, &c, tmppath, sizeof (tmppath))) != ZS_OK )
+		goto out;
+	c.window = ZSIGN_WINDOW * nthreads;
+	stats->threads = runworkers (&c, w, nthreads, worker);
+
+	stats->rr = c.zs->nrr;
+	for ( i = 0; i < c.njobs; i++ )
+		stats->rr += c.job[i].nsig;
+	if ( (ret = closezone (zp, outfile, &c, tmppath, stats->rr)) == ZS_OK )
+	{
+		stats->rrsets = cnt;
+		stats->keys = c.nkeys;
+		for ( i = 0; i < nthreads; i++ )
+			stats->sigs += w[i].sigs;
+	}
+
+out:
+	for ( i = 0; i < nthreads; i++ )
+	{
+		int	k;
+
+		zs_free (w[i].mem);
+		EVP_MD_CTX_free (w[i].mdctx);
+		for ( k = 0; k < c.nkeys; k++ )
+			EVP_MD_CTX_free (w[i].keyctx[k]);
+		free (w[i].buf);
+	}
+	for ( i = 0; i < c.nkeys; i++ )
+		EVP_PKEY_free (c.key[i].pkey);
+	if ( c.out )
+	{
+		fclose (c.out);
+		unlink (tmppath);
+	}
+	for ( i = 0; i < c.nshards; i++ )
+		free (c.shard[i].buf);
+	free (c.shard);
+	free (c.job);
+	free (nodes);
+	zs_free (prev);
+	zs_free (c.zs);
+
+	return ret;
+#else
+	snprintf (zsign_estr, sizeof (zsign_estr), "compiled without libcrypto");
+	return ZS_UNSUPPORTED;
+#endif
+}
+
+/*****************************************************************
+**	zsign_verify (zp, file, minexpire, stats)
+**	check the signed zone file of the zone (or file, relative to
+**	the zone directory, if not NULL): the NSEC or NSEC3
+**	chain has to match the zone data, each rrset has to be signed
+**	by all algorithms of the DNSKEY rrset with valid signatures,
+**	the DNSKEY rrset has to be signed by a KSK and no signature
+**	should expire before minexpire.
+**	returns ZS_OK, ZS_ERROR (zone not valid or error) or
+**	ZS_UNSUPPORTED (the zone could not be verified)
+*****************************************************************/
+int	zsign_verify (const zone_t *zp, const char *file, time_t minexpire, zsign_stats_t *stats)
+{
+#if defined(HAVE_LIBCRYPTO) && HAVE_LIBCRYPTO
+	zsctx_t	c;
+	zsworker_t	w[ZSIGN_MAXTHREADS];
+	node_t	*nodes;
+	rr_t	*sig;
+	rr_t	*chain;
+	long	nsig;
+	long	nchain;
+	long	nn;
+	long	i;
+	int	nthreads;
+	int	ret;
+
+	assert (zp != NULL);
+	assert (stats != NULL);
+
+	memset (stats, 0, sizeof (*stats));
+	memset (&c, 0, sizeof (c));
+	memset (w, 0, sizeof (w));
+	zsign_estr[0] = '\0';
+	nodes = NULL;
+	sig = chain = NULL;
+	nthreads = 0;
+	c.zone = zp->zone;
+	c.now = (ulong)time (NULL);
+	c.minexpire = (ulong)minexpire;
+
+	if ( (c.zs = zs_new (zp->zone)) == NULL )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "invalid zone name");
+		return ZS_ERROR;
+	}
+	if ( (ret = zs_readfile (c.zs, zp->dir, file ? file: zp->sfile)) != ZS_OK )
+	{
+		snprintf (zsign_estr, sizeof (zsign_estr), "%s", zs_geterrstr ());
+		goto out;
+	}
+	zs_sort (c.zs);
+	if ( (ret = splitsigs (c.zs, &sig, &nsig, &chain, &nchain)) < 0 )
+		goto out;
+	ret = ZS_ERROR;
+	if ( (nn = classify (c.zs, &nodes)) < 0 )
+		goto out;
+	if ( (ret = checkchain (&c, nodes, nn, chain, nchain)) < 0 )
+		goto out;
+
+	/* put the chain of the signed zone back and check all signatures */
+	ret = ZS_ERROR;
+	for ( i = 0; i < nchain; i++ )
+		if ( zs_add (c.zs, chain[i].owner, chain[i].type, chain[i].ttl, chain[i].rdata, chain[i].rdlen) == NULL )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+			goto out;
+		}
+	zs_sort (c.zs);
+	if ( (nn = classify (c.zs, &nodes)) < 0 || mkjobs (&c, nodes, nn, 0) < 0 )
+		goto out;
+	if ( (ret = dnskeys (&c, &nodes[0])) < 0 )
+		goto out;
+	ret = ZS_ERROR;
+	c.rrsig = sig;
+	mapsigs (&c, sig, nsig);
+
+	nthreads = numthreads (zp->conf);
+	if ( nthreads > c.njobs / ZSIGN_SHARD + 1 )
+		nthreads = c.njobs / ZSIGN_SHARD + 1;
+	for ( i = 0; i < nthreads; i++ )
+	{
+		w[i].ctx = &c;
+		if ( (w[i].mdctx = EVP_MD_CTX_new ()) == NULL )
+		{
+			snprintf (zsign_estr, sizeof (zsign_estr), "out of memory");
+			nthreads = i + 1;
+			goto out;
+		}
+	}
+	stats->threads = runworkers (&c, w, nthreads, vworker);
+	if ( c.error )
+		goto out;
+
+	stats->rr = c.zs->nrr + nsig;
+	stats->rrsets = c.njobs;
+	stats->nsec = nchain;
+	stats->keys = c.nkeys;
+	stats->errors = c.nerr;
+	for ( i = 0; i < nthreads; i++ )
+		stats->sigs += w[i].sigs;
+	if ( c.nerr > 0 )
+		snprintf (zsign_estr, sizeof (zsign_estr), "%ld error%s (%.200s)", c.nerr, c.nerr > 1 ? "s": "", c.errmsg);
+	else
+		ret = ZS_OK;
+
+out:
+	for ( i = 0; i < nthreads; i++ )
+	{
+		int	k;
+
+		EVP_MD_CTX_free (w[i].mdctx);
+		for ( k = 0; k < c.nkeys; k++ )
+			EVP_MD_CTX_free (w[i].keyctx[k]);
+		free (w[i].buf);
+	}
+	for ( i = 0; i < c.nkeys; i++ )
+		EVP_PKEY_free (c.key[i].pkey);
+	free (c.job);
+	free (nodes);
+	free (sig);
+	free (chain);
+	zs_free (c.zs);
+
+	return ret;
+#else
+	snprintf (zsign_estr, sizeof (zsign_estr), "compiled without libcrypto");
+	return ZS_UNSUPPORTED;
+#endif
+}
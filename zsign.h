@@ -0,0 +1,61 @@
+/*****************************************************************
+**
+**	@(#) zsign.h -- built-in zone signer
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+#ifndef ZSIGN_H
+# define ZSIGN_H
+
+# define	ZSIGN_MAXKEYS	32	/* max number of signing keys */
+# define	ZSIGN_MAXTHREADS	64
+# define	ZSIGN_INCEPTION	(HOURSEC)	/* backdating of signature inception */
+# define	ZSIGN_NSEC3ITER	0	/* NSEC3 iterations (RFC 9276) */
+# define	ZSIGN_REFRESH	(HOURSEC)	/* min. remaining time to the re-signing of a reused signature */
+
+typedef	struct	zsign_stats {
+	long	rr;		/* number of records in the signed zone */
+	long	rrsets;		/* number of signed rrsets */
+	long	sigs;		/* number of created signatures */
+	long	reused;		/* number of signatures taken from the signed zone */
+	long	nsec;		/* number of NSEC or NSEC3 records */
+	long	errors;		/* number of verification errors */
+	int	keys;		/* number of signing keys */
+	int	threads;	/* number of signing threads */
+} zsign_stats_t;
+
+extern	const	char	*zsign_geterrstr (void);
+extern	int	zsign_supported (const zone_t *zp);
+extern	int	zsign (const zone_t *zp, const char *salt, time_t refresh, const char *outfile, zsign_stats_t *stats);
+extern	int	zsign_verify (const zone_t *zp, const char *file, time_t minexpire, zsign_stats_t *stats);
+#endif
@@ -0,0 +1,1762 @@
+/*****************************************************************
+**
+**	@(#) zstore.c -- in-memory store of resource records
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+# include <stdio.h>
+# include <string.h>
+# include <stdlib.h>
+# include <ctype.h>
+# include <errno.h>
+# include <time.h>
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <assert.h>
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+# include "config_zkt.h"
+# include "debug.h"
+# include "misc.h"
+# include "dki.h"
+#define	extern
+# include "zstore.h"
+#undef	extern
+
+/*****************************************************************
+**	The zone store keeps all resource records of a zone in one
+**	array. Domain names and rdata are allocated in large memory
+**	chunks which are freed all at once by zs_free().
+**
+**	The zone file reader understands the master file format of
+**	RFC 1035 ($ORIGIN, $TTL, $INCLUDE, parentheses, comments,
+**	omitted owner, ttl and class) and the generic rdata format
+**	of RFC 3597. The rdata of the known types is parsed with the
+**	help of a format string; each character describes one field:
+**
+**	d  domain name (converted to lowercase, RFC 4034 6.2)
+**	N  domain name (case preserved, e.g. the next name of NSEC)
+**	b  8 bit number		s  16 bit number	l  32 bit number or ttl
+**	a  IPv4 address		A  IPv6 address		y  rr type
+**	e  time (YYYYMMDDHHmmSS or seconds since 1970)
+**	t  character string	k  unquoted character string
+**	T  one or more character strings until end of record
+**	Q  quoted string without length byte until end of record
+**	B  base64 until end of record
+**	X  hex until end of record
+**	x  hex with length byte ("-" for the empty string)
+**	H  base32hex with length byte
+**	M  type bitmap until end of record
+**
+**	Files with other record types, classes or the $GENERATE
+**	directive are rejected with ZS_UNSUPPORTED.
+*****************************************************************/
+# define	ZS_CHUNKSIZE	(1024 * 1024)
+# define	ZS_MAXTOKEN	(64 * 1024)
+
+typedef	struct	zsmem {
+	struct	zsmem	*next;
+	size_t	size;
+	size_t	used;
+	uchar	data[];
+} zsmem_t;
+
+typedef	struct	{
+	ushort	type;
+	const	char	*name;
+	const	char	*fmt;
+} zstype_t;
+
+static	const	zstype_t	types[] = {
+	{ 1,	"A",		"a" },
+	{ 2,	"NS",		"d" },
+	{ 5,	"CNAME",	"d" },
+	{ 6,	"SOA",		"ddlllll" },
+	{ 12,	"PTR",		"d" },
+	{ 13,	"HINFO",	"tt" },
+	{ 15,	"MX",		"sd" },
+	{ 16,	"TXT",		"T" },
+	{ 17,	"RP",		"dd" },
+	{ 18,	"AFSDB",	"sd" },
+	{ 28,	"AAAA",		"A" },
+	{ 33,	"SRV",		"sssd" },
+	{ 35,	"NAPTR",	"sstttd" },
+	{ 36,	"KX",		"sd" },
+	{ 39,	"DNAME",	"d" },
+	{ 43,	"DS",		"sbbX" },
+	{ 44,	"SSHFP",	"bbX" },
+	{ 46,	"RRSIG",	"ybbleesdB" },
+	{ 47,	"NSEC",		"NM" },
+	{ 48,	"DNSKEY",	"sbbB" },
+	{ 49,	"DHCID",	"B" },
+	{ 50,	"NSEC3",	"bbsxHM" },
+	{ 51,	"NSEC3PARAM",	"bbsx" },
+	{ 52,	"TLSA",		"bbbX" },
+	{ 53,	"SMIMEA",	"bbbX" },
+	{ 59,	"CDS",		"sbbX" },
+	{ 60,	"CDNSKEY",	"sbbB" },
+	{ 61,	"OPENPGPKEY",	"B" },
+	{ 63,	"ZONEMD",	"lbbX" },
+	{ 99,	"SPF",		"T" },
+	{ 256,	"URI",		"ssQ" },
+	{ 257,	"CAA",		"bkQ" },
+	{ 0,	NULL,		NULL },
+};
+
+/* state of one (included) zone file */
+typedef	struct	{
+	FILE	*fp;
+	const	char	*fname;
+	int	line;
+	int	paren;		/* nesting level of parentheses */
+	int	bol;		/* at begin of line */
+} zsfile_t;
+
+/* tokens of one entry */
+# define	ZS_MAXTOKENS	(4 * 1024)
+typedef	struct	{
+	char	*buf;
+	size_t	used;
+	size_t	size;
+	int	n;
+	int	off[ZS_MAXTOKENS];
+	char	quoted[ZS_MAXTOKENS];
+	int	leadws;		/* entry starts with white space */
+} zstok_t;
+
+/* parser state */
+typedef	struct	{
+	zstore_t	*zs;
+	const	char	*dir;
+	const	dname_t	*origin;
+	const	dname_t	*owner;
+	long	defttl;		/* $TTL (-1 if not set) */
+	long	lastttl;	/* last explicit ttl (-1 if not set) */
+	int	depth;
+	int	stream;		/* sequential reader (no $INCLUDE) */
+	zstok_t	tok;
+} zsparse_t;
+
+/* sequential reader: the records of one owner name at a time */
+struct	zsreader {
+	zsparse_t	p;
+	zsfile_t	f;
+	char	path[MAX_PATHSIZE+1];
+	int	eof;
+	int	havenext;	/* first record of the next name is pending */
+	rr_t	next;
+	uchar	rdata[ZS_MAXRDATA];
+	uchar	nextrdata[ZS_MAXRDATA];
+};
+
+# define	TOK_ERR		(-1)
+# define	TOK_EOF		0
+# define	TOK_EOL		1
+# define	TOK_WORD	2
+
+static	char	zs_estr[255+1];
+
+static	const	char	b64chr[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static	const	char	b32chr[] = "0123456789ABCDEFGHIJKLMNOPQRSTUV";
+
+/*****************************************************************
+**	private (static) function definition
+*****************************************************************/
+
+/*****************************************************************
+**	parseerr (f, ret, mesg, tok)
+**	set the error string and return ret
+*****************************************************************/
+static	int	parseerr (const zsfile_t *f, int ret, const char *mesg, const char *tok)
+{
+	if ( f )
+		snprintf (zs_estr, sizeof (zs_estr), "%s:%d: %s%s%.64s%s", f->fname, f->line,
+						mesg, tok ? " \"": "", tok ? tok: "", tok ? "\"": "");
+	else
+		snprintf (zs_estr, sizeof (zs_estr), "%s%s%.64s%s", mesg, tok ? " \"": "", tok ? tok: "", tok ? "\"": "");
+	return ret;
+}
+
+/*****************************************************************
+**	findtype (type)
+*****************************************************************/
+static	const	zstype_t	*findtype (int type)
+{
+	int	i;
+
+	for ( i = 0; types[i].name; i++ )
+		if ( types[i].type == type )
+			return &types[i];
+	return NULL;
+}
+
+/*****************************************************************
+**	mkkey (wire, labels, key)
+**	build the canonical sort key of a wire format name
+*****************************************************************/
+static	int	mkkey (const uchar *wire, int labels, uchar *key)
+{
+	const	uchar	*lab[128];
+	const	uchar	*p;
+	int	keylen;
+	int	i;
+	int	j;
+
+	for ( i = 0, p = wire; *p; p += *p + 1 )
+		lab[i++] = p;
+	keylen = 0;
+	while ( --i >= 0 )
+	{
+		for ( j = 1; j <= *lab[i]; j++ )
+		{
+			if ( lab[i][j] <= 1 )
+			{
+				key[keylen++] = 1;
+				key[keylen++] = lab[i][j] + 1;
+			}
+			else
+				key[keylen++] = lab[i][j];
+		}
+		key[keylen++] = 0;
+	}
+	return keylen;
+}
+
+/*****************************************************************
+**	str2num (str, max, pval)
+**	convert a decimal number
+*****************************************************************/
+static	int	str2num (const char *str, ulong max, ulong *pval)
+{
+	ulong	val;
+
+	if ( !isdigit (*str) )
+		return -1;
+	for ( val = 0; isdigit (*str); str++ )
+	{
+		val = val * 10 + (*str - '0');
+		if ( val > max )
+			return -1;
+	}
+	if ( *str )
+		return -1;
+	*pval = val;
+	return 0;
+}
+
+/*****************************************************************
+**	str2ttl (str, pval)
+**	convert a ttl value with optional units (1w2d3h4m5s)
+*****************************************************************/
+static	int	str2ttl (const char *str, ulong *pval)
+{
+	unsigned long long	val;
+	unsigned long long	sum;
+
+	if ( !isdigit (*str) )
+		return -1;
+	sum = val = 0;
+	for ( ; *str; str++ )
+	{
+		if ( isdigit (*str) )
+		{
+			val = val * 10 + (*str - '0');
+			if ( val > 0xFFFFFFFFULL )
+				return -1;
+			continue;
+		}
+		switch ( tolower (*str) )
+		{
+		case 'w':	val *= WEEKSEC;	break;
+		case 'd':	val *= DAYSEC;	break;
+		case 'h':	val *= HOURSEC;	break;
+		case 'm':	val *= MINSEC;	break;
+		case 's':			break;
+		default:	return -1;
+		}
+		if ( !isdigit (str[-1]) )
+			return -1;
+		sum += val;
+		val = 0;
+	}
+	sum += val;
+	if ( sum > 0xFFFFFFFFULL )
+		return -1;
+	*pval = sum;
+	return 0;
+}
+
+/*****************************************************************
+**	str2time (str, pval)
+**	convert a signature time (YYYYMMDDHHmmSS or seconds)
+*****************************************************************/
+static	int	str2time (const char *str, ulong *pval)
+{
+	time_t	sec;
+
+	if ( strlen (str) == 14 && strspn (str, "0123456789") == 14 )
+	{
+		if ( (sec = timestr2time (str)) == 0L )
+			return -1;
+		*pval = (ulong)sec & 0xFFFFFFFFUL;
+		return 0;
+	}
+	return str2num (str, 0xFFFFFFFFUL, pval);
+}
+
+/*****************************************************************
+**	unescape (str, buf, size)
+**	decode the escape sequences (\c and \DDD) of a string
+**	returns the number of bytes or -1 on error
+*****************************************************************/
+static	int	unescape (const char *str, uchar *buf, int size)
+{
+	int	len;
+	int	c;
+
+	for ( len = 0; *str; len++ )
+	{
+		c = (uchar)*str++;
+		if ( c == '\\' )
+		{
+			if ( isdigit (str[0]) && isdigit (str[1]) && isdigit (str[2]) )
+			{
+				c = (str[0] - '0') * 100 + (str[1] - '0') * 10 + (str[2] - '0');
+				if ( c > 255 )
+					return -1;
+				str += 3;
+			}
+			else if ( *str )
+				c = (uchar)*str++;
+			else
+				return -1;
+		}
+		if ( len >= size )
+			return -1;
+		buf[len] = c;
+	}
+	return len;
+}
+
+/*****************************************************************
+**	decoder of base64, base32hex and hex strings
+**	return the number of bytes or -1 on error
+*****************************************************************/
+static	int	unbase64 (const char *str, uchar *buf, int size)
+{
+	const	char	*p;
+	ulong	acc;
+	int	bits;
+	int	len;
+	int	pad;
+
+	acc = 0;
+	len = bits = pad = 0;
+	for ( ; *str; str++ )
+	{
+		if ( *str == '=' )
+		{
+			pad++;
+			continue;
+		}
+		if ( pad || (p = strchr (b64chr, *str)) == NULL )
+			return -1;
+		acc = (acc << 6) | (p - b64chr);
+		if ( (bits += 6) >= 8 )
+		{
+			bits -= 8;
+			if ( len >= size )
+				return -1;
+			buf[len++] = (acc >> bits) & 0xFF;
+		}
+	}
+	return len;
+}
+
+static	int	unbase32hex (const char *str, uchar *buf, int size)
+{
+	const	char	*p;
+	ulong	acc;
+	int	bits;
+	int	len;
+
+	acc = 0;
+	len = bits = 0;
+	for ( ; *str && *str != '='; str++ )
+	{
+		if ( (p = strchr (b32chr, toupper (*str))) == NULL )
+			return -1;
+		acc = (acc << 5) | (p - b32chr);
+		if ( (bits += 5) >= 8 )
+		{
+			bits -= 8;
+			if ( len >= size )
+				return -1;
+			buf[len++] = (acc >> bits) & 0xFF;
+		}
+	}
+	return len;
+}
+
+static	int	unhex (const char *str, uchar *buf, int size)
+{
+	int	len;
+	int	hi;
+	int	lo;
+
+	if ( strlen (str) % 2 )
+		return -1;
+	for ( len = 0; *str; str += 2 )
+	{
+		if ( !isxdigit (str[0]) || !isxdigit (str[1]) || len >= size )
+			return -1;
+		hi = isdigit (str[0]) ? str[0] - '0': tolower (str[0]) - 'a' + 10;
+		lo = isdigit (str[1]) ? str[1] - '0': tolower (str[1]) - 'a' + 10;
+		buf[len++] = hi << 4 | lo;
+	}
+	return len;
+}
+
+/*****************************************************************
+**	encoder of base64, base32hex and hex strings
+*****************************************************************/
+static	void	prt_base64 (FILE *fp, const uchar *p, int len)
+{
+	char	buf[4+1];
+	ulong	acc;
+	int	i;
+
+	buf[4] = '\0';
+	for ( ; len > 0; p += 3, len -= 3 )
+	{
+		acc = (ulong)p[0] << 16;
+		if ( len > 1 )
+			acc |= p[1] << 8;
+		if ( len > 2 )
+			acc |= p[2];
+		for ( i = 0; i < 4; i++ )
+			buf[i] = b64chr[(acc >> (18 - 6 * i)) & 0x3F];
+		if ( len < 3 )
+			buf[3] = '=';
+		if ( len < 2 )
+			buf[2] = '=';
+		fputs (buf, fp);
+	}
+}
+
+static	void	prt_base32hex (FILE *fp, const uchar *p, int len)
+{
+	ulong	acc;
+	int	bits;
+
+	acc = 0;
+	for ( bits = 0; len > 0; p++, len-- )
+	{
+		acc = (acc << 8) | *p;
+		for ( bits += 8; bits >= 5; bits -= 5 )
+			putc (b32chr[(acc >> (bits - 5)) & 0x1F], fp);
+	}
+	if ( bits > 0 )
+		putc (b32chr[(acc << (5 - bits)) & 0x1F], fp);
+}
+
+static	void	prt_hex (FILE *fp, const uchar *p, int len)
+{
+	while ( len-- > 0 )
+		fprintf (fp, "%02X", *p++);
+}
+
+/*****************************************************************
+**	prt_string (fp, p, len, quote)
+**	print a character string in presentation format
+*****************************************************************/
+static	void	prt_string (FILE *fp, const uchar *p, int len, int quote)
+{
+	if ( quote )
+		putc ('"', fp);
+	for ( ; len > 0; p++, len-- )
+	{
+		if ( *p < ' ' || *p > '~' )
+			fprintf (fp, "\\%03d", *p);
+		else if ( *p == '"' || *p == '\\' || (!quote && (*p == ' ' || *p == ';')) )
+			fprintf (fp, "\\%c", *p);
+		else
+			putc (*p, fp);
+	}
+	if ( quote )
+		putc ('"', fp);
+}
+
+/*****************************************************************
+**	prt_wirename (fp, wire)
+**	print a wire format domain name in presentation format
+*****************************************************************/
+static	void	prt_wirename (FILE *fp, const uchar *wire)
+{
+	int	i;
+
+	if ( *wire == 0 )
+	{
+		putc ('.', fp);
+		return;
+	}
+	for ( ; *wire; wire += *wire + 1 )
+	{
+		for ( i = 1; i <= *wire; i++ )
+		{
+			if ( wire[i] <= ' ' || wire[i] > '~' )
+				fprintf (fp, "\\%03d", wire[i]);
+			else if ( strchr (".\\\"()@$;", wire[i]) )
+				fprintf (fp, "\\%c", wire[i]);
+			else
+				putc (wire[i], fp);
+		}
+		putc ('.', fp);
+	}
+}
+
+/*****************************************************************
+**	fieldlen (f, p, len)
+**	returns the length of the rdata field described by the
+**	format character f or -1 if the rdata is malformed
+*****************************************************************/
+static	int	fieldlen (int f, const uchar *p, int len)
+{
+	int	n;
+	int	i;
+
+	i = 0;
+	switch ( f )
+	{
+	case 'd':
+	case 'N':	return zs_wirelen (p, len);
+	case 'b':	return len >= 1 ? 1: -1;
+	case 's':
+	case 'y':	return len >= 2 ? 2: -1;
+	case 'l':
+	case 'e':
+	case 'a':	return len >= 4 ? 4: -1;
+	case 'A':	return len >= 16 ? 16: -1;
+	case 't':
+	case 'k':
+	case 'x':
+	case 'H':	return (len >= 1 && len >= 1 + p[0]) ? 1 + p[0]: -1;
+	case 'T':
+		for ( n = 0; n < len; n += 1 + p[n] )
+			;
+		return (len > 0 && n == len) ? len: -1;
+	case 'M':
+		for ( n = 0; n < len; n += 2 + p[n+1] )
+			if ( n + 2 > len || p[n+1] < 1 || p[n+1] > 32 || (n > 0 && p[n] <= p[i]) )
+				return -1;
+			else
+				i = n;
+		return n == len ? len: -1;
+	}
+	return len;	/* B, X, Q */
+}
+
+/*****************************************************************
+**	checkrdata (fmt, rdata, rdlen)
+**	check if the rdata matches the format string
+*****************************************************************/
+static	int	checkrdata (const char *fmt, const uchar *rdata, int rdlen)
+{
+	int	n;
+
+	for ( ; *fmt; fmt++ )
+	{
+		if ( (n = fieldlen (*fmt, rdata, rdlen)) < 0 )
+			return 0;
+		if ( n == 0 && strchr ("BX", *fmt) )	/* required fields */
+			return 0;
+		rdata += n;
+		rdlen -= n;
+	}
+	return rdlen == 0;
+}
+
+/*****************************************************************
+**	gettoken (f, t)
+**	read the next token of the zone file and append it to t
+*****************************************************************/
+static	int	gettoken (zsfile_t *f, zstok_t *t)
+{
+	int	c;
+	int	ws;
+	int	bol;
+	int	quoted;
+	size_t	start;
+
+	ws = 0;
+	for (;;)
+	{
+		c = getc (f->fp);
+		if ( c == ';' )
+			while ( (c = getc (f->fp)) != EOF && c != '\n' )
+				;
+		if ( c == EOF )
+			return f->paren ? parseerr (f, TOK_ERR, "unbalanced parentheses", NULL): TOK_EOF;
+		if ( c == '\n' )
+		{
+			f->line++;
+			if ( f->paren == 0 )
+			{
+				f->bol = 1;
+				return TOK_EOL;
+			}
+		}
+		else if ( c == '(' )
+			f->paren++;
+		else if ( c == ')' )
+		{
+			if ( f->paren == 0 )
+				return parseerr (f, TOK_ERR, "unbalanced parentheses", NULL);
+			f->paren--;
+		}
+		else if ( !isspace (c) )
+			break;
+		ws = 1;
+	}
+
+	bol = f->bol;
+	f->bol = 0;
+	if ( t->n >= ZS_MAXTOKENS )
+		return parseerr (f, TOK_ERR, "too many tokens", NULL);
+	if ( t->n == 0 )
+		t->leadws = bol && ws;
+
+	quoted = (c == '"');
+	if ( quoted )
+		c = getc (f->fp);
+	start = t->used;
+	while ( c != EOF )
+	{
+		if ( quoted ? c == '"': (isspace (c) || c == ';' || c == '(' || c == ')' || c == '"') )
+			break;
+		if ( quoted && c == '\n' )
+			return parseerr (f, TOK_ERR, "newline in quoted string", NULL);
+		if ( t->used + 2 >= t->size )
+		{
+			if ( t->size >= ZS_MAXTOKEN * 4 )
+				return parseerr (f, TOK_ERR, "entry too long", NULL);
+			t->size = t->size ? t->size * 2: 4096;
+			if ( (t->buf = realloc (t->buf, t->size)) == NULL )
+				return parseerr (f, TOK_ERR, "out of memory", NULL);
+		}
+		t->buf[t->used++] = c;
+		if ( c == '\\' && (c = getc (f->fp)) != EOF )
+		{
+			if ( c == '\n' )
+				f->line++;
+			t->buf[t->used++] = c;
+		}
+		c = getc (f->fp);
+	}
+	if ( quoted && c != '"' )
+		return parseerr (f, TOK_ERR, "unterminated quoted string", NULL);
+	if ( !quoted && c != EOF )
+		ungetc (c, f->fp);
+
+	t->buf[t->used++] = '\0';
+	t->off[t->n] = start;
+	t->quoted[t->n] = quoted;
+	t->n++;
+
+	return TOK_WORD;
+}
+
+/*****************************************************************
+**	getentry (f, t)
+**	read all tokens of the next entry (line)
+**	returns the number of tokens, 0 on eof or -1 on error
+*****************************************************************/
+static	int	getentry (zsfile_t *f, zstok_t *t)
+{
+	int	ret;
+
+	do {
+		t->n = 0;
+		t->used = 0;
+		t->leadws = 0;
+		while ( (ret = gettoken (f, t)) == TOK_WORD )
+			;
+		if ( ret == TOK_ERR )
+			return -1;
+	} while ( t->n == 0 && ret != TOK_EOF );
+
+	return t->n;
+}
+
+# define	tok(t, i)	((t)->buf + (t)->off[i])
+
+/*****************************************************************
+**	parse_bitmap (t, i, buf, size)
+**	build the type bitmap of the tokens i .. n
+*****************************************************************/
+static	int	parse_bitmap (const zsfile_t *f, const zstok_t *t, int i, uchar *buf, int size)
+{
+	ushort	type[ZS_MAXTOKENS];
+	int	n;
+	int	len;
+
+	for ( n = 0; i < t->n; i++, n++ )
+		if ( (len = zs_str2type (tok (t, i))) < 0 )
+			return parseerr (f, ZS_UNSUPPORTED, "unknown type in bitmap", tok (t, i));
+		else
+			type[n] = len;
+
+	if ( (len = zs_mkbitmap (type, n, buf, size)) < 0 )
+		return parseerr (f, ZS_ERROR, "rdata too long", NULL);
+	return len;
+}
+
+/*****************************************************************
+**	parse_rdata (p, f, i, type, buf, size)
+**	convert the rdata in tokens i ... n into wire format
+**	returns the length of the rdata or ZS_ERROR/ZS_UNSUPPORTED
+*****************************************************************/
+static	int	parse_rdata (zsparse_t *p, const zsfile_t *f, int i, int type, uchar *buf, int size)
+{
+	const	zstype_t	*tp;
+	const	zstok_t	*t;
+	const	char	*fmt;
+	const	char	*s;
+	ulong	val;
+	int	len;
+	int	n;
+
+	t = &p->tok;
+	if ( i < t->n && !t->quoted[i] && strcmp (tok (t, i), "\\#") == 0 )	/* RFC 3597 */
+	{
+		if ( ++i >= t->n || str2num (tok (t, i), ZS_MAXRDATA, &val) < 0 )
+			return parseerr (f, ZS_ERROR, "invalid rdata length", i < t->n ? tok (t, i): NULL);
+		for ( len = 0, i++; i < t->n; i++, len += n )
+			if ( (n = unhex (tok (t, i), buf + len, size - len)) < 0 )
+				return parseerr (f, ZS_ERROR, "invalid hex data", tok (t, i));
+		if ( len != val )
+			return parseerr (f, ZS_ERROR, "rdata length mismatch", NULL);
+		return len;
+	}
+
+	if ( (tp = findtype (type)) == NULL )
+		return parseerr (f, ZS_UNSUPPORTED, "unsupported type", zs_type2str (type));
+
+	len = 0;
+	for ( fmt = tp->fmt; *fmt; fmt++ )
+	{
+		if ( i >= t->n && *fmt != 'M' )
+			return parseerr (f, ZS_ERROR, "missing rdata field", NULL);
+		s = i < t->n ? tok (t, i): "";
+		if ( len + 16 > size )
+			return parseerr (f, ZS_ERROR, "rdata too long", NULL);
+
+		switch ( *fmt )
+		{
+		case 'd':
+		case 'N':
+			if ( (n = zs_str2wire (s, p->origin, buf + len, *fmt == 'd')) < 0 )
+				return parseerr (f, ZS_ERROR, "invalid domain name", s);
+			len += n;
+			break;
+		case 'b':
+		case 's':
+			if ( str2num (s, *fmt == 'b' ? 0xFF: 0xFFFF, &val) < 0 )
+				return parseerr (f, isalpha (*s) ? ZS_UNSUPPORTED: ZS_ERROR, "invalid number", s);
+			if ( *fmt == 'b' )
+				buf[len++] = val;
+			else
+			{
+				zs_put16 (buf + len, val);
+				len += 2;
+			}
+			break;
+		case 'l':
+		case 'e':
+			if ( (*fmt == 'l' ? str2ttl (s, &val): str2time (s, &val)) < 0 )
+				return parseerr (f, ZS_ERROR, "invalid number", s);
+			zs_put32 (buf + len, val);
+			len += 4;
+			break;
+		case 'y':
+			if ( (n = zs_str2type (s)) < 0 )
+				return parseerr (f, ZS_UNSUPPORTED, "unknown type", s);
+			zs_put16 (buf + len, n);
+			len += 2;
+			break;
+		case 'a':
+		case 'A':
+			if ( inet_pton (*fmt == 'a' ? AF_INET: AF_INET6, s, buf + len) != 1 )
+				return parseerr (f, ZS_ERROR, "invalid address", s);
+			len += *fmt == 'a' ? 4: 16;
+			break;
+		case 't':
+		case 'k':
+		case 'T':
+			do {
+				if ( (n = unescape (tok (t, i), buf + len + 1, 255)) < 0 || len + 1 + n > size )
+					return parseerr (f, ZS_ERROR, "invalid character string", tok (t, i));
+				buf[len] = n;
+				len += 1 + n;
+			} while ( *fmt == 'T' && ++i < t->n );
+			break;
+		case 'Q':
+			if ( i + 1 != t->n || (n = unescape (s, buf + len, size - len)) < 0 )
+				return parseerr (f, ZS_ERROR, "invalid string", s);
+			len += n;
+			break;
+		case 'x':
+		case 'H':
+			n = 0;
+			if ( strcmp (s, "-") != 0 &&
+			     (n = (*fmt == 'x' ? unhex (s, buf + len + 1, 255): unbase32hex (s, buf + len + 1, 255))) <= 0 )
+				return parseerr (f, ZS_ERROR, *fmt == 'x' ? "invalid hex data": "invalid base32 data", s);
+			buf[len] = n;
+			len += 1 + n;
+			break;
+		case 'B':
+		case 'X':
+			for ( n = 0; i < t->n; i++, len += n )
+				if ( (n = (*fmt == 'B' ? unbase64 (tok (t, i), buf + len, size - len):
+							 unhex (tok (t, i), buf + len, size - len))) < 0 )
+					return parseerr (f, ZS_ERROR, *fmt == 'B' ? "invalid base64 data": "invalid hex data", tok (t, i));
+			i--;
+			break;
+		case 'M':
+			if ( (n = parse_bitmap (f, t, i, buf + len, size - len)) < 0 )
+				return n;
+			len += n;
+			i = t->n - 1;
+			break;
+		}
+		i++;
+	}
+	if ( i < t->n )
+		return parseerr (f, ZS_ERROR, "trailing garbage", tok (t, i));
+
+	return len;
+}
+
+static	int	readfile (zsparse_t *p, const char *fname);
+
+/*****************************************************************
+**	directive (p, f)
+**	process the $ORIGIN, $TTL and $INCLUDE directives
+*****************************************************************/
+static	int	directive (zsparse_t *p, zsfile_t *f)
+{
+	const	zstok_t	*t;
+	const	dname_t	*origin;
+	const	dname_t	*owner;
+	const	char	*d;
+	ulong	val;
+	int	ret;
+
+	t = &p->tok;
+	d = tok (t, 0);
+	if ( strcasecmp (d, "$TTL") == 0 )
+	{
+		if ( t->n != 2 || str2ttl (tok (t, 1), &val) < 0 )
+			return parseerr (f, ZS_ERROR, "invalid $TTL", NULL);
+		p->defttl = val;
+		return ZS_OK;
+	}
+	if ( strcasecmp (d, "$ORIGIN") == 0 )
+	{
+		if ( t->n != 2 || (origin = zs_str2dname (p->zs, tok (t, 1), p->origin)) == NULL )
+			return parseerr (f, ZS_ERROR, "invalid $ORIGIN", NULL);
+		p->origin = origin;
+		return ZS_OK;
+	}
+	if ( strcasecmp (d, "$INCLUDE") == 0 )
+	{
+		char	path[MAX_PATHSIZE+1];
+
+		if ( p->stream )
+			return parseerr (f, ZS_UNSUPPORTED, "$INCLUDE not supported by the sequential reader", NULL);
+		if ( t->n < 2 || t->n > 3 || p->depth >= ZS_MAXINCLUDE )
+			return parseerr (f, ZS_ERROR, "invalid $INCLUDE", NULL);
+		origin = p->origin;
+		owner = p->owner;
+		if ( t->n == 3 && (p->origin = zs_str2dname (p->zs, tok (t, 2), origin)) == NULL )
+			return parseerr (f, ZS_ERROR, "invalid $INCLUDE origin", tok (t, 2));
+		if ( *tok (t, 1) == '/' )
+			snprintf (path, sizeof (path), "%s", tok (t, 1));
+		else
+			pathname (path, sizeof (path), p->dir, tok (t, 1), NULL);
+		p->depth++;
+		ret = readfile (p, path);
+		p->depth--;
+		p->origin = origin;
+		p->owner = owner;
+		return ret;
+	}
+
+	return parseerr (f, ZS_UNSUPPORTED, "unsupported directive", d);
+}
+
+/*****************************************************************
+**	entry (p, f, rdata, size)
+**	process one resource record
+*****************************************************************/
+static	int	entry (zsparse_t *p, zsfile_t *f, uchar *rdata, int size)
+{
+	const	zstok_t	*t;
+	const	char	*s;
+	long	ttl;
+	ulong	val;
+	int	type;
+	int	i;
+	int	len;
+
+	t = &p->tok;
+	i = 0;
+	if ( !t->leadws )
+	{
+		s = tok (t, i++);
+		if ( (p->owner = zs_str2dname (p->zs, s, p->origin)) == NULL )
+			return parseerr (f, ZS_ERROR, "invalid owner name", s);
+	}
+	else if ( p->owner == NULL )
+		return parseerr (f, ZS_ERROR, "no owner name", NULL);
+
+	ttl = -1;
+	type = -1;
+	for ( ; type < 0 && i < t->n; i++ )
+	{
+		s = tok (t, i);
+		if ( ttl < 0 && isdigit (*s) )
+		{
+			if ( str2ttl (s, &val) < 0 )
+				return parseerr (f, ZS_ERROR, "invalid ttl", s);
+			ttl = val;
+		}
+		else if ( strcasecmp (s, "IN") == 0 )
+			;
+		else if ( strcasecmp (s, "CH") == 0 || strcasecmp (s, "HS") == 0 || strncasecmp (s, "CLASS", 5) == 0 )
+			return parseerr (f, ZS_UNSUPPORTED, "unsupported class", s);
+		else if ( (type = zs_str2type (s)) < 0 )
+			return parseerr (f, ZS_UNSUPPORTED, "unknown type", s);
+	}
+	if ( type < 0 )
+		return parseerr (f, ZS_ERROR, "missing type", NULL);
+
+	if ( (len = parse_rdata (p, f, i, type, rdata, size)) < 0 )
+		return len;
+
+	if ( ttl >= 0 )
+		p->lastttl = ttl;
+	else if ( p->defttl >= 0 )
+		ttl = p->defttl;
+	else if ( p->lastttl >= 0 )
+		ttl = p->lastttl;
+	else if ( type == ZS_T_SOA )		/* use the minimum field */
+		ttl = zs_get32 (rdata + len - 4);
+	else
+		return parseerr (f, ZS_ERROR, "no ttl specified", NULL);
+
+	if ( zs_add (p->zs, p->owner, type, ttl, rdata, len) == NULL )
+		return parseerr (f, ZS_ERROR, "out of memory", NULL);
+
+	return ZS_OK;
+}
+
+/*****************************************************************
+**	readfile (p, fname)
+*****************************************************************/
+static	int	readfile (zsparse_t *p, const char *fname)
+{
+	static	uchar	rdata[ZS_MAXRDATA];
+	zsfile_t	f;
+	int	ret;
+	int	n;
+
+	memset (&f, 0, sizeof (f));
+	f.fname = fname;
+	f.line = 1;
+	f.bol = 1;
+	if ( (f.fp = fopen (fname, "r")) == NULL )
+	{
+		snprintf (zs_estr, sizeof (zs_estr), "can't open \"%s\": %s", fname, strerror (errno));
+		return ZS_ERROR;
+	}
+
+	ret = ZS_OK;
+	while ( ret == ZS_OK && (n = getentry (&f, &p->tok)) != 0 )
+	{
+		if ( n < 0 )
+			ret = ZS_ERROR;
+		else if ( *tok (&p->tok, 0) == '$' && !p->tok.leadws )
+			ret = directive (p, &f);
+		else
+			ret = entry (p, &f, rdata, sizeof (rdata));
+	}
+	fclose (f.fp);
+
+	return ret;
+}
+
+/*****************************************************************
+**	zsreset (zs)
+**	remove all records and names of the zone store except the
+**	origin; one memory chunk is kept for reuse
+*****************************************************************/
+static	void	zsreset (zstore_t *zs)
+{
+	uchar	origin[ZS_MAXNAME];
+	zsmem_t	*m;
+
+	if ( zs->origin )
+		memcpy (origin, dname_wire (zs->origin), zs->origin->len);
+	while ( (m = zs->mem) != NULL && m->next != NULL )
+	{
+		zs->mem = m->next;
+		free (m);
+	}
+	if ( m )
+		m->used = 0;
+	zs->nrr = 0;
+	zs->sorted = 1;
+	zs->last = NULL;
+	if ( zs->origin )
+		zs->origin = zs_dname (zs, origin);
+}
+
+/*****************************************************************
+**	rrcmp_qsort (a, b)
+*****************************************************************/
+static	int	rrcmp_qsort (const void *a, const void *b)
+{
+	return zs_rrcmp ((const rr_t *)a, (const rr_t *)b);
+}
+
+/*****************************************************************
+**	public function definition
+*****************************************************************/
+
+/*****************************************************************
+**	zs_geterrstr ()
+*****************************************************************/
+const	char	*zs_geterrstr ()
+{
+	return zs_estr;
+}
+
+/*****************************************************************
+**	zs_new (origin)
+**	create a new (empty) zone store
+*****************************************************************/
+zstore_t	*zs_new (const char *origin)
+{
+	zstore_t	*zs;
+
+	if ( (zs = calloc (1, sizeof (zstore_t))) == NULL )
+		return NULL;
+	if ( origin && (zs->origin = zs_str2dname (zs, origin, NULL)) == NULL )
+	{
+		zs_free (zs);
+		return NULL;
+	}
+	zs->sorted = 1;
+	zs->defttl = -1;
+
+	return zs;
+}
+
+/*****************************************************************
+**	zs_free (zs)
+*****************************************************************/
+void	zs_free (zstore_t *zs)
+{
+	zsmem_t	*m;
+
+	if ( zs == NULL )
+		return;
+	while ( (m = zs->mem) != NULL )
+	{
+		zs->mem = m->next;
+		free (m);
+	}
+	free (zs->rr);
+	free (zs);
+}
+
+/*****************************************************************
+**	zs_alloc (zs, size)
+**	allocate memory which is freed by zs_free()
+*****************************************************************/
+void	*zs_alloc (zstore_t *zs, size_t size)
+{
+	zsmem_t	*m;
+	void	*p;
+
+	size = (size + 7) & ~(size_t)7;
+	if ( (m = zs->mem) == NULL || m->used + size > m->size )
+	{
+		size_t	chunk;
+
+		chunk = size > ZS_CHUNKSIZE / 4 ? size: ZS_CHUNKSIZE;
+		if ( (m = malloc (sizeof (zsmem_t) + chunk)) == NULL )
+			return NULL;
+		m->size = chunk;
+		m->used = 0;
+		if ( chunk == size && zs->mem )	/* keep the current chunk for small requests */
+		{
+			m->next = zs->mem->next;
+			zs->mem->next = m;
+		}
+		else
+		{
+			m->next = zs->mem;
+			zs->mem = m;
+		}
+	}
+	p = m->data + m->used;
+	m->used += size;
+
+	return p;
+}
+
+/*****************************************************************
+**	zs_wirelen (wire, size)
+**	returns the length of the wire format name or -1 if the
+**	name is invalid
+*****************************************************************/
+int	zs_wirelen (const uchar *wire, int size)
+{
+	int	len;
+
+	for ( len = 0; len < size && wire[len]; len += wire[len] + 1 )
+		if ( wire[len] > 63 )
+			return -1;
+	if ( len >= size || len + 1 > ZS_MAXNAME )
+		return -1;
+	return len + 1;
+}
+
+/*****************************************************************
+**	zs_str2wire (str, origin, wire, lower)
+**	convert a domain name in presentation format into wire
+**	format (relative names are completed with origin)
+**	returns the length of the name or -1 on error
+*****************************************************************/
+int	zs_str2wire (const char *str, const dname_t *origin, uchar *wire, int lower)
+{
+	int	len;
+	int	pos;
+	int	n;
+	int	c;
+
+	if ( strcmp (str, "@") == 0 )
+	{
+		if ( origin == NULL )
+			return -1;
+		memcpy (wire, dname_wire (origin), origin->len);
+		return origin->len;
+	}
+	if ( strcmp (str, ".") == 0 )
+	{
+		wire[0] = 0;
+		return 1;
+	}
+
+	len = 0;
+	while ( *str )
+	{
+		pos = len++;
+		for ( n = 0; *str && *str != '.'; n++ )
+		{
+			c = (uchar)*str++;
+			if ( c == '\\' )
+			{
+				if ( isdigit (str[0]) && isdigit (str[1]) && isdigit (str[2]) )
+				{
+					c = (str[0] - '0') * 100 + (str[1] - '0') * 10 + (str[2] - '0');
+					if ( c > 255 )
+						return -1;
+					str += 3;
+				}
+				else if ( *str )
+					c = (uchar)*str++;
+				else
+					return -1;
+			}
+			if ( lower && c >= 'A' && c <= 'Z' )
+				c += 'a' - 'A';
+			if ( n >= 63 || len >= ZS_MAXNAME - 1 )
+				return -1;
+			wire[len++] = c;
+		}
+		if ( n == 0 )
+			return -1;
+		wire[pos] = n;
+		if ( *str == '.' && *++str == '\0' )	/* absolute name */
+		{
+			wire[len++] = 0;
+			return len;
+		}
+	}
+
+	if ( origin == NULL || len + origin->len > ZS_MAXNAME )
+		return -1;
+	memcpy (wire + len, dname_wire (origin), origin->len);
+
+	return len + origin->len;
+}
+
+/*****************************************************************
+**	zs_dname (zs, wire)
+**	store the wire format name in the zone store
+*****************************************************************/
+const	dname_t	*zs_dname (zstore_t *zs, const uchar *wire)
+{
+	uchar	key[ZS_MAXKEY];
+	dname_t	*dn;
+	const	uchar	*p;
+	int	labels;
+	int	keylen;
+	int	len;
+
+	if ( (len = zs_wirelen (wire, ZS_MAXNAME)) < 0 )
+		return NULL;
+	if ( zs->last && zs->last->len == len && memcmp (dname_wire (zs->last), wire, len) == 0 )
+		return zs->last;
+
+	for ( labels = 0, p = wire; *p; p += *p + 1 )
+		labels++;
+	keylen = mkkey (wire, labels, key);
+
+	if ( (dn = zs_alloc (zs, sizeof (dname_t) + len + keylen)) == NULL )
+		return NULL;
+	dn->len = len;
+	dn->labels = labels;
+	dn->keylen = keylen;
+	memcpy (dn->data, wire, len);
+	memcpy (dn->data + len, key, keylen);
+	zs->last = dn;
+
+	return dn;
+}
+
+/*****************************************************************
+**	zs_str2dname (zs, str, origin)
+**	convert a presentation format name into a (lowercase)
+**	domain name of the zone store
+*****************************************************************/
+const	dname_t	*zs_str2dname (zstore_t *zs, const char *str, const dname_t *origin)
+{
+	uchar	wire[ZS_MAXNAME];
+
+	if ( zs_str2wire (str, origin, wire, 1) < 0 )
+		return NULL;
+	return zs_dname (zs, wire);
+}
+
+/*****************************************************************
+**	zs_dname2str (dn, buf, size)
+*****************************************************************/
+char	*zs_dname2str (const dname_t *dn, char *buf, size_t size)
+{
+	return zs_wire2str (dname_wire (dn), buf, size);
+}
+
+/*****************************************************************
+**	zs_wire2str (wire, buf, size)
+**	convert a wire format name (e.g. out of rdata) into
+**	presentation format
+*****************************************************************/
+char	*zs_wire2str (const uchar *wire, char *buf, size_t size)
+{
+	FILE	*fp;
+
+	buf[0] = '\0';
+	if ( (fp = fmemopen (buf, size, "w")) != NULL )
+	{
+		prt_wirename (fp, wire);
+		fclose (fp);
+	}
+	return buf;
+}
+
+/*****************************************************************
+**	zs_namecmp (a, b)
+**	compare two names in canonical order (RFC 4034 6.1)
+*****************************************************************/
+int	zs_namecmp (const dname_t *a, const dname_t *b)
+{
+	int	res;
+
+	if ( a == b )
+		return 0;
+	if ( (res = memcmp (dname_key (a), dname_key (b), a->keylen < b->keylen ? a->keylen: b->keylen)) != 0 )
+		return res;
+	return (int)a->keylen - (int)b->keylen;
+}
+
+/*****************************************************************
+**	zs_issubdomain (name, parent)
+**	returns 1 if name is equal to or below parent
+*****************************************************************/
+int	zs_issubdomain (const dname_t *name, const dname_t *parent)
+{
+	return name->keylen >= parent->keylen &&
+		memcmp (dname_key (name), dname_key (parent), parent->keylen) == 0;
+}
+
+/*****************************************************************
+**	zs_iswildcard (name)
+*****************************************************************/
+int	zs_iswildcard (const dname_t *name)
+{
+	return name->data[0] == 1 && name->data[1] == '*';
+}
+
+/*****************************************************************
+**	zs_add (zs, owner, type, ttl, rdata, rdlen)
+**	add a resource record to the zone store
+*****************************************************************/
+rr_t	*zs_add (zstore_t *zs, const dname_t *owner, int type, ulong ttl, const uchar *rdata, int rdlen)
+{
+	rr_t	*rr;
+
+	assert (zs != NULL);
+	if ( zs->nrr >= zs->maxrr )
+	{
+		long	max;
+
+		max = zs->maxrr ? zs->maxrr * 2: 1024;
+		if ( (rr = realloc (zs->rr, max * sizeof (rr_t))) == NULL )
+			return NULL;
+		zs->rr = rr;
+		zs->maxrr = max;
+	}
+
+	rr = &zs->rr[zs->nrr];
+	rr->owner = owner;
+	rr->ttl = ttl;
+	rr->type = type;
+	rr->rdlen = rdlen;
+	rr->rdata = NULL;
+	if ( rdlen > 0 && (rr->rdata = zs_alloc (zs, rdlen)) == NULL )
+		return NULL;
+	if ( rdlen > 0 )
+		memcpy (rr->rdata, rdata, rdlen);
+
+	if ( zs->sorted && zs->nrr > 0 && zs_rrcmp (rr - 1, rr) >= 0 )
+		zs->sorted = 0;
+	zs->nrr++;
+
+	return rr;
+}
+
+/*****************************************************************
+**	zs_readfile (zs, dir, file)
+**	read the zone file 'file' in directory 'dir' into the store
+**	returns ZS_OK, ZS_ERROR or ZS_UNSUPPORTED
+*****************************************************************/
+int	zs_readfile (zstore_t *zs, const char *dir, const char *file)
+{
+	char	path[MAX_PATHSIZE+1];
+	zsparse_t	p;
+	int	ret;
+
+	assert (zs != NULL);
+	memset (&p, 0, sizeof (p));
+	p.zs = zs;
+	p.dir = dir ? dir: ".";
+	p.origin = zs->origin;
+	p.defttl = zs->defttl;
+	p.lastttl = -1;
+
+	zs_estr[0] = '\0';
+	ret = readfile (&p, pathname (path, sizeof (path), p.dir, file, NULL));
+	free (p.tok.buf);
+
+	return ret;
+}
+
+/*****************************************************************
+**	zs_open (origin, dir, file)
+**	open the zone file for sequential reading by zs_readname()
+**	The memory needed is bounded by the largest owner name (the
+**	number of its records), not by the size of the zone.
+*****************************************************************/
+zsreader_t	*zs_open (const char *origin, const char *dir, const char *file)
+{
+	zsreader_t	*r;
+
+	zs_estr[0] = '\0';
+	if ( (r = calloc (1, sizeof (zsreader_t))) == NULL || (r->p.zs = zs_new (origin)) == NULL )
+	{
+		snprintf (zs_estr, sizeof (zs_estr), "out of memory");
+		free (r);
+		return NULL;
+	}
+	r->p.dir = dir ? dir: ".";
+	r->p.origin = r->p.zs->origin;
+	r->p.defttl = -1;
+	r->p.lastttl = -1;
+	r->p.stream = 1;
+
+	r->f.fname = pathname (r->path, sizeof (r->path), r->p.dir, file, NULL);
+	r->f.line = 1;
+	r->f.bol = 1;
+	if ( (r->f.fp = fopen (r->path, "r")) == NULL )
+	{
+		snprintf (zs_estr, sizeof (zs_estr), "can't open \"%.200s\": %s", r->path, strerror (errno));
+		zs_close (r);
+		return NULL;
+	}
+
+	return r;
+}
+
+/*****************************************************************
+**	zs_readname (r, prr)
+**	read all records of the next owner name in the zone file.
+**	The records are returned in canonical order and are valid
+**	up to the next call. Records of one name have to be
+**	contiguous in the file.
+**	returns the number of records, 0 at the end of the file,
+**	ZS_ERROR or ZS_UNSUPPORTED
+*****************************************************************/
+long	zs_readname (zsreader_t *r, rr_t **prr)
+{
+	uchar	origin[ZS_MAXNAME];
+	uchar	owner[ZS_MAXNAME];
+	zsparse_t	*p;
+	zstore_t	*zs;
+	rr_t	*rr;
+	int	ret;
+	int	n;
+
+	assert (r != NULL);
+	p = &r->p;
+	zs = p->zs;
+
+	/* release the records of the previous name but keep the parser state */
+	if ( p->origin )
+		memcpy (origin, dname_wire (p->origin), p->origin->len);
+	if ( p->owner )
+		memcpy (owner, dname_wire (p->owner), p->owner->len);
+	zsreset (zs);
+	if ( p->origin )
+		p->origin = zs_dname (zs, origin);
+	if ( p->owner )
+		p->owner = zs_dname (zs, owner);
+
+	if ( r->havenext )	/* the owner of the pending record is the last owner read */
+	{
+		r->havenext = 0;
+		if ( zs_add (zs, p->owner, r->next.type, r->next.ttl, r->nextrdata, r->next.rdlen) == NULL )
+			return parseerr (&r->f, ZS_ERROR, "out of memory", NULL);
+	}
+
+	while ( !r->eof )
+	{
+		if ( (n = getentry (&r->f, &p->tok)) < 0 )
+			return ZS_ERROR;
+		if ( n == 0 )
+		{
+			r->eof = 1;
+			break;
+		}
+		if ( *tok (&p->tok, 0) == '$' && !p->tok.leadws )
+			ret = directive (p, &r->f);
+		else
+			ret = entry (p, &r->f, r->rdata, sizeof (r->rdata));
+		if ( ret != ZS_OK )
+			return ret;
+
+		if ( zs->nrr > 1 && zs_namecmp (zs->rr[zs->nrr-1].owner, zs->rr[0].owner) != 0 )
+		{
+			rr = &zs->rr[--zs->nrr];	/* keep it for the next call */
+			r->next = *rr;
+			memcpy (r->nextrdata, rr->rdata, rr->rdlen);
+			r->havenext = 1;
+			break;
+		}
+	}
+
+	zs_sort (zs);
+	*prr = zs->rr;
+
+	return zs->nrr;
+}
+
+/*****************************************************************
+**	zs_close (r)
+*****************************************************************/
+void	zs_close (zsreader_t *r)
+{
+	if ( r == NULL )
+		return;
+	if ( r->f.fp )
+		fclose (r->f.fp);
+	zs_free (r->p.zs);
+	free (r->p.tok.buf);
+	free (r);
+}
+
+/*****************************************************************
+**	zs_rrcmp (a, b)
+**	compare two resource records by owner name (canonical order),
+**	type and rdata (canonical rdata order, RFC 4034 6.3)
+*****************************************************************/
+int	zs_rrcmp (const rr_t *a, const rr_t *b)
+{
+	int	res;
+
+	if ( (res = zs_namecmp (a->owner, b->owner)) != 0 )
+		return res;
+	if ( a->type != b->type )
+		return (int)a->type - (int)b->type;
+	if ( (res = memcmp (a->rdata, b->rdata, a->rdlen < b->rdlen ? a->rdlen: b->rdlen)) != 0 )
+		return res;
+	return (int)a->rdlen - (int)b->rdlen;
+}
+
+/*****************************************************************
+**	zs_sort (zs)
+**	sort the resource records in canonical order and remove
+**	duplicates. All records of a name share the same owner name
+**	afterwards, so owner names could be compared by pointer.
+*****************************************************************/
+void	zs_sort (zstore_t *zs)
+{
+	rr_t	*rr;
+	long	i;
+	long	n;
+
+	assert (zs != NULL);
+	if ( !zs->sorted )
+		qsort (zs->rr, zs->nrr, sizeof (rr_t), rrcmp_qsort);
+
+	rr = zs->rr;
+	for ( i = n = 0; i < zs->nrr; i++ )
+	{
+		if ( n > 0 && zs_namecmp (rr[i].owner, rr[n-1].owner) == 0 )
+			rr[i].owner = rr[n-1].owner;
+		else if ( zs->origin && zs_namecmp (rr[i].owner, zs->origin) == 0 )
+			rr[i].owner = zs->origin;
+		if ( n == 0 || zs_rrcmp (&rr[n-1], &rr[i]) != 0 )
+			rr[n++] = rr[i];
+	}
+	zs->nrr = n;
+	zs->sorted = 1;
+}
+
+/*****************************************************************
+**	zs_mkbitmap (type, n, buf, size)
+**	build the type bitmap (RFC 4034 4.1.2) of the n types
+**	returns the length of the bitmap or -1 if buf is too small
+*****************************************************************/
+int	zs_mkbitmap (const ushort type[], int n, uchar *buf, int size)
+{
+	uchar	map[256][32];
+	uchar	used[256];
+	int	win;
+	int	len;
+	int	i;
+
+	memset (used, 0, sizeof (used));
+	for ( i = 0; i < n; i++ )
+	{
+		win = type[i] >> 8;
+		if ( !used[win] )
+			memset (map[win], 0, sizeof (map[win]));
+		used[win] = 1;
+		map[win][(type[i] & 0xFF) >> 3] |= 0x80 >> (type[i] & 0x07);
+	}
+
+	len = 0;
+	for ( win = 0; win < 256; win++ )
+	{
+		if ( !used[win] )
+			continue;
+		for ( i = 32; i > 0 && map[win][i-1] == 0; i-- )
+			;
+		if ( len + 2 + i > size )
+			return -1;
+		buf[len++] = win;
+		buf[len++] = i;
+		memcpy (buf + len, map[win], i);
+		len += i;
+	}
+	return len;
+}
+
+/*****************************************************************
+**	zs_printrr (fp, rr)
+**	print the resource record in presentation format
+*****************************************************************/
+int	zs_printrr (FILE *fp, const rr_t *rr)
+{
+	prt_wirename (fp, dname_wire (rr->owner));
+	fprintf (fp, "\t%lu\tIN\t%s\t", rr->ttl, zs_type2str (rr->type));
+	zs_printrdata (fp, rr);
+
+	return putc ('\n', fp);
+}
+
+/*****************************************************************
+**	zs_printrdata (fp, rr)
+**	print the rdata of the resource record in presentation format
+*****************************************************************/
+int	zs_printrdata (FILE *fp, const rr_t *rr)
+{
+	const	zstype_t	*tp;
+	const	uchar	*p;
+	const	char	*fmt;
+	const	char	*sep;
+	char	addr[INET6_ADDRSTRLEN+1];
+	char	tstr[14+1];
+	time_t	sec;
+	struct	tm	t;
+	int	len;
+	int	n;
+	int	i;
+	int	j;
+
+	if ( (tp = findtype (rr->type)) == NULL || !checkrdata (tp->fmt, rr->rdata, rr->rdlen) )
+	{
+		fprintf (fp, "\\# %d ", rr->rdlen);
+		prt_hex (fp, rr->rdata, rr->rdlen);
+		return 0;
+	}
+
+	p = rr->rdata;
+	len = rr->rdlen;
+	for ( fmt = tp->fmt; *fmt; fmt++ )
+	{
+		n = fieldlen (*fmt, p, len);
+		if ( fmt != tp->fmt && n > 0 )
+			putc (' ', fp);
+		switch ( *fmt )
+		{
+		case 'd':
+		case 'N':	prt_wirename (fp, p);				break;
+		case 'b':	fprintf (fp, "%u", p[0]);			break;
+		case 's':	fprintf (fp, "%u", zs_get16 (p));		break;
+		case 'l':	fprintf (fp, "%lu", zs_get32 (p));		break;
+		case 'y':	fputs (zs_type2str (zs_get16 (p)), fp);		break;
+		case 'a':
+		case 'A':
+			fputs (inet_ntop (*fmt == 'a' ? AF_INET: AF_INET6, p, addr, sizeof (addr)), fp);
+			break;
+		case 'e':
+			sec = zs_get32 (p);
+			gmtime_r (&sec, &t);
+			strftime (tstr, sizeof (tstr), "%Y%m%d%H%M%S", &t);
+			fputs (tstr, fp);
+			break;
+		case 't':
+		case 'k':	prt_string (fp, p + 1, p[0], *fmt == 't');	break;
+		case 'T':
+			for ( i = 0; i < n; i += 1 + p[i] )
+			{
+				if ( i > 0 )
+					putc (' ', fp);
+				prt_string (fp, p + i + 1, p[i], 1);
+			}
+			break;
+		case 'Q':	prt_string (fp, p, n, 1);			break;
+		case 'x':
+			if ( p[0] == 0 )
+				putc ('-', fp);
+			prt_hex (fp, p + 1, p[0]);
+			break;
+		case 'H':	prt_base32hex (fp, p + 1, p[0]);		break;
+		case 'B':	prt_base64 (fp, p, n);				break;
+		case 'X':	prt_hex (fp, p, n);				break;
+		case 'M':
+			sep = "";
+			for ( i = 0; i < n; i += 2 + p[i+1] )
+				for ( j = 0; j < p[i+1] * 8; j++ )
+					if ( p[i + 2 + j / 8] & (0x80 >> (j % 8)) )
+					{
+						fprintf (fp, "%s%s", sep, zs_type2str (p[i] << 8 | j));
+						sep = " ";
+					}
+			break;
+		}
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/*****************************************************************
+**	zs_str2type (str)
+**	returns the type number of the mnemonic (or TYPEnnn) or -1
+*****************************************************************/
+int	zs_str2type (const char *str)
+{
+	ulong	val;
+	int	i;
+
+	for ( i = 0; types[i].name; i++ )
+		if ( strcasecmp (str, types[i].name) == 0 )
+			return types[i].type;
+	if ( strncasecmp (str, "TYPE", 4) == 0 && str2num (str + 4, 0xFFFF, &val) == 0 )
+		return val;
+	return -1;
+}
+
+/*****************************************************************
+**	zs_type2str (type)
+**	returns the mnemonic of the type (not reentrant for
+**	unknown types)
+*****************************************************************/
+const	char	*zs_type2str (int type)
+{
+	static	char	buf[4+5+1];
+	const	zstype_t	*tp;
+
+	if ( (tp = findtype (type)) != NULL )
+		return tp->name;
+	snprintf (buf, sizeof (buf), "TYPE%d", type);
+	return buf;
+}
+
+/*****************************************************************
+**	zs_typesupported (type)
+*****************************************************************/
+int	zs_typesupported (int type)
+{
+	return findtype (type) != NULL;
+}
@@ -0,0 +1,139 @@
+/*****************************************************************
+**
+**	@(#) zstore.h -- in-memory store of resource records
+**
+**	Copyright (c) Oct 2026, Holger Zuleger HZnet. All rights reserved.
+**
+**	This software is open source.
+**
+**	Redistribution and use in source and binary forms, with or without
+**	modification, are permitted provided that the following conditions
+**	are met:
+**
+**	Redistributions of source code must retain the above copyright notice,
+**	this list of conditions and the following disclaimer.
+**
+**	Redistributions in binary form must reproduce the above copyright notice,
+**	this list of conditions and the following disclaimer in the documentation
+**	and/or other materials provided with the distribution.
+**
+**	Neither the name of Holger Zuleger HZnet nor the names of its contributors may
+**	be used to endorse or promote products derived from this software without
+**	specific prior written permission.
+**
+**	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+**	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+**	TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+**	PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+**	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+**	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+**	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+**	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+**	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+**	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+**	POSSIBILITY OF SUCH DAMAGE.
+**
+*****************************************************************/
+#ifndef ZSTORE_H
+# define ZSTORE_H
+
+# define	ZS_MAXNAME	255	/* max length of a domain name in wire format */
+# define	ZS_MAXKEY	(2 * ZS_MAXNAME)	/* max length of the sort key */
+# define	ZS_MAXRDATA	65535
+# define	ZS_MAXINCLUDE	8	/* max nesting of $INCLUDE */
+
+/* return codes of the zone file reader */
+# define	ZS_OK		(0)
+# define	ZS_ERROR	(-1)
+# define	ZS_UNSUPPORTED	(-2)	/* valid zone file with unsupported content */
+
+/* resource record types used by the signer */
+# define	ZS_T_A		1
+# define	ZS_T_NS		2
+# define	ZS_T_CNAME	5
+# define	ZS_T_SOA	6
+# define	ZS_T_PTR	12
+# define	ZS_T_TXT	16
+# define	ZS_T_DNAME	39
+# define	ZS_T_DS		43
+# define	ZS_T_RRSIG	46
+# define	ZS_T_NSEC	47
+# define	ZS_T_DNSKEY	48
+# define	ZS_T_NSEC3	50
+# define	ZS_T_NSEC3PARAM	51
+# define	ZS_T_CDS	59
+# define	ZS_T_CDNSKEY	60
+
+# define	ZS_C_IN		1
+
+/* access to network byte order values */
+# define	zs_get16(p)	((ushort)((p)[0] << 8 | (p)[1]))
+# define	zs_get32(p)	((ulong)(p)[0] << 24 | (ulong)(p)[1] << 16 | (ulong)(p)[2] << 8 | (ulong)(p)[3])
+# define	zs_put16(p, v)	((p)[0] = ((v) >> 8) & 0xFF, (p)[1] = (v) & 0xFF)
+# define	zs_put32(p, v)	((p)[0] = ((v) >> 24) & 0xFF, (p)[1] = ((v) >> 16) & 0xFF, \
+				 (p)[2] = ((v) >> 8) & 0xFF, (p)[3] = (v) & 0xFF)
+
+/*
+ *	A domain name is stored in (lowercase) wire format followed by
+ *	a sort key which compares with memcmp() in canonical name order
+ *	(RFC 4034 6.1): the labels in reverse order, each label followed
+ *	by a 0 byte and the bytes 0 and 1 escaped as 1,1 and 1,2
+ */
+typedef	struct	dname {
+	uchar	len;		/* length of the wire format */
+	uchar	labels;		/* number of labels (without the root label) */
+	ushort	keylen;		/* length of the sort key */
+	uchar	data[];		/* wire format followed by the sort key */
+} dname_t;
+
+# define	dname_wire(dn)	((dn)->data)
+# define	dname_key(dn)	((dn)->data + (dn)->len)
+
+typedef	struct	rr {
+	const	dname_t	*owner;
+	ulong	ttl;
+	ushort	type;
+	ushort	rdlen;
+	uchar	*rdata;		/* canonical wire format (RFC 4034 6.2) */
+} rr_t;
+
+typedef	struct	zstore {
+	const	dname_t	*origin;
+	rr_t	*rr;		/* array of resource records */
+	long	nrr;
+	long	maxrr;
+	int	sorted;		/* rr array is in canonical order */
+	long	defttl;		/* ttl used if there is no $TTL (-1 = none) */
+	const	dname_t	*last;	/* last stored domain name */
+	struct	zsmem	*mem;	/* memory chunks of names and rdata */
+} zstore_t;
+
+typedef	struct	zsreader	zsreader_t;
+
+extern	const	char	*zs_geterrstr (void);
+extern	zstore_t	*zs_new (const char *origin);
+extern	void	zs_free (zstore_t *zs);
+extern	void	*zs_alloc (zstore_t *zs, size_t size);
+extern	const	dname_t	*zs_dname (zstore_t *zs, const uchar *wire);
+extern	const	dname_t	*zs_str2dname (zstore_t *zs, const char *str, const dname_t *origin);
+extern	int	zs_str2wire (const char *str, const dname_t *origin, uchar *wire, int lower);
+extern	int	zs_wirelen (const uchar *wire, int size);
+extern	char	*zs_dname2str (const dname_t *dn, char *buf, size_t size);
+extern	char	*zs_wire2str (const uchar *wire, char *buf, size_t size);
+extern	int	zs_namecmp (const dname_t *a, const dname_t *b);
+extern	int	zs_issubdomain (const dname_t *name, const dname_t *parent);
+extern	int	zs_iswildcard (const dname_t *name);
+extern	rr_t	*zs_add (zstore_t *zs, const dname_t *owner, int type, ulong ttl, const uchar *rdata, int rdlen);
+extern	int	zs_readfile (zstore_t *zs, const char *dir, const char *file);
+extern	zsreader_t	*zs_open (const char *origin, const char *dir, const char *file);
+extern	long	zs_readname (zsreader_t *r, rr_t **prr);
+extern	void	zs_close (zsreader_t *r);
+extern	int	zs_rrcmp (const rr_t *a, const rr_t *b);
+extern	void	zs_sort (zstore_t *zs);
+extern	int	zs_mkbitmap (const ushort type[], int n, uchar *buf, int size);
+extern	int	zs_printrr (FILE *fp, const rr_t *rr);
+extern	int	zs_printrdata (FILE *fp, const rr_t *rr);
+extern	int	zs_str2type (const char *str);
+extern	const	char	*zs_type2str (int type);
+extern	int	zs_typesupported (int type);
+#endif